@@ -0,0 +1,11 @@
+-- ============================================================================
+-- KithLy Global Protocol - ESCROW WATCHDOG
+-- 007_escrow_expiry_index.sql - Keyset Index for the 48-Hour Expiry Scan
+-- ============================================================================
+
+-- The C++ watchdog pages through LOCKED (200) gifts ordered by
+-- (expiry_timestamp, tx_id). A partial index keeps the scan proportional
+-- to the number of locked escrows, not the size of Global_Gifts.
+CREATE INDEX IF NOT EXISTS idx_gifts_escrow_expiry
+    ON Global_Gifts (expiry_timestamp, tx_id)
+    WHERE status_code = 200;
@@ -0,0 +1,15 @@
+-- ============================================================================
+-- KithLy Global Protocol - DEADLINE SCHEDULER
+-- 008_deadline_scheduler.sql - Explicit Shop Acceptance Deadline
+-- ============================================================================
+
+-- Baker's Protocol (110): the shop must accept within 2 hours or the order
+-- lapses to DECLINED (910). Storing the deadline lets the C++ scheduler
+-- rebuild its timing wheel on restart without recomputing windows.
+ALTER TABLE Global_Gifts
+    ADD COLUMN IF NOT EXISTS acceptance_deadline TIMESTAMPTZ;
+
+-- Startup rebuild reads every gift with an open clock
+CREATE INDEX IF NOT EXISTS idx_gifts_open_clocks
+    ON Global_Gifts (status_code)
+    WHERE status_code IN (110, 200, 300, 305);
@@ -0,0 +1,26 @@
+-- ============================================================================
+-- KithLy Global Protocol - THE REROUTER
+-- 009_shop_index_notify.sql - Change Feed for the C++ Shop Index
+-- ============================================================================
+
+-- The C++ core keeps a resident spatial index of active shops and LISTENs
+-- on kithly_shops. Each change sends the shop_id as payload; the listener
+-- re-reads that one row. An empty payload requests a full reload.
+CREATE OR REPLACE FUNCTION notify_shop_change()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('kithly_shops', OLD.shop_id::text);
+    ELSE
+        PERFORM pg_notify('kithly_shops', NEW.shop_id::text);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS trg_shops_notify ON Shops;
+CREATE TRIGGER trg_shops_notify
+    AFTER INSERT OR DELETE OR UPDATE OF name, category, latitude, longitude, is_active, performance_score
+    ON Shops
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_shop_change();
@@ -0,0 +1,64 @@
+-- ============================================================================
+-- KithLy Global Protocol - OPERATING HOURS
+-- 010_operating_hours_notify.sql - Open-Now Filtering for Reroutes
+-- ============================================================================
+
+-- The C++ shop index keeps a 15-minute open-hours bitmap per shop. Edits
+-- to Operating_Hours go out on the same kithly_shops channel as shop edits,
+-- so the listener re-reads that shop and its schedule together.
+CREATE OR REPLACE FUNCTION notify_operating_hours_change()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('kithly_shops', OLD.shop_id::text);
+    ELSE
+        PERFORM pg_notify('kithly_shops', NEW.shop_id::text);
+        IF TG_OP = 'UPDATE' AND OLD.shop_id IS DISTINCT FROM NEW.shop_id THEN
+            PERFORM pg_notify('kithly_shops', OLD.shop_id::text);
+        END IF;
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS trg_operating_hours_notify ON Operating_Hours;
+CREATE TRIGGER trg_operating_hours_notify
+    AFTER INSERT OR UPDATE OR DELETE ON Operating_Hours
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_operating_hours_change();
+
+-- SQL-side equivalent of the bitmap check, for queries that cannot use the
+-- in-memory index. Same rules as the C++ side:
+--   * Lusaka local time
+--   * close_time <= open_time spans midnight (open == close is 24 hours)
+--   * a shop with no Operating_Hours rows has an unknown schedule and
+--     is treated as open
+CREATE OR REPLACE FUNCTION shop_open_for_reroute(p_shop_id UUID)
+RETURNS BOOLEAN AS $$
+DECLARE
+    local_now TIMESTAMP := NOW() AT TIME ZONE 'Africa/Lusaka';
+    today     INT := EXTRACT(DOW FROM local_now);
+    yesterday INT := (EXTRACT(DOW FROM local_now)::INT + 6) % 7;
+    now_time  TIME := local_now::TIME;
+BEGIN
+    IF NOT EXISTS (SELECT 1 FROM Operating_Hours WHERE shop_id = p_shop_id) THEN
+        RETURN TRUE;
+    END IF;
+
+    RETURN EXISTS (
+        SELECT 1 FROM Operating_Hours
+        WHERE shop_id = p_shop_id
+          AND (
+                -- Same-day span
+                (day_of_week = today AND open_time < close_time
+                    AND now_time >= open_time AND now_time < close_time)
+                -- Overnight span, evening part
+             OR (day_of_week = today AND close_time <= open_time
+                    AND now_time >= open_time)
+                -- Overnight span from yesterday, early-morning part
+             OR (day_of_week = yesterday AND close_time <= open_time
+                    AND now_time < close_time)
+          )
+    );
+END;
+$$ LANGUAGE plpgsql STABLE;
@@ -0,0 +1,10 @@
+-- ============================================================================
+-- KithLy Global Protocol - IDEMPOTENCY FILTER
+-- 011_idempotency_filter.sql - Recent-Key Scan Index
+-- ============================================================================
+
+-- kithly_core seeds its idempotency Bloom filter at startup with every key
+-- created within IDEMPOTENCY_WINDOW_HOURS; a range scan on created_at keeps
+-- that read proportional to the window instead of the whole ledger.
+CREATE INDEX IF NOT EXISTS idx_global_gifts_created_at
+    ON Global_Gifts (created_at);
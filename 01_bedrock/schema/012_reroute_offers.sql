@@ -0,0 +1,27 @@
+-- ============================================================================
+-- KithLy Global Protocol - REROUTE FAN-OUT
+-- 012_reroute_offers.sql - Parallel Reroute Offers (First Accept Wins)
+-- ============================================================================
+
+-- A declined gift is offered to the top N alternative shops at once. Each
+-- offer is a shadow lock on that shop until it expires; the first shop to
+-- accept claims the gift and every sibling offer is released.
+CREATE TABLE IF NOT EXISTS Reroute_Offers (
+    tx_id        UUID NOT NULL REFERENCES Global_Gifts(tx_id) ON DELETE CASCADE,
+    shop_id      UUID NOT NULL REFERENCES Shops(shop_id) ON DELETE CASCADE,
+    state        VARCHAR(10) NOT NULL DEFAULT 'offered'
+                 CHECK (state IN ('offered', 'accepted', 'released')),
+    distance_km  DOUBLE PRECISION,
+    offered_at   TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    expires_at   TIMESTAMPTZ NOT NULL,
+    resolved_at  TIMESTAMPTZ,
+    PRIMARY KEY (tx_id, shop_id)
+);
+
+-- Backstop for kithly_claim_reroute: at most one winner per gift
+CREATE UNIQUE INDEX IF NOT EXISTS idx_reroute_offers_winner
+    ON Reroute_Offers (tx_id) WHERE state = 'accepted';
+
+-- Open offers per shop (the shop's pending-offer inbox)
+CREATE INDEX IF NOT EXISTS idx_reroute_offers_open
+    ON Reroute_Offers (shop_id, expires_at) WHERE state = 'offered';
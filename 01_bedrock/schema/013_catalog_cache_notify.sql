@@ -0,0 +1,35 @@
+-- ============================================================================
+-- KithLy Global Protocol - THE ORCHESTRATOR
+-- 013_catalog_cache_notify.sql - Change Feed for the Engine Catalog Cache
+-- ============================================================================
+
+-- The engine (02_engine) caches Shop and Product metadata and refreshes one
+-- entry per notification. Products send the sku_id on kithly_products;
+-- Shops reuse kithly_shops (009_shop_index_notify.sql). An empty payload
+-- on either channel requests a full reload.
+CREATE OR REPLACE FUNCTION notify_product_change()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('kithly_products', OLD.sku_id::text);
+    ELSE
+        PERFORM pg_notify('kithly_products', NEW.sku_id::text);
+    END IF;
+    RETURN NULL;
+END;
+$$ LANGUAGE plpgsql;
+
+DROP TRIGGER IF EXISTS trg_products_notify ON Products;
+CREATE TRIGGER trg_products_notify
+    AFTER INSERT OR DELETE OR UPDATE OF sku_id, is_made_to_order
+    ON Products
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_product_change();
+
+-- The cache also holds tier, so tier changes must notify too
+DROP TRIGGER IF EXISTS trg_shops_notify ON Shops;
+CREATE TRIGGER trg_shops_notify
+    AFTER INSERT OR DELETE OR UPDATE OF name, category, latitude, longitude, is_active, performance_score, tier
+    ON Shops
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_shop_change();
@@ -0,0 +1,10 @@
+-- ============================================================================
+-- KithLy Global Protocol - EVIDENCE VAULT
+-- 014_evidence_ingest.sql - Object Metadata for Streamed Delivery Proofs
+-- ============================================================================
+
+-- The C++ ingestor (02_core_logic/src/evidence) streams each photo into a
+-- content-addressed store and records its size and type with the proof,
+-- matching the Evidence struct in structs.h.
+ALTER TABLE Delivery_Proofs ADD COLUMN IF NOT EXISTS file_size BIGINT;
+ALTER TABLE Delivery_Proofs ADD COLUMN IF NOT EXISTS mime_type VARCHAR(100);
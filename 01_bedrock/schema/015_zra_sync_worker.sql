@@ -0,0 +1,14 @@
+-- ============================================================================
+-- KithLy Global Protocol - EVIDENCE VAULT
+-- 015_zra_sync_worker.sql - Due-Now Default for the ZRA Sync Drainer
+-- ============================================================================
+
+-- The C++ sync worker (02_core_logic/src/zra) claims PENDING rows in
+-- next_retry_at order through idx_sync_retry. A NULL next_retry_at would
+-- never come due, so new rows default to "due now" and queued rows are
+-- backfilled from their creation time.
+ALTER TABLE ZRA_Sync_Queue ALTER COLUMN next_retry_at SET DEFAULT NOW();
+
+UPDATE ZRA_Sync_Queue
+SET next_retry_at = COALESCE(created_at, NOW())
+WHERE status = 'PENDING' AND next_retry_at IS NULL;
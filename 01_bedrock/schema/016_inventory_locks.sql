@@ -0,0 +1,24 @@
+-- ============================================================================
+-- KithLy Global Protocol - THE ORCHESTRATOR
+-- 016_inventory_locks.sql - Shadow Locks Taken by the Engine Reroute
+-- ============================================================================
+
+-- The engine (02_engine) reroutes a declined gift in one statement that
+-- also holds the alternative shop's stock for 15 minutes. A repeat reroute
+-- of the same gift to the same shop refreshes the lock (ON CONFLICT on the
+-- primary key).
+CREATE TABLE IF NOT EXISTS Inventory_Locks (
+    shop_id    UUID NOT NULL REFERENCES Shops(shop_id) ON DELETE CASCADE,
+    tx_id      UUID NOT NULL REFERENCES Global_Gifts(tx_id) ON DELETE CASCADE,
+    locked_at  TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    expires_at TIMESTAMPTZ NOT NULL,
+    PRIMARY KEY (shop_id, tx_id)
+);
+
+-- Live locks per shop (expires_at > NOW())
+CREATE INDEX IF NOT EXISTS idx_inventory_locks_expiry
+    ON Inventory_Locks (shop_id, expires_at);
+
+-- Lookups by gift (release on completion or refund)
+CREATE INDEX IF NOT EXISTS idx_inventory_locks_tx
+    ON Inventory_Locks (tx_id);
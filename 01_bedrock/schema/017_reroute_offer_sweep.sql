@@ -0,0 +1,14 @@
+-- ============================================================================
+-- KithLy Global Protocol - REROUTE FAN-OUT
+-- 017_reroute_offer_sweep.sql - Fan-out Lease and Offer Expiry
+-- ============================================================================
+
+-- Only the node holding this lease fans a declined gift out
+-- (kithly_lease_reroute_fanout). A lease that lapses with no offer
+-- written (the holder died mid fan-out, or no shop was open) makes the
+-- gift eligible for the reroute sweep's retry.
+ALTER TABLE Global_Gifts ADD COLUMN IF NOT EXISTS reroute_fanout_until TIMESTAMPTZ;
+
+-- The sweep releases lapsed offers oldest first
+CREATE INDEX IF NOT EXISTS idx_reroute_offers_expiry
+    ON Reroute_Offers (expires_at) WHERE state = 'offered';
@@ -0,0 +1,24 @@
+-- ============================================================================
+-- KithLy Global Protocol - THE HEART
+-- 018_gateway_event_outbox.sql - Durable Outbox for Money-Moving Events
+-- ============================================================================
+
+-- Refund and disbursement events are written here before they enter the
+-- core's in-memory XADD buffer, and deleted once kithly:events:gateway
+-- holds them. A row whose lease lapsed (its node died, or Redis stayed
+-- down past the lease) is claimed and re-sent by any node, so delivery
+-- is at-least-once even across a restart during a Redis outage.
+CREATE TABLE IF NOT EXISTS Gateway_Event_Outbox (
+    event_id     BIGSERIAL PRIMARY KEY,
+    event_type   VARCHAR(32) NOT NULL,
+    tx_id        UUID NOT NULL,
+    status       INT,
+    shop_id      TEXT,
+    payment_ref  TEXT,
+    at_ms        BIGINT NOT NULL,
+    lease_until  TIMESTAMPTZ NOT NULL,
+    created_at   TIMESTAMPTZ NOT NULL DEFAULT NOW()
+);
+
+CREATE INDEX IF NOT EXISTS idx_gateway_outbox_lease
+    ON Gateway_Event_Outbox (lease_until);
@@ -0,0 +1,14 @@
+-- ============================================================================
+-- KithLy Global Protocol - REROUTE FAN-OUT
+-- 019_reroute_rounds.sql - Fan-out Round Cap
+-- ============================================================================
+
+-- Each fan-out lease taken on a declined gift is one round. Once every
+-- offer of a round has lapsed the reroute sweep runs another, up to the
+-- core's cap (RerouteFanoutOptions::max_rounds); a gift that used them
+-- all takes the DECLINED -> EXPIRED refund edge instead.
+ALTER TABLE Global_Gifts ADD COLUMN IF NOT EXISTS reroute_rounds INT NOT NULL DEFAULT 0;
+
+-- The sweep's scan: declined gifts whose lease lapsed
+CREATE INDEX IF NOT EXISTS idx_gifts_declined_fanout
+    ON Global_Gifts (reroute_fanout_until) WHERE status_code = 910;
@@ -0,0 +1,142 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - BENCHMARKS
+ * bench/bench_idempotency.cpp - Idempotency Guard Under Contention
+ * =============================================================================
+ *
+ * IdempotencyGuard's local path, minus the database: check() against the
+ * sharded cache and the key filter, reserve() in the reservation table,
+ * commit() back into the cache. Run across 1..N threads to expose lock
+ * contention; "hot" variants make every thread fight over a few keys.
+ */
+
+#include "idempotency_cache.h"
+#include "idempotency_filter.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace kithly::idempotency;
+
+constexpr std::size_t KEY_SPACE = 1 << 16;
+
+struct CachedTransaction {
+    std::string tx_id;
+    int status_code;
+};
+
+const std::vector<std::string>& keys() {
+    static const std::vector<std::string> all = [] {
+        std::vector<std::string> out;
+        out.reserve(KEY_SPACE);
+        for (std::size_t i = 0; i < KEY_SPACE; ++i) {
+            out.push_back("idem-" + std::to_string(i * 2654435761u));
+        }
+        return out;
+    }();
+    return all;
+}
+
+// Shared across benchmark threads; same sizing as IdempotencyGuard
+ShardedClockCache<std::string, CachedTransaction>& shared_cache() {
+    static ShardedClockCache<std::string, CachedTransaction> cache(KEY_SPACE / 2, std::chrono::hours(24));
+    return cache;
+}
+
+ReservationTable<std::string>& shared_reservations() {
+    static ReservationTable<std::string> table(std::chrono::seconds(30));
+    return table;
+}
+
+IdempotencyFilter& shared_filter() {
+    static IdempotencyFilter* filter = [] {
+        auto* f = new IdempotencyFilter();
+        for (std::size_t i = 0; i < KEY_SPACE; i += 2) {
+            f->insert(keys()[i]);
+        }
+        return f;
+    }();
+    return *filter;
+}
+
+// Each thread walks its own stride through the key space
+std::size_t start_for(const benchmark::State& state) {
+    return static_cast<std::size_t>(state.thread_index()) * (KEY_SPACE / 64);
+}
+
+void BM_CacheCheck(benchmark::State& state) {
+    auto& cache = shared_cache();
+    const auto& all = keys();
+    if (state.thread_index() == 0) {
+        for (std::size_t i = 0; i < KEY_SPACE; i += 2) {
+            cache.put(all[i], {all[i], 200});
+        }
+    }
+    std::size_t i = start_for(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.get(all[i++ & (KEY_SPACE - 1)]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CacheCheck)->ThreadRange(1, 16)->UseRealTime();
+
+void BM_FilterCheck(benchmark::State& state) {
+    auto& filter = shared_filter();
+    const auto& all = keys();
+    std::size_t i = start_for(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filter.may_contain(all[i++ & (KEY_SPACE - 1)]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FilterCheck)->ThreadRange(1, 16)->UseRealTime();
+
+// check -> reserve -> commit -> release on mostly distinct keys
+void BM_GuardCycle(benchmark::State& state) {
+    auto& cache = shared_cache();
+    auto& reservations = shared_reservations();
+    const auto& all = keys();
+    const uint64_t owner = static_cast<uint64_t>(state.thread_index()) + 1;
+    std::size_t i = start_for(state);
+    int64_t contended = 0;
+    for (auto _ : state) {
+        const std::string& key = all[i++ & (KEY_SPACE - 1)];
+        if (cache.get(key)) {
+            continue;
+        }
+        if (!reservations.try_reserve(key, owner)) {
+            ++contended;
+            continue;
+        }
+        cache.put(key, {key, 200});
+        reservations.release(key, owner);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["contended"] = benchmark::Counter(static_cast<double>(contended), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_GuardCycle)->ThreadRange(1, 16)->UseRealTime();
+
+// Every thread retries the same handful of keys (double-submit storm)
+void BM_GuardCycleHot(benchmark::State& state) {
+    auto& reservations = shared_reservations();
+    const auto& all = keys();
+    const uint64_t owner = static_cast<uint64_t>(state.thread_index()) + 1;
+    std::size_t i = 0;
+    int64_t contended = 0;
+    for (auto _ : state) {
+        const std::string& key = all[i++ & 7];
+        if (!reservations.try_reserve(key, owner)) {
+            ++contended;
+            continue;
+        }
+        reservations.release(key, owner);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["contended"] = benchmark::Counter(static_cast<double>(contended), benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_GuardCycleHot)->ThreadRange(1, 16)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,107 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - BENCHMARKS
+ * bench/bench_ingestion.cpp - Handshake Tokens, Payload Parsing
+ * =============================================================================
+ */
+
+#include "handshake_token.h"
+#include "payload_parser.h"
+#include "structs.h"
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace Kithly;
+
+// Shape of a gateway job as pushed to kithly:ingestion:gifts
+const std::string& sample_payload() {
+    static const std::string payload = R"({)"
+        R"("tx_id":"7f9c2ba4-e88f-4d2c-9d1e-3a6f4b8c2d10",)"
+        R"("idempotency_key":"idem-7f9c2ba4-e88f-4d2c-9d1e-3a6f4b8c2d10",)"
+        R"("receiver_phone":"+260971234567",)"
+        R"("shop_id":"3c1d8e2a-5b4f-4a9e-8c7d-6e5f4a3b2c1d",)"
+        R"("product_id":"SKU-CAKE-001",)"
+        R"("quantity":2,)"
+        R"("tx_ref":"KL-20261014-000123",)"
+        R"("sender_id":"user-8842",)"
+        R"("receiver_name":"Mwila Banda",)"
+        R"("unit_price":185.5,)"
+        R"("message":"Happy birthday! 🎂 See you \"soon\"",)"
+        R"("is_surprise":true,)"
+        R"("client":{"platform":"android","version":"3.4.1"})"
+        R"(})";
+    return payload;
+}
+
+// =============================================================================
+// HANDSHAKE TOKENS
+// =============================================================================
+
+void BM_HandshakeToken(benchmark::State& state) {
+    Orchestrator::HandshakeToken token;
+    for (auto _ : state) {
+        Orchestrator::generate_handshake_token(token);
+        benchmark::DoNotOptimize(token);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HandshakeToken)->ThreadRange(1, 8);
+
+void BM_HandshakeTokensBulk(benchmark::State& state) {
+    std::vector<Orchestrator::HandshakeToken> tokens(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        Orchestrator::generate_handshake_tokens(tokens.data(), tokens.size());
+        benchmark::DoNotOptimize(tokens.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HandshakeTokensBulk)->Arg(16)->Arg(256);
+
+// =============================================================================
+// PAYLOAD PARSING
+// =============================================================================
+
+// Previous path: nlohmann DOM, then from_json into an owning GiftPayload
+void BM_ParsePayloadDom(benchmark::State& state) {
+    const std::string& raw = sample_payload();
+    for (auto _ : state) {
+        GiftPayload payload = nlohmann::json::parse(raw).get<GiftPayload>();
+        benchmark::DoNotOptimize(payload.tx_id.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(raw.size()));
+}
+BENCHMARK(BM_ParsePayloadDom);
+
+void BM_ParsePayload(benchmark::State& state) {
+    const std::string& raw = sample_payload();
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    for (auto _ : state) {
+        if (!parser.parse(raw, view)) {
+            state.SkipWithError(parser.error().c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(view.tx_id.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(raw.size()));
+}
+BENCHMARK(BM_ParsePayload)->ThreadRange(1, 8);
+
+void BM_EscrowLockedEvent(benchmark::State& state) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    parser.parse(sample_payload(), view);
+    std::string event;
+    for (auto _ : state) {
+        event.clear();
+        append_escrow_locked_event(event, view.effective_tx_ref(), view.receiver_phone, "K7QX-M2PA");
+        benchmark::DoNotOptimize(event.data());
+    }
+}
+BENCHMARK(BM_EscrowLockedEvent);
+
+} // namespace
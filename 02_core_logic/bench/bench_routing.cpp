@@ -0,0 +1,219 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - BENCHMARKS
+ * bench/bench_routing.cpp - Distance Kernels, Route Optimiser, Ranking
+ * =============================================================================
+ */
+
+#include "geo.h"
+#include "ranking.h"
+#include "route_optimizer.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+using namespace Kithly;
+
+// Lusaka city centre; synthetic shops scatter within ~0.2 degrees
+constexpr double ORIGIN_LAT = -15.4167;
+constexpr double ORIGIN_LON = 28.2833;
+
+struct LatLon {
+    double lat, lon;
+};
+
+std::vector<LatLon> scatter(std::size_t n, uint32_t seed = 42) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> offset(-0.2, 0.2);
+    std::vector<LatLon> points(n);
+    for (auto& p : points) {
+        p = {ORIGIN_LAT + offset(rng), ORIGIN_LON + offset(rng)};
+    }
+    return points;
+}
+
+// The textbook trigonometric haversine the chord kernel replaced
+double trig_haversine_km(double lat1, double lon1, double lat2, double lon2) {
+    constexpr double RAD = 3.14159265358979323846 / 180.0;
+    const double dlat = (lat2 - lat1) * RAD;
+    const double dlon = (lon2 - lon1) * RAD;
+    const double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
+                     std::cos(lat1 * RAD) * std::cos(lat2 * RAD) *
+                     std::sin(dlon / 2) * std::sin(dlon / 2);
+    return geo::EARTH_RADIUS_KM * 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
+}
+
+// =============================================================================
+// HAVERSINE: SCALAR VS SIMD
+// =============================================================================
+
+void BM_HaversineTrig(benchmark::State& state) {
+    const auto points = scatter(static_cast<std::size_t>(state.range(0)));
+    std::vector<double> out(points.size());
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            out[i] = trig_haversine_km(ORIGIN_LAT, ORIGIN_LON, points[i].lat, points[i].lon);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HaversineTrig)->RangeMultiplier(8)->Range(64, 32768);
+
+void BM_DistanceScalar(benchmark::State& state) {
+    const auto points = scatter(static_cast<std::size_t>(state.range(0)));
+    std::vector<double> out(points.size());
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            out[i] = geo::distance_km(ORIGIN_LAT, ORIGIN_LON, points[i].lat, points[i].lon);
+        }
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_DistanceScalar)->RangeMultiplier(8)->Range(64, 32768);
+
+void BM_Chord2Batch(benchmark::State& state) {
+    geo::PointSet set;
+    for (const auto& p : scatter(static_cast<std::size_t>(state.range(0)))) {
+        set.add(p.lat, p.lon);
+    }
+    const auto origin = geo::to_unit(ORIGIN_LAT, ORIGIN_LON);
+    std::vector<double> out(set.size());
+    for (auto _ : state) {
+        set.chord2_batch(origin, out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(geo::simd_backend());
+}
+BENCHMARK(BM_Chord2Batch)->RangeMultiplier(8)->Range(64, 32768);
+
+void BM_DistancesKmBatch(benchmark::State& state) {
+    geo::PointSet set;
+    for (const auto& p : scatter(static_cast<std::size_t>(state.range(0)))) {
+        set.add(p.lat, p.lon);
+    }
+    const auto origin = geo::to_unit(ORIGIN_LAT, ORIGIN_LON);
+    std::vector<double> out(set.size());
+    for (auto _ : state) {
+        set.distances_km(origin, out.data());
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(geo::simd_backend());
+}
+BENCHMARK(BM_DistancesKmBatch)->RangeMultiplier(8)->Range(64, 32768);
+
+void BM_NearestBatch(benchmark::State& state) {
+    geo::PointSet set;
+    for (const auto& p : scatter(static_cast<std::size_t>(state.range(0)))) {
+        set.add(p.lat, p.lon);
+    }
+    const auto origin = geo::to_unit(ORIGIN_LAT, ORIGIN_LON);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(set.nearest(origin));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(geo::simd_backend());
+}
+BENCHMARK(BM_NearestBatch)->RangeMultiplier(8)->Range(64, 32768);
+
+// =============================================================================
+// PICKUP ROUTE (optimize_pickup_route)
+// =============================================================================
+
+void BM_OptimizePickupRoute(benchmark::State& state) {
+    std::vector<RouteStop> stops;
+    for (const auto& p : scatter(static_cast<std::size_t>(state.range(0)), 7)) {
+        stops.push_back({p.lat, p.lon, std::nullopt, std::nullopt});
+    }
+    // No cache: every iteration plans from scratch
+    RouteOptimizer::Options options;
+    options.cache_capacity = 0;
+    RouteOptimizer optimizer(options);
+    double km = 0;
+    for (auto _ : state) {
+        auto plan = optimizer.optimize(ORIGIN_LAT, ORIGIN_LON, stops);
+        km = plan.distance_km;
+        benchmark::DoNotOptimize(plan.order.data());
+    }
+    state.counters["route_km"] = km;
+}
+BENCHMARK(BM_OptimizePickupRoute)->DenseRange(4, 12, 4)->Arg(24)->Arg(48)->Unit(benchmark::kMicrosecond);
+
+void BM_OptimizePickupRouteCached(benchmark::State& state) {
+    std::vector<RouteStop> stops;
+    for (const auto& p : scatter(static_cast<std::size_t>(state.range(0)), 7)) {
+        stops.push_back({p.lat, p.lon, std::nullopt, std::nullopt});
+    }
+    RouteOptimizer optimizer;
+    optimizer.optimize(ORIGIN_LAT, ORIGIN_LON, stops);
+    for (auto _ : state) {
+        auto plan = optimizer.optimize(ORIGIN_LAT, ORIGIN_LON, stops);
+        benchmark::DoNotOptimize(plan.order.data());
+    }
+}
+BENCHMARK(BM_OptimizePickupRouteCached)->Arg(12)->Unit(benchmark::kMicrosecond);
+
+// =============================================================================
+// SWAP CANDIDATE RANKING (find_swap_candidates)
+// =============================================================================
+
+struct Candidate {
+    int shop;
+    double distance_km;
+    double confidence_score;
+};
+
+std::vector<Candidate> candidates(std::size_t n) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> distance(0.1, 20.0);
+    std::uniform_real_distribution<double> confidence(0.0, 1.0);
+    std::vector<Candidate> out(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = {static_cast<int>(i), distance(rng), confidence(rng)};
+    }
+    return out;
+}
+
+// Previous approach: full sort, comparator re-scoring both sides
+void BM_SwapRankFullSort(benchmark::State& state) {
+    const auto base = candidates(static_cast<std::size_t>(state.range(0)));
+    const ranking::Weights weights;
+    for (auto _ : state) {
+        auto items = base;
+        std::sort(items.begin(), items.end(), [&](const Candidate& a, const Candidate& b) {
+            return weights(a.distance_km, a.confidence_score) < weights(b.distance_km, b.confidence_score);
+        });
+        items.resize(std::min<std::size_t>(10, items.size()));
+        benchmark::DoNotOptimize(items.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SwapRankFullSort)->RangeMultiplier(4)->Range(16, 4096);
+
+void BM_SwapRankTopK(benchmark::State& state) {
+    const auto base = candidates(static_cast<std::size_t>(state.range(0)));
+    const ranking::Weights weights;
+    for (auto _ : state) {
+        auto items = base;
+        auto top = ranking::take_top_k(
+            std::move(items), 10,
+            [&](const Candidate& c) { return weights(c.distance_km, c.confidence_score); },
+            [](const Candidate& c) { return c.shop != 0; });
+        benchmark::DoNotOptimize(top.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SwapRankTopK)->RangeMultiplier(4)->Range(16, 4096);
+
+} // namespace
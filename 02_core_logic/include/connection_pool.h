@@ -0,0 +1,152 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE BRIDGE
+ * connection_pool.h - Thread-safe libpq Connection Pool
+ * =============================================================================
+ */
+
+#pragma once
+
+#include <libpq-fe.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace kithly {
+namespace db {
+
+/**
+ * Database Configuration
+ * Mirrors the KITHLY_DB_* environment variables
+ */
+struct DbConfig {
+    std::string host = "localhost";
+    int port = 5432;
+    std::string database = "kithly";
+    std::string user = "kithly_app";
+    std::string password;
+    int pool_size = 10;
+
+    // Callers queued beyond this fail fast instead of piling up
+    int max_waiters = 64;
+    std::chrono::milliseconds acquire_timeout{5000};
+    // libpq connect_timeout; bounds a checkout that has to (re)connect
+    // (0 = wait indefinitely)
+    std::chrono::seconds connect_timeout{5};
+    // Idle connections older than this are pinged before checkout
+    std::chrono::milliseconds validate_after_idle{30000};
+
+    /**
+     * Build config from KITHLY_DB_* environment variables
+     */
+    static DbConfig from_env();
+};
+
+/**
+ * Connection Pool
+ * Fixed number of slots, connected lazily on first checkout and
+ * reconnected transparently when a connection goes bad.
+ */
+class ConnectionPool {
+public:
+    /**
+     * Per-connection setup (e.g. PQprepare) run after every connect or
+     * reset, since server-side session state does not survive either.
+     */
+    using Initializer = std::function<bool(PGconn*)>;
+
+    /**
+     * RAII checkout - returns the connection to the pool on destruction
+     */
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        PGconn* get() const { return conn_; }
+        explicit operator bool() const { return conn_ != nullptr; }
+
+        /**
+         * Mark the connection as unusable; it is closed on return and
+         * the slot reconnects on its next checkout.
+         */
+        void invalidate() { broken_ = true; }
+
+    private:
+        friend class ConnectionPool;
+        Lease(ConnectionPool* pool, std::size_t slot, PGconn* conn)
+            : pool_(pool), slot_(slot), conn_(conn) {}
+
+        void release();
+
+        ConnectionPool* pool_ = nullptr;
+        std::size_t slot_ = 0;
+        PGconn* conn_ = nullptr;
+        bool broken_ = false;
+    };
+
+    explicit ConnectionPool(const DbConfig& config);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    /**
+     * Check out a healthy connection.
+     * Blocks up to acquire_timeout; returns an empty Lease if the pool is
+     * exhausted, the waiter cap is reached or the database is unreachable.
+     */
+    Lease acquire();
+
+    /**
+     * Install the per-connection initializer.
+     * Connections already open are initialized on their next checkout.
+     */
+    void set_initializer(Initializer initializer);
+
+    /**
+     * Open a connection outside the pool, for session-scoped work such
+     * as LISTEN that must not leak to other leases. Caller must PQfinish.
+     *
+     * @return nullptr if the database is unreachable
+     */
+    PGconn* open_dedicated() const { return connect(); }
+
+    std::size_t size() const { return slots_.size(); }
+    std::size_t idle() const;
+    std::size_t waiters() const;
+
+private:
+    struct Slot {
+        PGconn* conn = nullptr;
+        std::chrono::steady_clock::time_point returned_at;
+        uint64_t initialized_generation = 0;
+    };
+
+    DbConfig config_;
+    Initializer initializer_;
+    uint64_t initializer_generation_ = 0;
+    std::vector<Slot> slots_;
+    std::vector<std::size_t> idle_;   // LIFO: reuse the warmest connection
+    int waiters_ = 0;
+    mutable std::mutex mutex_;
+    std::condition_variable available_;
+
+    PGconn* connect() const;
+    bool ensure_healthy(Slot& slot) const;
+    bool ensure_initialized(Slot& slot, const Initializer& initializer, uint64_t generation);
+    void give_back(std::size_t slot, bool broken);
+};
+
+} // namespace db
+} // namespace kithly
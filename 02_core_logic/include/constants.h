@@ -28,4 +28,27 @@ enum Status {
     COMPLETED        = 400    // ZRA verified delivery
 };
 
+// Extended status codes (escalation, Baker's Protocol, failure)
+constexpr int ALT_FOUND = 106;                 // Reroute accepted by an alternative shop
+constexpr int AWAITING_SHOP_ACCEPTANCE = 110;
+constexpr int FORCE_CALL_PENDING = 305;
+constexpr int REROUTING = 315;
+constexpr int KEY_VERIFIED = 350;
+constexpr int HELD_FOR_REVIEW = 800;
+constexpr int EXPIRED = 900;
+constexpr int DECLINED = 910;
+
+// Escalation thresholds
+constexpr int FORCE_CALL_THRESHOLD_MINS = 5;
+constexpr int REROUTE_THRESHOLD_MINS = 10;
+constexpr int ESCROW_TIMEOUT_HOURS = 48;
+constexpr int SHOP_ACCEPTANCE_HOURS = 2;
+
+// Idempotency keys are remembered in memory for this long; older keys
+// are still caught by the UNIQUE constraint on Global_Gifts
+constexpr int IDEMPOTENCY_WINDOW_HOURS = 24;
+
+// Shop-local time for Operating_Hours (Lusaka, CAT = UTC+2, no DST)
+constexpr int SERVICE_UTC_OFFSET_MINS = 120;
+
 } // namespace Kithly
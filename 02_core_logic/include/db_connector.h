@@ -7,10 +7,22 @@
 
 #pragma once
 
+#include "connection_pool.h"
+#include "structs.h"
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 namespace Kithly {
 
+using DbLease = kithly::db::ConnectionPool::Lease;
+
 /**
  * Update the status_code for a transaction in Global_Gifts
  * 
@@ -20,14 +32,217 @@ namespace Kithly {
  */
 bool update_status(const std::string& uuid, int new_status);
 
+/**
+ * (tx_id, new_status) pair for bulk transitions
+ */
+using StatusUpdate = std::pair<std::string, int>;
+
+/**
+ * Apply a batch of status transitions in a single round-trip
+ * 
+ * @param updates Pairs of transaction UUID and new status; tx_ids should
+ *        be unique within a batch
+ * @return per-row outcome in input order (true = row updated); all false
+ *         if the statement failed
+ */
+std::vector<bool> bulk_update_status(const std::vector<StatusUpdate>& updates);
+
+/**
+ * Guarded transition: only applies while the row is still in from_status
+ */
+struct StatusTransition {
+    std::string tx_id;
+    int from_status;
+    int to_status;
+};
+
+/**
+ * Apply a batch of compare-and-set transitions in a single round-trip
+ * 
+ * @return per-row outcome in input order (false = row missing or no
+ *         longer in from_status)
+ */
+std::vector<bool> bulk_transition_status(const std::vector<StatusTransition>& transitions);
+
+/**
+ * Outcome of one bulk_transition_with_outbox row
+ */
+struct OutboxedTransition {
+    bool applied = false;
+    int64_t outbox_id = 0;       // Gateway_Event_Outbox.event_id
+    std::string payment_ref;     // Global_Gifts.stripe_payment_ref ("" if none)
+};
+
+/**
+ * bulk_transition_status that also writes a Gateway_Event_Outbox row of
+ * event_type for every gift that moved, in the same statement, so the
+ * transition and its money-moving event commit together. The rows are
+ * leased for `lease`; publish them with their outbox_id (see
+ * transition_with_event in gateway_events.h).
+ *
+ * @return per-row outcome in input order
+ */
+std::vector<OutboxedTransition> bulk_transition_with_outbox(
+    const std::vector<StatusTransition>& transitions,
+    const char* event_type,
+    std::chrono::seconds lease);
+
+/**
+ * Observer for committed status changes (tx_id, new_status).
+ * Called on the committing thread; must be cheap and thread-safe.
+ */
+using TransitionListener = std::function<void(const std::string&, int)>;
+
+/**
+ * Install (or clear, with nullptr) the transition observer
+ */
+void set_transition_listener(TransitionListener listener);
+
+/**
+ * Outcome of an idempotent gift INSERT
+ */
+enum class GiftWrite {
+    INSERTED,
+    DUPLICATE,   // idempotency_key already committed (possibly by a peer)
+    INVALID,     // payload rejected, here or by the database (bad data, constraint)
+    FAILED       // database unavailable or transient error; retry
+};
+
+/**
+ * Idempotency lookup against Global_Gifts
+ * 
+ * @return true if a gift with this key is committed, false if not,
+ *         std::nullopt on database error
+ */
+std::optional<bool> gift_exists(std::string_view idempotency_key);
+
+/**
+ * Pipelined idempotency lookups: every query streams out over one
+ * connection, so the batch costs about one round trip
+ * 
+ * @return per-key outcome in input order (std::nullopt = lookup failed)
+ */
+std::vector<std::optional<bool>> gifts_exist(const std::vector<std::string_view>& idempotency_keys);
+
+/**
+ * Insert an ESCROW_LOCKED (200) gift row for a queued payload
+ * 
+ * @param payload The parsed ingestion payload
+ * @param handshake_token Token stored in handshake_jwt
+ */
+GiftWrite insert_gift(const GiftPayloadView& payload, std::string_view handshake_token);
+GiftWrite insert_gift(const GiftPayload& payload, const std::string& handshake_token);
+
+/**
+ * Pipelined insert_gift for a batch. Each row runs in its own implicit
+ * transaction, so one failing INSERT does not roll back its neighbours.
+ * 
+ * @param handshake_tokens One token per payload
+ * @return per-row outcome in input order
+ */
+std::vector<GiftWrite> insert_gifts(const std::vector<GiftPayloadView>& payloads,
+                                    const std::vector<std::string_view>& handshake_tokens);
+
+/**
+ * Shop a gift is currently routed to, for a reroute fan-out
+ * 
+ * @return shop_id, "" if the gift is missing or opted out of reroutes,
+ *         std::nullopt on database error
+ */
+std::optional<std::string> find_reroute_origin(const std::string& tx_id);
+
+/**
+ * Offer a declined gift to one alternative shop (a shadow lock that
+ * lapses after ttl)
+ * 
+ * @return false if the offer was not written
+ */
+bool offer_reroute(const std::string& tx_id, const std::string& shop_id,
+                   double distance_km, std::chrono::minutes ttl);
+
+/**
+ * Outcome of a shop accepting a reroute offer
+ */
+enum class RerouteClaim {
+    WON,      // Gift moved to ALT_FOUND (106) with this shop
+    LOST,     // Another shop won, the offer lapsed, or the gift moved on
+    FAILED    // Database unavailable or statement error
+};
+
+/**
+ * First-accept-wins claim of a reroute offer
+ * 
+ * @param released Filled with the sibling shops whose offers were released
+ */
+RerouteClaim claim_reroute(const std::string& tx_id, const std::string& shop_id,
+                           std::vector<std::string>& released);
+
+/**
+ * Take the fan-out lease on a declined gift, so only one node offers it.
+ * Each lease taken counts as one round.
+ * 
+ * @return false if another node holds it, the gift moved on, it already
+ *         ran max_rounds, or on error
+ */
+bool lease_reroute_fanout(const std::string& tx_id, std::chrono::minutes ttl, int max_rounds);
+
+/**
+ * Release up to limit offers whose window lapsed
+ * 
+ * @return (tx_id, shop_id) per released offer, std::nullopt on error
+ */
+std::optional<std::vector<std::pair<std::string, std::string>>> release_lapsed_reroute_offers(int limit);
+
+/**
+ * Declined gifts with no open offer that no node is leasing
+ * 
+ * @return (tx_id, rounds run so far) pairs (empty on error)
+ */
+std::vector<std::pair<std::string, int>> find_idle_reroutes(int limit);
+
+/**
+ * Outcome of recording a delivery proof
+ */
+enum class ProofWrite {
+    INSERTED,
+    DUPLICATE,   // Same receipt_hash, or this proof_type already recorded for the gift
+    NOT_FOUND,   // No such gift (or its shop row is missing)
+    INVALID,     // Malformed tx_id / uploaded_by
+    FAILED       // Database unavailable or statement error
+};
+
+/**
+ * Insert the Delivery_Proofs row for a stored evidence object; tpin,
+ * bhf_id and vsdc_serial are taken from the gift's current shop.
+ * NaN latitude/longitude and empty device_info/uploaded_by are NULL.
+ *
+ * @param proof tx_id, proof_type, file_url, receipt_hash, file_size and
+ *              metadata in; proof_id out. On DUPLICATE, proof_id,
+ *              file_url and receipt_hash are replaced by the existing
+ *              row's (proof_id stays empty if it is not yet visible).
+ */
+ProofWrite insert_delivery_proof(Evidence& proof);
+
 /**
  * Initialize database connection
  * Uses environment variables or defaults to local 'kithly' database
  */
 bool init_db_connection();
 
+/**
+ * Initialize with an existing pool (shared with the worker node)
+ */
+bool init_db_connection(std::shared_ptr<kithly::db::ConnectionPool> pool);
+
+/**
+ * Check out a pooled connection for direct libpq use.
+ * Empty lease if no pool is installed or none is available.
+ */
+DbLease acquire_db_connection();
+
 /**
  * Close database connection
+ * Must not be called while leases are still checked out.
  */
 void close_db_connection();
 
@@ -0,0 +1,136 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * deadline_scheduler.h - Event-driven Escalation Deadlines (Timing Wheel)
+ * =============================================================================
+ *
+ * Every transition that starts a clock schedules its deadline here:
+ *   300 → 305  after 5 min   (force call)
+ *   305 → 315  after 10 min  (reroute)
+ *   200 → 900  at expiry_timestamp (48h escrow)
+ *   110 → 910  at acceptance_deadline (2h, Baker's Protocol)
+ *
+ * Deadlines live in a 4-level hierarchical timing wheel (64 slots per
+ * level, 1s ticks, ~194 days of range): insert and fire are O(1)
+ * amortised. A newer transition on the same tx_id supersedes any pending
+ * deadline lazily via a per-tx generation token.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Kithly {
+
+using Clock = std::chrono::system_clock;
+
+/**
+ * A pending status deadline
+ */
+struct Deadline {
+    std::string tx_id;
+    int from_status;     // Status the tx must still be in when it fires
+    int to_status;       // Escalation target
+    uint64_t due_tick;   // Seconds since epoch
+    uint64_t generation; // Matches the tx's token unless superseded
+};
+
+/**
+ * Hierarchical Timing Wheel
+ * Not thread-safe; DeadlineScheduler serialises access.
+ */
+class TimerWheel {
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr uint64_t SLOTS = 1u << SLOT_BITS;
+
+    explicit TimerWheel(uint64_t start_tick) : current_(start_tick) {}
+
+    /**
+     * Insert a deadline; overdue ones fire on the next tick
+     */
+    void schedule(Deadline deadline);
+
+    /**
+     * Process every tick up to and including now_tick,
+     * appending due deadlines to fired
+     */
+    void advance(uint64_t now_tick, std::vector<Deadline>& fired);
+
+    std::size_t size() const { return size_; }
+    uint64_t current_tick() const { return current_; }
+
+private:
+    std::array<std::array<std::vector<Deadline>, SLOTS>, LEVELS> slots_;
+    uint64_t current_;   // Next tick to process
+    std::size_t size_ = 0;
+
+    void cascade(int level);
+};
+
+/**
+ * Deadline Scheduler
+ * Owns the wheel and a 1 Hz driver thread; fired batches go to handler.
+ */
+class DeadlineScheduler {
+public:
+    using FireHandler = std::function<void(std::vector<Deadline>&)>;
+
+    explicit DeadlineScheduler(FireHandler handler);
+    ~DeadlineScheduler();
+
+    DeadlineScheduler(const DeadlineScheduler&) = delete;
+    DeadlineScheduler& operator=(const DeadlineScheduler&) = delete;
+
+    /**
+     * Record a transition: supersedes the tx's pending deadline and
+     * schedules the next one for new_status (if that status has a clock).
+     *
+     * @param changed_at When the status was entered
+     * @param explicit_deadline For 200/110, the stored expiry/acceptance
+     *        deadline; defaults to changed_at + the protocol window
+     */
+    void on_transition(const std::string& tx_id, int new_status,
+                       Clock::time_point changed_at = Clock::now(),
+                       std::optional<Clock::time_point> explicit_deadline = std::nullopt);
+
+    /**
+     * Reload every open clock (110/200/300/305) from Global_Gifts.
+     * Streams rows with single-row mode; call once before start().
+     *
+     * @return number of deadlines scheduled, or -1 on database error
+     */
+    int rebuild_from_database();
+
+    void start();
+    void stop();
+
+    std::size_t pending() const;
+
+private:
+    FireHandler handler_;
+    TimerWheel wheel_;
+    std::unordered_map<std::string, uint64_t> generations_;
+    uint64_t next_generation_ = 1;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> running_{false};
+    std::thread driver_;
+
+    void run();
+};
+
+} // namespace Kithly
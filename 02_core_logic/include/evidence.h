@@ -0,0 +1,200 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * evidence.h - Streaming Delivery Proof Ingestion
+ * =============================================================================
+ *
+ * A delivery photo is never held in memory. The body is moved from the
+ * client socket into a staging file through a pipe (splice, zero-copy),
+ * tee'd once so the same pages can be read back into a fixed 64 KB buffer
+ * and fed to the incremental SHA-256 (sha256.h). Memory per upload is one
+ * chunk buffer and two pipes, whatever the photo size.
+ *
+ * The staged file is then stored content-addressed under its hash
+ * (<root>/<ab>/<receipt_hash>) and the Delivery_Proofs row is inserted
+ * with the shop's ZRA identifiers (INSERT_DELIVERY_PROOF).
+ *
+ * Uploads arrive as
+ *     PUT /evidence/<tx_id>/<proof_type>
+ *     Content-Length: <bytes>            (required; no chunked bodies)
+ *     Content-Type: image/jpeg
+ *     X-Internal-Key, X-Uploaded-By, X-Latitude, X-Longitude, X-Device-Info
+ */
+
+#pragma once
+
+#include "sha256.h"
+#include "structs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Kithly {
+namespace evidence {
+
+constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+
+enum class IngestResult {
+    STORED,
+    DUPLICATE,       // Same photo, or this proof_type already recorded for the gift
+    NOT_FOUND,       // No such gift (or its shop is missing)
+    INVALID,         // Malformed tx_id / proof_type / metadata
+    TOO_LARGE,       // Content-Length over the configured limit
+    TRUNCATED,       // Client sent fewer bytes than announced (or timed out)
+    STORAGE_FAILED,  // Staging, fsync or rename failed
+    DB_FAILED        // Database unavailable or statement error
+};
+
+const char* ingest_result_name(IngestResult result);
+
+// =============================================================================
+// CONTENT-ADDRESSED OBJECT STORE
+// =============================================================================
+
+/**
+ * Local (or mounted) object store. Objects are written to <root>/.staging
+ * and renamed into place once their hash is known, so a reader never sees
+ * a partial object and identical photos share one file.
+ */
+class ObjectStore {
+public:
+    /**
+     * @param base_url Prefix for photo_url (e.g. a CDN in front of root);
+     *                 empty stores file:// URLs
+     */
+    ObjectStore(std::string root, std::string base_url);
+
+    /**
+     * Create root and the staging directory
+     */
+    bool open();
+
+    struct Staged {
+        int fd = -1;
+        std::string path;
+    };
+
+    std::optional<Staged> stage();
+
+    /**
+     * fsync, close and rename the staged file to its content address
+     *
+     * @return photo_url of the stored object
+     */
+    std::optional<std::string> commit(Staged& staged, const std::string& receipt_hash);
+
+    /**
+     * Close and unlink a staged file that will not be committed
+     */
+    void discard(Staged& staged);
+
+private:
+    std::string root_;
+    std::string staging_;
+    std::string base_url_;
+
+    std::string object_path(const std::string& receipt_hash) const;
+};
+
+// =============================================================================
+// INGESTION
+// =============================================================================
+
+/**
+ * Copy exactly `length` bytes from src_fd to dst_fd, hashing them on the
+ * way. `prefix` holds body bytes already read with the request headers;
+ * they are written and hashed first and count towards `length`.
+ *
+ * @return IngestResult::STORED on success, TRUNCATED if src ended or
+ *         timed out early, STORAGE_FAILED if dst could not be written
+ */
+IngestResult stream_copy(int src_fd, int dst_fd, std::string_view prefix,
+                         uint64_t length, Sha256& hasher);
+
+class EvidenceIngestor {
+public:
+    struct Options {
+        std::string root = "/var/lib/kithly/evidence";
+        std::string base_url;
+        uint64_t max_bytes = 20 * 1024 * 1024;
+    };
+
+    explicit EvidenceIngestor(Options options);
+
+    bool open() { return store_.open(); }
+
+    /**
+     * Stream one upload into the store and record it in Delivery_Proofs.
+     *
+     * @param proof Metadata in (tx_id, proof_type, mime_type, location,
+     *              device_info, uploaded_by); on STORED / DUPLICATE,
+     *              proof_id, receipt_hash, file_url and file_size out
+     */
+    IngestResult ingest(Evidence& proof, int src_fd, std::string_view prefix,
+                        uint64_t content_length);
+
+    const Options& options() const { return options_; }
+
+private:
+    Options options_;
+    ObjectStore store_;
+};
+
+// =============================================================================
+// HTTP ENDPOINT
+// =============================================================================
+
+/**
+ * Embedded PUT endpoint in front of an EvidenceIngestor. One acceptor
+ * thread hands connections to a fixed set of handlers; when every
+ * handler is busy and the backlog is full, uploads get 503 instead of
+ * queueing unbounded memory.
+ */
+class EvidenceServer {
+public:
+    struct Options {
+        int port = 9470;
+        std::size_t handlers = 8;
+        std::size_t max_pending = 64;
+        std::string internal_key;   // X-Internal-Key; empty = loopback bind only
+    };
+
+    EvidenceServer(EvidenceIngestor& ingestor, Options options);
+    ~EvidenceServer();
+
+    EvidenceServer(const EvidenceServer&) = delete;
+    EvidenceServer& operator=(const EvidenceServer&) = delete;
+
+    /**
+     * @return false if the port could not be bound
+     */
+    bool start();
+    void stop();
+
+private:
+    EvidenceIngestor& ingestor_;
+    Options options_;
+    int listen_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread acceptor_;
+    std::vector<std::thread> handlers_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<int> pending_;
+
+    void accept_loop();
+    void handler_loop();
+    void serve(int client_fd);
+};
+
+} // namespace evidence
+} // namespace Kithly
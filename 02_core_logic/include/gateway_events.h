@@ -0,0 +1,198 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * gateway_events.h - Write-behind Gateway Event Stream (Redis Streams)
+ * =============================================================================
+ *
+ * Transitions that need a Gateway side effect (force call, shop
+ * notification, ZRA fiscalization, disbursement, reroute offers) publish a
+ * GatewayEvent here instead of calling the Gateway over HTTP. publish()
+ * only appends to an in-memory buffer; a flusher thread XADDs the buffer
+ * to kithly:events:gateway in pipelined batches.
+ *
+ * Before each flush, repeats of the same (type, tx_id, shop_id) are
+ * coalesced: only the latest copy is sent, in the position of that copy.
+ * For example, a force call raised by both the sweep and the timing wheel
+ * is sent once.
+ *
+ * Delivery is at-least-once from the moment XADD succeeds. The Gateway
+ * reads through a consumer group (03_gateway/event_consumer.py), acks
+ * after its handler succeeds, and reclaims entries a crashed consumer left
+ * pending. Handlers must therefore be idempotent on (type, tx_id). When
+ * Redis is unreachable the buffer is retried with backoff, up to
+ * max_buffered events; beyond that new events are dropped and counted.
+ *
+ * Other events still buffered when the process dies are lost. Refunds
+ * and disbursements move money, so they have a row in
+ * Gateway_Event_Outbox (018_gateway_event_outbox.sql) that the flusher
+ * deletes once the XADD succeeds. transition_with_event() writes that
+ * row in the same statement as the status change; publish() writes one
+ * for a durable event that arrives without it. A row left behind (the
+ * node died, or the buffer was full) is re-sent by whichever node's
+ * flusher claims it after its lease lapses.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Kithly {
+
+struct StatusTransition;
+struct OutboxedTransition;
+
+/**
+ * Redis Stream the Gateway's consumer group reads
+ */
+constexpr const char* GATEWAY_EVENT_STREAM = "kithly:events:gateway";
+
+/**
+ * Gateway side effects, one per internal endpoint they replace
+ */
+enum class GatewayEventType {
+    FORCE_CALL,               // POST /internal/force-call
+    REROUTE,                  // POST /internal/reroute
+    NOTIFY_SHOP,              // POST /internal/notify-shop
+    REFUND,                   // POST /internal/refund
+    TRIGGER_ZRA,              // POST /verification/trigger-zra
+    TRIGGER_DISBURSEMENT,     // POST /verification/trigger-disbursement
+    REROUTE_OFFER,            // POST /internal/reroute-offer
+    REROUTE_OFFER_WITHDRAWN   // POST /internal/reroute-offer-withdrawn
+};
+
+/**
+ * Wire name of the event's "type" field, e.g. "force_call"
+ */
+const char* event_type_name(GatewayEventType type);
+
+/**
+ * true for the types that also go through the durable outbox
+ */
+bool is_durable_event(GatewayEventType type);
+
+/**
+ * One outbound event
+ */
+struct GatewayEvent {
+    GatewayEventType type;
+    std::string tx_id;
+    int status = 0;               // Status the transition entered (0 = n/a)
+    std::string shop_id;          // Empty when the event is not shop-specific
+    std::string payment_ref;      // REFUND only
+    int64_t at_ms = 0;            // Unix ms; set by publish() when 0
+    int64_t outbox_id = 0;        // Gateway_Event_Outbox row (0 = none)
+};
+
+/**
+ * Buffered XADD publisher with a single flusher thread
+ */
+class GatewayEventStream {
+public:
+    struct Options {
+        std::string stream = GATEWAY_EVENT_STREAM;
+        // Upper bound on XADDs per pipelined round trip
+        std::size_t max_batch = 256;
+        // Longest an event waits in the buffer before a flush
+        std::chrono::milliseconds flush_interval{5};
+        // Approximate MAXLEN cap on the stream (0 = uncapped)
+        long long max_length = 1000000;
+        // Events held while Redis is down; later ones are dropped
+        std::size_t max_buffered = 100000;
+        // Outbox durable types publish()ed without a row, and replay
+        // lapsed rows (needs the DB pool)
+        bool durable_outbox = true;
+        // How long a row is left to its node before any node re-sends it
+        std::chrono::seconds outbox_lease{300};
+        std::chrono::seconds outbox_replay_interval{30};
+    };
+
+    struct Stats {
+        uint64_t published = 0;   // Events accepted by publish()
+        uint64_t coalesced = 0;   // Events replaced by a later repeat
+        uint64_t appended = 0;    // Entries XADDed to the stream
+        uint64_t dropped = 0;     // Events refused because the buffer was full
+        uint64_t outboxed = 0;    // Durable events written to the outbox
+        uint64_t replayed = 0;    // Outbox rows re-sent after their lease lapsed
+    };
+
+    explicit GatewayEventStream(std::string redis_uri);
+    GatewayEventStream(std::string redis_uri, Options options);
+    ~GatewayEventStream();
+
+    GatewayEventStream(const GatewayEventStream&) = delete;
+    GatewayEventStream& operator=(const GatewayEventStream&) = delete;
+
+    /**
+     * Buffer an event without blocking on Redis (a durable one first
+     * takes one INSERT into the outbox)
+     *
+     * @return false if the buffer was full and the event was dropped; a
+     *         durable event with an outbox row is kept there instead
+     */
+    bool publish(GatewayEvent event);
+
+    void start();
+
+    /**
+     * Flush whatever is buffered (one last attempt) and join the flusher
+     */
+    void stop();
+
+    Stats stats() const;
+    const Options& options() const { return options_; }
+
+private:
+    std::string redis_uri_;
+    Options options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<GatewayEvent> buffer_;
+    std::size_t retained_ = 0;    // Events the flusher holds for retry
+    bool stopping_ = false;
+    std::thread flusher_;
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> appended_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<uint64_t> outboxed_{0};
+    std::atomic<uint64_t> replayed_{0};
+
+    void run();
+};
+
+/**
+ * Node-wide stream used by publish_gateway_event(); nullptr uninstalls
+ */
+void install_gateway_events(std::shared_ptr<GatewayEventStream> stream);
+std::shared_ptr<GatewayEventStream> installed_gateway_events();
+
+/**
+ * Publish on the installed stream. Every event is also logged under
+ * [GATEWAY]. Without an installed stream (tools, tests) the log line is
+ * the only output.
+ */
+void publish_gateway_event(GatewayEventType type, const std::string& tx_id, int status = 0,
+                           const std::string& shop_id = "", const std::string& payment_ref = "");
+
+/**
+ * Apply compare-and-set transitions and, for each gift that moved,
+ * publish the durable event `type` (REFUND, TRIGGER_DISBURSEMENT). The
+ * outbox row commits with the transition (bulk_transition_with_outbox),
+ * and the event carries the gift's stored stripe_payment_ref.
+ *
+ * @return per-row outcome in input order
+ */
+std::vector<OutboxedTransition> transition_with_event(GatewayEventType type,
+                                                      const std::vector<StatusTransition>& transitions);
+
+} // namespace Kithly
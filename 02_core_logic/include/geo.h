@@ -0,0 +1,109 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * geo.h - Shared Distance Kernels (SoA, SIMD)
+ * =============================================================================
+ *
+ * Points are stored once as unit vectors on the sphere (x, y, z), in
+ * structure-of-arrays form. The chord between two unit vectors needs
+ * three subtractions and three multiply-adds, no trigonometry:
+ *
+ *     chord² = |a - b|²             distance = 2R · asin(chord / 2)
+ *
+ * chord² is monotonic in great-circle distance, so ranking and radius
+ * filtering run entirely on chord² with AVX2 (4 lanes) or NEON (2 lanes);
+ * asin is paid only for the distances a caller actually reports.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace Kithly {
+namespace geo {
+
+constexpr double EARTH_RADIUS_KM = 6371.0;
+
+/**
+ * A point pre-converted to its unit vector
+ */
+struct UnitVector {
+    double x, y, z;
+};
+
+UnitVector to_unit(double lat_deg, double lon_deg);
+
+/**
+ * Chord² ↔ kilometers
+ */
+double chord2_to_km(double chord2);
+double km_to_chord2(double km);
+
+/**
+ * Scalar great-circle distance in kilometers
+ */
+double distance_km(double lat1, double lon1, double lat2, double lon2);
+
+/**
+ * Squared chord; the difference form keeps metre-scale precision
+ * where 2 - 2(a · b) would cancel
+ */
+inline double chord2(const UnitVector& a, const UnitVector& b) {
+    double dx = a.x - b.x;
+    double dy = a.y - b.y;
+    double dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+/**
+ * Candidate coordinates, SoA
+ */
+class PointSet {
+public:
+    void reserve(std::size_t n);
+    void clear();
+
+    /**
+     * @return index of the added point
+     */
+    std::size_t add(double lat_deg, double lon_deg);
+    void set(std::size_t i, const UnitVector& u);
+
+    std::size_t size() const { return x_.size(); }
+    UnitVector at(std::size_t i) const { return {x_[i], y_[i], z_[i]}; }
+
+    /**
+     * out[i] = chord² from origin to point i, for every point
+     */
+    void chord2_batch(const UnitVector& origin, double* out) const;
+
+    /**
+     * out[i] = great-circle km from origin to point i, for every point
+     */
+    void distances_km(const UnitVector& origin, double* out) const;
+
+    /**
+     * Indices of points within radius_km (exact, chord² threshold)
+     */
+    std::vector<std::size_t> within(const UnitVector& origin, double radius_km) const;
+
+    /**
+     * Index of the point closest to origin, skipping those with
+     * skip[i] set (may be nullptr); size() if none qualifies
+     */
+    std::size_t nearest(const UnitVector& origin, const std::vector<bool>* skip = nullptr) const;
+
+private:
+    std::vector<double> x_, y_, z_;
+};
+
+/**
+ * Name of the kernel in use ("avx2", "neon" or "scalar"). On x86-64
+ * builds without -mavx2 the AVX2/FMA kernel is picked at first use from
+ * the host CPU.
+ */
+const char* simd_backend();
+
+} // namespace geo
+} // namespace Kithly
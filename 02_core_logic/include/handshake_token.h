@@ -0,0 +1,45 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE ORCHESTRATOR
+ * handshake_token.h - Per-Thread CSPRNG Handshake Tokens
+ * =============================================================================
+ *
+ * Handshake tokens (XXXX-XXXX) gate a physical pickup, so they must be
+ * unpredictable. Bytes come from the kernel CSPRNG (getrandom(2)), read
+ * in blocks into a per-thread buffer; no seeding, no shared state.
+ *
+ * The alphabet has exactly 32 symbols, so each symbol is 5 uniformly
+ * random bits: rejection sampling never rejects, and a token costs 5
+ * random bytes. Each thread keeps a pool of pre-generated tokens that is
+ * refilled in one batch when it runs dry.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace Kithly {
+namespace Orchestrator {
+
+// 8 symbols + hyphen, not NUL-terminated
+constexpr std::size_t HANDSHAKE_TOKEN_LEN = 9;
+
+using HandshakeToken = char[HANDSHAKE_TOKEN_LEN];
+
+/**
+ * Write one token from the calling thread's pool
+ *
+ * @throws std::system_error if the kernel CSPRNG is unavailable
+ */
+void generate_handshake_token(HandshakeToken& out);
+
+/**
+ * Fill `count` tokens from one block of random bytes (pool refill, bulk
+ * issuance)
+ *
+ * @throws std::system_error if the kernel CSPRNG is unavailable
+ */
+void generate_handshake_tokens(HandshakeToken* out, std::size_t count);
+
+} // namespace Orchestrator
+} // namespace Kithly
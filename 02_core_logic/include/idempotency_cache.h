@@ -0,0 +1,398 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * idempotency_cache.h - Lock-Striped Caches for the Idempotency Guard
+ * =============================================================================
+ *
+ * ShardedClockCache: fixed-capacity, TTL-bounded cache. Keys hash to one
+ * of N independently locked shards; each shard evicts with the CLOCK
+ * (second-chance) policy, so memory is capped no matter how long the
+ * idempotency window is.
+ *
+ * ReservationTable: in-flight key reservations with a fixed TTL, each
+ * tagged with its owner token. Because the TTL is constant, expiry order
+ * equals insertion order, and a reaper thread pops expired keys from the
+ * front of a per-shard FIFO, so reserve() never walks the table.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace kithly {
+namespace idempotency {
+
+using SteadyClock = std::chrono::steady_clock;
+
+/**
+ * Counters exported by both structures (monotonic, relaxed)
+ */
+struct CacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    std::size_t size = 0;
+};
+
+// =============================================================================
+// SHARDED CLOCK CACHE
+// =============================================================================
+
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedClockCache {
+public:
+    /**
+     * @param capacity Total entries across all shards
+     * @param ttl Entries older than this are treated as absent
+     * @param shards Lock stripes (rounded up to a power of two)
+     */
+    ShardedClockCache(std::size_t capacity, SteadyClock::duration ttl, std::size_t shards = 16)
+        : ttl_(ttl) {
+        std::size_t n = 1;
+        while (n < shards) {
+            n <<= 1;
+        }
+        mask_ = n - 1;
+        std::size_t per_shard = std::max<std::size_t>(1, (capacity + n - 1) / n);
+        shards_.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            shards_.push_back(std::make_unique<Shard>(per_shard));
+        }
+    }
+
+    std::optional<Value> get(const Key& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        Slot& slot = shard.slots[it->second];
+        if (SteadyClock::now() - slot.inserted >= ttl_) {
+            shard.free(it->second);
+            shard.index.erase(it);
+            expirations_.fetch_add(1, std::memory_order_relaxed);
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        slot.referenced = true;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return slot.value;
+    }
+
+    void put(const Key& key, const Value& value) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            Slot& slot = shard.slots[it->second];
+            slot.value = value;
+            slot.inserted = SteadyClock::now();
+            slot.referenced = true;
+            return;
+        }
+
+        std::size_t index = shard.take_free();
+        if (index == Shard::NONE) {
+            index = evict(shard);
+        }
+
+        Slot& slot = shard.slots[index];
+        slot.key = key;
+        slot.value = value;
+        slot.inserted = SteadyClock::now();
+        slot.referenced = false;   // Earns its second chance on first hit
+        slot.occupied = true;
+        shard.index.emplace(key, index);
+    }
+
+    void erase(const Key& key) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.free(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+    CacheStats stats() const {
+        CacheStats s;
+        s.hits = hits_.load(std::memory_order_relaxed);
+        s.misses = misses_.load(std::memory_order_relaxed);
+        s.evictions = evictions_.load(std::memory_order_relaxed);
+        s.expirations = expirations_.load(std::memory_order_relaxed);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            s.size += shard->index.size();
+        }
+        return s;
+    }
+
+private:
+    struct Slot {
+        Key key{};
+        Value value{};
+        SteadyClock::time_point inserted;
+        bool referenced = false;
+        bool occupied = false;
+    };
+
+    struct Shard {
+        static constexpr std::size_t NONE = static_cast<std::size_t>(-1);
+
+        explicit Shard(std::size_t capacity) : slots(capacity) {
+            free_list.reserve(capacity);
+            for (std::size_t i = capacity; i-- > 0; ) {
+                free_list.push_back(i);
+            }
+            index.reserve(capacity);
+        }
+
+        std::size_t take_free() {
+            if (free_list.empty()) {
+                return NONE;
+            }
+            std::size_t i = free_list.back();
+            free_list.pop_back();
+            return i;
+        }
+
+        void free(std::size_t i) {
+            slots[i].occupied = false;
+            slots[i].value = Value{};
+            free_list.push_back(i);
+        }
+
+        mutable std::mutex mutex;
+        std::vector<Slot> slots;
+        std::vector<std::size_t> free_list;
+        std::unordered_map<Key, std::size_t, Hash> index;
+        std::size_t hand = 0;
+    };
+
+    /**
+     * CLOCK sweep: expired slots go first; referenced slots get one
+     * more lap. Terminates within two laps.
+     */
+    std::size_t evict(Shard& shard) {
+        const auto now = SteadyClock::now();
+        while (true) {
+            std::size_t i = shard.hand;
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+            Slot& slot = shard.slots[i];
+
+            bool expired = now - slot.inserted >= ttl_;
+            if (slot.referenced && !expired) {
+                slot.referenced = false;
+                continue;
+            }
+
+            shard.index.erase(slot.key);
+            (expired ? expirations_ : evictions_).fetch_add(1, std::memory_order_relaxed);
+            return i;
+        }
+    }
+
+    // Mix before masking: the shard's own map buckets on the same hash
+    Shard& shard_for(const Key& key) {
+        std::size_t h = Hash{}(key);
+        return *shards_[(h ^ (h >> 29)) & mask_];
+    }
+
+    SteadyClock::duration ttl_;
+    std::size_t mask_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> expirations_{0};
+};
+
+// =============================================================================
+// RESERVATION TABLE
+// =============================================================================
+
+template <typename Key, typename Hash = std::hash<Key>>
+class ReservationTable {
+public:
+    ReservationTable(SteadyClock::duration ttl, std::size_t shards = 16,
+                     SteadyClock::duration reap_interval = std::chrono::seconds(1))
+        : ttl_(ttl), reap_interval_(reap_interval) {
+        std::size_t n = 1;
+        while (n < shards) {
+            n <<= 1;
+        }
+        mask_ = n - 1;
+        shards_.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            shards_.push_back(std::make_unique<Shard>());
+        }
+        reaper_ = std::thread(&ReservationTable::reap_loop, this);
+    }
+
+    ~ReservationTable() {
+        {
+            std::lock_guard<std::mutex> lock(reaper_mutex_);
+            stopping_ = true;
+        }
+        reaper_wake_.notify_all();
+        reaper_.join();
+    }
+
+    ReservationTable(const ReservationTable&) = delete;
+    ReservationTable& operator=(const ReservationTable&) = delete;
+
+    /**
+     * @param owner Opaque owner token (e.g. a fencing token) stored with
+     *              the reservation; release() can be made conditional on it
+     * @return false if the key is already reserved and not yet expired
+     */
+    bool try_reserve(const Key& key, uint64_t owner = 0) {
+        Shard& shard = shard_for(key);
+        const auto now = SteadyClock::now();
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto it = shard.entries.find(key);
+        if (it != shard.entries.end()) {
+            if (now < it->second.deadline) {
+                contended_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            // Expired but not yet reaped: take it over
+            it->second = {now + ttl_, owner};
+        } else {
+            shard.entries.emplace(key, Entry{now + ttl_, owner});
+        }
+        shard.expiry_queue.emplace_back(now + ttl_, key);
+        return true;
+    }
+
+    /**
+     * Drop the reservation. With a non-zero owner, only if that owner
+     * still holds it (a stale holder cannot free a re-taken key).
+     *
+     * @return false if nothing was released
+     */
+    bool release(const Key& key, uint64_t owner = 0) {
+        Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        if (it == shard.entries.end() || (owner != 0 && it->second.owner != owner)) {
+            return false;
+        }
+        shard.entries.erase(it);
+        // The queue entry is now stale; the reaper skips it
+        return true;
+    }
+
+    /**
+     * Whether owner holds an unexpired reservation on key
+     */
+    bool holds(const Key& key, uint64_t owner) const {
+        const Shard& shard = shard_for(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.entries.find(key);
+        return it != shard.entries.end() && it->second.owner == owner &&
+               SteadyClock::now() < it->second.deadline;
+    }
+
+    /**
+     * Drop every reservation past its deadline. Runs on the reaper
+     * thread; public so callers can force a pass.
+     */
+    void reap() {
+        const auto now = SteadyClock::now();
+        for (auto& shard_ptr : shards_) {
+            Shard& shard = *shard_ptr;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            while (!shard.expiry_queue.empty() && shard.expiry_queue.front().first <= now) {
+                auto [deadline, key] = std::move(shard.expiry_queue.front());
+                shard.expiry_queue.pop_front();
+
+                // Only expire if this queue entry is still the live one
+                auto it = shard.entries.find(key);
+                if (it != shard.entries.end() && it->second.deadline == deadline) {
+                    shard.entries.erase(it);
+                    expired_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    CacheStats stats() const {
+        CacheStats s;
+        s.misses = contended_.load(std::memory_order_relaxed);
+        s.expirations = expired_.load(std::memory_order_relaxed);
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            s.size += shard->entries.size();
+        }
+        return s;
+    }
+
+private:
+    struct Entry {
+        SteadyClock::time_point deadline;
+        uint64_t owner;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, Entry, Hash> entries;
+        std::deque<std::pair<SteadyClock::time_point, Key>> expiry_queue;
+    };
+
+    void reap_loop() {
+        std::unique_lock<std::mutex> lock(reaper_mutex_);
+        while (!stopping_) {
+            reaper_wake_.wait_for(lock, reap_interval_, [this] { return stopping_; });
+            if (stopping_) {
+                break;
+            }
+            lock.unlock();
+            reap();
+            lock.lock();
+        }
+    }
+
+    // Mix before masking: the shard's own map buckets on the same hash
+    Shard& shard_for(const Key& key) const {
+        std::size_t h = Hash{}(key);
+        return *shards_[(h ^ (h >> 29)) & mask_];
+    }
+
+    SteadyClock::duration ttl_;
+    SteadyClock::duration reap_interval_;
+    std::size_t mask_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::atomic<uint64_t> contended_{0};
+    std::atomic<uint64_t> expired_{0};
+
+    std::mutex reaper_mutex_;
+    std::condition_variable reaper_wake_;
+    bool stopping_ = false;
+    std::thread reaper_;
+};
+
+} // namespace idempotency
+} // namespace kithly
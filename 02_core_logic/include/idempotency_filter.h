@@ -0,0 +1,119 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * idempotency_filter.h - Time-Windowed Bloom Filter over Idempotency Keys
+ * =============================================================================
+ *
+ * Almost every key IdempotencyGuard::check() sees is new, so the cold path
+ * (find_by_idempotency_key) almost always returns nothing. This filter
+ * answers "definitely never seen" without the round trip.
+ *
+ * The window (IDEMPOTENCY_WINDOW_HOURS) is split into G slices. There is
+ * one blocked Bloom filter per slice plus the current one; a key is added
+ * to the filter of the slice it was created in, a query ORs them all, and
+ * when the clock enters a new slice the oldest filter is cleared and
+ * reused. Every key therefore stays visible for at least the full window.
+ *
+ * Blocked: each key sets all its bits inside one 512-bit block (a single
+ * cache line), so an insert or query costs one cache miss per slice.
+ *
+ * Until seed_from_database() succeeds the filter is not ready() and must
+ * not be consulted. A "maybe" always falls through to the database; keys
+ * older than the window are still caught by the UNIQUE constraint on
+ * Global_Gifts.idempotency_key.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+namespace kithly {
+namespace idempotency {
+
+class IdempotencyFilter {
+public:
+    struct Options {
+        std::chrono::hours window{24};
+        std::size_t slices = 4;
+        // Keys expected per window; each slice is sized for window/slices
+        std::size_t expected_keys = 1000000;
+        double false_positive_rate = 0.01;   // Across all slices combined
+    };
+
+    IdempotencyFilter();
+    explicit IdempotencyFilter(Options options);
+
+    /**
+     * Record a key created at the given time (default: now).
+     * Keys older than the window are ignored.
+     */
+    void insert(const std::string& key);
+    void insert(const std::string& key, std::chrono::system_clock::time_point created_at);
+
+    /**
+     * @return false only if the key was definitely not inserted within
+     *         the window
+     */
+    bool may_contain(const std::string& key);
+
+    /**
+     * Insert every key created within the window from Global_Gifts and
+     * mark the filter ready. Streams rows (single-row mode).
+     *
+     * @return number of keys loaded, or -1 on database error
+     */
+    long seed_from_database();
+
+    bool ready() const { return ready_.load(std::memory_order_acquire); }
+
+    struct Stats {
+        uint64_t definite_misses = 0;   // DB lookups skipped
+        uint64_t maybe_hits = 0;        // Fell through to the DB
+        std::size_t bytes = 0;
+    };
+
+    Stats stats() const;
+
+private:
+    static constexpr std::size_t BLOCK_WORDS = 8;    // 8 x 64 = 512 bits
+    static constexpr unsigned BITS_PER_KEY = 8;
+
+    struct Slice {
+        int64_t epoch_slice = -1;                        // Which slice this holds
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+    };
+
+    Options options_;
+    std::chrono::seconds slice_length_;
+    std::size_t blocks_per_slice_;
+
+    // Ring of slices + 1 filters, indexed by epoch_slice % ring size
+    std::vector<Slice> ring_;
+    std::atomic<int64_t> current_slice_{-1};
+    mutable std::shared_mutex rotate_mutex_;   // Exclusive only to rotate
+
+    std::atomic<bool> ready_{false};
+    std::atomic<uint64_t> definite_misses_{0};
+    std::atomic<uint64_t> maybe_hits_{0};
+
+    int64_t slice_of(std::chrono::system_clock::time_point t) const;
+
+    /**
+     * Advance the ring to the slice containing now, clearing filters
+     * that fell out of the window
+     */
+    void rotate_to(int64_t now_slice);
+
+    void set_bits(Slice& slice, uint64_t hash);
+    bool test_bits(const Slice& slice, uint64_t hash) const;
+};
+
+} // namespace idempotency
+} // namespace kithly
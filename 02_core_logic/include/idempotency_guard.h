@@ -0,0 +1,177 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * idempotency_guard.h - Double-Spend Protection for Gift Ingestion
+ * =============================================================================
+ *
+ * Sits in front of gift_exists / gifts_exist on the ingestion path. A key
+ * this node has seen committed within the window is answered from a
+ * bounded ShardedClockCache (see idempotency_cache.h); everything else
+ * goes to Postgres. The INSERT's ON CONFLICT stays the final word, so a
+ * key the cache never saw (a peer node's, or one evicted) is still caught.
+ *
+ * With a seeded key filter (see idempotency_filter.h) a key the filter has
+ * definitely never seen is NEW without the round trip. Only this node's
+ * commits and the startup seed feed it, so a peer's recent key can read
+ * NEW; its INSERT then comes back DUPLICATE.
+ *
+ * With a reservation backend (see reservation_backend.h) a NEW key is
+ * also claimed before its INSERT, so two nodes never work the same key at
+ * once; the claim is committed or released with its fencing token.
+ */
+
+#pragma once
+
+#include "idempotency_cache.h"
+#include "idempotency_filter.h"
+#include "reservation_backend.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kithly {
+namespace idempotency {
+
+/**
+ * What the guard knows about an idempotency key
+ */
+enum class KeyState {
+    NEW,         // Not committed; go on and insert
+    DUPLICATE,   // Already committed
+    UNKNOWN      // Lookup failed; retry the job
+};
+
+class IdempotencyGuard {
+public:
+    static constexpr std::size_t DEFAULT_CACHE_CAPACITY = 100000;
+
+    /**
+     * @param cache_capacity Committed keys kept in memory (0 = none)
+     * @param reservations Cross-node claims (nullptr = none)
+     */
+    explicit IdempotencyGuard(std::size_t cache_capacity = DEFAULT_CACHE_CAPACITY,
+                              std::shared_ptr<ReservationBackend> reservations = nullptr);
+
+    IdempotencyGuard(const IdempotencyGuard&) = delete;
+    IdempotencyGuard& operator=(const IdempotencyGuard&) = delete;
+
+    /**
+     * Install a key filter (nullptr to remove). Call before serving
+     * traffic; it is consulted only once ready() (seeded).
+     */
+    void set_key_filter(std::shared_ptr<IdempotencyFilter> filter) { filter_ = std::move(filter); }
+    const std::shared_ptr<IdempotencyFilter>& key_filter() const { return filter_; }
+
+    KeyState check(std::string_view key);
+
+    /**
+     * check() for a batch; keys neither the cache nor the filter can
+     * answer share one pipelined round trip (gifts_exist)
+     *
+     * @return per-key state in input order
+     */
+    std::vector<KeyState> check_all(const std::vector<std::string_view>& keys);
+
+    /**
+     * Claim a NEW key before inserting it. Without a backend every key is
+     * granted with token 0.
+     *
+     * @return NEW (token set), DUPLICATE if another node committed it, or
+     *         UNKNOWN if another request holds it or the backend is
+     *         unreachable (fail closed; retry the job)
+     */
+    KeyState reserve(std::string_view key, uint64_t& token);
+
+    /**
+     * Record a key as committed (inserted here, or found to be a
+     * duplicate) and commit its reservation, if any
+     */
+    void committed(std::string_view key, uint64_t token = 0);
+
+    /**
+     * Drop a reservation whose INSERT did not commit
+     */
+    void release(std::string_view key, uint64_t token);
+
+    bool has_reservations() const { return reservations_ != nullptr; }
+
+    struct Stats {
+        CacheStats cache;
+        CacheStats reservations;  // Backend-specific, see reservation_backend.h
+    };
+
+    Stats stats() const;
+
+private:
+    bool cache_enabled_;
+    ShardedClockCache<std::string, bool> cache_;
+    std::shared_ptr<ReservationBackend> reservations_;
+    std::shared_ptr<IdempotencyFilter> filter_;
+
+    /**
+     * true if the filter is seeded and has definitely never seen key
+     */
+    bool definitely_new(std::string_view key) const;
+};
+
+/**
+ * RAII claim on one key: released on scope exit unless commit() ran
+ */
+class ReservationGuard {
+public:
+    ReservationGuard() = default;
+    ReservationGuard(std::shared_ptr<IdempotencyGuard> guard, std::string_view key, uint64_t token)
+        : guard_(std::move(guard)), key_(key), token_(token) {}
+
+    ReservationGuard(ReservationGuard&& other) noexcept
+        : guard_(std::move(other.guard_)), key_(std::move(other.key_)), token_(other.token_) {}
+    ReservationGuard& operator=(ReservationGuard&& other) noexcept {
+        if (this != &other) {
+            release();
+            guard_ = std::move(other.guard_);
+            key_ = std::move(other.key_);
+            token_ = other.token_;
+        }
+        return *this;
+    }
+    ReservationGuard(const ReservationGuard&) = delete;
+    ReservationGuard& operator=(const ReservationGuard&) = delete;
+
+    ~ReservationGuard() { release(); }
+
+    /**
+     * The key committed (inserted, or a peer's duplicate)
+     */
+    void commit() {
+        if (guard_) {
+            guard_->committed(key_, token_);
+            guard_.reset();
+        }
+    }
+
+    void release() {
+        if (guard_) {
+            guard_->release(key_, token_);
+            guard_.reset();
+        }
+    }
+
+private:
+    std::shared_ptr<IdempotencyGuard> guard_;
+    std::string key_;
+    uint64_t token_ = 0;
+};
+
+/**
+ * Install (or clear, with nullptr) the guard the ingestion path uses.
+ * Without one, every lookup goes straight to the database.
+ */
+void install_idempotency_guard(std::shared_ptr<IdempotencyGuard> guard);
+std::shared_ptr<IdempotencyGuard> installed_idempotency_guard();
+
+} // namespace idempotency
+} // namespace kithly
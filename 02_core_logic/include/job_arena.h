@@ -0,0 +1,99 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * job_arena.h - Per-Worker Monotonic Arena for the Ingestion Hot Path
+ * =============================================================================
+ *
+ * Each worker thread owns one JobArena: a std::pmr::monotonic_buffer_resource
+ * over a fixed inline buffer. Everything a job (or batch) builds that dies
+ * with it - the escrow_locked events and the LPUSH argument list - is
+ * allocated from the arena and dropped in one reset() afterwards, so
+ * steady-state ingestion does not touch malloc and worker threads stop
+ * contending on the allocator.
+ *
+ * If a batch outgrows the inline buffer the arena falls back to operator
+ * new; spills() counts those so the buffer size can be tuned.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+namespace Kithly {
+
+class JobArena {
+public:
+    static constexpr std::size_t INLINE_BYTES = 64 * 1024;
+
+    JobArena()
+        : arena_(buffer_.data(), buffer_.size(), &upstream_) {}
+
+    JobArena(const JobArena&) = delete;
+    JobArena& operator=(const JobArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &arena_; }
+
+    /**
+     * Drop everything allocated since the last reset and rewind to the
+     * start of the inline buffer. Nothing allocated from the arena may
+     * be used afterwards.
+     */
+    void reset() { arena_.release(); }
+
+    // Upstream (heap) allocations since construction
+    uint64_t spills() const { return upstream_.allocations; }
+
+private:
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        uint64_t allocations = 0;
+
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    alignas(std::max_align_t) std::array<std::byte, INLINE_BYTES> buffer_;
+    CountingResource upstream_;
+    std::pmr::monotonic_buffer_resource arena_;
+};
+
+/**
+ * The calling thread's arena (created on first use)
+ */
+inline JobArena& worker_arena() {
+    thread_local JobArena arena;
+    return arena;
+}
+
+/**
+ * Resets the arena when the job or batch scope ends. Declare it before
+ * anything allocated from the arena, so those are destroyed first.
+ * Scopes do not nest: the inner one would reset the outer one's data.
+ */
+class ArenaScope {
+public:
+    explicit ArenaScope(JobArena& arena) : arena_(arena) {}
+    ~ArenaScope() { arena_.reset(); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    std::pmr::memory_resource* resource() { return arena_.resource(); }
+
+private:
+    JobArena& arena_;
+};
+
+} // namespace Kithly
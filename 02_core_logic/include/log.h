@@ -0,0 +1,147 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * log.h - Asynchronous Structured Logging
+ * =============================================================================
+ *
+ * One JSON object per line:
+ *
+ *   {"ts":"2026-10-14T09:12:03.481220Z","level":"info","tag":"ORCHESTRATOR",
+ *    "msg":"Parsed gift","tx_id":"..."}
+ *
+ * A record is formatted on the caller's stack and copied into a bounded
+ * lock-free ring (one CAS per line); a background thread drains the ring
+ * and writes in large batches, info/debug to stdout and warn/error to
+ * stderr. Nothing on the hot path locks, flushes or allocates. When the
+ * ring is full the line is dropped and counted rather than blocking the
+ * caller; the drainer reports the count.
+ *
+ * Levels below KITHLY_LOG_MIN_LEVEL (0 debug .. 3 error; default info
+ * under NDEBUG, debug otherwise) compile away entirely, arguments
+ * included. KITHLY_LOG_LEVEL raises the threshold at runtime.
+ *
+ * Before start() and after stop() records are written synchronously, so
+ * tools that never start the drainer still get their output.
+ *
+ *   KITHLY_LOG_INFO("ORCHESTRATOR", "Parsed gift").field("tx_id", payload.tx_id);
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#ifndef KITHLY_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define KITHLY_LOG_MIN_LEVEL 1
+#else
+#define KITHLY_LOG_MIN_LEVEL 0
+#endif
+#endif
+
+namespace Kithly {
+namespace log {
+
+enum class Level : int {
+    DEBUG = 0,
+    INFO  = 1,
+    WARN  = 2,
+    ERROR = 3
+};
+
+constexpr Level COMPILED_MIN_LEVEL = static_cast<Level>(KITHLY_LOG_MIN_LEVEL);
+
+// Runtime threshold; relaxed, read once per log call
+inline std::atomic<int> runtime_level{static_cast<int>(COMPILED_MIN_LEVEL)};
+
+inline bool enabled(Level level) {
+    return static_cast<int>(level) >= runtime_level.load(std::memory_order_relaxed);
+}
+
+void set_level(Level level);
+
+/**
+ * One log line under construction. Fields are appended in call order;
+ * the line is submitted when the record is destroyed (end of the
+ * statement for the KITHLY_LOG_* macros). Values that do not fit are
+ * cut and the line is marked "truncated":true.
+ */
+class Record {
+public:
+    static constexpr std::size_t MAX_BYTES = 512;
+
+    Record(Level level, std::string_view tag, std::string_view message);
+    ~Record();
+
+    Record(const Record&) = delete;
+    Record& operator=(const Record&) = delete;
+
+    Record& field(std::string_view key, std::string_view value);
+    Record& field(std::string_view key, const char* value) {
+        return field(key, std::string_view(value ? value : ""));
+    }
+    Record& field(std::string_view key, bool value);
+    Record& field(std::string_view key, double value);
+
+    template <typename T, typename std::enable_if<std::is_integral<T>::value &&
+                                                  !std::is_same<T, bool>::value, int>::type = 0>
+    Record& field(std::string_view key, T value) {
+        if (std::is_signed<T>::value) {
+            return integer(key, static_cast<int64_t>(value));
+        }
+        return unsigned_integer(key, static_cast<uint64_t>(value));
+    }
+
+private:
+    char buffer_[MAX_BYTES];
+    std::size_t size_ = 0;
+    Level level_;
+    bool truncated_ = false;
+
+    Record& integer(std::string_view key, int64_t value);
+    Record& unsigned_integer(std::string_view key, uint64_t value);
+    bool raw(std::string_view text);
+    bool key(std::string_view name);
+    void quoted(std::string_view value);
+};
+
+/**
+ * True for one in every KITHLY_LOG_PAYLOAD_SAMPLE calls on this thread
+ * (default 100; 0 never, 1 always). Gates full-payload lines.
+ */
+bool sample_payload();
+
+/**
+ * Read KITHLY_LOG_LEVEL / KITHLY_LOG_PAYLOAD_SAMPLE and start the drainer
+ */
+void start();
+
+/**
+ * Drain whatever is queued and stop the drainer (idempotent)
+ */
+void stop();
+
+struct Stats {
+    uint64_t written;
+    uint64_t dropped;
+};
+Stats stats();
+
+} // namespace log
+} // namespace Kithly
+
+// Discarded at compile time below KITHLY_LOG_MIN_LEVEL; otherwise the
+// arguments are only evaluated when the runtime level lets the line through
+#define KITHLY_LOG(LEVEL, tag, message)                                            \
+    if constexpr (::Kithly::log::Level::LEVEL < ::Kithly::log::COMPILED_MIN_LEVEL) { \
+    } else if (!::Kithly::log::enabled(::Kithly::log::Level::LEVEL)) {             \
+    } else                                                                         \
+        ::Kithly::log::Record(::Kithly::log::Level::LEVEL, tag, message)
+
+#define KITHLY_LOG_DEBUG(tag, message) KITHLY_LOG(DEBUG, tag, message)
+#define KITHLY_LOG_INFO(tag, message)  KITHLY_LOG(INFO, tag, message)
+#define KITHLY_LOG_WARN(tag, message)  KITHLY_LOG(WARN, tag, message)
+#define KITHLY_LOG_ERROR(tag, message) KITHLY_LOG(ERROR, tag, message)
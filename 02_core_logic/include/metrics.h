@@ -0,0 +1,173 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * metrics.h - Per-Thread HDR Latency Histograms
+ * =============================================================================
+ *
+ * Each LatencyHistogram is an HDR-style log-linear histogram over
+ * nanoseconds: 128 sub-buckets per power of two (under 1% value error)
+ * from 1 ns up to ~68 s, in 1984 counters.
+ *
+ * Recording never contends: every thread writes its own shard with plain
+ * relaxed stores (a single writer needs no read-modify-write), and shards
+ * are linked into the histogram through a lock-free push-only list. A
+ * scrape walks the list and merges the shards with relaxed loads. Shards
+ * outlive their threads, so counts stay cumulative as Prometheus expects.
+ *
+ * Histograms are registered by (name, labels) and never destroyed; hot
+ * paths keep a reference in a function-local static.
+ *
+ * render_prometheus() formats every histogram as a Prometheus summary
+ * (p50/p90/p99/p99.9 plus _sum and _count); MetricsServer serves it.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace Kithly {
+namespace metrics {
+
+using Clock = std::chrono::steady_clock;
+
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKET_BITS = 7;                        // 128 sub-buckets
+    static constexpr int HALF_BITS = SUB_BUCKET_BITS - 1;
+    static constexpr int BUCKETS = 30;                               // 128 << 29 ns ≈ 68.7 s
+    static constexpr std::size_t COUNTS = std::size_t(BUCKETS + 1) << HALF_BITS;
+    static constexpr uint64_t MAX_VALUE = (uint64_t{1} << (SUB_BUCKET_BITS + BUCKETS - 1)) - 1;
+
+    LatencyHistogram(std::string name, std::string labels);
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    const std::string& name() const { return name_; }
+    const std::string& labels() const { return labels_; }
+
+    /**
+     * Record one latency (clamped to MAX_VALUE) into the calling thread's shard
+     */
+    void record(std::chrono::nanoseconds latency);
+
+    void record_since(Clock::time_point start) {
+        record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start));
+    }
+
+    struct Snapshot {
+        std::vector<uint64_t> counts;   // Merged, COUNTS entries
+        uint64_t total = 0;
+        uint64_t sum_ns = 0;
+        uint64_t max_ns = 0;
+
+        /**
+         * Highest value equivalent to the q-th quantile, in nanoseconds
+         */
+        uint64_t quantile(double q) const;
+    };
+
+    /**
+     * Merge every thread's shard (safe while other threads record)
+     */
+    Snapshot snapshot() const;
+
+    // Counter index holding a value, and the highest value it stands for
+    static std::size_t index_of(uint64_t value);
+    static uint64_t highest_equivalent(std::size_t index);
+
+private:
+    struct Shard {
+        std::array<std::atomic<uint64_t>, COUNTS> counts;
+        std::atomic<uint64_t> total;
+        std::atomic<uint64_t> sum_ns;
+        std::atomic<uint64_t> max_ns;
+        Shard* next = nullptr;
+
+        Shard();
+    };
+
+    std::string name_;
+    std::string labels_;
+    std::size_t id_;                       // Slot in each thread's shard table
+    std::atomic<Shard*> shards_{nullptr};
+
+    Shard& local_shard();
+};
+
+/**
+ * Register (or look up) the histogram for name{labels}
+ *
+ * @param labels Prometheus label list without braces, e.g. path="cache"
+ * @param help HELP text for the metric family (first registration wins)
+ */
+LatencyHistogram& histogram(const std::string& name, const std::string& labels = "",
+                            const char* help = "");
+
+/**
+ * kithly_db_statement_seconds{statement="<name>"}; cached per thread, so
+ * the registry lock is taken once per thread and statement
+ */
+LatencyHistogram& statement_latency(const char* statement);
+
+/**
+ * Every registered histogram in Prometheus text format (version 0.0.4)
+ */
+std::string render_prometheus();
+
+/**
+ * Records the time from construction to destruction
+ */
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram& histogram)
+        : histogram_(histogram), start_(Clock::now()) {}
+    ~ScopedTimer() { histogram_.record_since(start_); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    LatencyHistogram& histogram_;
+    Clock::time_point start_;
+};
+
+/**
+ * Minimal embedded HTTP server for GET /metrics
+ * One connection at a time on a dedicated thread; scrapes are rare and
+ * the response is rendered per request.
+ */
+class MetricsServer {
+public:
+    explicit MetricsServer(int port);
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    /**
+     * @return false if the port could not be bound
+     */
+    bool start();
+    void stop();
+
+private:
+    int port_;
+    int listen_fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void run();
+    void serve(int client_fd);
+};
+
+} // namespace metrics
+} // namespace Kithly
@@ -0,0 +1,82 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * operating_hours.h - Weekly Open-Hours Bitmap
+ * =============================================================================
+ *
+ * One bit per 15-minute slot across the week (7 × 96 = 672 bits), built
+ * from Operating_Hours rows. "Open now?" is then a single bit test, cheap
+ * enough to run inside spatial-index queries.
+ */
+
+#pragma once
+
+#include "constants.h"
+#include <bitset>
+#include <chrono>
+
+namespace Kithly {
+
+constexpr int SLOT_MINUTES = 15;
+constexpr int SLOTS_PER_DAY = 24 * 60 / SLOT_MINUTES;
+constexpr int WEEK_SLOTS = 7 * SLOTS_PER_DAY;
+
+// Query sentinel: do not filter on opening hours
+constexpr int ANY_TIME = -1;
+
+/**
+ * Week slot (0 = Sunday 00:00 shop-local) containing t
+ */
+inline int week_slot(std::chrono::system_clock::time_point t,
+                     int utc_offset_minutes = SERVICE_UTC_OFFSET_MINS) {
+    auto minutes = std::chrono::duration_cast<std::chrono::minutes>(t.time_since_epoch()).count()
+                 + utc_offset_minutes;
+    constexpr long long MINUTES_PER_DAY = 24 * 60;
+    long long days = minutes / MINUTES_PER_DAY - (minutes % MINUTES_PER_DAY < 0 ? 1 : 0);
+    long long minute_of_day = minutes - days * MINUTES_PER_DAY;
+    int day_of_week = static_cast<int>(((days + 4) % 7 + 7) % 7);  // 1970-01-01 was a Thursday
+    return day_of_week * SLOTS_PER_DAY + static_cast<int>(minute_of_day / SLOT_MINUTES);
+}
+
+inline int current_week_slot() {
+    return week_slot(std::chrono::system_clock::now());
+}
+
+/**
+ * A shop's weekly schedule
+ */
+class WeeklyHours {
+public:
+    /**
+     * Mark one Operating_Hours row open (day 0 = Sunday, minutes since
+     * midnight). Only slots open for their whole 15 minutes are set.
+     * close <= open spans midnight into the next day; open == close is
+     * treated as 24 hours.
+     */
+    void add(int day_of_week, int open_minute, int close_minute) {
+        if (day_of_week < 0 || day_of_week > 6) {
+            return;
+        }
+        if (close_minute <= open_minute) {
+            close_minute += 24 * 60;
+        }
+
+        int first = (open_minute + SLOT_MINUTES - 1) / SLOT_MINUTES;
+        int last = close_minute / SLOT_MINUTES;  // Exclusive
+        int base = day_of_week * SLOTS_PER_DAY;
+        for (int slot = first; slot < last; ++slot) {
+            bits_.set((base + slot) % WEEK_SLOTS);
+        }
+    }
+
+    bool open_at(int slot) const {
+        return slot < 0 || bits_.test(static_cast<std::size_t>(slot % WEEK_SLOTS));
+    }
+
+    bool empty() const { return bits_.none(); }
+
+private:
+    std::bitset<WEEK_SLOTS> bits_;
+};
+
+} // namespace Kithly
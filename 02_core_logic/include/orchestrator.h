@@ -7,9 +7,17 @@
 
 #pragma once
 
+#include <memory_resource>
 #include <string>
-#include <random>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <optional>
+#include <system_error>
+#include <stdexcept>
 #include <sw/redis++/redis++.h>
+#include "deadline_scheduler.h"
+#include "handshake_token.h"
 
 namespace Kithly {
 namespace Orchestrator {
@@ -17,11 +25,50 @@ namespace Orchestrator {
 /**
  * Generates a secure 8-character token (XXXX-XXXX).
  * Excludes confusing characters ('O', '0', '1', 'I').
+ * Allocation-free overloads are in handshake_token.h.
  * 
  * @return std::string formatted token
  */
 std::string generate_handshake_token();
 
+/**
+ * Thrown when a job could not run for a retryable reason (database
+ * unavailable). The job must not be acked; it is re-driven later.
+ */
+struct TransientJobError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Redis list the Gateway pushes gift jobs onto and the workers drain.
+ */
+constexpr const char* INGESTION_QUEUE = "kithly:ingestion:gifts";
+
+/**
+ * Redis list the Python Gateway drains to send handshake SMS.
+ */
+constexpr const char* ESCROW_LOCKED_QUEUE = "kithly:events:escrow_locked";
+
+/**
+ * Execute a single gift job without touching Redis.
+ * Performs idempotency checking and Database insertion.
+ * 
+ * @param raw_json The raw string from Redis brpop
+ * @return serialized escrow_locked event, or std::nullopt if the job was
+ *         a duplicate or malformed (logged)
+ * @throws TransientJobError if the database was unavailable
+ */
+std::optional<std::string> execute_gift_job(const std::string& raw_json);
+
+/**
+ * Allocation-free variant for the worker hot path: the event is appended
+ * to `event` (typically backed by the worker's JobArena, job_arena.h).
+ * 
+ * @return true if an escrow_locked event was written
+ * @throws TransientJobError if the database was unavailable
+ */
+bool execute_gift_job(std::string_view raw_json, std::pmr::string& event);
+
 /**
  * Process a JSON payload from the Redis queue.
  * Performs idempotency checking and Database insertion.
@@ -30,5 +77,55 @@ std::string generate_handshake_token();
  */
 void process_gift_job(const std::string& raw_json, sw::redis::Redis& redis);
 
+/**
+ * Process a batch of JSON payloads popped in one round-trip.
+ * All idempotency lookups, then all INSERTs, are pipelined over one
+ * connection each (pipeline.h), and the escrow_locked events are
+ * published with a single multi-value LPUSH.
+ * 
+ * @param raw_jsons Payloads in queue (FIFO) order
+ * @return number of events published
+ * @throws TransientJobError after publishing the events of every job that
+ *         committed, if any lookup or INSERT failed
+ */
+std::size_t process_gift_batch(const std::vector<std::string>& raw_jsons, sw::redis::Redis& redis);
+
+/**
+ * DeadlineScheduler fire handler: applies the fired escalations with one
+ * compare-and-set bulk update and triggers the matching Gateway hooks.
+ * 
+ * @param deadlines Batch fired on one scheduler tick
+ */
+void fire_deadlines(std::vector<Deadline>& deadlines);
+
 } // namespace Orchestrator
+
+// =============================================================================
+// ZRA INTERLOCK (350 KEY_VERIFIED → 400 COMPLETED / 800 HELD_FOR_REVIEW)
+// =============================================================================
+
+/**
+ * True if a VSDC resultCd releases the interlock (000 or 001)
+ */
+bool can_complete_delivery(const std::string& tx_id, const std::string& zra_result_code);
+
+/**
+ * (tx_id, VSDC resultCd) of a fiscalisation attempt
+ */
+using ZraResult = std::pair<std::string, std::string>;
+
+/**
+ * Apply a batch of ZRA results in one round trip: released gifts move
+ * to COMPLETED, the rest to HELD_FOR_REVIEW. Compare-and-set from
+ * KEY_VERIFIED, so a gift that already moved on is left alone.
+ *
+ * @return per result, true if the gift reached COMPLETED
+ */
+std::vector<bool> complete_deliveries(const std::vector<ZraResult>& results);
+
+/**
+ * Single-gift complete_deliveries
+ */
+bool complete_delivery(const std::string& tx_id, const std::string& zra_result_code);
+
 } // namespace Kithly
@@ -0,0 +1,129 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * payload_parser.h - Single-Pass Ingestion Payload Parser
+ * =============================================================================
+ *
+ * Replaces the nlohmann DOM on the job hot path. One forward pass over the
+ * raw job string validates the JSON grammar (including UTF-8) and the
+ * GiftPayload schema, and fills a GiftPayloadView:
+ *   - strings without escapes are views straight into the input
+ *   - escaped strings are decoded into a scratch buffer that is reserved
+ *     once per parse to the input size (decoding never grows a string, so
+ *     earlier views are never invalidated)
+ *   - unknown keys are skipped without materialising their values
+ *
+ * Schema rules match from_json(GiftPayload) in structs.h: required fields
+ * must be present and non-null, optional fields may be null or absent,
+ * and a repeated key keeps its last value.
+ *
+ * The escrow_locked event is written directly to a string with the same
+ * bytes nlohmann's dump() produced (sorted keys, same escaping).
+ */
+
+#pragma once
+
+#include "structs.h"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+namespace Kithly {
+
+class GiftPayloadParser {
+public:
+    /**
+     * Parse one job. On success `out` views into `json` and this parser's
+     * buffer; both must outlive it (until the next parse call).
+     *
+     * @return false on malformed JSON or schema mismatch (see error())
+     */
+    bool parse(std::string_view json, GiftPayloadView& out);
+
+    const std::string& error() const { return error_; }
+
+    /**
+     * Copy the fields that view into this parser's buffer (escaped
+     * strings) into `resource`, so `view` survives the next parse and
+     * only needs the raw job to stay alive
+     */
+    void detach(GiftPayloadView& view, std::pmr::memory_resource* resource) const;
+
+private:
+    std::string scratch_;
+    std::string error_;
+    const char* begin_ = nullptr;
+    const char* p_ = nullptr;
+    const char* end_ = nullptr;
+
+    bool fail(const char* what);
+    bool type_error(std::string_view key, const char* expected);
+    void skip_ws();
+    bool expect(char c);
+    bool parse_string(std::string_view& out);
+    bool skip_utf8();
+    bool parse_hex4(uint32_t& out);
+    bool parse_number(double& out);
+    bool parse_literal(std::string_view word);
+    bool skip_value(int depth);
+};
+
+namespace detail {
+
+// nlohmann dump() escaping with ensure_ascii off
+template <typename String>
+void append_json_string(String& out, std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out += '"';
+    std::size_t run = 0;   // Start of the pending unescaped run
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                const char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                out.append(esc, sizeof(esc));
+            }
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out += '"';
+}
+
+} // namespace detail
+
+/**
+ * Append the escrow_locked event consumed by the Python Gateway:
+ * {"handshake_code":...,"receiver_phone":...,"tx_ref":...}
+ * 
+ * @tparam String std::string or std::pmr::string (arena-backed)
+ */
+template <typename String>
+void append_escrow_locked_event(String& out,
+                                std::string_view tx_ref,
+                                std::string_view receiver_phone,
+                                std::string_view handshake_code) {
+    // Keys in the order nlohmann's std::map-backed object dumped them
+    out.reserve(out.size() + 56 + tx_ref.size() + receiver_phone.size() + handshake_code.size());
+    out += "{\"handshake_code\":";
+    detail::append_json_string(out, handshake_code);
+    out += ",\"receiver_phone\":";
+    detail::append_json_string(out, receiver_phone);
+    out += ",\"tx_ref\":";
+    detail::append_json_string(out, tx_ref);
+    out += '}';
+}
+
+} // namespace Kithly
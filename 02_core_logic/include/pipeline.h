@@ -0,0 +1,107 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE BRIDGE
+ * pipeline.h - libpq Pipeline Mode over a Non-Blocking Socket
+ * =============================================================================
+ *
+ * Every statement a worker sends normally costs one full round trip, and
+ * the database is cross-AZ. A StatementPipeline puts a leased connection
+ * into pipeline mode (libpq 14+), queues any number of prepared
+ * statements, and drives the socket from an epoll loop: queries stream
+ * out while results stream back, so a batch of N statements costs about
+ * one round trip instead of N.
+ *
+ * Each statement is followed by its own sync point, so it runs in its own
+ * implicit transaction: a failing statement aborts only itself, never
+ * its neighbours.
+ *
+ * Built without pipeline support (libpq < 14), the same interface runs
+ * each statement synchronously as it is queued.
+ */
+
+#pragma once
+
+#include "connection_pool.h"
+#include <libpq-fe.h>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+
+namespace Kithly {
+
+class StatementPipeline {
+public:
+    /**
+     * Receives the statement's result, or nullptr if the connection failed
+     * before it arrived. The pipeline owns the result (do not PQclear).
+     */
+    using Handler = std::function<void(const PGresult*)>;
+
+    /**
+     * Enter pipeline mode on an idle leased connection. Any failure
+     * invalidates the lease, so a connection left mid-pipeline is never
+     * handed to the next caller.
+     */
+    explicit StatementPipeline(kithly::db::ConnectionPool::Lease& lease);
+
+    /**
+     * Leave pipeline mode and restore blocking mode (invalidates the lease
+     * if results are still outstanding)
+     */
+    ~StatementPipeline();
+
+    StatementPipeline(const StatementPipeline&) = delete;
+    StatementPipeline& operator=(const StatementPipeline&) = delete;
+
+    /**
+     * False if pipeline mode could not be entered or the connection failed;
+     * the connection should then be discarded
+     */
+    bool ok() const { return ok_; }
+
+    /**
+     * Queue one prepared statement. Parameters are copied into libpq's
+     * output buffer before this returns.
+     */
+    void send_prepared(const char* statement, int n_params,
+                       const char* const* values, const int* lengths, const int* formats,
+                       Handler on_result);
+
+    /**
+     * Send everything queued and dispatch results, in order, until every
+     * handler has run
+     *
+     * @return false on connection failure or timeout (remaining handlers
+     *         receive nullptr)
+     */
+    bool run(std::chrono::milliseconds timeout = std::chrono::seconds(30));
+
+    std::size_t pending() const { return pending_.size(); }
+
+private:
+    struct Pending {
+        Handler handler;
+        const char* statement;                    // For per-statement latency
+        std::chrono::steady_clock::time_point sent;
+        bool delivered = false;   // Result handed to the handler
+    };
+
+    kithly::db::ConnectionPool::Lease& lease_;
+    PGconn* conn_;
+    bool ok_ = false;
+    bool pipelined_ = false;
+    std::deque<Pending> pending_;
+
+    /**
+     * Dispatch every result libpq has already parsed
+     */
+    void drain();
+
+    /**
+     * Hand nullptr to every outstanding handler and give up the connection
+     */
+    void fail_all();
+};
+
+} // namespace Kithly
@@ -0,0 +1,81 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * proximity.h - Shop Discovery, Shop-Swap and Pickup Routing
+ * =============================================================================
+ *
+ * Served from the resident ShopIndex (shop_index.h), so no query touches
+ * the database. Swap candidates come from the original shop's category
+ * partition, skip shops closed right now, and are ordered by
+ * ranking::Weights (ranking.h).
+ */
+
+#pragma once
+
+#include "ranking.h"
+#include "route_optimizer.h"
+#include "shop_index.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Kithly {
+
+class ProximityEngine {
+public:
+    static constexpr double DEFAULT_RADIUS_KM = 5.0;
+
+    /**
+     * @param index Index to query (nullptr = installed_shop_index() at
+     *              call time, so a reload is picked up)
+     */
+    explicit ProximityEngine(std::shared_ptr<ShopIndex> index = nullptr);
+
+    /**
+     * Active shops within radius_km, closest first
+     *
+     * @return empty if no index is loaded
+     */
+    std::vector<ShopHit> find_nearest_shops(double lat, double lon,
+                                            double radius_km = DEFAULT_RADIUS_KM,
+                                            std::size_t limit = 10) const;
+
+    /**
+     * Alternatives for a shop-swap (original shop out of stock or
+     * unavailable): same category as the original, open now, best
+     * `limit` by weights. Unknown original = every category.
+     *
+     * @return empty if no index is loaded
+     */
+    std::vector<ShopHit> find_swap_candidates(double receiver_lat, double receiver_lon,
+                                              const std::string& original_shop_id,
+                                              double radius_km = DEFAULT_RADIUS_KM * 2,
+                                              std::size_t limit = 10,
+                                              const ranking::Weights& weights = {}) const;
+
+    /**
+     * Visiting order for a rider's pickups (see route_optimizer.h);
+     * plans are cached per rider batch
+     */
+    RoutePlan optimize_pickup_route(double rider_lat, double rider_lon,
+                                    const std::vector<RouteStop>& pickups);
+
+    /**
+     * Travel plus pickup time, rounded up
+     *
+     * @param traffic_factor 1.0 = normal, 2.0 = heavy traffic
+     */
+    static int estimate_delivery_minutes(double from_lat, double from_lon,
+                                         double to_lat, double to_lon,
+                                         double traffic_factor = 1.0);
+
+private:
+    std::shared_ptr<ShopIndex> index() const;
+
+    std::shared_ptr<ShopIndex> index_;
+    RouteOptimizer route_optimizer_;
+};
+
+} // namespace Kithly
@@ -0,0 +1,116 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * ranking.h - Top-k Candidate Ranking
+ * =============================================================================
+ *
+ * Scores every candidate exactly once, then selects the best k with
+ * nth_element (O(n)) and orders only those k (O(k log k)), instead of a
+ * full sort whose comparator re-scores both sides on every comparison.
+ * Lower score = better.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace Kithly {
+namespace ranking {
+
+/**
+ * Linear blend used by shop-swap and reroute ranking.
+ * Defaults are the historical 0.6 distance / 0.4 confidence split;
+ * performance (0-100, as in Shops.performance_score) is opt-in.
+ */
+struct Weights {
+    double distance = 0.6;      // Per km
+    double confidence = 0.4;    // Applied to (1 - confidence)
+    double performance = 0.0;   // Applied to (1 - performance / 100)
+
+    double operator()(double distance_km, double confidence_score,
+                      double performance_score = 100.0) const {
+        return distance_km * distance +
+               (1.0 - confidence_score) * confidence +
+               (1.0 - performance_score / 100.0) * performance;
+    }
+};
+
+/**
+ * Candidate position and its precomputed score
+ */
+struct Ranked {
+    double score;
+    std::size_t index;
+};
+
+/**
+ * Best k of items (closest first) among those passing keep.
+ * Ties keep input order.
+ *
+ * @param score Callable item -> double, invoked once per kept item
+ * @param keep Callable item -> bool (filter; no copies are made)
+ */
+template <typename T, typename ScoreFn, typename KeepFn>
+std::vector<Ranked> rank_top_k(const std::vector<T>& items, std::size_t k,
+                               ScoreFn&& score, KeepFn&& keep) {
+    std::vector<Ranked> ranked;
+    ranked.reserve(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        if (keep(items[i])) {
+            ranked.push_back({score(items[i]), i});
+        }
+    }
+
+    auto better = [](const Ranked& a, const Ranked& b) {
+        return a.score < b.score || (a.score == b.score && a.index < b.index);
+    };
+
+    if (k < ranked.size()) {
+        std::nth_element(ranked.begin(), ranked.begin() + k, ranked.end(), better);
+        ranked.resize(k);
+    }
+    std::sort(ranked.begin(), ranked.end(), better);
+    return ranked;
+}
+
+template <typename T, typename ScoreFn>
+std::vector<Ranked> rank_top_k(const std::vector<T>& items, std::size_t k, ScoreFn&& score) {
+    return rank_top_k(items, k, std::forward<ScoreFn>(score), [](const T&) { return true; });
+}
+
+/**
+ * Borrowing variant: pointers into items, best first.
+ * items must outlive the result.
+ */
+template <typename T, typename ScoreFn, typename KeepFn>
+std::vector<const T*> borrow_top_k(const std::vector<T>& items, std::size_t k,
+                                   ScoreFn&& score, KeepFn&& keep) {
+    auto ranked = rank_top_k(items, k, std::forward<ScoreFn>(score), std::forward<KeepFn>(keep));
+    std::vector<const T*> out;
+    out.reserve(ranked.size());
+    for (const auto& r : ranked) {
+        out.push_back(&items[r.index]);
+    }
+    return out;
+}
+
+/**
+ * Consuming variant: winners are moved out of items, best first
+ */
+template <typename T, typename ScoreFn, typename KeepFn>
+std::vector<T> take_top_k(std::vector<T>&& items, std::size_t k,
+                          ScoreFn&& score, KeepFn&& keep) {
+    auto ranked = rank_top_k(items, k, std::forward<ScoreFn>(score), std::forward<KeepFn>(keep));
+    std::vector<T> out;
+    out.reserve(ranked.size());
+    for (const auto& r : ranked) {
+        out.push_back(std::move(items[r.index]));
+    }
+    return out;
+}
+
+} // namespace ranking
+} // namespace Kithly
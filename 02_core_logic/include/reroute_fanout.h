@@ -0,0 +1,120 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * reroute_fanout.h - Parallel Reroute Offers, First Accept Wins
+ * =============================================================================
+ *
+ * A single-candidate reroute spends the whole 2-hour Baker's Protocol
+ * window on one shop; if that one declines too, the gift starts over.
+ * The fan-out instead takes the top N open alternatives from the resident
+ * ShopIndex (same category, nearest first, excluding the shop that
+ * declined) and shadow-locks all of them in parallel on the node's
+ * TaskPool. The first shop to accept claims the gift (→ 106 ALT_FOUND)
+ * and every sibling offer is released in the same statement, so
+ * deadline-bound orders converge in one round instead of N serial ones.
+ *
+ * Offers live in Reroute_Offers (012_reroute_offers.sql). Only the node
+ * holding the gift's fan-out lease (017_reroute_offer_sweep.sql) writes
+ * them, so a deadline fired on several scheduler nodes, or a re-run by
+ * the sweep, offers the gift once. Candidates are capped at radius_km
+ * and ranked by performance_score, then distance, like the engine's
+ * single-shop reroute. A gift whose offers all lapse is offered again,
+ * up to max_rounds leases (019_reroute_rounds.sql), then refunded.
+ *
+ * Shops accept through the Gateway, which pushes {"tx_id", "shop_id"}
+ * onto REROUTE_ACCEPT_QUEUE; a RerouteOfferWorker on each node drains it
+ * and, on the same thread, sweeps lapsed offers and fan-outs that never
+ * wrote one.
+ */
+
+#pragma once
+
+#include "db_connector.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Kithly {
+
+constexpr const char* REROUTE_ACCEPT_QUEUE = "kithly:commands:reroute_accept";
+
+struct RerouteFanoutOptions {
+    std::size_t candidates = 3;                // Shops offered at once
+    std::chrono::minutes offer_ttl{15};        // Shadow lock lifetime
+    double radius_km = 5.0;                    // Same cap as the engine's reroute
+    int max_rounds = 3;                        // Fan-outs before the gift is refunded
+};
+
+/**
+ * One candidate of a fan-out
+ */
+struct RerouteOffer {
+    std::string shop_id;
+    std::string name;
+    double distance_km = 0.0;   // From the shop that declined
+    bool offered = false;       // Shadow lock written
+};
+
+/**
+ * Offer a declined gift to the top N alternative shops in parallel.
+ * Needs an installed ShopIndex; runs inline if no TaskPool is installed.
+ *
+ * @return the candidates in rank order (empty if none, the gift opted
+ *         out of reroutes, its shop is unknown, or another node holds
+ *         the fan-out lease)
+ */
+std::vector<RerouteOffer> fan_out_reroute(const std::string& tx_id,
+                                          const RerouteFanoutOptions& options = {});
+
+/**
+ * A shop accepted its offer: claim the gift if no other shop got there
+ * first, and release the sibling offers
+ *
+ * @return WON if this shop won the gift; FAILED is worth retrying
+ */
+RerouteClaim accept_reroute_offer(const std::string& tx_id, const std::string& shop_id);
+
+/**
+ * Release lapsed offers (each withdrawal goes to the Gateway), then give
+ * every declined gift left with no open offer another round, or, once it
+ * ran max_rounds, refund it (910 → 900, REFUND). Safe on every node.
+ *
+ * @return offers released plus gifts re-offered or refunded
+ */
+std::size_t sweep_reroute_offers(const RerouteFanoutOptions& options = {}, int limit = 256);
+
+/**
+ * Drains REROUTE_ACCEPT_QUEUE into accept_reroute_offer and runs
+ * sweep_reroute_offers every sweep_interval
+ */
+class RerouteOfferWorker {
+public:
+    struct Options {
+        RerouteFanoutOptions fanout;
+        std::chrono::seconds pop_timeout{1};
+        std::chrono::seconds sweep_interval{60};
+    };
+
+    RerouteOfferWorker(std::string redis_uri, Options options);
+    ~RerouteOfferWorker();
+
+    RerouteOfferWorker(const RerouteOfferWorker&) = delete;
+    RerouteOfferWorker& operator=(const RerouteOfferWorker&) = delete;
+
+    void start();
+    void stop();
+
+private:
+    std::string redis_uri_;
+    Options options_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void run();
+};
+
+} // namespace Kithly
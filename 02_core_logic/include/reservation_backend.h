@@ -0,0 +1,167 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * reservation_backend.h - Pluggable Idempotency Reservation Backends
+ * =============================================================================
+ *
+ * IdempotencyGuard::reserve() claims a key before the gift is created.
+ * Where the claim lives is pluggable:
+ *
+ *   LocalReservationBackend  - in-process ReservationTable. Correct only
+ *                              while a single kithly_core node ingests.
+ *   RedisReservationBackend  - SET key NX PX on the shared Redis, so every
+ *                              node sees every claim. Commit and release are
+ *                              Lua compare-and-set on the fencing token.
+ *
+ * Every successful reservation carries a fencing token that increases
+ * monotonically across nodes. A holder whose reservation expired (GC pause,
+ * slow DB) and was re-taken by another node holds a stale token: its
+ * commit() and release() are rejected instead of clobbering the new owner.
+ *
+ * Redis key layout (single-node Redis; the scripts touch two keys):
+ *   <prefix><key>  = "r:<token>"  reserved, PX = reservation TTL
+ *                  = "c:<token>"  committed, PX = idempotency window
+ *   <prefix>fence  = fencing counter (INCR)
+ */
+
+#pragma once
+
+#include "idempotency_cache.h"
+#include <sw/redis++/redis++.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace kithly {
+namespace idempotency {
+
+/**
+ * Outcome of a reservation attempt
+ */
+struct ReserveOutcome {
+    enum class Status {
+        ACQUIRED,      // Caller owns the key until commit/release/TTL
+        IN_PROGRESS,   // Another request (any node) holds the key
+        COMMITTED,     // Key already committed; treat as duplicate
+        UNAVAILABLE    // Backend unreachable; fail closed
+    };
+
+    Status status;
+    uint64_t fencing_token = 0;   // Valid only when ACQUIRED
+
+    bool acquired() const { return status == Status::ACQUIRED; }
+};
+
+/**
+ * Reservation backend interface. Implementations must be thread-safe.
+ */
+class ReservationBackend {
+public:
+    virtual ~ReservationBackend() = default;
+
+    virtual ReserveOutcome try_reserve(const std::string& key) = 0;
+
+    /**
+     * Mark the key committed for the idempotency window
+     *
+     * @return false if token no longer owns the key
+     */
+    virtual bool commit(const std::string& key, uint64_t fencing_token) = 0;
+
+    /**
+     * Drop the reservation (processing failed). No-op for a stale token.
+     */
+    virtual void release(const std::string& key, uint64_t fencing_token) = 0;
+
+    virtual CacheStats stats() const = 0;
+};
+
+// =============================================================================
+// LOCAL (SINGLE NODE)
+// =============================================================================
+
+class LocalReservationBackend : public ReservationBackend {
+public:
+    explicit LocalReservationBackend(SteadyClock::duration reservation_ttl);
+
+    ReserveOutcome try_reserve(const std::string& key) override;
+    bool commit(const std::string& key, uint64_t fencing_token) override;
+    void release(const std::string& key, uint64_t fencing_token) override;
+    CacheStats stats() const override;
+
+private:
+    ReservationTable<std::string> table_;
+    std::atomic<uint64_t> next_token_{1};
+};
+
+// =============================================================================
+// REDIS (MULTI NODE)
+// =============================================================================
+
+class RedisReservationBackend : public ReservationBackend {
+public:
+    struct Options {
+        std::string key_prefix = "kithly:idem:";
+        std::chrono::milliseconds reservation_ttl{30000};
+        std::chrono::milliseconds committed_ttl{std::chrono::hours(24)};
+        // L1: keys this node knows are committed, skipped without a round trip
+        std::size_t l1_capacity = 65536;
+        std::chrono::milliseconds l1_ttl{std::chrono::minutes(10)};
+    };
+
+    RedisReservationBackend(std::shared_ptr<sw::redis::Redis> redis, Options options);
+    explicit RedisReservationBackend(std::shared_ptr<sw::redis::Redis> redis);
+
+    ReserveOutcome try_reserve(const std::string& key) override;
+    bool commit(const std::string& key, uint64_t fencing_token) override;
+    void release(const std::string& key, uint64_t fencing_token) override;
+
+    /**
+     * hits = duplicates answered by L1, misses = round trips to Redis,
+     * size = reservations held by this node
+     */
+    CacheStats stats() const override;
+
+private:
+    std::shared_ptr<sw::redis::Redis> redis_;
+    Options options_;
+    std::string fence_key_;
+
+    // L1, in front of Redis:
+    //  - local_ holds this node's in-flight keys, so a hot duplicate on the
+    //    same node is rejected without a network hop
+    //  - committed_ remembers keys Redis reported (or we made) committed
+    ReservationTable<std::string> local_;
+    ShardedClockCache<std::string, uint64_t> committed_;
+
+    // SHA1 of each script after SCRIPT LOAD (empty = not loaded yet)
+    struct Script {
+        const char* source;
+        std::string sha;
+    };
+    Script reserve_script_;
+    Script commit_script_;
+    Script release_script_;
+    std::mutex script_mutex_;
+
+    std::atomic<uint64_t> l1_hits_{0};
+    std::atomic<uint64_t> round_trips_{0};
+
+    std::string redis_key(const std::string& key) const { return options_.key_prefix + key; }
+
+    /**
+     * EVALSHA, loading the script on first use and again after NOSCRIPT
+     * (Redis restarted or SCRIPT FLUSH)
+     */
+    long long run(Script& script,
+                  std::initializer_list<sw::redis::StringView> keys,
+                  std::initializer_list<sw::redis::StringView> args);
+};
+
+} // namespace idempotency
+} // namespace kithly
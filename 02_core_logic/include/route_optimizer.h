@@ -0,0 +1,86 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * route_optimizer.h - Rider Pickup Route Optimisation
+ * =============================================================================
+ *
+ * Open-path TSP from the rider's position through every pickup:
+ *   1. Distance matrix built once with the SoA chord kernel (geo.h)
+ *   2. Greedy nearest-neighbour seed tour
+ *   3. 2-opt and Or-opt (segments of 1-3 stops) until no move improves
+ *      or the time budget runs out
+ *
+ * Optional per-stop time windows (minutes from departure, e.g. derived
+ * from Operating_Hours) turn lateness into a penalty, so improving moves
+ * never trade a shorter route for a missed pickup.
+ *
+ * Results are cached per rider batch (same stops, rider within ~100 m).
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Kithly {
+
+/**
+ * A pickup to visit
+ */
+struct RouteStop {
+    double latitude;
+    double longitude;
+    // Pickup window in minutes from departure (nullopt = unconstrained)
+    std::optional<double> opens_min;
+    std::optional<double> closes_min;
+};
+
+struct RoutePlan {
+    std::vector<std::size_t> order;   // Indices into the stops vector
+    double distance_km = 0.0;
+    double late_minutes = 0.0;        // Total lateness against windows
+    bool from_cache = false;
+};
+
+class RouteOptimizer {
+public:
+    struct Options {
+        std::chrono::microseconds time_budget{2000};
+        double speed_kmh = 25.0;          // Urban motorcycle
+        double service_minutes = 5.0;     // Per pickup
+        double late_penalty_km = 10.0;    // Cost of one minute late
+        std::size_t cache_capacity = 256;
+    };
+
+    RouteOptimizer();
+    explicit RouteOptimizer(Options options);
+
+    /**
+     * Order stops for a rider starting at (rider_lat, rider_lon).
+     * Thread-safe; the cache is shared across callers.
+     */
+    RoutePlan optimize(double rider_lat, double rider_lon, const std::vector<RouteStop>& stops);
+
+    std::size_t cache_size() const;
+
+private:
+    Options options_;
+
+    // LRU: most recent at front
+    using CacheList = std::list<std::pair<std::string, RoutePlan>>;
+    CacheList lru_;
+    std::unordered_map<std::string, CacheList::iterator> cache_;
+    mutable std::mutex cache_mutex_;
+
+    std::string cache_key(double rider_lat, double rider_lon, const std::vector<RouteStop>& stops) const;
+    RoutePlan solve(double rider_lat, double rider_lon, const std::vector<RouteStop>& stops) const;
+};
+
+} // namespace Kithly
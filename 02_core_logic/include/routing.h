@@ -0,0 +1,34 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * routing.h - Nearest Shop Lookup Interface
+ * =============================================================================
+ */
+
+#pragma once
+
+#include <libpq-fe.h>
+#include <string>
+
+namespace Kithly {
+
+/**
+ * Haversine Formula - distance between two points on Earth in kilometers
+ */
+double haversine_distance(double lat1, double lon1, double lat2, double lon2);
+
+/**
+ * Find the nearest active shop excluding the failed shop.
+ * Served from the installed ShopIndex when one is loaded; otherwise
+ * falls back to scanning Shops over conn.
+ *
+ * @return shop_id, or "" if no alternative exists
+ */
+std::string find_nearest_shop(
+    const std::string& failed_shop_id,
+    double origin_lat,
+    double origin_lon,
+    PGconn* conn
+);
+
+} // namespace Kithly
@@ -0,0 +1,68 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * sha256.h - Incremental SHA-256 (receipt_hash)
+ * =============================================================================
+ *
+ * Streaming hasher for evidence uploads: update() takes any number of
+ * chunks of any size and buffers at most one partial 64-byte block.
+ *
+ * The block function is chosen at compile time, like geo.h's kernels:
+ * SHA-NI on x86 when built with -msha (or KITHLY_NATIVE_ARCH on a CPU
+ * that has it), the ARMv8 SHA2 extension on aarch64 (+crypto/+sha2),
+ * and portable C++ otherwise. sha256_backend() names the one in use.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace Kithly {
+
+class Sha256 {
+public:
+    static constexpr std::size_t DIGEST_SIZE = 32;
+    static constexpr std::size_t BLOCK_SIZE = 64;
+
+    Sha256() { reset(); }
+
+    void reset();
+
+    void update(const void* data, std::size_t size);
+    void update(std::string_view data) { update(data.data(), data.size()); }
+
+    /**
+     * Finish and write the 32-byte digest; the hasher must be reset()
+     * before it is reused
+     */
+    void finish(uint8_t (&digest)[DIGEST_SIZE]);
+
+    /**
+     * Finish and return the digest as 64 lowercase hex characters
+     * (the Delivery_Proofs.receipt_hash format)
+     */
+    std::string hex_digest();
+
+    uint64_t bytes_hashed() const { return total_; }
+
+private:
+    uint32_t state_[8];
+    uint8_t block_[BLOCK_SIZE];
+    std::size_t block_len_;
+    uint64_t total_;
+};
+
+/**
+ * One-shot helper
+ */
+std::string sha256_hex(std::string_view data);
+
+/**
+ * "sha-ni", "armv8-sha2" or "portable"
+ */
+const char* sha256_backend();
+
+} // namespace Kithly
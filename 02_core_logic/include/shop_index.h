@@ -0,0 +1,184 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * shop_index.h - Resident Spatial Index of Active Shops
+ * =============================================================================
+ *
+ * Active shops are bucketed into a uniform lat/lon grid (0.01° cells,
+ * ~1.1 km in Lusaka), with one grid for all shops plus one per category.
+ * k-nearest queries walk rings of cells outward from the origin and stop
+ * once no unvisited cell can beat the current k-th distance, so a reroute
+ * touches a handful of cells instead of the whole Shops table.
+ *
+ * Each shop carries its weekly open-hours bitmap, so queries can skip
+ * closed shops with one bit test per candidate.
+ *
+ * The index is loaded once at startup and kept current by ShopIndexListener,
+ * which LISTENs on kithly_shops (see 009_shop_index_notify.sql and
+ * 010_operating_hours_notify.sql) and re-reads only the shops named in
+ * each notification.
+ */
+
+#pragma once
+
+#include "connection_pool.h"
+#include "geo.h"
+#include "operating_hours.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace Kithly {
+
+/**
+ * Shop as held by the index
+ */
+struct IndexedShop {
+    std::string shop_id;
+    std::string name;
+    std::string category;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    double performance_score = 0.0;
+    // nullopt = no Operating_Hours rows: schedule unknown, never filtered
+    std::optional<WeeklyHours> hours;
+};
+
+/**
+ * Query result: a shop and its distance from the query origin.
+ * Carries performance_score so hits can be re-ranked with
+ * ranking::Weights without another lookup.
+ */
+struct ShopHit {
+    std::string shop_id;
+    std::string name;
+    double distance_km;
+    double performance_score;
+};
+
+/**
+ * Spatial Shop Index
+ * Thread-safe: queries take a shared lock, updates an exclusive one.
+ */
+class ShopIndex {
+public:
+    explicit ShopIndex(double cell_degrees = 0.01);
+
+    /**
+     * Replace the index contents with every active, geolocated shop
+     *
+     * @return number of shops loaded, or -1 on database error
+     */
+    int load_all();
+
+    /**
+     * Re-read one shop and upsert it (or drop it if it is gone/inactive)
+     *
+     * @return false on database error
+     */
+    bool refresh_shop(const std::string& shop_id);
+
+    void upsert(const IndexedShop& shop);
+    void remove(const std::string& shop_id);
+
+    /**
+     * k nearest shops, closest first
+     *
+     * @param exclude_shop_id Shop to skip (e.g. the one that failed)
+     * @param category Restrict to one category partition ("" = all)
+     * @param open_slot Only shops open in this week slot (ANY_TIME = all)
+     */
+    std::vector<ShopHit> nearest(double lat, double lon, std::size_t k,
+                                 const std::string& exclude_shop_id = "",
+                                 const std::string& category = "",
+                                 int open_slot = ANY_TIME) const;
+
+    /**
+     * Every shop within radius_km, closest first
+     */
+    std::vector<ShopHit> within(double lat, double lon, double radius_km,
+                                const std::string& exclude_shop_id = "",
+                                const std::string& category = "",
+                                int open_slot = ANY_TIME) const;
+
+    /**
+     * Whether the shop is open in the given week slot.
+     * Shops not in the index, or without a schedule, count as open.
+     */
+    bool is_open(const std::string& shop_id, int slot) const;
+
+    /**
+     * Copy of one indexed shop (std::nullopt if not in the index)
+     */
+    std::optional<IndexedShop> find(const std::string& shop_id) const;
+
+    std::size_t size() const;
+
+private:
+    struct Grid {
+        std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+        // Occupied cell extent, so ring walks know when to stop
+        int32_t min_row = 0, max_row = -1;
+        int32_t min_col = 0, max_col = -1;
+    };
+
+    double cell_degrees_;
+    std::vector<IndexedShop> shops_;                  // Slot storage
+    geo::PointSet points_;                            // Unit vectors by slot
+    std::vector<uint32_t> free_slots_;
+    std::unordered_map<std::string, uint32_t> slot_by_id_;
+    std::unordered_map<std::string, Grid> partitions_; // "" = all shops
+    mutable std::shared_mutex mutex_;
+
+    int32_t row_of(double lat) const;
+    int32_t col_of(double lon) const;
+    static uint64_t cell_key(int32_t row, int32_t col);
+
+    void insert_locked(const IndexedShop& shop);
+    void erase_locked(const std::string& shop_id);
+
+    std::vector<ShopHit> search(double lat, double lon, std::size_t k, double radius_km,
+                                const std::string& exclude_shop_id,
+                                const std::string& category,
+                                int open_slot) const;
+};
+
+/**
+ * Install (or clear, with nullptr) the index find_nearest_shop serves from
+ */
+void install_shop_index(std::shared_ptr<ShopIndex> index);
+std::shared_ptr<ShopIndex> installed_shop_index();
+
+/**
+ * LISTEN/NOTIFY refresher
+ * Holds a dedicated (unpooled) connection; on reconnect it reloads the
+ * whole index, since notifications sent while disconnected are lost.
+ */
+class ShopIndexListener {
+public:
+    ShopIndexListener(std::shared_ptr<ShopIndex> index,
+                      std::shared_ptr<kithly::db::ConnectionPool> pool);
+    ~ShopIndexListener();
+
+    ShopIndexListener(const ShopIndexListener&) = delete;
+    ShopIndexListener& operator=(const ShopIndexListener&) = delete;
+
+    void start();
+    void stop();
+
+private:
+    std::shared_ptr<ShopIndex> index_;
+    std::shared_ptr<kithly::db::ConnectionPool> pool_;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+
+    void run();
+};
+
+} // namespace Kithly
@@ -0,0 +1,157 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE BRIDGE
+ * statements.h - Prepared Statement Catalog & Binary Parameter Encoding
+ * =============================================================================
+ *
+ * Every hot-path statement is prepared once per pooled connection (the
+ * pool re-runs prepare_statements after each connect/reset) and executed
+ * with PQexecPrepared. Fixed-width parameters (INT4, UUID, BOOL) are sent
+ * in binary so the backend skips text parsing.
+ */
+
+#pragma once
+
+#include <libpq-fe.h>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace Kithly {
+namespace sql {
+
+// Type OIDs from pg_type.h (server headers are not a client dependency)
+constexpr Oid BOOL_OID        = 16;
+constexpr Oid INT8_OID        = 20;
+constexpr Oid INT4_OID        = 23;
+constexpr Oid TEXT_OID        = 25;
+constexpr Oid FLOAT8_OID      = 701;
+constexpr Oid INT4_ARRAY_OID  = 1007;
+constexpr Oid INT8_ARRAY_OID  = 1016;
+constexpr Oid TIMESTAMPTZ_OID = 1184;
+constexpr Oid NUMERIC_OID     = 1700;
+constexpr Oid UUID_OID        = 2950;
+constexpr Oid UUID_ARRAY_OID  = 2951;
+
+// Param formats for PQexecPrepared
+constexpr int TEXT_FORMAT   = 0;
+constexpr int BINARY_FORMAT = 1;
+
+// Statement names
+constexpr const char* UPDATE_STATUS           = "kithly_update_status";
+constexpr const char* FIND_BY_IDEMPOTENCY_KEY = "kithly_find_by_idempotency_key";
+constexpr const char* INSERT_GIFT             = "kithly_insert_gift";
+constexpr const char* BULK_UPDATE_STATUS      = "kithly_bulk_update_status";
+constexpr const char* SCAN_EXPIRED_ESCROW     = "kithly_scan_expired_escrow";
+constexpr const char* BULK_TRANSITION_STATUS  = "kithly_bulk_transition_status";
+constexpr const char* TRANSITION_WITH_OUTBOX  = "kithly_transition_with_outbox";
+constexpr const char* FIND_REROUTE_ORIGIN     = "kithly_find_reroute_origin";
+constexpr const char* OFFER_REROUTE           = "kithly_offer_reroute";
+constexpr const char* CLAIM_REROUTE           = "kithly_claim_reroute";
+constexpr const char* LEASE_REROUTE_FANOUT    = "kithly_lease_reroute_fanout";
+constexpr const char* RELEASE_LAPSED_OFFERS   = "kithly_release_lapsed_offers";
+constexpr const char* SCAN_IDLE_REROUTES      = "kithly_scan_idle_reroutes";
+constexpr const char* INSERT_DELIVERY_PROOF   = "kithly_insert_delivery_proof";
+constexpr const char* CLAIM_ZRA_SYNC          = "kithly_claim_zra_sync";
+constexpr const char* FINISH_ZRA_SYNC         = "kithly_finish_zra_sync";
+constexpr const char* SCAN_STRANDED_ZRA_SYNC  = "kithly_scan_stranded_zra_sync";
+constexpr const char* INSERT_OUTBOX_EVENT     = "kithly_insert_outbox_event";
+constexpr const char* DELETE_OUTBOX_EVENTS    = "kithly_delete_outbox_events";
+constexpr const char* CLAIM_OUTBOX_EVENTS     = "kithly_claim_outbox_events";
+
+/**
+ * Prepare the whole catalog on a fresh connection.
+ * Installed as the connection pool's initializer.
+ *
+ * @return false if any PQprepare failed (the connection is discarded)
+ */
+bool prepare_statements(PGconn* conn);
+
+/**
+ * PQexecPrepared, timed into kithly_db_statement_seconds{statement=...}
+ * (metrics.h)
+ */
+PGresult* exec_prepared(PGconn* conn, const char* statement, int n_params,
+                        const char* const* values, const int* lengths, const int* formats,
+                        int result_format);
+
+// =============================================================================
+// BINARY PARAMETER ENCODING (network byte order)
+// =============================================================================
+
+/**
+ * INT4 in binary wire format
+ */
+struct Int4Param {
+    char bytes[4];
+
+    explicit Int4Param(int32_t value) {
+        uint32_t v = static_cast<uint32_t>(value);
+        bytes[0] = static_cast<char>((v >> 24) & 0xFF);
+        bytes[1] = static_cast<char>((v >> 16) & 0xFF);
+        bytes[2] = static_cast<char>((v >> 8) & 0xFF);
+        bytes[3] = static_cast<char>(v & 0xFF);
+    }
+};
+
+/**
+ * UUID in binary wire format (16 raw bytes)
+ */
+struct UuidParam {
+    char bytes[16];
+    bool valid = false;
+
+    /**
+     * Parse canonical 8-4-4-4-12 hex form
+     */
+    explicit UuidParam(std::string_view text) {
+        if (text.size() != 36) {
+            return;
+        }
+
+        auto hex = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        };
+
+        std::size_t out = 0;
+        for (std::size_t i = 0; i < text.size(); ) {
+            if (i == 8 || i == 13 || i == 18 || i == 23) {
+                if (text[i] != '-') return;
+                ++i;
+                continue;
+            }
+            int hi = hex(text[i]);
+            int lo = hex(text[i + 1]);
+            if (hi < 0 || lo < 0) return;
+            bytes[out++] = static_cast<char>((hi << 4) | lo);
+            i += 2;
+        }
+        valid = (out == 16);
+    }
+};
+
+/**
+ * Format a binary UUID result column back to canonical text
+ */
+inline std::string uuid_to_string(const char* bytes) {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string out;
+    out.reserve(36);
+    for (int i = 0; i < 16; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            out += '-';
+        }
+        auto b = static_cast<unsigned char>(bytes[i]);
+        out += digits[b >> 4];
+        out += digits[b & 0x0F];
+    }
+    return out;
+}
+
+} // namespace sql
+} // namespace Kithly
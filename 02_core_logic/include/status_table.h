@@ -0,0 +1,195 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE FIRST BRICK
+ * status_table.h - Compile-time Status Names & Transition Table
+ * =============================================================================
+ *
+ * The single source of the protocol's legal transitions (EDGES below).
+ * Everything is built at compile time:
+ *   INDEX        status code → compact id (0 = UNKNOWN), 1 KB lookup
+ *   TABLE        compact id  → code and name
+ *   TRANSITIONS  one 16-bit row per id; bit `to` set if from → to is legal
+ *
+ * name(), can_transition() and is_known() are O(1) table loads with no
+ * branches and no allocation. Code that hard-codes a transition writes
+ * `status::checked<FROM, TO>`, which fails the build if the transition
+ * is not an edge.
+ *
+ * Dependency-free (02_engine includes it too).
+ */
+
+#pragma once
+
+#include "constants.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Kithly {
+namespace status {
+
+struct Entry {
+    int code;
+    const char* name;
+};
+
+// Id 0 is the sink for every unknown code
+inline constexpr std::array<Entry, 15> TABLE = {{
+    {0,                         "UNKNOWN"},
+    {Status::INITIATED,         "INITIATED"},
+    {ALT_FOUND,                 "ALT_FOUND"},
+    {AWAITING_SHOP_ACCEPTANCE,  "AWAITING_SHOP_ACCEPTANCE"},
+    {Status::AGENT_INITIATED,   "AGENT_INITIATED"},
+    {Status::FUNDS_LOCKED,      "FUNDS_LOCKED"},
+    {Status::SETTLED,           "SETTLED"},
+    {Status::FULFILLING,        "FULFILLING"},
+    {FORCE_CALL_PENDING,        "FORCE_CALL_PENDING"},
+    {REROUTING,                 "REROUTING"},
+    {KEY_VERIFIED,              "KEY_VERIFIED"},
+    {Status::COMPLETED,         "COMPLETED"},
+    {HELD_FOR_REVIEW,           "HELD_FOR_REVIEW"},
+    {EXPIRED,                   "EXPIRED"},
+    {DECLINED,                  "DECLINED"},
+}};
+
+constexpr std::size_t COUNT = TABLE.size();
+
+using Id = uint8_t;
+using Row = uint16_t;
+static_assert(COUNT <= sizeof(Row) * 8, "widen Row");
+
+struct Edge {
+    int from;
+    int to;
+};
+
+/**
+ * Every legal transition in the protocol
+ */
+inline constexpr Edge EDGES[] = {
+    // Initiation
+    {Status::INITIATED,        Status::FUNDS_LOCKED},      // Stripe webhook
+    {Status::AGENT_INITIATED,  Status::FUNDS_LOCKED},
+    {Status::INITIATED,        AWAITING_SHOP_ACCEPTANCE},  // Baker's Protocol
+    {AWAITING_SHOP_ACCEPTANCE, Status::FUNDS_LOCKED},      // Shop accepted
+    {AWAITING_SHOP_ACCEPTANCE, DECLINED},                  // Declined or window lapsed
+    // Payment
+    {Status::FUNDS_LOCKED,     Status::SETTLED},           // Flutterwave account verified
+    {Status::FUNDS_LOCKED,     EXPIRED},                   // 48h escrow watchdog
+    {Status::SETTLED,          Status::FULFILLING},        // Shop notified
+    // Fulfilment and escalation
+    {Status::FULFILLING,       FORCE_CALL_PENDING},        // 5 min
+    {FORCE_CALL_PENDING,       REROUTING},                 // 10 min
+    {Status::FULFILLING,       KEY_VERIFIED},              // Collection token scanned
+    {FORCE_CALL_PENDING,       KEY_VERIFIED},
+    // Rerouting
+    {DECLINED,                 ALT_FOUND},                 // Reroute offer claimed
+    {REROUTING,                ALT_FOUND},
+    {ALT_FOUND,                Status::FULFILLING},
+    {DECLINED,                 EXPIRED},                   // No alternative: refund
+    {REROUTING,                EXPIRED},
+    // Completion (ZRA interlock)
+    {KEY_VERIFIED,             Status::COMPLETED},
+    {KEY_VERIFIED,             HELD_FOR_REVIEW},
+    {HELD_FOR_REVIEW,          Status::COMPLETED},         // Manual review released
+    {HELD_FOR_REVIEW,          EXPIRED},                   // Manual review refunded
+};
+
+namespace detail {
+
+// Codes are clamped to MAX_CODE; that slot is never a real status
+constexpr unsigned MAX_CODE = 1023;
+
+constexpr std::array<Id, MAX_CODE + 1> build_index() {
+    std::array<Id, MAX_CODE + 1> index{};
+    for (std::size_t id = 1; id < COUNT; ++id) {
+        index[static_cast<unsigned>(TABLE[id].code)] = static_cast<Id>(id);
+    }
+    return index;
+}
+
+constexpr bool codes_valid() {
+    for (std::size_t id = 1; id < COUNT; ++id) {
+        if (TABLE[id].code <= 0 || static_cast<unsigned>(TABLE[id].code) >= MAX_CODE) return false;
+        for (std::size_t other = 1; other < id; ++other) {
+            if (TABLE[other].code == TABLE[id].code) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(codes_valid(), "status codes must be unique and in 1..1022");
+
+} // namespace detail
+
+inline constexpr auto INDEX = detail::build_index();
+
+/**
+ * Compact id of a status code; 0 for anything unknown (negative included)
+ */
+constexpr Id id_of(int code) {
+    const unsigned u = static_cast<unsigned>(code);
+    return INDEX[u < detail::MAX_CODE ? u : detail::MAX_CODE];
+}
+
+namespace detail {
+
+constexpr std::array<Row, COUNT> build_transitions() {
+    std::array<Row, COUNT> rows{};
+    for (const Edge& e : EDGES) {
+        rows[id_of(e.from)] = static_cast<Row>(rows[id_of(e.from)] | (Row{1} << id_of(e.to)));
+    }
+    return rows;
+}
+
+constexpr bool edges_valid() {
+    for (const Edge& e : EDGES) {
+        if (id_of(e.from) == 0 || id_of(e.to) == 0 || e.from == e.to) return false;
+    }
+    return true;
+}
+
+static_assert(edges_valid(), "every EDGES entry must join two distinct known statuses");
+
+} // namespace detail
+
+inline constexpr auto TRANSITIONS = detail::build_transitions();
+
+constexpr bool is_known(int code) {
+    return id_of(code) != 0;
+}
+
+/**
+ * Name for logs and errors; "UNKNOWN" for codes outside the protocol
+ */
+constexpr const char* name(int code) {
+    return TABLE[id_of(code)].name;
+}
+
+/**
+ * True if from → to is an edge (always false for unknown codes)
+ */
+constexpr bool can_transition(int from, int to) {
+    return (TRANSITIONS[id_of(from)] >> id_of(to)) & 1u;
+}
+
+/**
+ * A transition written in code: the build fails unless it is an edge
+ */
+template <int From, int To>
+struct Transition {
+    static_assert(can_transition(From, To), "illegal status transition (see EDGES in status_table.h)");
+    static constexpr int from = From;
+    static constexpr int to = To;
+};
+
+/**
+ * The target status of a compile-time checked transition, e.g.
+ * update_status(tx_id, status::checked<Status::FUNDS_LOCKED, Status::SETTLED>)
+ */
+template <int From, int To>
+inline constexpr int checked = Transition<From, To>::to;
+
+} // namespace status
+} // namespace Kithly
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <ctime>
 #include <nlohmann/json.hpp>
 
@@ -76,8 +77,84 @@ struct GiftPayload {
     std::string shop_id;
     std::string product_id;
     int quantity;
+    
+    // Optional gateway fields (absent or null in older payloads)
+    std::string tx_ref;
+    std::string sender_id;
+    std::string receiver_name;
+    double unit_price = 0.0;
+    std::string message;
+    bool is_surprise = false;
 };
 
-NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(GiftPayload, tx_id, idempotency_key, receiver_phone, shop_id, product_id, quantity)
+/**
+ * GiftPayloadView - non-owning GiftPayload
+ * Filled by GiftPayloadParser (payload_parser.h) with views into the raw
+ * job string or the parser's scratch buffer; valid until the next parse.
+ * Views are not NUL-terminated.
+ */
+struct GiftPayloadView {
+    std::string_view tx_id;
+    std::string_view idempotency_key;
+    std::string_view receiver_phone;
+    std::string_view shop_id;
+    std::string_view product_id;
+    int quantity = 0;
+    
+    std::string_view tx_ref;
+    std::string_view sender_id;
+    std::string_view receiver_name;
+    double unit_price = 0.0;
+    std::string_view message;
+    bool is_surprise = false;
+    
+    GiftPayloadView() = default;
+    
+    explicit GiftPayloadView(const GiftPayload& p)
+        : tx_id(p.tx_id), idempotency_key(p.idempotency_key),
+          receiver_phone(p.receiver_phone), shop_id(p.shop_id),
+          product_id(p.product_id), quantity(p.quantity),
+          tx_ref(p.tx_ref), sender_id(p.sender_id),
+          receiver_name(p.receiver_name), unit_price(p.unit_price),
+          message(p.message), is_surprise(p.is_surprise) {}
+    
+    // Gateway reference, falling back to tx_id for older payloads
+    std::string_view effective_tx_ref() const { return tx_ref.empty() ? tx_id : tx_ref; }
+};
+
+inline void to_json(nlohmann::json& j, const GiftPayload& p) {
+    j = nlohmann::json{
+        {"tx_id", p.tx_id}, {"idempotency_key", p.idempotency_key},
+        {"receiver_phone", p.receiver_phone}, {"shop_id", p.shop_id},
+        {"product_id", p.product_id}, {"quantity", p.quantity},
+        {"tx_ref", p.tx_ref}, {"sender_id", p.sender_id},
+        {"receiver_name", p.receiver_name}, {"unit_price", p.unit_price},
+        {"message", p.message}, {"is_surprise", p.is_surprise}
+    };
+}
+
+inline void from_json(const nlohmann::json& j, GiftPayload& p) {
+    // Required: missing or mistyped fields throw (schema mismatch)
+    j.at("tx_id").get_to(p.tx_id);
+    j.at("idempotency_key").get_to(p.idempotency_key);
+    j.at("receiver_phone").get_to(p.receiver_phone);
+    j.at("shop_id").get_to(p.shop_id);
+    j.at("product_id").get_to(p.product_id);
+    j.at("quantity").get_to(p.quantity);
+    
+    // Optional: JSON null is treated like an absent key
+    auto optional = [&j](const char* key, auto& out) {
+        auto it = j.find(key);
+        if (it != j.end() && !it->is_null()) {
+            it->get_to(out);
+        }
+    };
+    optional("tx_ref", p.tx_ref);
+    optional("sender_id", p.sender_id);
+    optional("receiver_name", p.receiver_name);
+    optional("unit_price", p.unit_price);
+    optional("message", p.message);
+    optional("is_surprise", p.is_surprise);
+}
 
 } // namespace Kithly
@@ -0,0 +1,139 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * task_pool.h - Work-Stealing Task Pool
+ * =============================================================================
+ *
+ * One pool per worker node, installed next to the ingestion consumers, for
+ * short fan-out work (e.g. the parallel reroute offers in reroute_fanout.h).
+ * Each pool thread owns a deque: it pushes and pops its own tasks at the
+ * back (LIFO, cache-warm) and, when empty, steals from the front of a
+ * sibling's deque (FIFO, oldest first).
+ *
+ * TaskGroup::wait() runs queued tasks on the calling thread while it waits,
+ * so a consumer or pool thread that fans out never just blocks - and a
+ * task may start and wait on a nested group without deadlocking the pool.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Kithly {
+
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param threads Pool threads (0 = hardware concurrency)
+     */
+    explicit TaskPool(std::size_t threads = 0);
+
+    /**
+     * Runs every task still queued, then joins the pool threads
+     */
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * Queue a task. From a pool thread it goes on that thread's own deque;
+     * from any other thread, round-robin across the deques.
+     */
+    void submit(Task task);
+
+    /**
+     * Run one queued task on the calling thread
+     *
+     * @return false if every deque was empty
+     */
+    bool run_one();
+
+    /**
+     * Pool the calling thread belongs to (nullptr off-pool). Tasks should
+     * use this rather than hold a shared_ptr: the last reference must not
+     * be dropped on one of the pool's own threads.
+     */
+    static TaskPool* current();
+
+    std::size_t threads() const { return threads_.size(); }
+
+    struct Stats {
+        uint64_t executed;
+        uint64_t stolen;    // Taken from another thread's deque
+    };
+    Stats stats() const;
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues_;   // One per pool thread
+    std::vector<std::thread> threads_;
+    std::atomic<std::size_t> queued_{0};
+    std::atomic<std::size_t> next_queue_{0};
+    std::atomic<bool> stopping_{false};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+
+    std::atomic<uint64_t> executed_{0};
+    std::atomic<uint64_t> stolen_{0};
+
+    // Deque owned by the calling thread, or queues_.size() if none
+    std::size_t own_queue() const;
+    bool take(std::size_t home, Task& out);
+    void execute(Task& task);
+    void worker_loop(std::size_t index);
+};
+
+/**
+ * Fork/join over a TaskPool. wait() returns once every task started by
+ * run() has finished, and rethrows the first exception one of them threw.
+ * With a null pool, run() executes the task inline.
+ */
+class TaskGroup {
+public:
+    explicit TaskGroup(TaskPool* pool);
+
+    /**
+     * Waits (ignoring task exceptions) if wait() was not called
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    void run(TaskPool::Task task);
+    void wait();
+
+private:
+    TaskPool* pool_;
+    std::atomic<std::size_t> pending_{0};
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::exception_ptr error_;
+
+    void finish(std::exception_ptr error);
+};
+
+/**
+ * Install (or clear, with nullptr) the node-wide pool
+ */
+void install_task_pool(std::shared_ptr<TaskPool> pool);
+std::shared_ptr<TaskPool> installed_task_pool();
+
+} // namespace Kithly
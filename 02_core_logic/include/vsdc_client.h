@@ -0,0 +1,74 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * vsdc_client.h - ZRA VSDC HTTP/1.1 Client (Keep-alive)
+ * =============================================================================
+ *
+ * The VSDC is a local fiscal device / service reached over plain HTTP
+ * (ZRA_VSDC_URL, default http://localhost:8080/vsdc). post() reuses idle
+ * persistent connections, so a batch of submissions costs one TCP
+ * handshake per sender rather than one per request. Thread-safe; each
+ * call uses one connection exclusively.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Kithly {
+
+struct VsdcResponse {
+    int http_status = 0;      // 0 = no response (see error)
+    std::string body;
+    std::string error;        // Transport failure, empty otherwise
+
+    bool transport_ok() const { return http_status != 0; }
+};
+
+class VsdcClient {
+public:
+    struct Options {
+        std::string base_url = "http://localhost:8080/vsdc";
+        std::chrono::milliseconds connect_timeout{10000};
+        std::chrono::milliseconds read_timeout{30000};
+        std::size_t max_idle = 16;          // Persistent connections kept open
+        std::size_t max_response_bytes = 1024 * 1024;
+    };
+
+    explicit VsdcClient(Options options);
+    ~VsdcClient();
+
+    VsdcClient(const VsdcClient&) = delete;
+    VsdcClient& operator=(const VsdcClient&) = delete;
+
+    /**
+     * false if base_url is not an http:// URL (https is not supported)
+     */
+    bool valid() const { return valid_; }
+
+    /**
+     * POST a JSON body to <base_url><endpoint>, e.g. "/trnsSales/saveSales"
+     */
+    VsdcResponse post(const std::string& endpoint, const std::string& json_body);
+
+    const Options& options() const { return options_; }
+
+private:
+    Options options_;
+    bool valid_ = false;
+    std::string host_;
+    std::string port_;
+    std::string path_;        // Base path without trailing '/'
+
+    std::mutex mutex_;
+    std::vector<int> idle_;
+
+    int acquire(bool& reused, std::string& error);
+    void release(int fd, bool keep_alive);
+    int connect_new(std::string& error);
+};
+
+} // namespace Kithly
@@ -0,0 +1,131 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * zra_sync.h - Batched ZRA_Sync_Queue Drainer (VSDC Fiscalisation)
+ * =============================================================================
+ *
+ * One cycle:
+ *   1. CLAIM_ZRA_SYNC takes up to batch_size due PENDING rows
+ *      (FOR UPDATE SKIP LOCKED, so nodes never contend for a row) and
+ *      leases them by pushing next_retry_at out.
+ *   2. The payloads go to the VSDC over keep-alive connections, at most
+ *      `concurrency` requests in flight.
+ *   3. FINISH_ZRA_SYNC records every outcome in one statement: SUCCESS,
+ *      FAILED, or PENDING with a jittered exponential backoff, and copies
+ *      the resultCd to Delivery_Proofs.
+ *   4. saveSales results go to complete_deliveries in one bulk
+ *      compare-and-set (350 → 400, or 350 → 800 for review).
+ *
+ * Steps 3 and 4 are separate transactions. A node that dies (or loses
+ * the database) between them would leave the gift at 350 with its sync
+ * row already ended, so every sweep_interval the loop also runs
+ * sweep_stranded(), which replays step 4 for such gifts. The
+ * compare-and-set makes a replay that races the original harmless.
+ *
+ * A full batch is followed by the next one immediately. A batch in
+ * which the VSDC was unreachable for every row pauses the loop, with
+ * the pause doubling up to max_outage_pause, so an outage costs a few
+ * probes instead of a hot loop.
+ */
+
+#pragma once
+
+#include "vsdc_client.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace Kithly {
+
+constexpr const char* ZRA_SAVE_SALES_ENDPOINT = "/trnsSales/saveSales";
+
+class ZraSyncWorker {
+public:
+    struct Options {
+        int batch_size = 64;
+        std::size_t concurrency = 8;
+        std::chrono::seconds lease{120};               // Raised to cover a worst-case batch
+        std::chrono::milliseconds idle_poll{2000};
+        std::chrono::seconds base_retry{60};           // As zra_fiscalizer.py
+        std::chrono::seconds max_retry{86400};
+        std::chrono::seconds max_outage_pause{60};
+        std::chrono::seconds sweep_interval{300};
+    };
+
+    struct Stats {
+        uint64_t claimed = 0;
+        uint64_t succeeded = 0;
+        uint64_t retried = 0;
+        uint64_t failed = 0;
+        uint64_t completed = 0;    // Gifts moved to COMPLETED
+        uint64_t held = 0;         // Gifts moved to HELD_FOR_REVIEW
+        uint64_t swept = 0;        // Of those, moved by sweep_stranded()
+    };
+
+    ZraSyncWorker(VsdcClient::Options vsdc, Options options);
+    ~ZraSyncWorker();
+
+    ZraSyncWorker(const ZraSyncWorker&) = delete;
+    ZraSyncWorker& operator=(const ZraSyncWorker&) = delete;
+
+    void start();
+    void stop();
+
+    /**
+     * One claim → submit → finish cycle on the calling thread
+     *
+     * @return rows claimed (0 if none were due or the database failed)
+     */
+    std::size_t run_once();
+
+    /**
+     * Complete (or hold) up to batch_size gifts stranded at 350 after
+     * their saveSales row ended, i.e. whose complete_deliveries never
+     * ran. Rows younger than the lease are skipped: their batch may
+     * still be completing them.
+     *
+     * @return stranded gifts found
+     */
+    std::size_t sweep_stranded();
+
+    Stats stats() const;
+
+    /**
+     * Backoff after the attempt-th failed try: the exponential delay
+     * min(cap, base * 2^(attempt-1)), jittered over its upper half by
+     * unit_random in [0, 1) so rows failed by one outage do not all
+     * come due together
+     */
+    static std::chrono::seconds retry_delay(int attempt, std::chrono::seconds base,
+                                            std::chrono::seconds cap, double unit_random);
+
+private:
+    VsdcClient client_;
+    Options options_;
+    std::chrono::seconds lease_;
+
+    // Set by run_once: true if every request of the last batch failed
+    // without reaching the VSDC
+    bool last_batch_unreachable_ = false;
+
+    std::atomic<uint64_t> claimed_{0};
+    std::atomic<uint64_t> succeeded_{0};
+    std::atomic<uint64_t> retried_{0};
+    std::atomic<uint64_t> failed_{0};
+    std::atomic<uint64_t> completed_{0};
+    std::atomic<uint64_t> held_{0};
+    std::atomic<uint64_t> swept_{0};
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    void loop();
+};
+
+} // namespace Kithly
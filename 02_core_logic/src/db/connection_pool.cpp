@@ -0,0 +1,248 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE BRIDGE
+ * db/connection_pool.cpp - Thread-safe libpq Connection Pool
+ * =============================================================================
+ */
+
+#include "connection_pool.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+namespace kithly {
+namespace db {
+
+DbConfig DbConfig::from_env() {
+    DbConfig config;
+
+    if (const char* v = std::getenv("KITHLY_DB_HOST")) config.host = v;
+    if (const char* v = std::getenv("KITHLY_DB_PORT")) config.port = std::stoi(v);
+    if (const char* v = std::getenv("KITHLY_DB_NAME")) config.database = v;
+    if (const char* v = std::getenv("KITHLY_DB_USER")) config.user = v;
+    if (const char* v = std::getenv("KITHLY_DB_PASSWORD")) config.password = v;
+    if (const char* v = std::getenv("KITHLY_DB_POOL_SIZE")) config.pool_size = std::max(1, std::stoi(v));
+    if (const char* v = std::getenv("KITHLY_DB_MAX_WAITERS")) config.max_waiters = std::max(0, std::stoi(v));
+    if (const char* v = std::getenv("KITHLY_DB_ACQUIRE_TIMEOUT_MS")) {
+        config.acquire_timeout = std::chrono::milliseconds(std::stoi(v));
+    }
+    if (const char* v = std::getenv("KITHLY_DB_CONNECT_TIMEOUT_SECS")) {
+        config.connect_timeout = std::chrono::seconds(std::max(0, std::stoi(v)));
+    }
+
+    return config;
+}
+
+// =============================================================================
+// LEASE (RAII checkout)
+// =============================================================================
+
+ConnectionPool::Lease::~Lease() {
+    release();
+}
+
+ConnectionPool::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), slot_(other.slot_), conn_(other.conn_), broken_(other.broken_) {
+    other.pool_ = nullptr;
+    other.conn_ = nullptr;
+}
+
+ConnectionPool::Lease& ConnectionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        slot_ = other.slot_;
+        conn_ = other.conn_;
+        broken_ = other.broken_;
+        other.pool_ = nullptr;
+        other.conn_ = nullptr;
+    }
+    return *this;
+}
+
+void ConnectionPool::Lease::release() {
+    if (pool_ && conn_) {
+        pool_->give_back(slot_, broken_);
+    }
+    pool_ = nullptr;
+    conn_ = nullptr;
+}
+
+// =============================================================================
+// POOL
+// =============================================================================
+
+ConnectionPool::ConnectionPool(const DbConfig& config)
+    : config_(config), slots_(std::max(1, config.pool_size)) {
+    idle_.reserve(slots_.size());
+    for (std::size_t i = slots_.size(); i-- > 0; ) {
+        idle_.push_back(i);
+    }
+}
+
+ConnectionPool::~ConnectionPool() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& slot : slots_) {
+        if (slot.conn) {
+            PQfinish(slot.conn);
+            slot.conn = nullptr;
+        }
+    }
+}
+
+ConnectionPool::Lease ConnectionPool::acquire() {
+    std::size_t index;
+    Initializer initializer;
+    uint64_t generation;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        if (idle_.empty()) {
+            if (waiters_ >= config_.max_waiters) {
+                std::cerr << "[DB POOL] Waiter cap (" << config_.max_waiters
+                          << ") reached - rejecting checkout" << std::endl;
+                return Lease();
+            }
+
+            ++waiters_;
+            bool ready = available_.wait_for(lock, config_.acquire_timeout,
+                                             [this] { return !idle_.empty(); });
+            --waiters_;
+
+            if (!ready) {
+                std::cerr << "[DB POOL] Timed out after " << config_.acquire_timeout.count()
+                          << "ms waiting for a connection" << std::endl;
+                return Lease();
+            }
+        }
+
+        index = idle_.back();
+        idle_.pop_back();
+        initializer = initializer_;
+        generation = initializer_generation_;
+    }
+
+    // The slot is exclusively ours now; connect/ping without holding the lock
+    Slot& slot = slots_[index];
+    if (!ensure_healthy(slot) || !ensure_initialized(slot, initializer, generation)) {
+        give_back(index, true);
+        return Lease();
+    }
+
+    return Lease(this, index, slot.conn);
+}
+
+void ConnectionPool::set_initializer(Initializer initializer) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    initializer_ = std::move(initializer);
+    ++initializer_generation_;
+}
+
+std::size_t ConnectionPool::idle() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return idle_.size();
+}
+
+std::size_t ConnectionPool::waiters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<std::size_t>(waiters_);
+}
+
+PGconn* ConnectionPool::connect() const {
+    const std::string port = std::to_string(config_.port);
+    const std::string connect_timeout = std::to_string(config_.connect_timeout.count());
+
+    // Keyword/value form: no quoting issues with passwords
+    const char* keywords[] = { "host", "port", "dbname", "user", "password",
+                               "application_name", "connect_timeout", nullptr };
+    const char* values[] = { config_.host.c_str(), port.c_str(), config_.database.c_str(),
+                             config_.user.c_str(),
+                             config_.password.empty() ? nullptr : config_.password.c_str(),
+                             "kithly_core", connect_timeout.c_str(), nullptr };
+
+    PGconn* conn = PQconnectdbParams(keywords, values, 0);
+
+    if (PQstatus(conn) != CONNECTION_OK) {
+        std::cerr << "[DB POOL] Database connection failed: "
+                  << PQerrorMessage(conn) << std::endl;
+        PQfinish(conn);
+        return nullptr;
+    }
+
+    return conn;
+}
+
+bool ConnectionPool::ensure_healthy(Slot& slot) const {
+    // Lazy connect on first use (or after the slot was discarded)
+    if (!slot.conn) {
+        slot.conn = connect();
+        slot.initialized_generation = 0;
+        return slot.conn != nullptr;
+    }
+
+    // Known-bad socket: try an in-place reset before giving up
+    if (PQstatus(slot.conn) != CONNECTION_OK) {
+        PQreset(slot.conn);
+        slot.initialized_generation = 0;
+        if (PQstatus(slot.conn) != CONNECTION_OK) {
+            PQfinish(slot.conn);
+            slot.conn = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // Long-idle connections may have been dropped by a proxy/failover
+    auto idle_for = std::chrono::steady_clock::now() - slot.returned_at;
+    if (idle_for > config_.validate_after_idle) {
+        PGresult* res = PQexec(slot.conn, "SELECT 1");
+        bool ok = PQresultStatus(res) == PGRES_TUPLES_OK;
+        PQclear(res);
+
+        if (!ok) {
+            PQreset(slot.conn);
+            slot.initialized_generation = 0;
+            if (PQstatus(slot.conn) != CONNECTION_OK) {
+                PQfinish(slot.conn);
+                slot.conn = nullptr;
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool ConnectionPool::ensure_initialized(Slot& slot, const Initializer& initializer, uint64_t generation) {
+    if (!initializer || slot.initialized_generation == generation) {
+        return true;
+    }
+
+    if (!initializer(slot.conn)) {
+        return false;
+    }
+    slot.initialized_generation = generation;
+    return true;
+}
+
+void ConnectionPool::give_back(std::size_t index, bool broken) {
+    Slot& slot = slots_[index];
+
+    // A connection left mid-transaction would leak state to the next user
+    bool dirty = slot.conn && (PQstatus(slot.conn) != CONNECTION_OK ||
+                               PQtransactionStatus(slot.conn) != PQTRANS_IDLE);
+    if ((broken || dirty) && slot.conn) {
+        PQfinish(slot.conn);
+        slot.conn = nullptr;
+    }
+    slot.returned_at = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(index);
+    }
+    available_.notify_one();
+}
+
+} // namespace db
+} // namespace kithly
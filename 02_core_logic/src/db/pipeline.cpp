@@ -0,0 +1,210 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE BRIDGE
+ * db/pipeline.cpp - libpq Pipeline Mode over a Non-Blocking Socket
+ * =============================================================================
+ */
+
+#include "pipeline.h"
+#include "metrics.h"
+#include "statements.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace Kithly {
+
+StatementPipeline::StatementPipeline(kithly::db::ConnectionPool::Lease& lease)
+    : lease_(lease), conn_(lease.get()) {
+    if (!conn_ || PQstatus(conn_) != CONNECTION_OK ||
+        PQtransactionStatus(conn_) != PQTRANS_IDLE) {
+        std::cerr << "[DB PIPELINE] Connection not idle - pipeline disabled" << std::endl;
+        lease_.invalidate();
+        return;
+    }
+#ifdef LIBPQ_HAS_PIPELINING
+    if (PQsetnonblocking(conn_, 1) != 0 || PQenterPipelineMode(conn_) != 1) {
+        std::cerr << "[DB PIPELINE] Cannot enter pipeline mode: "
+                  << PQerrorMessage(conn_) << std::endl;
+        lease_.invalidate();
+        return;
+    }
+    pipelined_ = true;
+#endif
+    ok_ = true;
+}
+
+StatementPipeline::~StatementPipeline() {
+    if (!pending_.empty()) {
+        fail_all();  // Unread results: the connection is not reusable
+    }
+#ifdef LIBPQ_HAS_PIPELINING
+    if (pipelined_) {
+        if (PQexitPipelineMode(conn_) != 1) {
+            lease_.invalidate();
+        }
+        PQsetnonblocking(conn_, 0);
+    }
+#endif
+}
+
+void StatementPipeline::send_prepared(const char* statement, int n_params,
+                                      const char* const* values, const int* lengths,
+                                      const int* formats, Handler on_result) {
+    if (!ok_) {
+        on_result(nullptr);
+        return;
+    }
+#ifdef LIBPQ_HAS_PIPELINING
+    pending_.push_back(Pending{std::move(on_result), statement, std::chrono::steady_clock::now()});
+    if (!PQsendQueryPrepared(conn_, statement, n_params, values, lengths, formats, 0) ||
+        !PQpipelineSync(conn_)) {
+        std::cerr << "[DB PIPELINE] Send failed: " << PQerrorMessage(conn_) << std::endl;
+        fail_all();
+    }
+#else
+    PGresult* res = sql::exec_prepared(conn_, statement, n_params, values, lengths, formats, 0);
+    on_result(res);
+    PQclear(res);
+    if (PQstatus(conn_) != CONNECTION_OK) {
+        ok_ = false;
+        lease_.invalidate();
+    }
+#endif
+}
+
+void StatementPipeline::drain() {
+#ifdef LIBPQ_HAS_PIPELINING
+    bool query_ended = false;  // NULL seen since the last result
+    while (!pending_.empty() && !PQisBusy(conn_)) {
+        PGresult* res = PQgetResult(conn_);
+        if (!res) {
+            // NULL closes one statement's results; a second in a row
+            // means nothing more has been parsed yet
+            if (query_ended) {
+                break;
+            }
+            query_ended = true;
+            continue;
+        }
+        query_ended = false;
+
+        Pending& front = pending_.front();
+        if (PQresultStatus(res) == PGRES_PIPELINE_SYNC) {
+            if (!front.delivered) {
+                front.handler(nullptr);
+            }
+            pending_.pop_front();
+        } else if (!front.delivered) {
+            // PGRES_PIPELINE_ABORTED included: the handler sees a failure.
+            // Latency runs from queueing to result, pipeline wait included.
+            metrics::statement_latency(front.statement).record_since(front.sent);
+            front.delivered = true;
+            front.handler(res);
+        }
+        PQclear(res);
+    }
+#endif
+}
+
+bool StatementPipeline::run(std::chrono::milliseconds timeout) {
+    if (!ok_) {
+        fail_all();
+        return false;
+    }
+    if (pending_.empty()) {
+        return true;
+    }
+#ifdef LIBPQ_HAS_PIPELINING
+    const int sock = PQsocket(conn_);
+    const int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (sock < 0 || ep < 0) {
+        std::cerr << "[DB PIPELINE] epoll setup failed: " << std::strerror(errno) << std::endl;
+        if (ep >= 0) close(ep);
+        fail_all();
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLOUT;
+    ev.data.fd = sock;
+    bool want_write = true;
+    epoll_ctl(ep, EPOLL_CTL_ADD, sock, &ev);
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const char* failure = nullptr;
+
+    while (!pending_.empty()) {
+        // Flush until libpq's output buffer is empty; watch for writability
+        // only while it is not, so the loop never spins on EPOLLOUT
+        if (want_write) {
+            const int flushed = PQflush(conn_);
+            if (flushed < 0) {
+                failure = "flush failed";
+                break;
+            }
+            if (flushed == 0) {
+                want_write = false;
+                ev.events = EPOLLIN;
+                epoll_ctl(ep, EPOLL_CTL_MOD, sock, &ev);
+            }
+        }
+
+        drain();
+        if (pending_.empty()) {
+            break;
+        }
+
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            failure = "timed out";
+            break;
+        }
+
+        epoll_event ready{};
+        const int n = epoll_wait(ep, &ready, 1, static_cast<int>(remaining.count()));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            failure = "epoll_wait failed";
+            break;
+        }
+        if (n == 0) {
+            continue;  // Deadline is checked above
+        }
+
+        // Errors and hangups surface through PQconsumeInput
+        if ((ready.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && !PQconsumeInput(conn_)) {
+            failure = "connection lost";
+            break;
+        }
+    }
+    close(ep);
+
+    if (failure) {
+        std::cerr << "[DB PIPELINE] " << failure << " with " << pending_.size()
+                  << " statements outstanding: " << PQerrorMessage(conn_) << std::endl;
+        fail_all();
+        return false;
+    }
+    return true;
+#else
+    return ok_;
+#endif
+}
+
+void StatementPipeline::fail_all() {
+    ok_ = false;
+    lease_.invalidate();
+    while (!pending_.empty()) {
+        Pending front = std::move(pending_.front());
+        pending_.pop_front();
+        if (!front.delivered) {
+            front.handler(nullptr);
+        }
+    }
+}
+
+} // namespace Kithly
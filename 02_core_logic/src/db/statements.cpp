@@ -0,0 +1,494 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE BRIDGE
+ * db/statements.cpp - Prepared Statement Catalog
+ * =============================================================================
+ */
+
+#include "statements.h"
+#include "metrics.h"
+#include <iostream>
+
+namespace Kithly {
+namespace sql {
+
+namespace {
+
+struct StatementDef {
+    const char* name;
+    const char* text;
+    int n_params;
+    std::array<Oid, 13> param_types;
+};
+
+const StatementDef CATALOG[] = {
+    {
+        UPDATE_STATUS,
+        "UPDATE Global_Gifts SET status_code = $1 WHERE tx_id = $2",
+        2,
+        { INT4_OID, UUID_OID }
+    },
+    {
+        // Parallel arrays keep the statement text fixed (preparable) for
+        // any batch size, unlike an inline VALUES list.
+        BULK_UPDATE_STATUS,
+        R"(
+            UPDATE Global_Gifts g
+            SET status_code = v.status_code
+            FROM unnest($1::uuid[], $2::int4[]) AS v(tx_id, status_code)
+            WHERE g.tx_id = v.tx_id
+            RETURNING g.tx_id
+        )",
+        2,
+        { UUID_ARRAY_OID, INT4_ARRAY_OID }
+    },
+    {
+        // Compare-and-set variant: a row only moves if it is still in
+        // from_status, so a stale deadline can never regress a gift.
+        BULK_TRANSITION_STATUS,
+        R"(
+            UPDATE Global_Gifts g
+            SET status_code = v.to_status
+            FROM unnest($1::uuid[], $2::int4[], $3::int4[]) AS v(tx_id, from_status, to_status)
+            WHERE g.tx_id = v.tx_id
+              AND g.status_code = v.from_status
+            RETURNING g.tx_id
+        )",
+        3,
+        { UUID_ARRAY_OID, INT4_ARRAY_OID, INT4_ARRAY_OID }
+    },
+    {
+        // BULK_TRANSITION_STATUS plus one Gateway_Event_Outbox row of type
+        // $4 per gift that moved, in the same statement (one transaction):
+        // a transition can never commit without its refund/disbursement.
+        // The row is leased to this node for $6 s; event_id comes back as
+        // text so the binary result needs no int8 decoding.
+        TRANSITION_WITH_OUTBOX,
+        R"(
+            WITH moved AS (
+                UPDATE Global_Gifts g
+                SET status_code = v.to_status
+                FROM unnest($1::uuid[], $2::int4[], $3::int4[]) AS v(tx_id, from_status, to_status)
+                WHERE g.tx_id = v.tx_id
+                  AND g.status_code = v.from_status
+                RETURNING g.tx_id, v.to_status, COALESCE(g.stripe_payment_ref, '') AS payment_ref
+            ),
+            outboxed AS (
+                INSERT INTO Gateway_Event_Outbox
+                    (event_type, tx_id, status, payment_ref, at_ms, lease_until)
+                SELECT $4, m.tx_id, m.to_status, NULLIF(m.payment_ref, ''), $5,
+                       NOW() + make_interval(secs => $6)
+                FROM moved m
+                RETURNING event_id, tx_id
+            )
+            SELECT m.tx_id, m.payment_ref, o.event_id::text
+            FROM moved m
+            JOIN outboxed o ON o.tx_id = m.tx_id
+        )",
+        6,
+        { UUID_ARRAY_OID, INT4_ARRAY_OID, INT4_ARRAY_OID, TEXT_OID, INT8_OID, INT4_OID }
+    },
+    {
+        // Keyset page over (expiry_timestamp, tx_id), served by the
+        // idx_gifts_escrow_expiry partial index. Memory is bounded by $3.
+        SCAN_EXPIRED_ESCROW,
+        R"(
+            SELECT tx_id,
+                   expiry_timestamp,
+                   (EXTRACT(EPOCH FROM expiry_timestamp) * 1000)::int8 AS expiry_ms,
+                   COALESCE(collection_token, ''),
+                   COALESCE(stripe_payment_ref, ''),
+                   COALESCE(is_settled, false)
+            FROM Global_Gifts
+            WHERE status_code = 200
+              AND expiry_timestamp < NOW()
+              AND (expiry_timestamp, tx_id) > ($1, $2)
+            ORDER BY expiry_timestamp, tx_id
+            LIMIT $3
+        )",
+        3,
+        { TIMESTAMPTZ_OID, UUID_OID, INT4_OID }
+    },
+    {
+        FIND_BY_IDEMPOTENCY_KEY,
+        "SELECT tx_id, status_code FROM Global_Gifts WHERE idempotency_key = $1",
+        1,
+        { TEXT_OID }
+    },
+    {
+        // ON CONFLICT closes the race between two workers that both passed
+        // the lookup: the loser gets zero rows back and treats it as a dup.
+        INSERT_GIFT,
+        R"(
+            INSERT INTO Global_Gifts (
+                tx_id, tx_ref, idempotency_key, sender_id,
+                receiver_phone, receiver_name, shop_id, product_id,
+                quantity, unit_price, total_amount, amount_zmw,
+                message, is_surprise, handshake_jwt,
+                status, status_code, expiry_timestamp
+            )
+            VALUES (
+                $1, $2, $3, $4,
+                $5, $6, $7, $8,
+                $9, $10, $10 * $9, $10 * $9,
+                $11, $12, $13,
+                'ESCROW_LOCKED', 200, NOW() + INTERVAL '48 hours'
+            )
+            ON CONFLICT (idempotency_key) DO NOTHING
+            RETURNING tx_id
+        )",
+        13,
+        { UUID_OID, TEXT_OID, TEXT_OID, TEXT_OID,
+          TEXT_OID, TEXT_OID, TEXT_OID, TEXT_OID,
+          INT4_OID, NUMERIC_OID, TEXT_OID, BOOL_OID, TEXT_OID }
+    },
+    {
+        // Shop a declined gift was routed to, if the sender allowed reroutes
+        FIND_REROUTE_ORIGIN,
+        R"(
+            SELECT shop_id::text
+            FROM Global_Gifts
+            WHERE tx_id = $1
+              AND COALESCE(auto_reroute, true)
+        )",
+        1,
+        { UUID_OID }
+    },
+    {
+        // Shadow lock for one fan-out candidate (012_reroute_offers.sql).
+        // Re-offering refreshes the window, but never reopens a winner.
+        OFFER_REROUTE,
+        R"(
+            INSERT INTO Reroute_Offers (tx_id, shop_id, distance_km, offered_at, expires_at)
+            VALUES ($1, $2, $3, NOW(), NOW() + make_interval(mins => $4))
+            ON CONFLICT (tx_id, shop_id) DO UPDATE
+            SET state = 'offered',
+                distance_km = EXCLUDED.distance_km,
+                offered_at = NOW(),
+                expires_at = EXCLUDED.expires_at,
+                resolved_at = NULL
+            WHERE Reroute_Offers.state <> 'accepted'
+            RETURNING shop_id
+        )",
+        4,
+        { UUID_OID, UUID_OID, FLOAT8_OID, INT4_OID }
+    },
+    {
+        // First accept wins: the compare-and-set on the gift row (still
+        // DECLINED / REROUTING) serialises racing accepts, and the winner
+        // releases every sibling offer in the same statement. Always one
+        // row for the loser; one per released shop for the winner.
+        CLAIM_REROUTE,
+        R"(
+            WITH claimed AS (
+                UPDATE Global_Gifts g
+                SET status_code = $3,
+                    alternative_shop_id = $2,
+                    rerouted_at = NOW()
+                WHERE g.tx_id = $1
+                  AND g.status_code IN (910, 315)
+                  AND EXISTS (
+                      SELECT 1 FROM Reroute_Offers o
+                      WHERE o.tx_id = $1 AND o.shop_id = $2
+                        AND o.state = 'offered' AND o.expires_at > NOW()
+                  )
+                RETURNING g.tx_id
+            ),
+            resolved AS (
+                UPDATE Reroute_Offers o
+                SET state = CASE WHEN o.shop_id = $2 THEN 'accepted' ELSE 'released' END,
+                    resolved_at = NOW()
+                FROM claimed c
+                WHERE o.tx_id = c.tx_id AND o.state = 'offered'
+                RETURNING o.shop_id, o.state
+            )
+            SELECT (SELECT COUNT(*) FROM claimed)::int4, r.shop_id::text
+            FROM (SELECT 1) AS one
+            LEFT JOIN resolved r ON r.state = 'released'
+        )",
+        3,
+        { UUID_OID, UUID_OID, INT4_OID }
+    },
+    {
+        // One node per fan-out (017_reroute_offer_sweep.sql): the lease
+        // is taken only while the gift still awaits a shop, no other node
+        // holds it, and fewer than $3 rounds ran (019_reroute_rounds.sql).
+        // Empty RETURNING = not ours to fan out.
+        LEASE_REROUTE_FANOUT,
+        R"(
+            UPDATE Global_Gifts
+            SET reroute_fanout_until = NOW() + make_interval(mins => $2),
+                reroute_rounds = reroute_rounds + 1
+            WHERE tx_id = $1
+              AND status_code IN (910, 315)
+              AND (reroute_fanout_until IS NULL OR reroute_fanout_until <= NOW())
+              AND reroute_rounds < $3
+            RETURNING tx_id
+        )",
+        3,
+        { UUID_OID, INT4_OID, INT4_OID }
+    },
+    {
+        // Up to $1 offers past their window, oldest first; SKIP LOCKED
+        // lets every node sweep and lets a racing accept keep its row
+        RELEASE_LAPSED_OFFERS,
+        R"(
+            WITH lapsed AS (
+                SELECT tx_id, shop_id
+                FROM Reroute_Offers
+                WHERE state = 'offered' AND expires_at <= NOW()
+                ORDER BY expires_at
+                LIMIT $1
+                FOR UPDATE SKIP LOCKED
+            )
+            UPDATE Reroute_Offers o
+            SET state = 'released',
+                resolved_at = NOW()
+            FROM lapsed l
+            WHERE o.tx_id = l.tx_id AND o.shop_id = l.shop_id
+            RETURNING o.tx_id::text, o.shop_id::text
+        )",
+        1,
+        { INT4_OID }
+    },
+    {
+        // Declined gifts whose fan-out lease lapsed (or was never taken)
+        // with no offer still open: every offer of the last round lapsed,
+        // the node died mid fan-out, or no alternative was open at the
+        // time. Returns the rounds run so far.
+        SCAN_IDLE_REROUTES,
+        R"(
+            SELECT g.tx_id::text, g.reroute_rounds
+            FROM Global_Gifts g
+            WHERE g.status_code = 910
+              AND (g.reroute_fanout_until IS NULL OR g.reroute_fanout_until <= NOW())
+              AND COALESCE(g.auto_reroute, true)
+              AND NOT EXISTS (
+                  SELECT 1 FROM Reroute_Offers o
+                  WHERE o.tx_id = g.tx_id AND o.state IN ('offered', 'accepted')
+              )
+            ORDER BY g.reroute_fanout_until NULLS FIRST
+            LIMIT $1
+        )",
+        1,
+        { INT4_OID }
+    },
+    {
+        // ZRA identifiers come from the shop the gift is routed to (the
+        // alternative after a reroute). Exactly one row: 'inserted', the
+        // existing proof on a conflict (a row with the same hash first,
+        // else the gift's proof of this type), or 'missing' for an
+        // unknown gift. No row only if the conflicting proof committed
+        // after this statement's snapshot.
+        INSERT_DELIVERY_PROOF,
+        R"(
+            WITH gift AS (
+                SELECT g.tx_id,
+                       COALESCE(s.tpin, '') AS tpin,
+                       COALESCE(s.bhf_id, '00') AS bhf_id,
+                       s.vsdc_serial
+                FROM Global_Gifts g
+                JOIN Shops s ON s.shop_id = COALESCE(g.alternative_shop_id, g.shop_id)
+                WHERE g.tx_id = $1
+            ),
+            inserted AS (
+                INSERT INTO Delivery_Proofs (
+                    tx_id, tpin, bhf_id, vsdc_serial, proof_type, photo_url, receipt_hash,
+                    file_size, mime_type, latitude, longitude, device_info, uploaded_by
+                )
+                SELECT tx_id, tpin, bhf_id, vsdc_serial, $2, $3, $4, $5, $6, $7, $8, $9::jsonb, $10
+                FROM gift
+                ON CONFLICT DO NOTHING
+                RETURNING proof_id, photo_url, receipt_hash
+            ),
+            existing AS (
+                SELECT d.proof_id, d.photo_url, d.receipt_hash
+                FROM Delivery_Proofs d
+                WHERE EXISTS (SELECT 1 FROM gift)
+                  AND NOT EXISTS (SELECT 1 FROM inserted)
+                  AND (d.receipt_hash = $4 OR (d.tx_id = $1 AND d.proof_type = $2))
+                ORDER BY (d.receipt_hash = $4) DESC
+                LIMIT 1
+            )
+            SELECT 'inserted', proof_id::text, photo_url, receipt_hash FROM inserted
+            UNION ALL
+            SELECT 'duplicate', proof_id::text, photo_url, receipt_hash FROM existing
+            UNION ALL
+            SELECT 'missing', NULL, NULL, NULL
+            WHERE NOT EXISTS (SELECT 1 FROM gift)
+        )",
+        10,
+        { UUID_OID, TEXT_OID, TEXT_OID, TEXT_OID, INT8_OID, TEXT_OID,
+          FLOAT8_OID, FLOAT8_OID, TEXT_OID, UUID_OID }
+    },
+    {
+        // Due PENDING rows, oldest first off idx_sync_retry. SKIP LOCKED
+        // lets every node claim disjoint batches; pushing next_retry_at
+        // out by the lease ($2 s) hands the row back if this node dies
+        // before FINISH_ZRA_SYNC. attempt_count counts this attempt.
+        CLAIM_ZRA_SYNC,
+        R"(
+            UPDATE ZRA_Sync_Queue q
+            SET next_retry_at = NOW() + make_interval(secs => $2),
+                attempt_count = COALESCE(q.attempt_count, 0) + 1
+            FROM (
+                SELECT sync_id
+                FROM ZRA_Sync_Queue
+                WHERE status = 'PENDING' AND next_retry_at <= NOW()
+                ORDER BY next_retry_at
+                LIMIT $1
+                FOR UPDATE SKIP LOCKED
+            ) due
+            WHERE q.sync_id = due.sync_id
+            RETURNING q.sync_id::text, q.tx_id::text, q.endpoint, q.payload_json::text,
+                      q.attempt_count, COALESCE(q.max_attempts, 5)
+        )",
+        2,
+        { INT4_OID, INT4_OID }
+    },
+    {
+        // One statement per batch: $1 is a JSON array of
+        // {sync_id, status, result_code, last_error, retry_secs, response}.
+        // Rows go back to PENDING with their own backoff or to
+        // SUCCESS / FAILED, and every VSDC result code is copied to the
+        // proof(s) so the 400 interlock (trg_check_proof) can see it.
+        FINISH_ZRA_SYNC,
+        R"(
+            WITH v AS (
+                SELECT *
+                FROM jsonb_to_recordset($1::jsonb) AS v(
+                    sync_id uuid, status text, result_code text, last_error text,
+                    retry_secs int4, response jsonb
+                )
+            ),
+            queue AS (
+                UPDATE ZRA_Sync_Queue q
+                SET status = v.status,
+                    last_error = v.last_error,
+                    next_retry_at = CASE WHEN v.status = 'PENDING'
+                                         THEN NOW() + make_interval(secs => v.retry_secs)
+                                         ELSE q.next_retry_at END,
+                    completed_at = CASE WHEN v.status = 'PENDING' THEN NULL ELSE NOW() END
+                FROM v
+                WHERE q.sync_id = v.sync_id AND q.status = 'PENDING'
+                RETURNING q.sync_id, q.tx_id, q.proof_id, q.endpoint, v.status, v.result_code, v.response
+            ),
+            proofs AS (
+                UPDATE Delivery_Proofs d
+                SET zra_result_code = u.result_code,
+                    zra_last_req_dt = to_char(NOW(), 'YYYYMMDDHH24MISS'),
+                    vsdc_response_json = u.response
+                FROM queue u
+                WHERE u.result_code IS NOT NULL
+                  AND (d.proof_id = u.proof_id OR (u.proof_id IS NULL AND d.tx_id = u.tx_id))
+                RETURNING d.tx_id
+            )
+            SELECT u.sync_id::text, u.tx_id::text, u.endpoint, u.status, u.result_code,
+                   EXISTS (SELECT 1 FROM proofs p WHERE p.tx_id = u.tx_id)
+            FROM queue u
+        )",
+        1,
+        { TEXT_OID }
+    },
+    {
+        // Gifts still KEY_VERIFIED (350) whose saveSales row ended more
+        // than $2 s ago: FINISH_ZRA_SYNC committed but complete_deliveries
+        // never ran. The newest ended row per gift wins; a gift with a
+        // row still PENDING is left to the drainer. The result code is
+        // the one FINISH_ZRA_SYNC copied to the proof ('' = none).
+        SCAN_STRANDED_ZRA_SYNC,
+        R"(
+            SELECT DISTINCT ON (g.tx_id)
+                   g.tx_id::text, q.status, COALESCE(d.zra_result_code, '')
+            FROM Global_Gifts g
+            JOIN ZRA_Sync_Queue q ON q.tx_id = g.tx_id
+            LEFT JOIN Delivery_Proofs d
+                   ON d.proof_id = q.proof_id OR (q.proof_id IS NULL AND d.tx_id = q.tx_id)
+            WHERE g.status_code = 350
+              AND q.endpoint = $1
+              AND q.status IN ('SUCCESS', 'FAILED')
+              AND q.completed_at < NOW() - make_interval(secs => $2)
+              AND NOT EXISTS (
+                  SELECT 1 FROM ZRA_Sync_Queue p
+                  WHERE p.tx_id = g.tx_id AND p.endpoint = $1 AND p.status = 'PENDING'
+              )
+            ORDER BY g.tx_id, q.completed_at DESC
+            LIMIT $3
+        )",
+        3,
+        { TEXT_OID, INT4_OID, INT4_OID }
+    },
+    {
+        // Durable copy of a money-moving gateway event
+        // (018_gateway_event_outbox.sql), leased to this node for $7 s
+        INSERT_OUTBOX_EVENT,
+        R"(
+            INSERT INTO Gateway_Event_Outbox
+                (event_type, tx_id, status, shop_id, payment_ref, at_ms, lease_until)
+            VALUES ($1, $2, NULLIF($3, 0), NULLIF($4, ''), NULLIF($5, ''), $6,
+                    NOW() + make_interval(secs => $7))
+            RETURNING event_id
+        )",
+        7,
+        { TEXT_OID, UUID_OID, INT4_OID, TEXT_OID, TEXT_OID, INT8_OID, INT4_OID }
+    },
+    {
+        // The stream holds them now
+        DELETE_OUTBOX_EVENTS,
+        R"(
+            DELETE FROM Gateway_Event_Outbox
+            WHERE event_id = ANY($1)
+        )",
+        1,
+        { INT8_ARRAY_OID }
+    },
+    {
+        // Up to $1 rows whose lease lapsed, re-leased for $2 s
+        CLAIM_OUTBOX_EVENTS,
+        R"(
+            UPDATE Gateway_Event_Outbox o
+            SET lease_until = NOW() + make_interval(secs => $2)
+            FROM (
+                SELECT event_id
+                FROM Gateway_Event_Outbox
+                WHERE lease_until <= NOW()
+                ORDER BY event_id
+                LIMIT $1
+                FOR UPDATE SKIP LOCKED
+            ) due
+            WHERE o.event_id = due.event_id
+            RETURNING o.event_id, o.event_type, o.tx_id::text, COALESCE(o.status, 0),
+                      COALESCE(o.shop_id, ''), COALESCE(o.payment_ref, ''), o.at_ms
+        )",
+        2,
+        { INT4_OID, INT4_OID }
+    },
+};
+
+} // namespace
+
+bool prepare_statements(PGconn* conn) {
+    for (const auto& def : CATALOG) {
+        PGresult* res = PQprepare(conn, def.name, def.text, def.n_params, def.param_types.data());
+
+        if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+            std::cerr << "[KITHLY] PREPARE " << def.name << " failed: "
+                      << PQerrorMessage(conn) << std::endl;
+            PQclear(res);
+            return false;
+        }
+        PQclear(res);
+    }
+
+    return true;
+}
+
+PGresult* exec_prepared(PGconn* conn, const char* statement, int n_params,
+                        const char* const* values, const int* lengths, const int* formats,
+                        int result_format) {
+    metrics::ScopedTimer timer(metrics::statement_latency(statement));
+    return PQexecPrepared(conn, statement, n_params, values, lengths, formats, result_format);
+}
+
+} // namespace sql
+} // namespace Kithly
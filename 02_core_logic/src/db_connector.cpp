@@ -6,90 +6,129 @@
  */
 
 #include "db_connector.h"
+#include "statements.h"
+#include "constants.h"
+#include "status_table.h"
+#include "pipeline.h"
+#include "log.h"
 #include <libpq-fe.h>
-#include <iostream>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
+#include <atomic>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
 
 namespace Kithly {
 
-// Global connection handle
-static PGconn* conn = nullptr;
+// Shared pool - every caller checks out its own connection
+static std::shared_ptr<kithly::db::ConnectionPool> pool;
+static std::mutex pool_mutex;
+
+static std::shared_ptr<kithly::db::ConnectionPool> current_pool() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return pool;
+}
 
 bool init_db_connection() {
-    // Build connection string from environment or defaults
-    const char* host = std::getenv("KITHLY_DB_HOST");
-    const char* port = std::getenv("KITHLY_DB_PORT");
-    const char* dbname = std::getenv("KITHLY_DB_NAME");
-    const char* user = std::getenv("KITHLY_DB_USER");
-    const char* password = std::getenv("KITHLY_DB_PASSWORD");
-    
-    std::string conninfo = "dbname=";
-    conninfo += (dbname ? dbname : "kithly");
-    conninfo += " host=";
-    conninfo += (host ? host : "localhost");
-    conninfo += " port=";
-    conninfo += (port ? port : "5432");
-    if (user) {
-        conninfo += " user=";
-        conninfo += user;
-    }
-    if (password) {
-        conninfo += " password=";
-        conninfo += password;
-    }
-    
-    conn = PQconnectdb(conninfo.c_str());
-    
-    if (PQstatus(conn) != CONNECTION_OK) {
-        std::cerr << "[KITHLY] Database connection failed: " 
-                  << PQerrorMessage(conn) << std::endl;
-        PQfinish(conn);
-        conn = nullptr;
+    // Build connection config from environment or defaults
+    auto config = kithly::db::DbConfig::from_env();
+    if (!init_db_connection(std::make_shared<kithly::db::ConnectionPool>(config))) {
+        return false;
+    }
+    
+    // Connect eagerly once so a bad config fails at startup, not mid-job
+    if (!acquire_db_connection()) {
+        KITHLY_LOG_ERROR("KITHLY", "Database connection failed").field("database", config.database);
+        close_db_connection();
         return false;
     }
     
-    std::cout << "[KITHLY] Connected to database: " 
-              << (dbname ? dbname : "kithly") << std::endl;
+    KITHLY_LOG_INFO("KITHLY", "Connected to database").field("database", config.database);
     return true;
 }
 
+bool init_db_connection(std::shared_ptr<kithly::db::ConnectionPool> new_pool) {
+    if (!new_pool) {
+        return false;
+    }
+    // Hot statements are prepared once per pooled connection
+    new_pool->set_initializer(sql::prepare_statements);
+    
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    pool = std::move(new_pool);
+    return true;
+}
+
+DbLease acquire_db_connection() {
+    auto p = current_pool();
+    if (!p) {
+        return DbLease();
+    }
+    return p->acquire();
+}
+
 void close_db_connection() {
-    if (conn) {
-        PQfinish(conn);
-        conn = nullptr;
-        std::cout << "[KITHLY] Database connection closed." << std::endl;
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (pool) {
+        // Leases point into the pool: call only after workers have stopped
+        pool.reset();
+        KITHLY_LOG_INFO("KITHLY", "Database connection closed");
+    }
+}
+
+static std::shared_ptr<const TransitionListener> listener;
+
+void set_transition_listener(TransitionListener new_listener) {
+    std::shared_ptr<const TransitionListener> next;
+    if (new_listener) {
+        next = std::make_shared<const TransitionListener>(std::move(new_listener));
+    }
+    std::atomic_store(&listener, std::move(next));
+}
+
+static void notify_transition(const std::string& tx_id, int new_status) {
+    auto current = std::atomic_load(&listener);
+    if (current) {
+        (*current)(tx_id, new_status);
     }
 }
 
 bool update_status(const std::string& uuid, int new_status) {
-    if (!conn) {
-        std::cerr << "[KITHLY] No database connection." << std::endl;
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
         return false;
     }
+    PGconn* conn = lease.get();
     
-    // Prepare the UPDATE query
-    const char* query = 
-        "UPDATE Global_Gifts SET status_code = $1 WHERE tx_id = $2";
+    // Binary INT4 + UUID params against the per-connection prepared plan
+    sql::UuidParam tx_id(uuid);
+    if (!tx_id.valid) {
+        KITHLY_LOG_ERROR("KITHLY", "Malformed UUID").field("tx_id", uuid);
+        return false;
+    }
+    sql::Int4Param status(new_status);
     
-    // Convert parameters to C strings
-    std::string status_str = std::to_string(new_status);
-    const char* paramValues[2] = { status_str.c_str(), uuid.c_str() };
+    const char* paramValues[2] = { status.bytes, tx_id.bytes };
+    const int paramLengths[2] = { sizeof(status.bytes), sizeof(tx_id.bytes) };
+    const int paramFormats[2] = { sql::BINARY_FORMAT, sql::BINARY_FORMAT };
     
-    // Execute parameterized query (prevents SQL injection)
-    PGresult* res = PQexecParams(
+    // Execute prepared statement (prevents SQL injection)
+    PGresult* res = sql::exec_prepared(
         conn,
-        query,
+        sql::UPDATE_STATUS,
         2,           // number of parameters
-        nullptr,     // let backend deduce param types
         paramValues,
-        nullptr,     // param lengths (text format doesn't need this)
-        nullptr,     // param formats (0 = text)
+        paramLengths,
+        paramFormats,
         0            // result format (0 = text)
     );
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "[KITHLY] UPDATE failed: " 
-                  << PQerrorMessage(conn) << std::endl;
+        KITHLY_LOG_ERROR("KITHLY", "UPDATE failed").field("tx_id", uuid).field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -99,14 +138,729 @@ bool update_status(const std::string& uuid, int new_status) {
     PQclear(res);
     
     if (rows_affected == 0) {
-        std::cerr << "[KITHLY] No transaction found with UUID: " 
-                  << uuid << std::endl;
+        KITHLY_LOG_WARN("KITHLY", "No transaction found").field("tx_id", uuid);
         return false;
     }
     
-    std::cout << "[KITHLY] Status updated to " << new_status 
-              << " for tx_id: " << uuid << std::endl;
+    KITHLY_LOG_INFO("STATUS", "Status updated").field("tx_id", uuid).field("to", new_status);
+    notify_transition(uuid, new_status);
     return true;
 }
 
+/**
+ * Run a bulk status statement whose params are a uuid[] followed by
+ * int4[] columns (then any trailing text params), and map RETURNING
+ * tx_id back to per-row outcomes. With `returned`, the row's remaining
+ * RETURNING columns (text) are copied out per input row.
+ */
+static std::vector<bool> exec_bulk_status(
+    const char* statement,
+    const std::vector<const std::string*>& tx_ids,
+    const std::vector<std::vector<int>>& int_columns,
+    const std::vector<std::string>& trailing_params = {},
+    std::vector<std::vector<std::string>>* returned = nullptr
+) {
+    std::vector<bool> outcomes(tx_ids.size(), false);
+    if (tx_ids.empty()) {
+        return outcomes;
+    }
+    
+    // Build '{uuid,...}' / '{int,...}' array literals. Every UUID is
+    // validated first, so nothing unescaped reaches the literal.
+    std::string id_array = "{";
+    id_array.reserve(tx_ids.size() * 37 + 2);
+    std::vector<std::string> int_arrays(int_columns.size(), "{");
+    
+    std::vector<std::string> keys(tx_ids.size());
+    bool first = true;
+    for (std::size_t i = 0; i < tx_ids.size(); ++i) {
+        sql::UuidParam tx_id(*tx_ids[i]);
+        if (!tx_id.valid) {
+            KITHLY_LOG_ERROR("KITHLY", "Malformed UUID skipped").field("tx_id", *tx_ids[i]);
+            continue;
+        }
+        keys[i].assign(tx_id.bytes, sizeof(tx_id.bytes));
+        
+        if (!first) {
+            id_array += ',';
+            for (auto& arr : int_arrays) arr += ',';
+        }
+        first = false;
+        id_array += *tx_ids[i];
+        for (std::size_t c = 0; c < int_columns.size(); ++c) {
+            int_arrays[c] += std::to_string(int_columns[c][i]);
+        }
+    }
+    
+    if (first) {
+        return outcomes;  // Nothing valid to send
+    }
+    id_array += '}';
+    for (auto& arr : int_arrays) arr += '}';
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return outcomes;
+    }
+    
+    std::vector<const char*> paramValues;
+    paramValues.push_back(id_array.c_str());
+    for (const auto& arr : int_arrays) paramValues.push_back(arr.c_str());
+    for (const auto& param : trailing_params) paramValues.push_back(param.c_str());
+    
+    // Binary result: RETURNING tx_id comes back as 16 raw bytes
+    PGresult* res = sql::exec_prepared(
+        lease.get(), statement, static_cast<int>(paramValues.size()), 
+        paramValues.data(), nullptr, nullptr, 1);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Bulk UPDATE failed").field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return outcomes;
+    }
+    
+    // Key -> result row
+    std::unordered_map<std::string, int> updated;
+    int rows = PQntuples(res);
+    updated.reserve(rows);
+    for (int r = 0; r < rows; ++r) {
+        updated.emplace(std::string(PQgetvalue(res, r, 0), PQgetlength(res, r, 0)), r);
+    }
+    
+    if (returned) {
+        returned->assign(tx_ids.size(), {});
+    }
+    for (std::size_t i = 0; i < tx_ids.size(); ++i) {
+        auto it = keys[i].empty() ? updated.end() : updated.find(keys[i]);
+        outcomes[i] = it != updated.end();
+        if (returned && outcomes[i]) {
+            for (int c = 1; c < PQnfields(res); ++c) {
+                (*returned)[i].emplace_back(PQgetvalue(res, it->second, c), PQgetlength(res, it->second, c));
+            }
+        }
+    }
+    PQclear(res);
+    
+    KITHLY_LOG_INFO("STATUS", "Bulk status update").field("updated", rows).field("requested", tx_ids.size());
+    return outcomes;
+}
+
+std::vector<bool> bulk_update_status(const std::vector<StatusUpdate>& updates) {
+    std::vector<const std::string*> tx_ids;
+    std::vector<std::vector<int>> columns(1);
+    tx_ids.reserve(updates.size());
+    columns[0].reserve(updates.size());
+    for (const auto& update : updates) {
+        tx_ids.push_back(&update.first);
+        columns[0].push_back(update.second);
+    }
+    
+    auto outcomes = exec_bulk_status(sql::BULK_UPDATE_STATUS, tx_ids, columns);
+    for (std::size_t i = 0; i < updates.size(); ++i) {
+        if (outcomes[i]) notify_transition(updates[i].first, updates[i].second);
+    }
+    return outcomes;
+}
+
+std::vector<bool> bulk_transition_status(const std::vector<StatusTransition>& transitions) {
+    std::vector<const std::string*> tx_ids;
+    std::vector<std::vector<int>> columns(2);
+    std::vector<std::size_t> legal;   // Index into transitions per row sent
+    tx_ids.reserve(transitions.size());
+    legal.reserve(transitions.size());
+    for (auto& column : columns) column.reserve(transitions.size());
+    for (std::size_t i = 0; i < transitions.size(); ++i) {
+        const auto& t = transitions[i];
+        // Runtime pairs (e.g. from fired deadlines) get the same table
+        // check that status::checked applies at compile time
+        if (!status::can_transition(t.from_status, t.to_status)) {
+            KITHLY_LOG_ERROR("STATUS", "Illegal transition refused").field("tx_id", t.tx_id)
+                .field("from", status::name(t.from_status)).field("to", status::name(t.to_status));
+            continue;
+        }
+        tx_ids.push_back(&t.tx_id);
+        columns[0].push_back(t.from_status);
+        columns[1].push_back(t.to_status);
+        legal.push_back(i);
+    }
+    
+    auto applied = exec_bulk_status(sql::BULK_TRANSITION_STATUS, tx_ids, columns);
+    std::vector<bool> outcomes(transitions.size(), false);
+    for (std::size_t k = 0; k < legal.size(); ++k) {
+        if (applied[k]) {
+            outcomes[legal[k]] = true;
+            notify_transition(transitions[legal[k]].tx_id, transitions[legal[k]].to_status);
+        }
+    }
+    return outcomes;
+}
+
+std::vector<OutboxedTransition> bulk_transition_with_outbox(
+    const std::vector<StatusTransition>& transitions,
+    const char* event_type,
+    std::chrono::seconds lease
+) {
+    std::vector<const std::string*> tx_ids;
+    std::vector<std::vector<int>> columns(2);
+    std::vector<std::size_t> legal;
+    tx_ids.reserve(transitions.size());
+    legal.reserve(transitions.size());
+    for (auto& column : columns) column.reserve(transitions.size());
+    for (std::size_t i = 0; i < transitions.size(); ++i) {
+        const auto& t = transitions[i];
+        if (!status::can_transition(t.from_status, t.to_status)) {
+            KITHLY_LOG_ERROR("STATUS", "Illegal transition refused").field("tx_id", t.tx_id)
+                .field("from", status::name(t.from_status)).field("to", status::name(t.to_status));
+            continue;
+        }
+        tx_ids.push_back(&t.tx_id);
+        columns[0].push_back(t.from_status);
+        columns[1].push_back(t.to_status);
+        legal.push_back(i);
+    }
+    
+    const std::string at_ms = std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::vector<std::vector<std::string>> returned;
+    auto applied = exec_bulk_status(sql::TRANSITION_WITH_OUTBOX, tx_ids, columns,
+                                    { event_type, at_ms, std::to_string(lease.count()) }, &returned);
+    
+    std::vector<OutboxedTransition> outcomes(transitions.size());
+    for (std::size_t k = 0; k < legal.size(); ++k) {
+        if (!applied[k] || returned[k].size() != 2) {
+            continue;
+        }
+        OutboxedTransition& out = outcomes[legal[k]];
+        out.applied = true;
+        out.payment_ref = std::move(returned[k][0]);
+        out.outbox_id = std::strtoll(returned[k][1].c_str(), nullptr, 10);
+        notify_transition(transitions[legal[k]].tx_id, transitions[legal[k]].to_status);
+    }
+    return outcomes;
+}
+
+// TEXT in binary format is the raw bytes, so a view needs no NUL. An
+// empty view may have a null data(), which libpq would send as NULL.
+static const char* text_value(std::string_view v) {
+    return v.empty() ? "" : v.data();
+}
+
+static int text_length(std::string_view v) {
+    return static_cast<int>(v.size());
+}
+
+namespace {
+
+/**
+ * Bound parameters of sql::INSERT_GIFT. Values point into the members,
+ * so the struct is neither copied nor moved.
+ */
+struct InsertGiftParams {
+    static constexpr int COUNT = 13;
+    static constexpr int formats[COUNT] = {
+        sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT,
+        sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT,
+        sql::BINARY_FORMAT, sql::TEXT_FORMAT,
+        sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT
+    };
+
+    sql::UuidParam tx_id;
+    sql::Int4Param quantity;
+    char unit_price[32];
+    char is_surprise;
+    const char* values[COUNT];
+    int lengths[COUNT];
+
+    InsertGiftParams(const GiftPayloadView& payload, std::string_view handshake_token)
+        : tx_id(payload.tx_id), quantity(payload.quantity),
+          is_surprise(payload.is_surprise ? 1 : 0) {
+        std::snprintf(unit_price, sizeof(unit_price), "%.2f", payload.unit_price);
+        const std::string_view tx_ref = payload.effective_tx_ref();
+        
+        // TEXT params go in binary format (raw bytes + length), so string
+        // views straight out of the job payload need no NUL-terminated copy
+        const char* v[COUNT] = {
+            tx_id.bytes, text_value(tx_ref), text_value(payload.idempotency_key),
+            text_value(payload.sender_id), text_value(payload.receiver_phone),
+            text_value(payload.receiver_name), text_value(payload.shop_id),
+            text_value(payload.product_id), quantity.bytes, unit_price,
+            payload.message.empty() ? nullptr : payload.message.data(), &is_surprise,
+            text_value(handshake_token)
+        };
+        const int l[COUNT] = {
+            sizeof(tx_id.bytes), text_length(tx_ref), text_length(payload.idempotency_key),
+            text_length(payload.sender_id), text_length(payload.receiver_phone),
+            text_length(payload.receiver_name), text_length(payload.shop_id),
+            text_length(payload.product_id), sizeof(quantity.bytes), 0,
+            text_length(payload.message), 1, text_length(handshake_token)
+        };
+        std::copy(v, v + COUNT, values);
+        std::copy(l, l + COUNT, lengths);
+    }
+
+    InsertGiftParams(const InsertGiftParams&) = delete;
+    InsertGiftParams& operator=(const InsertGiftParams&) = delete;
+};
+
+} // namespace
+
+/**
+ * true if a statement error is worth retrying: connection exceptions (08),
+ * rollbacks such as serialization failure or deadlock (40), insufficient
+ * resources (53) and operator intervention (57). Anything else the row
+ * would hit again. No SQLSTATE means a client-side failure, also retried.
+ */
+static bool transient_error(const PGresult* res) {
+    const char* sqlstate = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+    if (!sqlstate || std::strlen(sqlstate) != 5) {
+        return true;
+    }
+    const std::string_view error_class(sqlstate, 2);
+    return error_class == "08" || error_class == "40" || error_class == "53" || error_class == "57";
+}
+
+/**
+ * Map an INSERT_GIFT result (nullptr = connection lost) to its outcome
+ */
+static GiftWrite insert_outcome(const PGresult* res) {
+    if (!res) {
+        return GiftWrite::FAILED;
+    }
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        // A pipeline aborted by an earlier row's error carries no error of
+        // its own; the row itself may be fine
+        if (PQresultStatus(res) == PGRES_PIPELINE_ABORTED || transient_error(res)) {
+            KITHLY_LOG_ERROR("KITHLY", "INSERT failed").field("error", PQresultErrorMessage(res));
+            return GiftWrite::FAILED;
+        }
+        // Bad data or a constraint other than the idempotency key (e.g. a
+        // tx_ref collision): retrying would fail the same way
+        KITHLY_LOG_ERROR("KITHLY", "INSERT rejected")
+            .field("sqlstate", PQresultErrorField(res, PG_DIAG_SQLSTATE))
+            .field("error", PQresultErrorMessage(res));
+        return GiftWrite::INVALID;
+    }
+    // RETURNING is empty when ON CONFLICT swallowed the row
+    return PQntuples(res) == 1 ? GiftWrite::INSERTED : GiftWrite::DUPLICATE;
+}
+
+/**
+ * Map a FIND_BY_IDEMPOTENCY_KEY result to found / not found / error
+ */
+static std::optional<bool> lookup_outcome(const PGresult* res) {
+    if (!res) {
+        return std::nullopt;
+    }
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Idempotency lookup failed").field("error", PQresultErrorMessage(res));
+        return std::nullopt;
+    }
+    return PQntuples(res) > 0;
+}
+
+std::optional<bool> gift_exists(std::string_view idempotency_key) {
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return std::nullopt;
+    }
+    
+    const char* paramValues[1] = { text_value(idempotency_key) };
+    const int paramLengths[1] = { text_length(idempotency_key) };
+    const int paramFormats[1] = { sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::FIND_BY_IDEMPOTENCY_KEY, 1, paramValues, paramLengths, paramFormats, 0);
+    auto found = lookup_outcome(res);
+    PQclear(res);
+    return found;
+}
+
+std::vector<std::optional<bool>> gifts_exist(const std::vector<std::string_view>& idempotency_keys) {
+    std::vector<std::optional<bool>> outcomes(idempotency_keys.size());
+    if (idempotency_keys.empty()) {
+        return outcomes;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return outcomes;
+    }
+    
+    StatementPipeline pipeline(lease);
+    for (std::size_t i = 0; i < idempotency_keys.size(); ++i) {
+        const char* paramValues[1] = { text_value(idempotency_keys[i]) };
+        const int paramLengths[1] = { text_length(idempotency_keys[i]) };
+        const int paramFormats[1] = { sql::BINARY_FORMAT };
+        pipeline.send_prepared(sql::FIND_BY_IDEMPOTENCY_KEY, 1, paramValues, paramLengths, paramFormats,
+                               [&outcomes, i](const PGresult* res) { outcomes[i] = lookup_outcome(res); });
+    }
+    
+    if (!pipeline.run()) {
+        KITHLY_LOG_ERROR("KITHLY", "Pipelined idempotency lookup failed").field("keys", idempotency_keys.size());
+    }
+    return outcomes;
+}
+
+GiftWrite insert_gift(const GiftPayload& payload, const std::string& handshake_token) {
+    return insert_gift(GiftPayloadView(payload), handshake_token);
+}
+
+GiftWrite insert_gift(const GiftPayloadView& payload, std::string_view handshake_token) {
+    InsertGiftParams params(payload, handshake_token);
+    if (!params.tx_id.valid) {
+        KITHLY_LOG_ERROR("KITHLY", "Malformed UUID").field("tx_id", payload.tx_id);
+        return GiftWrite::INVALID;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return GiftWrite::FAILED;
+    }
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::INSERT_GIFT, InsertGiftParams::COUNT,
+        params.values, params.lengths, InsertGiftParams::formats, 0);
+    GiftWrite outcome = insert_outcome(res);
+    PQclear(res);
+    
+    if (outcome == GiftWrite::INSERTED) {
+        notify_transition(std::string(payload.tx_id), Status::FUNDS_LOCKED);  // ESCROW_LOCKED starts the 48h clock
+    }
+    return outcome;
+}
+
+std::vector<GiftWrite> insert_gifts(const std::vector<GiftPayloadView>& payloads,
+                                    const std::vector<std::string_view>& handshake_tokens) {
+    std::vector<GiftWrite> outcomes(payloads.size(), GiftWrite::FAILED);
+    if (payloads.empty()) {
+        return outcomes;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return outcomes;
+    }
+    
+    // One implicit transaction per row: a failing INSERT aborts only itself
+    StatementPipeline pipeline(lease);
+    for (std::size_t i = 0; i < payloads.size(); ++i) {
+        InsertGiftParams params(payloads[i], handshake_tokens[i]);
+        if (!params.tx_id.valid) {
+            KITHLY_LOG_ERROR("KITHLY", "Malformed UUID").field("tx_id", payloads[i].tx_id);
+            outcomes[i] = GiftWrite::INVALID;
+            continue;
+        }
+        pipeline.send_prepared(sql::INSERT_GIFT, InsertGiftParams::COUNT,
+                               params.values, params.lengths, InsertGiftParams::formats,
+                               [&outcomes, i](const PGresult* res) { outcomes[i] = insert_outcome(res); });
+    }
+    
+    if (!pipeline.run()) {
+        KITHLY_LOG_ERROR("KITHLY", "Pipelined INSERT failed").field("rows", payloads.size());
+    }
+    
+    for (std::size_t i = 0; i < payloads.size(); ++i) {
+        if (outcomes[i] == GiftWrite::INSERTED) {
+            notify_transition(std::string(payloads[i].tx_id), Status::FUNDS_LOCKED);
+        }
+    }
+    return outcomes;
+}
+
+std::optional<std::string> find_reroute_origin(const std::string& tx_id) {
+    sql::UuidParam tx(tx_id);
+    if (!tx.valid) {
+        KITHLY_LOG_ERROR("KITHLY", "Malformed UUID").field("tx_id", tx_id);
+        return std::string();
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return std::nullopt;
+    }
+    
+    const char* paramValues[1] = { tx.bytes };
+    const int paramLengths[1] = { sizeof(tx.bytes) };
+    const int paramFormats[1] = { sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::FIND_REROUTE_ORIGIN, 1, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Reroute origin lookup failed")
+            .field("tx_id", tx_id).field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return std::nullopt;
+    }
+    
+    std::string shop_id;
+    if (PQntuples(res) == 1 && !PQgetisnull(res, 0, 0)) {
+        shop_id = PQgetvalue(res, 0, 0);
+    }
+    PQclear(res);
+    return shop_id;
+}
+
+bool offer_reroute(const std::string& tx_id, const std::string& shop_id,
+                   double distance_km, std::chrono::minutes ttl) {
+    sql::UuidParam tx(tx_id);
+    sql::UuidParam shop(shop_id);
+    if (!tx.valid || !shop.valid) {
+        KITHLY_LOG_ERROR("KITHLY", "Malformed UUID in reroute offer").field("tx_id", tx_id).field("shop_id", shop_id);
+        return false;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return false;
+    }
+    
+    char distance[32];
+    std::snprintf(distance, sizeof(distance), "%.3f", distance_km);
+    sql::Int4Param minutes(static_cast<int32_t>(ttl.count()));
+    
+    const char* paramValues[4] = { tx.bytes, shop.bytes, distance, minutes.bytes };
+    const int paramLengths[4] = { sizeof(tx.bytes), sizeof(shop.bytes), 0, sizeof(minutes.bytes) };
+    const int paramFormats[4] = { sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::TEXT_FORMAT, sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::OFFER_REROUTE, 4, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Reroute offer failed")
+            .field("tx_id", tx_id).field("shop_id", shop_id).field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return false;
+    }
+    
+    // Empty RETURNING: this shop already won the gift
+    bool offered = PQntuples(res) == 1;
+    PQclear(res);
+    return offered;
+}
+
+RerouteClaim claim_reroute(const std::string& tx_id, const std::string& shop_id,
+                           std::vector<std::string>& released) {
+    released.clear();
+    sql::UuidParam tx(tx_id);
+    sql::UuidParam shop(shop_id);
+    if (!tx.valid || !shop.valid) {
+        KITHLY_LOG_ERROR("KITHLY", "Malformed UUID in reroute claim").field("tx_id", tx_id).field("shop_id", shop_id);
+        return RerouteClaim::LOST;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return RerouteClaim::FAILED;
+    }
+    
+    sql::Int4Param status(ALT_FOUND);
+    const char* paramValues[3] = { tx.bytes, shop.bytes, status.bytes };
+    const int paramLengths[3] = { sizeof(tx.bytes), sizeof(shop.bytes), sizeof(status.bytes) };
+    const int paramFormats[3] = { sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::CLAIM_REROUTE, 3, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
+        KITHLY_LOG_ERROR("KITHLY", "Reroute claim failed")
+            .field("tx_id", tx_id).field("shop_id", shop_id).field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return RerouteClaim::FAILED;
+    }
+    
+    const bool won = std::atoi(PQgetvalue(res, 0, 0)) > 0;
+    int rows = PQntuples(res);
+    for (int r = 0; won && r < rows; ++r) {
+        if (!PQgetisnull(res, r, 1)) {
+            released.emplace_back(PQgetvalue(res, r, 1));
+        }
+    }
+    PQclear(res);
+    
+    if (!won) {
+        return RerouteClaim::LOST;
+    }
+    notify_transition(tx_id, ALT_FOUND);
+    return RerouteClaim::WON;
+}
+
+bool lease_reroute_fanout(const std::string& tx_id, std::chrono::minutes ttl, int max_rounds) {
+    sql::UuidParam tx(tx_id);
+    if (!tx.valid) {
+        KITHLY_LOG_ERROR("KITHLY", "Malformed UUID").field("tx_id", tx_id);
+        return false;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return false;
+    }
+    
+    sql::Int4Param minutes(static_cast<int32_t>(ttl.count()));
+    sql::Int4Param rounds(max_rounds);
+    const char* paramValues[3] = { tx.bytes, minutes.bytes, rounds.bytes };
+    const int paramLengths[3] = { sizeof(tx.bytes), sizeof(minutes.bytes), sizeof(rounds.bytes) };
+    const int paramFormats[3] = { sql::BINARY_FORMAT, sql::BINARY_FORMAT, sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::LEASE_REROUTE_FANOUT, 3, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Reroute fan-out lease failed")
+            .field("tx_id", tx_id).field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return false;
+    }
+    
+    bool leased = PQntuples(res) == 1;
+    PQclear(res);
+    return leased;
+}
+
+std::optional<std::vector<std::pair<std::string, std::string>>> release_lapsed_reroute_offers(int limit) {
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return std::nullopt;
+    }
+    
+    sql::Int4Param batch(limit);
+    const char* paramValues[1] = { batch.bytes };
+    const int paramLengths[1] = { sizeof(batch.bytes) };
+    const int paramFormats[1] = { sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::RELEASE_LAPSED_OFFERS, 1, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Lapsed offer release failed").field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return std::nullopt;
+    }
+    
+    std::vector<std::pair<std::string, std::string>> released;
+    int rows = PQntuples(res);
+    released.reserve(rows);
+    for (int r = 0; r < rows; ++r) {
+        released.emplace_back(PQgetvalue(res, r, 0), PQgetvalue(res, r, 1));
+    }
+    PQclear(res);
+    return released;
+}
+
+std::vector<std::pair<std::string, int>> find_idle_reroutes(int limit) {
+    std::vector<std::pair<std::string, int>> tx_ids;
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("KITHLY", "No database connection");
+        return tx_ids;
+    }
+    
+    sql::Int4Param batch(limit);
+    const char* paramValues[1] = { batch.bytes };
+    const int paramLengths[1] = { sizeof(batch.bytes) };
+    const int paramFormats[1] = { sql::BINARY_FORMAT };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::SCAN_IDLE_REROUTES, 1, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("KITHLY", "Idle reroute scan failed").field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return tx_ids;
+    }
+    
+    int rows = PQntuples(res);
+    tx_ids.reserve(rows);
+    for (int r = 0; r < rows; ++r) {
+        tx_ids.emplace_back(PQgetvalue(res, r, 0), std::atoi(PQgetvalue(res, r, 1)));
+    }
+    PQclear(res);
+    return tx_ids;
+}
+
+ProofWrite insert_delivery_proof(Evidence& proof) {
+    sql::UuidParam tx(proof.tx_id);
+    std::optional<sql::UuidParam> uploader;
+    if (!proof.uploaded_by.empty()) {
+        uploader.emplace(proof.uploaded_by);
+    }
+    if (!tx.valid || (uploader && !uploader->valid) || proof.proof_type.empty() ||
+        proof.receipt_hash.size() != 64) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Malformed delivery proof")
+            .field("tx_id", proof.tx_id).field("uploaded_by", proof.uploaded_by);
+        return ProofWrite::INVALID;
+    }
+    
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        KITHLY_LOG_ERROR("EVIDENCE", "No database connection");
+        return ProofWrite::FAILED;
+    }
+    
+    const std::string file_size = std::to_string(proof.file_size);
+    char latitude[32];
+    char longitude[32];
+    std::snprintf(latitude, sizeof(latitude), "%.8f", proof.latitude);
+    std::snprintf(longitude, sizeof(longitude), "%.8f", proof.longitude);
+    
+    const char* paramValues[10] = {
+        tx.bytes,
+        proof.proof_type.c_str(),
+        proof.file_url.c_str(),
+        proof.receipt_hash.c_str(),
+        file_size.c_str(),
+        proof.mime_type.empty() ? nullptr : proof.mime_type.c_str(),
+        std::isnan(proof.latitude) ? nullptr : latitude,
+        std::isnan(proof.longitude) ? nullptr : longitude,
+        proof.device_info.empty() ? nullptr : proof.device_info.c_str(),
+        uploader ? uploader->bytes : nullptr,
+    };
+    const int paramLengths[10] = { sizeof(tx.bytes), 0, 0, 0, 0, 0, 0, 0, 0, uploader ? 16 : 0 };
+    const int paramFormats[10] = {
+        sql::BINARY_FORMAT, sql::TEXT_FORMAT, sql::TEXT_FORMAT, sql::TEXT_FORMAT, sql::TEXT_FORMAT,
+        sql::TEXT_FORMAT, sql::TEXT_FORMAT, sql::TEXT_FORMAT, sql::TEXT_FORMAT, sql::BINARY_FORMAT
+    };
+    
+    PGresult* res = sql::exec_prepared(
+        lease.get(), sql::INSERT_DELIVERY_PROOF, 10, paramValues, paramLengths, paramFormats, 0);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Delivery proof insert failed")
+            .field("tx_id", proof.tx_id).field("error", PQerrorMessage(lease.get()));
+        PQclear(res);
+        return ProofWrite::FAILED;
+    }
+    
+    // Conflicting proof committed after our snapshot: a duplicate whose
+    // row we cannot see yet
+    if (PQntuples(res) == 0) {
+        PQclear(res);
+        proof.proof_id.clear();
+        return ProofWrite::DUPLICATE;
+    }
+    
+    const std::string_view outcome = PQgetvalue(res, 0, 0);
+    if (outcome == "missing") {
+        PQclear(res);
+        return ProofWrite::NOT_FOUND;
+    }
+    
+    proof.proof_id = PQgetvalue(res, 0, 1);
+    proof.file_url = PQgetvalue(res, 0, 2);
+    proof.receipt_hash = PQgetvalue(res, 0, 3);
+    PQclear(res);
+    return outcome == "inserted" ? ProofWrite::INSERTED : ProofWrite::DUPLICATE;
+}
+
 } // namespace Kithly
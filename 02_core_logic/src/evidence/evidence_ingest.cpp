@@ -0,0 +1,386 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * evidence/evidence_ingest.cpp - Zero-copy Streaming, Hashing & Object Store
+ * =============================================================================
+ */
+
+#include "evidence.h"
+#include "db_connector.h"
+#include "log.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Kithly {
+namespace evidence {
+
+namespace {
+
+metrics::LatencyHistogram& ingest_latency(IngestResult result) {
+    static metrics::LatencyHistogram& stored = metrics::histogram(
+        "kithly_evidence_ingest_seconds", "result=\"stored\"",
+        "Evidence upload from first body byte to proof row");
+    static metrics::LatencyHistogram& duplicate = metrics::histogram(
+        "kithly_evidence_ingest_seconds", "result=\"duplicate\"");
+    static metrics::LatencyHistogram& failed = metrics::histogram(
+        "kithly_evidence_ingest_seconds", "result=\"failed\"");
+    switch (result) {
+        case IngestResult::STORED:    return stored;
+        case IngestResult::DUPLICATE: return duplicate;
+        default:                      return failed;
+    }
+}
+
+bool write_all(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * read/write through one chunk buffer (sources splice cannot take)
+ */
+IngestResult copy_buffered(int src_fd, int dst_fd, uint64_t remaining, Sha256& hasher) {
+    std::unique_ptr<char[]> buffer(new char[CHUNK_SIZE]);
+    while (remaining > 0) {
+        ssize_t n = read(src_fd, buffer.get(), static_cast<std::size_t>(std::min<uint64_t>(remaining, CHUNK_SIZE)));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return IngestResult::TRUNCATED;
+        }
+        hasher.update(buffer.get(), static_cast<std::size_t>(n));
+        if (!write_all(dst_fd, buffer.get(), static_cast<std::size_t>(n))) {
+            return IngestResult::STORAGE_FAILED;
+        }
+        remaining -= static_cast<uint64_t>(n);
+    }
+    return IngestResult::STORED;
+}
+
+#if defined(__linux__)
+
+struct Pipe {
+    int read_fd = -1;
+    int write_fd = -1;
+
+    bool open() {
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC) != 0) {
+            return false;
+        }
+        read_fd = fds[0];
+        write_fd = fds[1];
+        // One chunk in flight; the default (64 KB) is already enough, a
+        // smaller pipe-max-size just leaves it as is
+        fcntl(write_fd, F_SETPIPE_SZ, static_cast<int>(CHUNK_SIZE));
+        return true;
+    }
+
+    ~Pipe() {
+        if (read_fd >= 0) close(read_fd);
+        if (write_fd >= 0) close(write_fd);
+    }
+};
+
+/**
+ * src → body pipe (splice), duplicated into the store pipe (tee) and
+ * spliced into dst, so the file write never touches user space. The
+ * body pipe is then drained into the chunk buffer for the hasher.
+ *
+ * @param unsupported Set if src cannot be spliced (nothing was consumed)
+ */
+IngestResult copy_spliced(int src_fd, int dst_fd, uint64_t remaining, Sha256& hasher,
+                          bool& unsupported) {
+    Pipe body;
+    Pipe store;
+    if (!body.open() || !store.open()) {
+        unsupported = true;
+        return IngestResult::STORAGE_FAILED;
+    }
+    std::unique_ptr<char[]> buffer(new char[CHUNK_SIZE]);
+    bool first = true;
+
+    while (remaining > 0) {
+        ssize_t n = splice(src_fd, nullptr, body.write_fd, nullptr,
+                           static_cast<std::size_t>(std::min<uint64_t>(remaining, CHUNK_SIZE)),
+                           SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && first && (errno == EINVAL || errno == ENOSYS)) {
+            unsupported = true;
+            return IngestResult::STORAGE_FAILED;
+        }
+        if (n <= 0) {
+            return IngestResult::TRUNCATED;   // EOF, reset or SO_RCVTIMEO
+        }
+        first = false;
+
+        // tee never consumes; take what it duplicated out of the body
+        // pipe before asking for the rest
+        std::size_t pending = static_cast<std::size_t>(n);
+        while (pending > 0) {
+            ssize_t teed = tee(body.read_fd, store.write_fd, pending, 0);
+            if (teed < 0 && errno == EINTR) {
+                continue;
+            }
+            if (teed <= 0) {
+                return IngestResult::STORAGE_FAILED;
+            }
+
+            std::size_t moved = 0;
+            while (moved < static_cast<std::size_t>(teed)) {
+                ssize_t m = splice(store.read_fd, nullptr, dst_fd, nullptr,
+                                   static_cast<std::size_t>(teed) - moved, SPLICE_F_MOVE);
+                if (m < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (m <= 0) {
+                    return IngestResult::STORAGE_FAILED;
+                }
+                moved += static_cast<std::size_t>(m);
+            }
+
+            std::size_t hashed = 0;
+            while (hashed < static_cast<std::size_t>(teed)) {
+                ssize_t r = read(body.read_fd, buffer.get(), static_cast<std::size_t>(teed) - hashed);
+                if (r < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (r <= 0) {
+                    return IngestResult::STORAGE_FAILED;
+                }
+                hasher.update(buffer.get(), static_cast<std::size_t>(r));
+                hashed += static_cast<std::size_t>(r);
+            }
+            pending -= static_cast<std::size_t>(teed);
+        }
+        remaining -= static_cast<uint64_t>(n);
+    }
+    return IngestResult::STORED;
+}
+
+#endif
+
+} // namespace
+
+const char* ingest_result_name(IngestResult result) {
+    switch (result) {
+        case IngestResult::STORED:         return "stored";
+        case IngestResult::DUPLICATE:      return "duplicate";
+        case IngestResult::NOT_FOUND:      return "not_found";
+        case IngestResult::INVALID:        return "invalid";
+        case IngestResult::TOO_LARGE:      return "too_large";
+        case IngestResult::TRUNCATED:      return "truncated";
+        case IngestResult::STORAGE_FAILED: return "storage_failed";
+        case IngestResult::DB_FAILED:      return "db_failed";
+    }
+    return "unknown";
+}
+
+IngestResult stream_copy(int src_fd, int dst_fd, std::string_view prefix,
+                         uint64_t length, Sha256& hasher) {
+    const std::size_t head = static_cast<std::size_t>(std::min<uint64_t>(prefix.size(), length));
+    if (head > 0) {
+        hasher.update(prefix.data(), head);
+        if (!write_all(dst_fd, prefix.data(), head)) {
+            return IngestResult::STORAGE_FAILED;
+        }
+    }
+    const uint64_t remaining = length - head;
+    if (remaining == 0) {
+        return IngestResult::STORED;
+    }
+
+#if defined(__linux__)
+    bool unsupported = false;
+    IngestResult result = copy_spliced(src_fd, dst_fd, remaining, hasher, unsupported);
+    if (!unsupported) {
+        return result;
+    }
+#endif
+    return copy_buffered(src_fd, dst_fd, remaining, hasher);
+}
+
+// =============================================================================
+// OBJECT STORE
+// =============================================================================
+
+ObjectStore::ObjectStore(std::string root, std::string base_url)
+    : root_(std::move(root)), staging_(root_ + "/.staging"), base_url_(std::move(base_url)) {
+    while (!base_url_.empty() && base_url_.back() == '/') {
+        base_url_.pop_back();
+    }
+}
+
+bool ObjectStore::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(staging_, ec);
+    if (ec) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Cannot create staging directory")
+            .field("path", staging_).field("error", ec.message());
+        return false;
+    }
+    return true;
+}
+
+std::optional<ObjectStore::Staged> ObjectStore::stage() {
+    Staged staged;
+    staged.path = staging_ + "/upload-XXXXXX";
+    staged.fd = mkostemp(staged.path.data(), O_CLOEXEC);
+    if (staged.fd < 0) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Cannot create staging file")
+            .field("dir", staging_).field("error", std::strerror(errno));
+        return std::nullopt;
+    }
+    return staged;
+}
+
+std::string ObjectStore::object_path(const std::string& receipt_hash) const {
+    return root_ + "/" + receipt_hash.substr(0, 2) + "/" + receipt_hash;
+}
+
+std::optional<std::string> ObjectStore::commit(Staged& staged, const std::string& receipt_hash) {
+    const std::string dir = root_ + "/" + receipt_hash.substr(0, 2);
+    const std::string path = object_path(receipt_hash);
+
+    if (fsync(staged.fd) != 0) {
+        KITHLY_LOG_ERROR("EVIDENCE", "fsync failed").field("error", std::strerror(errno));
+        discard(staged);
+        return std::nullopt;
+    }
+    fchmod(staged.fd, 0644);
+    close(staged.fd);
+    staged.fd = -1;
+
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Cannot create object directory")
+            .field("dir", dir).field("error", std::strerror(errno));
+        discard(staged);
+        return std::nullopt;
+    }
+    // Same hash, same bytes: replacing an existing object is harmless
+    if (rename(staged.path.c_str(), path.c_str()) != 0) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Cannot move object into place")
+            .field("path", path).field("error", std::strerror(errno));
+        discard(staged);
+        return std::nullopt;
+    }
+    staged.path.clear();
+
+    // Make the rename itself durable before the row points at it
+    int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+    if (base_url_.empty()) {
+        return "file://" + path;
+    }
+    return base_url_ + "/" + receipt_hash.substr(0, 2) + "/" + receipt_hash;
+}
+
+void ObjectStore::discard(Staged& staged) {
+    if (staged.fd >= 0) {
+        close(staged.fd);
+        staged.fd = -1;
+    }
+    if (!staged.path.empty()) {
+        unlink(staged.path.c_str());
+        staged.path.clear();
+    }
+}
+
+// =============================================================================
+// INGESTOR
+// =============================================================================
+
+EvidenceIngestor::EvidenceIngestor(Options options)
+    : options_(std::move(options)), store_(options_.root, options_.base_url) {}
+
+IngestResult EvidenceIngestor::ingest(Evidence& proof, int src_fd, std::string_view prefix,
+                                      uint64_t content_length) {
+    if (content_length > options_.max_bytes) {
+        return IngestResult::TOO_LARGE;
+    }
+    // Column widths from 003_evidence_vault.sql / 014_evidence_ingest.sql;
+    // rejected before a single body byte is read
+    if (proof.tx_id.size() != 36 || proof.proof_type.empty() || proof.proof_type.size() > 50 ||
+        proof.mime_type.size() > 100) {
+        return IngestResult::INVALID;
+    }
+
+    const auto start = metrics::Clock::now();
+    auto finish = [&](IngestResult result) {
+        ingest_latency(result).record_since(start);
+        return result;
+    };
+
+    auto staged = store_.stage();
+    if (!staged) {
+        return finish(IngestResult::STORAGE_FAILED);
+    }
+
+    Sha256 hasher;
+    const IngestResult copied = stream_copy(src_fd, staged->fd, prefix, content_length, hasher);
+    if (copied != IngestResult::STORED) {
+        KITHLY_LOG_WARN("EVIDENCE", "Upload aborted")
+            .field("tx_id", proof.tx_id).field("result", ingest_result_name(copied))
+            .field("received", hasher.bytes_hashed()).field("expected", content_length);
+        store_.discard(*staged);
+        return finish(copied);
+    }
+
+    proof.receipt_hash = hasher.hex_digest();
+    proof.file_size = static_cast<int>(content_length);
+
+    // Object first: a crash before the insert leaves an unreferenced
+    // object, never a proof row without its photo. Objects whose row
+    // loses the insert stay too (another row may share the hash).
+    auto url = store_.commit(*staged, proof.receipt_hash);
+    if (!url) {
+        return finish(IngestResult::STORAGE_FAILED);
+    }
+    proof.file_url = *url;
+
+    switch (insert_delivery_proof(proof)) {
+        case ProofWrite::INSERTED:
+            KITHLY_LOG_INFO("EVIDENCE", "Proof stored")
+                .field("tx_id", proof.tx_id).field("proof_id", proof.proof_id)
+                .field("proof_type", proof.proof_type).field("bytes", content_length)
+                .field("receipt_hash", proof.receipt_hash);
+            return finish(IngestResult::STORED);
+        case ProofWrite::DUPLICATE:
+            return finish(IngestResult::DUPLICATE);
+        case ProofWrite::NOT_FOUND:
+            return finish(IngestResult::NOT_FOUND);
+        case ProofWrite::INVALID:
+            return finish(IngestResult::INVALID);
+        case ProofWrite::FAILED:
+            break;
+    }
+    return finish(IngestResult::DB_FAILED);
+}
+
+} // namespace evidence
+} // namespace Kithly
@@ -0,0 +1,377 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * evidence/evidence_server.cpp - Embedded HTTP PUT /evidence Endpoint
+ * =============================================================================
+ */
+
+#include "evidence.h"
+#include "log.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace Kithly {
+namespace evidence {
+
+namespace {
+
+constexpr std::size_t MAX_HEADER_BYTES = 8192;
+
+// Between body bytes, not for the whole upload
+constexpr timeval RECV_TIMEOUT{10, 0};
+constexpr timeval SEND_TIMEOUT{5, 0};
+
+void send_all(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+void respond(int fd, int code, const char* reason, const std::string& body) {
+    std::string response = "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\n";
+    response += "Content-Type: application/json\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    send_all(fd, response);
+}
+
+void respond_error(int fd, int code, const char* reason, const char* error) {
+    respond(fd, code, reason, nlohmann::json{{"error", error}}.dump());
+}
+
+struct Request {
+    std::string_view method;
+    std::string_view target;
+    std::vector<std::pair<std::string, std::string_view>> headers;   // Lowercased names
+
+    std::optional<std::string_view> header(std::string_view name) const {
+        for (const auto& [key, value] : headers) {
+            if (key == name) {
+                return value;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+/**
+ * Parse the request line and headers (head excludes the blank line)
+ */
+bool parse_head(std::string_view head, Request& request) {
+    std::size_t eol = head.find("\r\n");
+    std::string_view line = head.substr(0, eol);
+    std::size_t sp1 = line.find(' ');
+    std::size_t sp2 = line.rfind(' ');
+    if (sp1 == std::string_view::npos || sp2 <= sp1) {
+        return false;
+    }
+    request.method = line.substr(0, sp1);
+    request.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+    while (eol != std::string_view::npos) {
+        head.remove_prefix(eol + 2);
+        eol = head.find("\r\n");
+        std::string_view field = head.substr(0, eol);
+        std::size_t colon = field.find(':');
+        if (colon == std::string_view::npos) {
+            continue;
+        }
+        std::string name(field.substr(0, colon));
+        for (char& c : name) {
+            c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        request.headers.emplace_back(std::move(name), trim(field.substr(colon + 1)));
+    }
+    return true;
+}
+
+double parse_coordinate(std::optional<std::string_view> value) {
+    if (!value || value->empty()) {
+        return std::nan("");
+    }
+    std::string text(*value);
+    char* end = nullptr;
+    double parsed = std::strtod(text.c_str(), &end);
+    return (end && *end == '\0' && std::isfinite(parsed)) ? parsed : std::nan("");
+}
+
+bool keys_match(std::string_view expected, std::string_view provided) {
+    // Length leaks, content does not
+    if (expected.size() != provided.size()) {
+        return false;
+    }
+    unsigned char diff = 0;
+    for (std::size_t i = 0; i < expected.size(); ++i) {
+        diff |= static_cast<unsigned char>(expected[i] ^ provided[i]);
+    }
+    return diff == 0;
+}
+
+} // namespace
+
+EvidenceServer::EvidenceServer(EvidenceIngestor& ingestor, Options options)
+    : ingestor_(ingestor), options_(std::move(options)) {
+    options_.handlers = std::max<std::size_t>(1, options_.handlers);
+}
+
+EvidenceServer::~EvidenceServer() {
+    stop();
+}
+
+bool EvidenceServer::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        KITHLY_LOG_ERROR("EVIDENCE", "socket failed").field("error", std::strerror(errno));
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // Without a key there is nothing to authenticate the caller, so only
+    // a co-located gateway may reach the endpoint
+    const bool loopback_only = options_.internal_key.empty();
+    if (loopback_only) {
+        KITHLY_LOG_WARN("EVIDENCE", "No internal key configured; listening on loopback only")
+            .field("port", options_.port);
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(loopback_only ? INADDR_LOOPBACK : INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(options_.port));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 128) != 0) {
+        KITHLY_LOG_ERROR("EVIDENCE", "Cannot listen")
+            .field("port", options_.port).field("error", std::strerror(errno));
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    for (std::size_t i = 0; i < options_.handlers; ++i) {
+        handlers_.emplace_back(&EvidenceServer::handler_loop, this);
+    }
+    acceptor_ = std::thread(&EvidenceServer::accept_loop, this);
+    KITHLY_LOG_INFO("EVIDENCE", "Accepting PUT /evidence")
+        .field("port", options_.port)
+        .field("bind", loopback_only ? "loopback" : "any")
+        .field("handlers", options_.handlers)
+        .field("sha256", sha256_backend());
+    return true;
+}
+
+void EvidenceServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    ready_.notify_all();
+    if (acceptor_.joinable()) {
+        acceptor_.join();
+    }
+    for (auto& handler : handlers_) {
+        handler.join();
+    }
+    handlers_.clear();
+    close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void EvidenceServer::accept_loop() {
+    while (running_) {
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, 500);
+        if (ready <= 0) {
+            continue;
+        }
+
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &RECV_TIMEOUT, sizeof(RECV_TIMEOUT));
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &SEND_TIMEOUT, sizeof(SEND_TIMEOUT));
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.size() < options_.max_pending) {
+                pending_.push_back(client);
+                client = -1;
+            }
+        }
+        if (client >= 0) {
+            // Shed load; the gateway retries
+            respond_error(client, 503, "Service Unavailable", "busy");
+            close(client);
+            continue;
+        }
+        ready_.notify_one();
+    }
+}
+
+void EvidenceServer::handler_loop() {
+    while (true) {
+        int client;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return !pending_.empty() || !running_; });
+            if (pending_.empty()) {
+                return;   // Stopping with nothing queued
+            }
+            client = pending_.front();
+            pending_.pop_front();
+        }
+        serve(client);
+        close(client);
+    }
+}
+
+void EvidenceServer::serve(int client_fd) {
+    // Headers only; whatever body bytes come with them become the prefix
+    char buffer[MAX_HEADER_BYTES];
+    std::size_t received = 0;
+    std::size_t head_end = std::string_view::npos;
+    while (received < sizeof(buffer)) {
+        ssize_t n = recv(client_fd, buffer + received, sizeof(buffer) - received, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return;
+        }
+        received += static_cast<std::size_t>(n);
+        head_end = std::string_view(buffer, received).find("\r\n\r\n");
+        if (head_end != std::string_view::npos) {
+            break;
+        }
+    }
+    if (head_end == std::string_view::npos) {
+        respond_error(client_fd, 431, "Request Header Fields Too Large", "headers_too_large");
+        return;
+    }
+
+    Request request;
+    if (!parse_head(std::string_view(buffer, head_end), request)) {
+        respond_error(client_fd, 400, "Bad Request", "malformed_request");
+        return;
+    }
+    const std::string_view prefix(buffer + head_end + 4, received - head_end - 4);
+
+    // /evidence/<tx_id>/<proof_type>
+    constexpr std::string_view ROUTE = "/evidence/";
+    std::string_view path = request.target;
+    if (path.rfind(ROUTE, 0) != 0) {
+        respond_error(client_fd, 404, "Not Found", "not_found");
+        return;
+    }
+    path.remove_prefix(ROUTE.size());
+    const std::size_t slash = path.find('/');
+    if (slash == std::string_view::npos || path.find('/', slash + 1) != std::string_view::npos) {
+        respond_error(client_fd, 404, "Not Found", "not_found");
+        return;
+    }
+    if (request.method != "PUT") {
+        respond_error(client_fd, 405, "Method Not Allowed", "method_not_allowed");
+        return;
+    }
+
+    if (!options_.internal_key.empty()) {
+        auto key = request.header("x-internal-key");
+        if (!key || !keys_match(options_.internal_key, *key)) {
+            respond_error(client_fd, 403, "Forbidden", "forbidden");
+            return;
+        }
+    }
+
+    // The length is the storage bound and the truncation check
+    auto length_header = request.header("content-length");
+    if (request.header("transfer-encoding") || !length_header || length_header->empty()) {
+        respond_error(client_fd, 411, "Length Required", "content_length_required");
+        return;
+    }
+    uint64_t content_length = 0;
+    for (char c : *length_header) {
+        if (c < '0' || c > '9' || content_length > ingestor_.options().max_bytes) {
+            content_length = UINT64_MAX;
+            break;
+        }
+        content_length = content_length * 10 + static_cast<uint64_t>(c - '0');
+    }
+    if (content_length > ingestor_.options().max_bytes) {
+        respond_error(client_fd, 413, "Payload Too Large", ingest_result_name(IngestResult::TOO_LARGE));
+        return;
+    }
+
+    Evidence proof{};
+    proof.tx_id = std::string(path.substr(0, slash));
+    proof.proof_type = std::string(path.substr(slash + 1));
+    proof.mime_type = std::string(request.header("content-type").value_or(""));
+    proof.latitude = parse_coordinate(request.header("x-latitude"));
+    proof.longitude = parse_coordinate(request.header("x-longitude"));
+    proof.uploaded_by = std::string(request.header("x-uploaded-by").value_or(""));
+    proof.device_info = std::string(request.header("x-device-info").value_or(""));
+    if (!proof.device_info.empty() && !nlohmann::json::accept(proof.device_info)) {
+        respond_error(client_fd, 400, "Bad Request", "device_info_not_json");
+        return;
+    }
+
+    auto expect = request.header("expect");
+    if (expect && prefix.empty() && *expect == "100-continue") {
+        send_all(client_fd, "HTTP/1.1 100 Continue\r\n\r\n");
+    }
+
+    const IngestResult result = ingestor_.ingest(proof, client_fd, prefix, content_length);
+
+    nlohmann::json body{{"result", ingest_result_name(result)}};
+    if (result == IngestResult::STORED || result == IngestResult::DUPLICATE) {
+        body["proof_id"] = proof.proof_id;
+        body["receipt_hash"] = proof.receipt_hash;
+        body["photo_url"] = proof.file_url;
+        body["file_size"] = proof.file_size;
+    }
+
+    switch (result) {
+        case IngestResult::STORED:         respond(client_fd, 201, "Created", body.dump()); break;
+        case IngestResult::DUPLICATE:      respond(client_fd, 200, "OK", body.dump()); break;
+        case IngestResult::NOT_FOUND:      respond(client_fd, 404, "Not Found", body.dump()); break;
+        case IngestResult::INVALID:        respond(client_fd, 400, "Bad Request", body.dump()); break;
+        case IngestResult::TOO_LARGE:      respond(client_fd, 413, "Payload Too Large", body.dump()); break;
+        case IngestResult::TRUNCATED:      respond(client_fd, 400, "Bad Request", body.dump()); break;
+        case IngestResult::STORAGE_FAILED: respond(client_fd, 500, "Internal Server Error", body.dump()); break;
+        case IngestResult::DB_FAILED:      respond(client_fd, 503, "Service Unavailable", body.dump()); break;
+    }
+}
+
+} // namespace evidence
+} // namespace Kithly
@@ -0,0 +1,256 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * evidence/sha256.cpp - SHA-256 Block Functions (SHA-NI / ARMv8 / Portable)
+ * =============================================================================
+ */
+
+#include "sha256.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SHA__) && defined(__SSE4_1__)
+#include <immintrin.h>
+#define KITHLY_SHA256_X86 1
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+#include <arm_neon.h>
+#define KITHLY_SHA256_ARM 1
+#endif
+
+namespace Kithly {
+
+namespace {
+
+alignas(16) constexpr uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+constexpr uint32_t INITIAL_STATE[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+#if defined(KITHLY_SHA256_X86)
+
+// =============================================================================
+// SHA-NI: two rounds per sha256rnds2, state kept as ABEF / CDGH
+// =============================================================================
+
+void compress(uint32_t state[8], const uint8_t* data, std::size_t blocks) {
+    const __m128i byteswap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0])), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4])), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);   // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);        // CDGH
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const __m128i abef = state0;
+        const __m128i cdgh = state1;
+        __m128i w[4];
+
+        for (int g = 0; g < 16; ++g) {
+            __m128i& current = w[g & 3];
+            if (g < 4) {
+                current = _mm_shuffle_epi8(
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * g)), byteswap);
+            } else {
+                // W[g] from W[g-4..g-1]
+                const __m128i& w1 = w[(g - 3) & 3];
+                const __m128i& w2 = w[(g - 2) & 3];
+                const __m128i& w3 = w[(g - 1) & 3];
+                current = _mm_sha256msg1_epu32(current, w1);
+                current = _mm_add_epi32(current, _mm_alignr_epi8(w3, w2, 4));
+                current = _mm_sha256msg2_epu32(current, w3);
+            }
+            __m128i msg = _mm_add_epi32(current, _mm_load_si128(reinterpret_cast<const __m128i*>(&K[4 * g])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);              // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xB1);           // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);        // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);           // HGFE
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), state1);
+}
+
+#elif defined(KITHLY_SHA256_ARM)
+
+// =============================================================================
+// ARMv8 SHA2: four rounds per sha256h/sha256h2 pair
+// =============================================================================
+
+void compress(uint32_t state[8], const uint8_t* data, std::size_t blocks) {
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+
+    for (; blocks > 0; --blocks, data += 64) {
+        const uint32x4_t abcd = state0;
+        const uint32x4_t efgh = state1;
+        uint32x4_t w[4];
+
+        for (int g = 0; g < 16; ++g) {
+            uint32x4_t& current = w[g & 3];
+            if (g < 4) {
+                current = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * g)));
+            } else {
+                current = vsha256su1q_u32(vsha256su0q_u32(current, w[(g - 3) & 3]),
+                                          w[(g - 2) & 3], w[(g - 1) & 3]);
+            }
+            const uint32x4_t msg = vaddq_u32(current, vld1q_u32(&K[4 * g]));
+            const uint32x4_t previous = state0;
+            state0 = vsha256hq_u32(state0, state1, msg);
+            state1 = vsha256h2q_u32(state1, previous, msg);
+        }
+
+        state0 = vaddq_u32(state0, abcd);
+        state1 = vaddq_u32(state1, efgh);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+#else
+
+// =============================================================================
+// PORTABLE
+// =============================================================================
+
+inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void compress(uint32_t state[8], const uint8_t* data, std::size_t blocks) {
+    uint32_t w[64];
+    for (; blocks > 0; --blocks, data += 64) {
+        for (int i = 0; i < 16; ++i) {
+            w[i] = (uint32_t(data[4 * i]) << 24) | (uint32_t(data[4 * i + 1]) << 16) |
+                   (uint32_t(data[4 * i + 2]) << 8) | uint32_t(data[4 * i + 3]);
+        }
+        for (int i = 16; i < 64; ++i) {
+            const uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            const uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; ++i) {
+            const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            const uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+    }
+}
+
+#endif
+
+} // namespace
+
+void Sha256::reset() {
+    std::memcpy(state_, INITIAL_STATE, sizeof(state_));
+    block_len_ = 0;
+    total_ = 0;
+}
+
+void Sha256::update(const void* data, std::size_t size) {
+    auto* in = static_cast<const uint8_t*>(data);
+    total_ += size;
+
+    if (block_len_ > 0) {
+        const std::size_t take = std::min(size, BLOCK_SIZE - block_len_);
+        std::memcpy(block_ + block_len_, in, take);
+        block_len_ += take;
+        in += take;
+        size -= take;
+        if (block_len_ < BLOCK_SIZE) {
+            return;
+        }
+        compress(state_, block_, 1);
+        block_len_ = 0;
+    }
+
+    // Whole blocks straight from the caller's buffer
+    if (size >= BLOCK_SIZE) {
+        const std::size_t blocks = size / BLOCK_SIZE;
+        compress(state_, in, blocks);
+        in += blocks * BLOCK_SIZE;
+        size -= blocks * BLOCK_SIZE;
+    }
+
+    if (size > 0) {
+        std::memcpy(block_, in, size);
+        block_len_ = size;
+    }
+}
+
+void Sha256::finish(uint8_t (&digest)[DIGEST_SIZE]) {
+    const uint64_t bits = total_ * 8;
+
+    block_[block_len_++] = 0x80;
+    if (block_len_ > BLOCK_SIZE - 8) {
+        std::memset(block_ + block_len_, 0, BLOCK_SIZE - block_len_);
+        compress(state_, block_, 1);
+        block_len_ = 0;
+    }
+    std::memset(block_ + block_len_, 0, BLOCK_SIZE - 8 - block_len_);
+    for (int i = 0; i < 8; ++i) {
+        block_[BLOCK_SIZE - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+    }
+    compress(state_, block_, 1);
+    block_len_ = 0;
+
+    for (int i = 0; i < 8; ++i) {
+        digest[4 * i]     = static_cast<uint8_t>(state_[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(state_[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(state_[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(state_[i]);
+    }
+}
+
+std::string Sha256::hex_digest() {
+    static constexpr char digits[] = "0123456789abcdef";
+    uint8_t digest[DIGEST_SIZE];
+    finish(digest);
+    std::string out(2 * DIGEST_SIZE, '0');
+    for (std::size_t i = 0; i < DIGEST_SIZE; ++i) {
+        out[2 * i] = digits[digest[i] >> 4];
+        out[2 * i + 1] = digits[digest[i] & 0x0F];
+    }
+    return out;
+}
+
+std::string sha256_hex(std::string_view data) {
+    Sha256 hasher;
+    hasher.update(data);
+    return hasher.hex_digest();
+}
+
+const char* sha256_backend() {
+#if defined(KITHLY_SHA256_X86)
+    return "sha-ni";
+#elif defined(KITHLY_SHA256_ARM)
+    return "armv8-sha2";
+#else
+    return "portable";
+#endif
+}
+
+} // namespace Kithly
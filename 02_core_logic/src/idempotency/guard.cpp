@@ -5,206 +5,178 @@
  * =============================================================================
  */
 
-#include "../include/constants.h"
-#include "../include/structs.h"
-#include "../include/db_connector.h"
+#include "idempotency_guard.h"
+#include "constants.h"
+#include "db_connector.h"
+#include "metrics.h"
+#include "log.h"
 
-#include <mutex>
-#include <unordered_map>
+#include <algorithm>
 #include <chrono>
+#include <mutex>
 
 namespace kithly {
 namespace idempotency {
 
-/**
- * Idempotency Guard
- * Prevents duplicate processing of the same request
- * Critical for payment safety and gift creation
- */
-class IdempotencyGuard {
-public:
-    explicit IdempotencyGuard(std::shared_ptr<db::GiftRepository> gift_repo)
-        : gift_repo_(gift_repo) {}
-
-    /**
-     * Result of idempotency check
-     */
-    struct CheckResult {
-        bool is_duplicate;
-        std::optional<GiftTransaction> existing_transaction;
-    };
-
-    /**
-     * Check if a request is a duplicate
-     * Returns existing transaction if found
-     */
-    Result<CheckResult> check(const UUID& idempotency_key) {
-        // First check in-memory cache (hot path)
-        {
-            std::shared_lock lock(cache_mutex_);
-            auto it = cache_.find(idempotency_key);
-            if (it != cache_.end()) {
-                auto age = std::chrono::steady_clock::now() - it->second.cached_at;
-                if (age < CACHE_TTL) {
-                    return Result<CheckResult>::ok({true, it->second.transaction});
-                }
-            }
-        }
-        
-        // Check database (cold path)
-        auto db_result = gift_repo_->find_by_idempotency_key(idempotency_key);
-        if (!db_result.success) {
-            return Result<CheckResult>::fail(db_result.error.value_or("Database error"));
-        }
-        
-        if (db_result.value->has_value()) {
-            // Found in DB - cache it and return
-            auto& tx = **db_result.value;
-            cache_transaction(idempotency_key, tx);
-            return Result<CheckResult>::ok({true, tx});
-        }
-        
-        // Not a duplicate
-        return Result<CheckResult>::ok({false, std::nullopt});
-    }
+namespace {
 
-    /**
-     * Reserve an idempotency key before processing
-     * Prevents race conditions
-     */
-    Result<bool> reserve(const UUID& idempotency_key) {
-        std::unique_lock lock(cache_mutex_);
-        
-        // Check if already reserved
-        if (reservations_.find(idempotency_key) != reservations_.end()) {
-            return Result<bool>::fail("Key already reserved - concurrent request in progress");
-        }
-        
-        // Reserve with timestamp
-        reservations_[idempotency_key] = std::chrono::steady_clock::now();
-        
-        // Clean up old reservations
-        cleanup_expired_reservations();
-        
-        return Result<bool>::ok(true);
+// Lookup latency, labelled by the path that resolved the key
+Kithly::metrics::LatencyHistogram& check_latency(std::string_view path) {
+    using Kithly::metrics::histogram;
+    static auto& cache = histogram("kithly_idempotency_check_seconds", "path=\"cache\"",
+                                   "Idempotency check latency by resolving path");
+    static auto& bloom = histogram("kithly_idempotency_check_seconds", "path=\"bloom\"");
+    static auto& db = histogram("kithly_idempotency_check_seconds", "path=\"db\"");
+    static auto& pipelined = histogram("kithly_idempotency_check_seconds", "path=\"db_pipeline\"");
+    return path == "cache" ? cache : path == "bloom" ? bloom : path == "db" ? db : pipelined;
+}
+
+constexpr auto CACHE_TTL = std::chrono::hours(Kithly::IDEMPOTENCY_WINDOW_HOURS);
+
+std::mutex installed_mutex;
+std::shared_ptr<IdempotencyGuard> installed;
+
+} // namespace
+
+IdempotencyGuard::IdempotencyGuard(std::size_t cache_capacity,
+                                   std::shared_ptr<ReservationBackend> reservations)
+    : cache_enabled_(cache_capacity > 0),
+      cache_(std::max<std::size_t>(1, cache_capacity), CACHE_TTL),
+      reservations_(std::move(reservations)) {}
+
+KeyState IdempotencyGuard::check(std::string_view key) {
+    const auto start = Kithly::metrics::Clock::now();
+
+    // In-memory cache first (hot path, one shard lock)
+    if (cache_enabled_ && cache_.get(std::string(key))) {
+        check_latency("cache").record_since(start);
+        return KeyState::DUPLICATE;
     }
 
-    /**
-     * Release a reservation (used when processing fails)
-     */
-    void release(const UUID& idempotency_key) {
-        std::unique_lock lock(cache_mutex_);
-        reservations_.erase(idempotency_key);
+    // Never seen within the window: skip the round trip
+    if (definitely_new(key)) {
+        check_latency("bloom").record_since(start);
+        return KeyState::NEW;
     }
 
-    /**
-     * Commit a successful transaction to cache
-     */
-    void commit(const UUID& idempotency_key, const GiftTransaction& tx) {
-        std::unique_lock lock(cache_mutex_);
-        reservations_.erase(idempotency_key);
-        cache_transaction(idempotency_key, tx);
+    // Database (cold path)
+    auto exists = Kithly::gift_exists(key);
+    check_latency("db").record_since(start);
+    if (!exists) {
+        return KeyState::UNKNOWN;
     }
+    if (*exists) {
+        committed(key);
+        return KeyState::DUPLICATE;
+    }
+    return KeyState::NEW;
+}
+
+std::vector<KeyState> IdempotencyGuard::check_all(const std::vector<std::string_view>& keys) {
+    std::vector<KeyState> states(keys.size(), KeyState::NEW);
 
-    /**
-     * RAII guard for reservation
-     */
-    class ReservationGuard {
-    public:
-        ReservationGuard(IdempotencyGuard& parent, const UUID& key)
-            : parent_(parent), key_(key), committed_(false) {}
-        
-        ~ReservationGuard() {
-            if (!committed_) {
-                parent_.release(key_);
-            }
+    // Cache hits and definite filter misses drop out; the rest go to the
+    // database together
+    std::vector<std::size_t> pending;
+    std::vector<std::string_view> lookups;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        const auto start = Kithly::metrics::Clock::now();
+        if (cache_enabled_ && cache_.get(std::string(keys[i]))) {
+            check_latency("cache").record_since(start);
+            states[i] = KeyState::DUPLICATE;
+            continue;
         }
-        
-        void commit(const GiftTransaction& tx) {
-            parent_.commit(key_, tx);
-            committed_ = true;
+        if (definitely_new(keys[i])) {
+            check_latency("bloom").record_since(start);
+            continue;
         }
-        
-    private:
-        IdempotencyGuard& parent_;
-        UUID key_;
-        bool committed_;
-    };
-
-    ReservationGuard make_guard(const UUID& key) {
-        return ReservationGuard(*this, key);
+        pending.push_back(i);
+        lookups.push_back(keys[i]);
     }
-
-private:
-    std::shared_ptr<db::GiftRepository> gift_repo_;
-    
-    // In-memory cache for hot path
-    struct CacheEntry {
-        GiftTransaction transaction;
-        std::chrono::steady_clock::time_point cached_at;
-    };
-    
-    std::unordered_map<UUID, CacheEntry> cache_;
-    std::unordered_map<UUID, std::chrono::steady_clock::time_point> reservations_;
-    mutable std::shared_mutex cache_mutex_;
-    
-    static constexpr auto CACHE_TTL = std::chrono::hours(config::IDEMPOTENCY_WINDOW_HOURS);
-    static constexpr auto RESERVATION_TTL = std::chrono::seconds(30);
-    
-    void cache_transaction(const UUID& key, const GiftTransaction& tx) {
-        cache_[key] = {tx, std::chrono::steady_clock::now()};
+    if (lookups.empty()) {
+        return states;
     }
-    
-    void cleanup_expired_reservations() {
-        auto now = std::chrono::steady_clock::now();
-        for (auto it = reservations_.begin(); it != reservations_.end(); ) {
-            if (now - it->second > RESERVATION_TTL) {
-                it = reservations_.erase(it);
-            } else {
-                ++it;
-            }
+
+    // Recorded once per batch: the round trip every lookup in it shared
+    const auto start = Kithly::metrics::Clock::now();
+    auto exists = Kithly::gifts_exist(lookups);
+    check_latency("db_pipeline").record_since(start);
+
+    for (std::size_t k = 0; k < pending.size(); ++k) {
+        KeyState& state = states[pending[k]];
+        if (!exists[k]) {
+            state = KeyState::UNKNOWN;
+        } else if (*exists[k]) {
+            committed(lookups[k]);
+            state = KeyState::DUPLICATE;
         }
     }
-};
+    return states;
+}
 
-/**
- * Process a gift creation with idempotency protection
- */
-template<typename Func>
-Result<GiftTransaction> with_idempotency(
-    IdempotencyGuard& guard,
-    const UUID& idempotency_key,
-    Func&& create_func
-) {
-    // 1. Check for duplicate
-    auto check = guard.check(idempotency_key);
-    if (!check.success) {
-        return Result<GiftTransaction>::fail(check.error.value_or("Check failed"));
+KeyState IdempotencyGuard::reserve(std::string_view key, uint64_t& token) {
+    token = 0;
+    if (!reservations_) {
+        return KeyState::NEW;
+    }
+    const ReserveOutcome outcome = reservations_->try_reserve(std::string(key));
+    switch (outcome.status) {
+        case ReserveOutcome::Status::ACQUIRED:
+            token = outcome.fencing_token;
+            return KeyState::NEW;
+        case ReserveOutcome::Status::COMMITTED:
+            committed(key);
+            return KeyState::DUPLICATE;
+        case ReserveOutcome::Status::IN_PROGRESS:
+        case ReserveOutcome::Status::UNAVAILABLE:
+            break;
     }
-    
-    if (check.value->is_duplicate) {
-        // Return existing transaction (idempotent behavior)
-        return Result<GiftTransaction>::ok(*check.value->existing_transaction);
+    return KeyState::UNKNOWN;
+}
+
+void IdempotencyGuard::committed(std::string_view key, uint64_t token) {
+    // Cache before committing, so a racing check() never sees neither
+    if (cache_enabled_) {
+        cache_.put(std::string(key), true);
     }
-    
-    // 2. Reserve the key
-    auto reserve = guard.reserve(idempotency_key);
-    if (!reserve.success) {
-        return Result<GiftTransaction>::fail(reserve.error.value_or("Reservation failed"));
+    if (filter_) {
+        filter_->insert(std::string(key));
     }
-    
-    auto reservation = guard.make_guard(idempotency_key);
-    
-    // 3. Execute the creation
-    try {
-        auto result = create_func();
-        if (result.success) {
-            reservation.commit(*result.value);
-        }
-        return result;
-    } catch (const std::exception& e) {
-        return Result<GiftTransaction>::fail(e.what());
+    if (reservations_ && token != 0 && !reservations_->commit(std::string(key), token)) {
+        // Expired and re-taken by another node; the row itself is safe
+        // behind ON CONFLICT, only the claim was lost
+        KITHLY_LOG_WARN("IDEMPOTENCY", "Reservation lost before commit")
+            .field("key", key).field("fencing_token", token);
+    }
+}
+
+void IdempotencyGuard::release(std::string_view key, uint64_t token) {
+    if (reservations_ && token != 0) {
+        reservations_->release(std::string(key), token);
+    }
+}
+
+bool IdempotencyGuard::definitely_new(std::string_view key) const {
+    return filter_ && filter_->ready() && !filter_->may_contain(std::string(key));
+}
+
+IdempotencyGuard::Stats IdempotencyGuard::stats() const {
+    Stats s;
+    s.cache = cache_.stats();
+    if (reservations_) {
+        s.reservations = reservations_->stats();
     }
+    return s;
+}
+
+void install_idempotency_guard(std::shared_ptr<IdempotencyGuard> guard) {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    installed = std::move(guard);
+}
+
+std::shared_ptr<IdempotencyGuard> installed_idempotency_guard() {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    return installed;
 }
 
 } // namespace idempotency
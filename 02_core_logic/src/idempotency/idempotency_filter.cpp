@@ -0,0 +1,234 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * idempotency/idempotency_filter.cpp - Rotating Blocked Bloom Filter
+ * =============================================================================
+ */
+
+#include "idempotency_filter.h"
+#include "db_connector.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+namespace kithly {
+namespace idempotency {
+
+namespace {
+
+using SystemClock = std::chrono::system_clock;
+
+// splitmix64 finaliser: decorrelates the in-block bit positions from the
+// block choice, which both come from one string hash
+uint64_t remix(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+uint64_t key_hash(const std::string& key) {
+    return static_cast<uint64_t>(std::hash<std::string>{}(key));
+}
+
+} // namespace
+
+IdempotencyFilter::IdempotencyFilter() : IdempotencyFilter(Options{}) {}
+
+IdempotencyFilter::IdempotencyFilter(Options options)
+    : options_(options),
+      slice_length_(std::chrono::duration_cast<std::chrono::seconds>(options.window) /
+                    static_cast<long>(std::max<std::size_t>(1, options.slices))) {
+    options_.slices = std::max<std::size_t>(1, options_.slices);
+    if (slice_length_.count() <= 0) {
+        slice_length_ = std::chrono::seconds(1);
+    }
+
+    // The query ORs slices + 1 filters, so each gets its share of the
+    // target rate. Bits per key are those of a standard Bloom at that
+    // rate plus a quarter, which covers the uneven load of 512-bit blocks.
+    const std::size_t ring_size = options_.slices + 1;
+    const double per_filter_rate = options_.false_positive_rate / static_cast<double>(ring_size);
+    const double bits_per_key =
+        1.25 * -std::log(per_filter_rate) / (std::log(2.0) * std::log(2.0));
+    const double keys_per_slice =
+        static_cast<double>(std::max<std::size_t>(1, options_.expected_keys)) /
+        static_cast<double>(options_.slices);
+    blocks_per_slice_ = std::max<std::size_t>(
+        1, static_cast<std::size_t>(std::ceil(keys_per_slice * bits_per_key / (BLOCK_WORDS * 64))));
+
+    ring_.resize(ring_size);
+    for (auto& slice : ring_) {
+        slice.words.reset(new std::atomic<uint64_t>[blocks_per_slice_ * BLOCK_WORDS]);
+        for (std::size_t i = 0; i < blocks_per_slice_ * BLOCK_WORDS; ++i) {
+            slice.words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    rotate_to(slice_of(SystemClock::now()));
+}
+
+int64_t IdempotencyFilter::slice_of(SystemClock::time_point t) const {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch());
+    return seconds.count() / slice_length_.count();
+}
+
+void IdempotencyFilter::rotate_to(int64_t now_slice) {
+    if (current_slice_.load(std::memory_order_acquire) >= now_slice) {
+        return;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(rotate_mutex_);
+    const int64_t current = current_slice_.load(std::memory_order_relaxed);
+    if (current >= now_slice) {
+        return;  // Another thread rotated first
+    }
+
+    // Only slices inside the ring's reach need (re)initialising
+    const int64_t ring_size = static_cast<int64_t>(ring_.size());
+    const int64_t first = std::max(current + 1, now_slice - ring_size + 1);
+    for (int64_t s = first; s <= now_slice; ++s) {
+        Slice& slice = ring_[static_cast<std::size_t>(s % ring_size)];
+        for (std::size_t i = 0; i < blocks_per_slice_ * BLOCK_WORDS; ++i) {
+            slice.words[i].store(0, std::memory_order_relaxed);
+        }
+        slice.epoch_slice = s;
+    }
+    current_slice_.store(now_slice, std::memory_order_release);
+}
+
+void IdempotencyFilter::set_bits(Slice& slice, uint64_t hash) {
+    // Block from the high bits (multiply-shift range reduction), bit
+    // positions by double hashing within the block
+    const std::size_t block = static_cast<std::size_t>(
+        ((hash >> 32) * static_cast<uint64_t>(blocks_per_slice_)) >> 32);
+    std::atomic<uint64_t>* words = &slice.words[block * BLOCK_WORDS];
+
+    const uint64_t mixed = remix(hash);
+    const uint32_t a = static_cast<uint32_t>(mixed);
+    const uint32_t b = static_cast<uint32_t>(mixed >> 32) | 1u;
+    for (unsigned i = 0; i < BITS_PER_KEY; ++i) {
+        const uint32_t bit = (a + i * b) & 511u;
+        words[bit >> 6].fetch_or(uint64_t{1} << (bit & 63), std::memory_order_relaxed);
+    }
+}
+
+bool IdempotencyFilter::test_bits(const Slice& slice, uint64_t hash) const {
+    const std::size_t block = static_cast<std::size_t>(
+        ((hash >> 32) * static_cast<uint64_t>(blocks_per_slice_)) >> 32);
+    const std::atomic<uint64_t>* words = &slice.words[block * BLOCK_WORDS];
+
+    const uint64_t mixed = remix(hash);
+    const uint32_t a = static_cast<uint32_t>(mixed);
+    const uint32_t b = static_cast<uint32_t>(mixed >> 32) | 1u;
+    for (unsigned i = 0; i < BITS_PER_KEY; ++i) {
+        const uint32_t bit = (a + i * b) & 511u;
+        if (!(words[bit >> 6].load(std::memory_order_relaxed) & (uint64_t{1} << (bit & 63)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void IdempotencyFilter::insert(const std::string& key) {
+    insert(key, SystemClock::now());
+}
+
+void IdempotencyFilter::insert(const std::string& key, SystemClock::time_point created_at) {
+    const int64_t now_slice = slice_of(SystemClock::now());
+    rotate_to(now_slice);
+
+    // Future timestamps (clock skew against Postgres) count as now
+    const int64_t s = std::min(slice_of(created_at), now_slice);
+    if (s < now_slice - static_cast<int64_t>(options_.slices)) {
+        return;  // Older than the window
+    }
+
+    const uint64_t hash = key_hash(key);
+    std::shared_lock<std::shared_mutex> lock(rotate_mutex_);
+    Slice& slice = ring_[static_cast<std::size_t>(s % static_cast<int64_t>(ring_.size()))];
+    if (slice.epoch_slice == s) {
+        set_bits(slice, hash);
+    }
+}
+
+bool IdempotencyFilter::may_contain(const std::string& key) {
+    rotate_to(slice_of(SystemClock::now()));
+
+    const uint64_t hash = key_hash(key);
+    std::shared_lock<std::shared_mutex> lock(rotate_mutex_);
+    for (const auto& slice : ring_) {
+        if (test_bits(slice, hash)) {
+            maybe_hits_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    definite_misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+long IdempotencyFilter::seed_from_database() {
+    auto lease = Kithly::acquire_db_connection();
+    if (!lease) {
+        std::cerr << "[IDEMPOTENCY] No database connection - filter not seeded" << std::endl;
+        return -1;
+    }
+    PGconn* conn = lease.get();
+
+    // Served by idx_global_gifts_created_at (011_idempotency_filter.sql)
+    const std::string hours = std::to_string(options_.window.count());
+    const char* params[1] = { hours.c_str() };
+    const char* query = R"(
+        SELECT idempotency_key, EXTRACT(EPOCH FROM created_at)::int8
+        FROM Global_Gifts
+        WHERE created_at > NOW() - make_interval(hours => $1::int)
+    )";
+
+    if (!PQsendQueryParams(conn, query, 1, nullptr, params, nullptr, nullptr, 0) ||
+        !PQsetSingleRowMode(conn)) {
+        std::cerr << "[IDEMPOTENCY] Seed query failed: " << PQerrorMessage(conn) << std::endl;
+        lease.invalidate();
+        return -1;
+    }
+
+    long loaded = 0;
+    bool failed = false;
+    while (PGresult* res = PQgetResult(conn)) {
+        ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_SINGLE_TUPLE) {
+            SystemClock::time_point created_at{std::chrono::seconds(
+                std::strtoll(PQgetvalue(res, 0, 1), nullptr, 10))};
+            insert(PQgetvalue(res, 0, 0), created_at);
+            ++loaded;
+        } else if (status != PGRES_TUPLES_OK) {
+            std::cerr << "[IDEMPOTENCY] Seed failed: " << PQerrorMessage(conn) << std::endl;
+            failed = true;
+        }
+        PQclear(res);
+    }
+
+    if (failed) {
+        return -1;
+    }
+
+    ready_.store(true, std::memory_order_release);
+    std::cout << "[IDEMPOTENCY] Filter seeded with " << loaded << " keys ("
+              << stats().bytes / 1024 << " KiB)" << std::endl;
+    return loaded;
+}
+
+IdempotencyFilter::Stats IdempotencyFilter::stats() const {
+    Stats s;
+    s.definite_misses = definite_misses_.load(std::memory_order_relaxed);
+    s.maybe_hits = maybe_hits_.load(std::memory_order_relaxed);
+    s.bytes = ring_.size() * blocks_per_slice_ * BLOCK_WORDS * sizeof(uint64_t);
+    return s;
+}
+
+} // namespace idempotency
+} // namespace kithly
@@ -0,0 +1,203 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * idempotency/reservation_backend.cpp - Local and Redis Reservation Backends
+ * =============================================================================
+ */
+
+#include "reservation_backend.h"
+#include <iostream>
+
+namespace kithly {
+namespace idempotency {
+
+namespace {
+
+// KEYS[1] = reservation key, KEYS[2] = fencing counter, ARGV[1] = TTL ms.
+// Returns the fencing token, 0 if reserved elsewhere, -1 if committed.
+constexpr const char* RESERVE_LUA = R"lua(
+local current = redis.call('GET', KEYS[1])
+if current then
+    if string.sub(current, 1, 2) == 'c:' then
+        return -1
+    end
+    return 0
+end
+local token = redis.call('INCR', KEYS[2])
+redis.call('SET', KEYS[1], 'r:' .. token, 'NX', 'PX', ARGV[1])
+return token
+)lua";
+
+// KEYS[1] = reservation key, ARGV[1] = fencing token, ARGV[2] = window ms
+constexpr const char* COMMIT_LUA = R"lua(
+if redis.call('GET', KEYS[1]) == 'r:' .. ARGV[1] then
+    redis.call('SET', KEYS[1], 'c:' .. ARGV[1], 'PX', ARGV[2])
+    return 1
+end
+return 0
+)lua";
+
+// KEYS[1] = reservation key, ARGV[1] = fencing token
+constexpr const char* RELEASE_LUA = R"lua(
+if redis.call('GET', KEYS[1]) == 'r:' .. ARGV[1] then
+    return redis.call('DEL', KEYS[1])
+end
+return 0
+)lua";
+
+} // namespace
+
+// =============================================================================
+// LOCAL
+// =============================================================================
+
+LocalReservationBackend::LocalReservationBackend(SteadyClock::duration reservation_ttl)
+    : table_(reservation_ttl) {}
+
+ReserveOutcome LocalReservationBackend::try_reserve(const std::string& key) {
+    const uint64_t token = next_token_.fetch_add(1, std::memory_order_relaxed);
+    if (!table_.try_reserve(key, token)) {
+        return {ReserveOutcome::Status::IN_PROGRESS};
+    }
+    return {ReserveOutcome::Status::ACQUIRED, token};
+}
+
+bool LocalReservationBackend::commit(const std::string& key, uint64_t fencing_token) {
+    // The committed transaction itself lives in the guard's cache
+    return table_.release(key, fencing_token);
+}
+
+void LocalReservationBackend::release(const std::string& key, uint64_t fencing_token) {
+    table_.release(key, fencing_token);
+}
+
+CacheStats LocalReservationBackend::stats() const {
+    return table_.stats();
+}
+
+// =============================================================================
+// REDIS
+// =============================================================================
+
+RedisReservationBackend::RedisReservationBackend(std::shared_ptr<sw::redis::Redis> redis)
+    : RedisReservationBackend(std::move(redis), Options{}) {}
+
+RedisReservationBackend::RedisReservationBackend(std::shared_ptr<sw::redis::Redis> redis,
+                                                 Options options)
+    : redis_(std::move(redis)),
+      options_(std::move(options)),
+      fence_key_(options_.key_prefix + "fence"),
+      local_(options_.reservation_ttl),
+      committed_(options_.l1_capacity, options_.l1_ttl),
+      reserve_script_{RESERVE_LUA, {}},
+      commit_script_{COMMIT_LUA, {}},
+      release_script_{RELEASE_LUA, {}} {}
+
+long long RedisReservationBackend::run(Script& script,
+                                       std::initializer_list<sw::redis::StringView> keys,
+                                       std::initializer_list<sw::redis::StringView> args) {
+    std::string sha;
+    {
+        std::lock_guard<std::mutex> lock(script_mutex_);
+        if (script.sha.empty()) {
+            script.sha = redis_->script_load(script.source);
+        }
+        sha = script.sha;
+    }
+
+    round_trips_.fetch_add(1, std::memory_order_relaxed);
+    try {
+        return redis_->evalsha<long long>(sha, keys, args);
+    } catch (const sw::redis::ReplyError& e) {
+        if (std::string(e.what()).rfind("NOSCRIPT", 0) != 0) {
+            throw;
+        }
+        {
+            std::lock_guard<std::mutex> lock(script_mutex_);
+            script.sha.clear();
+        }
+        // EVAL caches the script server-side; the next call reloads the SHA
+        return redis_->eval<long long>(script.source, keys, args);
+    }
+}
+
+ReserveOutcome RedisReservationBackend::try_reserve(const std::string& key) {
+    // L1: known-committed keys and this node's own in-flight keys never
+    // need the round trip
+    if (committed_.get(key)) {
+        l1_hits_.fetch_add(1, std::memory_order_relaxed);
+        return {ReserveOutcome::Status::COMMITTED};
+    }
+    if (!local_.try_reserve(key)) {
+        l1_hits_.fetch_add(1, std::memory_order_relaxed);
+        return {ReserveOutcome::Status::IN_PROGRESS};
+    }
+
+    long long reply = 0;
+    try {
+        const std::string ttl = std::to_string(options_.reservation_ttl.count());
+        reply = run(reserve_script_, {redis_key(key), fence_key_}, {ttl});
+    } catch (const sw::redis::Error& e) {
+        local_.release(key);
+        std::cerr << "[IDEMPOTENCY] Redis reserve failed for " << key << ": " << e.what() << std::endl;
+        return {ReserveOutcome::Status::UNAVAILABLE};
+    }
+
+    if (reply > 0) {
+        return {ReserveOutcome::Status::ACQUIRED, static_cast<uint64_t>(reply)};
+    }
+
+    local_.release(key);
+    if (reply < 0) {
+        committed_.put(key, 0);
+        return {ReserveOutcome::Status::COMMITTED};
+    }
+    return {ReserveOutcome::Status::IN_PROGRESS};
+}
+
+bool RedisReservationBackend::commit(const std::string& key, uint64_t fencing_token) {
+    long long reply = 0;
+    try {
+        const std::string window = std::to_string(options_.committed_ttl.count());
+        reply = run(commit_script_, {redis_key(key)}, {std::to_string(fencing_token), window});
+    } catch (const sw::redis::Error& e) {
+        local_.release(key);
+        std::cerr << "[IDEMPOTENCY] Redis commit failed for " << key << ": " << e.what() << std::endl;
+        return false;
+    }
+
+    if (reply != 1) {
+        // Our reservation expired and someone else holds the key now;
+        // leave the local entry alone, it may belong to the new holder
+        std::cerr << "[IDEMPOTENCY] Commit rejected for " << key
+                  << ": fencing token " << fencing_token << " is stale" << std::endl;
+        return false;
+    }
+
+    committed_.put(key, fencing_token);
+    local_.release(key);
+    return true;
+}
+
+void RedisReservationBackend::release(const std::string& key, uint64_t fencing_token) {
+    try {
+        if (run(release_script_, {redis_key(key)}, {std::to_string(fencing_token)}) == 0) {
+            return;  // Stale token: nothing of ours to release
+        }
+    } catch (const sw::redis::Error& e) {
+        // The Redis key expires on its own after the reservation TTL
+        std::cerr << "[IDEMPOTENCY] Redis release failed for " << key << ": " << e.what() << std::endl;
+    }
+    local_.release(key);
+}
+
+CacheStats RedisReservationBackend::stats() const {
+    CacheStats s;
+    s.hits = l1_hits_.load(std::memory_order_relaxed);
+    s.misses = round_trips_.load(std::memory_order_relaxed);
+    s.size = local_.stats().size;
+    return s;
+}
+
+} // namespace idempotency
+} // namespace kithly
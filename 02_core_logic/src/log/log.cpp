@@ -0,0 +1,443 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * log/log.cpp - Lock-Free Log Ring and Background Drainer
+ * =============================================================================
+ */
+
+#include "log.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace Kithly {
+namespace log {
+
+namespace {
+
+constexpr std::string_view LEVEL_NAMES[] = {"debug", "info", "warn", "error"};
+
+// Room always kept for ,"truncated":true}\n
+constexpr std::size_t TAIL_RESERVE = 20;
+
+// Widest scalar value a field can write (int64, double, bool)
+constexpr std::size_t SCALAR_RESERVE = 24;
+
+// =============================================================================
+// RING
+// =============================================================================
+
+/**
+ * Bounded multi-producer ring (Vyukov): producers claim a slot with one
+ * CAS on tail_ and publish it through the slot's sequence number; the
+ * single drainer consumes in order without contending with them.
+ */
+class LogRing {
+public:
+    static constexpr std::size_t CAPACITY = 4096;   // Power of two, 2 MiB of slots
+
+    LogRing() {
+        for (std::size_t i = 0; i < CAPACITY; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(Level level, const char* data, std::size_t size) {
+        uint64_t pos = tail_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & (CAPACITY - 1)];
+            const uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+            const int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Full: the drainer is a whole ring behind
+            } else {
+                pos = tail_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->size = static_cast<uint32_t>(size);
+        std::memcpy(slot->data, data, size);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Hand the oldest published line to sink; single consumer only
+     */
+    template <typename Sink>
+    bool pop(Sink&& sink) {
+        Slot& slot = slots_[head_ & (CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != head_ + 1) {
+            return false;
+        }
+        sink(slot.level, std::string_view(slot.data, slot.size));
+        slot.sequence.store(head_ + CAPACITY, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        Level level;
+        uint32_t size;
+        char data[Record::MAX_BYTES];
+    };
+
+    std::array<Slot, CAPACITY> slots_;
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    alignas(64) uint64_t head_ = 0;               // Drainer only
+};
+
+void write_all(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return;  // Nowhere left to report it
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
+
+int fd_for(Level level) {
+    return level >= Level::WARN ? STDERR_FILENO : STDOUT_FILENO;
+}
+
+// =============================================================================
+// DRAINER
+// =============================================================================
+
+class Drainer {
+public:
+    void push(Level level, const char* data, std::size_t size) {
+        if (!running_.load(std::memory_order_acquire)) {
+            write_all(fd_for(level), data, size);
+            written_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!ring_->push(level, data, size)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void start() {
+        std::lock_guard<std::mutex> lock(control_);
+        if (running_.load()) {
+            return;
+        }
+        if (!ring_) {
+            ring_ = std::make_unique<LogRing>();
+        }
+        running_.store(true, std::memory_order_release);
+        thread_ = std::thread(&Drainer::run, this);
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(control_);
+        if (!running_.exchange(false)) {
+            return;
+        }
+        thread_.join();
+        // Lines claimed just before running_ flipped
+        drain_once();
+        flush();
+    }
+
+    Stats stats() const {
+        return Stats{written_.load(std::memory_order_relaxed), dropped_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    static constexpr std::size_t FLUSH_BYTES = 64 * 1024;
+
+    std::unique_ptr<LogRing> ring_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> written_{0};
+    std::atomic<uint64_t> dropped_{0};
+    uint64_t reported_drops_ = 0;
+    std::mutex control_;
+    std::thread thread_;
+    std::string out_;   // stdout batch
+    std::string err_;   // stderr batch
+
+    void run() {
+        out_.reserve(FLUSH_BYTES * 2);
+        err_.reserve(FLUSH_BYTES);
+        while (running_.load(std::memory_order_acquire)) {
+            if (drain_once() == 0) {
+                flush();
+                // Idle: lines wait at most this long, the hot path never does
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+
+    std::size_t drain_once() {
+        std::size_t lines = 0;
+        while (ring_->pop([this](Level level, std::string_view line) {
+            (level >= Level::WARN ? err_ : out_).append(line);
+        })) {
+            ++lines;
+            if (out_.size() >= FLUSH_BYTES || err_.size() >= FLUSH_BYTES) {
+                flush();
+            }
+        }
+        written_.fetch_add(lines, std::memory_order_relaxed);
+        report_drops();
+        return lines;
+    }
+
+    void report_drops() {
+        const uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped == reported_drops_) {
+            return;
+        }
+        char line[160];
+        const int n = std::snprintf(line, sizeof(line),
+                                    "{\"level\":\"warn\",\"tag\":\"LOG\",\"msg\":\"Ring full, lines dropped\","
+                                    "\"dropped\":%llu,\"dropped_total\":%llu}\n",
+                                    static_cast<unsigned long long>(dropped - reported_drops_),
+                                    static_cast<unsigned long long>(dropped));
+        err_.append(line, static_cast<std::size_t>(n));
+        reported_drops_ = dropped;
+    }
+
+    void flush() {
+        if (!out_.empty()) {
+            write_all(STDOUT_FILENO, out_.data(), out_.size());
+            out_.clear();
+        }
+        if (!err_.empty()) {
+            write_all(STDERR_FILENO, err_.data(), err_.size());
+            err_.clear();
+        }
+    }
+};
+
+Drainer& drainer() {
+    static auto* instance = new Drainer();  // Never destroyed: usable from any exit path
+    return *instance;
+}
+
+std::atomic<uint32_t> payload_sample_every{100};
+
+/**
+ * "YYYY-MM-DDTHH:MM:SS.uuuuuuZ"; the calendar part is cached per thread
+ * and recomputed once a second
+ */
+std::size_t format_timestamp(char* out) {
+    using namespace std::chrono;
+    thread_local std::time_t cached_second = -1;
+    thread_local char cached[20];
+
+    const auto now = system_clock::now();
+    const auto micros = duration_cast<microseconds>(now.time_since_epoch()).count();
+    const std::time_t second = static_cast<std::time_t>(micros / 1000000);
+    if (second != cached_second) {
+        std::tm tm{};
+        gmtime_r(&second, &tm);
+        std::strftime(cached, sizeof(cached), "%Y-%m-%dT%H:%M:%S", &tm);
+        cached_second = second;
+    }
+    std::memcpy(out, cached, 19);
+    std::snprintf(out + 19, 10, ".%06lldZ", static_cast<long long>(micros % 1000000));
+    return 27;
+}
+
+} // namespace
+
+// =============================================================================
+// RECORD
+// =============================================================================
+
+void set_level(Level level) {
+    runtime_level.store(std::max(static_cast<int>(level), static_cast<int>(COMPILED_MIN_LEVEL)),
+                        std::memory_order_relaxed);
+}
+
+Record::Record(Level level, std::string_view tag, std::string_view message) : level_(level) {
+    char ts[32];
+    const std::size_t ts_len = format_timestamp(ts);
+    raw("{\"ts\":\"");
+    raw(std::string_view(ts, ts_len));
+    raw("\",\"level\":\"");
+    raw(LEVEL_NAMES[static_cast<int>(level)]);
+    raw("\",\"tag\":");
+    quoted(tag);
+    raw(",\"msg\":");
+    quoted(message);
+}
+
+Record::~Record() {
+    if (truncated_) {
+        raw(",\"truncated\":true");
+    }
+    // TAIL_RESERVE guarantees these fit
+    buffer_[size_++] = '}';
+    buffer_[size_++] = '\n';
+    drainer().push(level_, buffer_, size_);
+}
+
+bool Record::raw(std::string_view text) {
+    if (size_ + text.size() > MAX_BYTES - 2) {
+        return false;
+    }
+    std::memcpy(buffer_ + size_, text.data(), text.size());
+    size_ += text.size();
+    return true;
+}
+
+bool Record::key(std::string_view name) {
+    // ,"name": plus a number (or an empty string) must fit ahead of the tail
+    if (size_ + name.size() + 4 + SCALAR_RESERVE > MAX_BYTES - TAIL_RESERVE) {
+        truncated_ = true;
+        return false;
+    }
+    buffer_[size_++] = ',';
+    quoted(name);
+    buffer_[size_++] = ':';
+    return true;
+}
+
+void Record::quoted(std::string_view value) {
+    static constexpr char HEX[] = "0123456789abcdef";
+    // Closing quote plus the tail stay reserved
+    const std::size_t limit = MAX_BYTES - TAIL_RESERVE - 1;
+    if (size_ >= limit) {
+        truncated_ = true;
+        return;
+    }
+    buffer_[size_++] = '"';
+    const std::size_t start = size_;
+
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        const unsigned char c = static_cast<unsigned char>(value[i]);
+        char escaped[6];
+        std::size_t n = 0;
+        switch (c) {
+            case '"':  escaped[0] = '\\'; escaped[1] = '"';  n = 2; break;
+            case '\\': escaped[0] = '\\'; escaped[1] = '\\'; n = 2; break;
+            case '\n': escaped[0] = '\\'; escaped[1] = 'n';  n = 2; break;
+            case '\r': escaped[0] = '\\'; escaped[1] = 'r';  n = 2; break;
+            case '\t': escaped[0] = '\\'; escaped[1] = 't';  n = 2; break;
+            default:
+                if (c < 0x20) {
+                    std::memcpy(escaped, "\\u00", 4);
+                    escaped[4] = HEX[c >> 4];
+                    escaped[5] = HEX[c & 0xF];
+                    n = 6;
+                } else {
+                    escaped[0] = static_cast<char>(c);
+                    n = 1;
+                }
+        }
+        if (size_ + n > limit) {
+            // Never leave half a UTF-8 sequence behind
+            while (size_ > start && (static_cast<unsigned char>(buffer_[size_ - 1]) & 0xC0) == 0x80) {
+                --size_;
+            }
+            if (size_ > start && static_cast<unsigned char>(buffer_[size_ - 1]) >= 0xC0) {
+                --size_;
+            }
+            truncated_ = true;
+            break;
+        }
+        std::memcpy(buffer_ + size_, escaped, n);
+        size_ += n;
+    }
+    buffer_[size_++] = '"';
+}
+
+Record& Record::field(std::string_view name, std::string_view value) {
+    if (key(name)) {
+        quoted(value);
+    }
+    return *this;
+}
+
+Record& Record::field(std::string_view name, bool value) {
+    if (key(name)) {
+        raw(value ? "true" : "false");
+    }
+    return *this;
+}
+
+Record& Record::field(std::string_view name, double value) {
+    char text[32];
+    const int n = std::snprintf(text, sizeof(text), "%.6g", value);
+    if (key(name)) {
+        raw(std::string_view(text, static_cast<std::size_t>(n)));
+    }
+    return *this;
+}
+
+Record& Record::integer(std::string_view name, int64_t value) {
+    char text[24];
+    const int n = std::snprintf(text, sizeof(text), "%lld", static_cast<long long>(value));
+    if (key(name)) {
+        raw(std::string_view(text, static_cast<std::size_t>(n)));
+    }
+    return *this;
+}
+
+Record& Record::unsigned_integer(std::string_view name, uint64_t value) {
+    char text[24];
+    const int n = std::snprintf(text, sizeof(text), "%llu", static_cast<unsigned long long>(value));
+    if (key(name)) {
+        raw(std::string_view(text, static_cast<std::size_t>(n)));
+    }
+    return *this;
+}
+
+// =============================================================================
+// CONTROL
+// =============================================================================
+
+bool sample_payload() {
+    thread_local uint32_t calls = 0;
+    const uint32_t every = payload_sample_every.load(std::memory_order_relaxed);
+    return every != 0 && calls++ % every == 0;
+}
+
+void start() {
+    if (const char* level = std::getenv("KITHLY_LOG_LEVEL")) {
+        const std::string_view name(level);
+        for (int i = 0; i < 4; ++i) {
+            if (name == LEVEL_NAMES[i]) {
+                set_level(static_cast<Level>(i));
+            }
+        }
+    }
+    if (const char* sample = std::getenv("KITHLY_LOG_PAYLOAD_SAMPLE")) {
+        payload_sample_every.store(static_cast<uint32_t>(std::max(0, std::atoi(sample))));
+    }
+    drainer().start();
+}
+
+void stop() {
+    drainer().stop();
+}
+
+Stats stats() {
+    return drainer().stats();
+}
+
+} // namespace log
+} // namespace Kithly
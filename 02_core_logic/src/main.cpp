@@ -5,10 +5,19 @@
  * =============================================================================
  */
 
-#include "include/constants.h"
-#include "include/structs.h"
-#include "include/db_connector.h"
-#include "include/orchestrator.h"
+#include "constants.h"
+#include "structs.h"
+#include "db_connector.h"
+#include "orchestrator.h"
+#include "shop_index.h"
+#include "reroute_fanout.h"
+#include "task_pool.h"
+#include "gateway_events.h"
+#include "evidence.h"
+#include "idempotency_guard.h"
+#include "zra_sync.h"
+#include "metrics.h"
+#include "log.h"
 
 #include <sw/redis++/redis++.h>
 #include <iostream>
@@ -19,6 +28,11 @@
 #include <chrono>
 #include <thread>
 #include <optional>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <unistd.h>
 
 namespace kithly {
 
@@ -30,20 +44,90 @@ void signal_handler(int signal) {
     g_shutdown = true;
 }
 
+using Kithly::Orchestrator::INGESTION_QUEUE;
+
+// Reliable-queue mode: in-flight jobs live in kithly:processing:<id> until
+// acked; kithly:heartbeat:<id> marks the owning consumer as alive.
+constexpr const char* PROCESSING_PREFIX = "kithly:processing:";
+constexpr const char* HEARTBEAT_PREFIX = "kithly:heartbeat:";
+
+/**
+ * Worker Configuration
+ * Read from KITHLY_WORKER_* / KITHLY_REDIS_* environment variables
+ */
+struct WorkerConfig {
+    std::string redis_uri = "tcp://127.0.0.1:6379";
+    int threads = 1;
+    // Bounded BRPOP timeout so every consumer re-checks g_shutdown
+    std::chrono::seconds pop_timeout{1};
+    // Max payloads drained per round-trip (1 = one job per BRPOP)
+    int batch_size = 1;
+    // BLMOVE into a per-consumer processing list, ack after commit
+    bool reliable = false;
+    // Node identity; consumer ids are "<node_id>:<thread index>". Must be
+    // unique per process: two nodes sharing one would ack, heartbeat and
+    // redrive each other's processing lists (see default_node_id)
+    std::string node_id;
+    // Run the escalation/expiry timing wheel on this node
+    bool run_scheduler = true;
+    // Serve find_nearest_shop from the resident spatial index
+    bool shop_index = true;
+    // Work-stealing pool for fan-out work such as reroute offers (0 = cores)
+    int task_threads = 0;
+    // Prometheus scrape port for GET /metrics (0 = disabled)
+    int metrics_port = 9464;
+    // Publish Gateway side effects to kithly:events:gateway
+    bool gateway_events = true;
+    // Streaming PUT /evidence endpoint (0 = disabled)
+    int evidence_port = 0;
+    std::string evidence_dir = "/var/lib/kithly/evidence";
+    // photo_url prefix for stored objects (empty = file:// URLs)
+    std::string evidence_base_url;
+    int evidence_handlers = 8;
+    // Shared with the Gateway's internal API (X-Internal-Key)
+    std::string internal_key;
+    // Committed idempotency keys remembered in memory (0 = always ask Postgres)
+    int idempotency_cache = 100000;
+    // Seeded Bloom filter over the window's keys, skips lookups for new keys
+    bool idempotency_filter = true;
+    // Claim keys on the shared Redis before inserting (several ingesting nodes)
+    bool redis_reservations = false;
+    // Drain shops' reroute accepts and sweep lapsed offers
+    bool reroute_offers = true;
+    // Drain ZRA_Sync_Queue against the VSDC
+    bool zra_sync = true;
+    std::string vsdc_url = "http://localhost:8080/vsdc";
+    int vsdc_timeout_secs = 10;
+    int zra_batch = 64;
+    int zra_concurrency = 8;
+};
+
+/**
+ * "<hostname>-<pid>" when KITHLY_NODE_ID is unset. A restarted process
+ * gets a new id; its predecessor's processing lists are redriven by the
+ * periodic recovery sweep once their heartbeats expire.
+ */
+std::string default_node_id() {
+    char host[256] = {};
+    if (gethostname(host, sizeof(host) - 1) != 0 || host[0] == '\0') {
+        std::snprintf(host, sizeof(host), "kithly");
+    }
+    return std::string(host) + "-" + std::to_string(getpid());
+}
+
 /**
  * The KithLy Core Worker
  * High-performance event-driven engine for draining Redis ingestion queues
  */
 class KithLyWorker {
 public:
-    KithLyWorker(const db::DbConfig& db_config) {
+    KithLyWorker(const db::DbConfig& db_config, const WorkerConfig& worker_config)
+        : config_(worker_config) {
         // Initialize connection pool
         pool_ = std::make_shared<db::ConnectionPool>(db_config);
         
-        // Initialize repositories
-        gift_repo_ = std::make_shared<db::GiftRepository>(pool_);
-        shop_repo_ = std::make_shared<db::ShopRepository>(pool_);
-        evidence_repo_ = std::make_shared<db::EvidenceRepository>(pool_);
+        // update_status / escalation / watchdog share the same pool
+        Kithly::init_db_connection(pool_);
         
         std::cout << "[KITHLY] Worker initialized with " << db_config.pool_size << " DB connections" << std::endl;
     }
@@ -52,65 +136,514 @@ public:
         std::cout << "[KITHLY] ============================================" << std::endl;
         std::cout << "[KITHLY]    KithLy Global Protocol - C++ Worker Node" << std::endl;
         std::cout << "[KITHLY] ============================================" << std::endl;
-        std::cout << "[KITHLY] Connecting to Redis at tcp://127.0.0.1:6379" << std::endl;
-        std::cout << "[KITHLY] Queue: kithly:ingestion:gifts" << std::endl;
+        std::cout << "[KITHLY] Connecting to Redis at " << config_.redis_uri << std::endl;
+        std::cout << "[KITHLY] Queue: " << INGESTION_QUEUE << std::endl;
+        std::cout << "[KITHLY] Consumers: " << config_.threads 
+                  << " (batch size " << config_.batch_size << ")" << std::endl;
+        std::cout << "[KITHLY] Reliable queue: " << (config_.reliable ? "ON" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Node id: " << config_.node_id << std::endl;
+        std::cout << "[KITHLY] Idempotency cache: "
+                  << (config_.idempotency_cache > 0 ? std::to_string(config_.idempotency_cache) + " keys" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Idempotency filter: " << (config_.idempotency_filter ? "ON" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Idempotency reservations: " << (config_.redis_reservations ? "Redis" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Deadline scheduler: " << (config_.run_scheduler ? "ON" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Shop index: " << (config_.shop_index ? "ON" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Reroute offers: "
+                  << (config_.reroute_offers ? Kithly::REROUTE_ACCEPT_QUEUE : "OFF") << std::endl;
+        std::cout << "[KITHLY] Task pool threads: " 
+                  << (config_.task_threads > 0 ? std::to_string(config_.task_threads) : "auto") << std::endl;
+        std::cout << "[KITHLY] Metrics: " 
+                  << (config_.metrics_port > 0 ? ":" + std::to_string(config_.metrics_port) + "/metrics" : "OFF") << std::endl;
+        std::cout << "[KITHLY] Gateway events: " 
+                  << (config_.gateway_events ? Kithly::GATEWAY_EVENT_STREAM : "OFF (log only)") << std::endl;
+        std::cout << "[KITHLY] Evidence ingest: " 
+                  << (config_.evidence_port > 0 ? ":" + std::to_string(config_.evidence_port) + " → " + config_.evidence_dir : "OFF") << std::endl;
+        std::cout << "[KITHLY] ZRA sync: "
+                  << (config_.zra_sync ? config_.vsdc_url + " (batch " + std::to_string(config_.zra_batch)
+                                         + ", " + std::to_string(config_.zra_concurrency) + " in flight)" : "OFF") << std::endl;
         std::cout << "[KITHLY] ============================================" << std::endl;
         
+        // Sweeps at startup and then every heartbeat TTL, so lists left by
+        // a predecessor that restarted under a new id are picked up once
+        // its heartbeats lapse, not only when the next process starts
+        std::thread recovery;
+        if (config_.reliable) {
+            recovery = std::thread(&KithLyWorker::recovery_loop, this);
+        }
+        
+        // A failed bind only loses the scrape endpoint, never the worker
+        std::unique_ptr<Kithly::metrics::MetricsServer> metrics_server;
+        if (config_.metrics_port > 0) {
+            metrics_server = std::make_unique<Kithly::metrics::MetricsServer>(config_.metrics_port);
+            if (!metrics_server->start()) {
+                metrics_server.reset();
+            }
+        }
+        
+        // Installed before anything that transitions gifts; stopped last
+        // so the final flush sees every event the pool produced
+        std::shared_ptr<Kithly::GatewayEventStream> gateway_events;
+        if (config_.gateway_events) {
+            gateway_events = std::make_shared<Kithly::GatewayEventStream>(config_.redis_uri);
+            gateway_events->start();
+            Kithly::install_gateway_events(gateway_events);
+        }
+        
+        // Node-wide pool, alive for as long as the consumers and the
+        // scheduler may hand it work
+        auto task_pool = std::make_shared<Kithly::TaskPool>(static_cast<std::size_t>(config_.task_threads));
+        Kithly::install_task_pool(task_pool);
+        
+        // Every committed transition re-arms its deadline; the wheel is
+        // seeded from the database before the first tick
+        std::unique_ptr<Kithly::DeadlineScheduler> scheduler;
+        if (config_.run_scheduler) {
+            scheduler = std::make_unique<Kithly::DeadlineScheduler>(&Kithly::Orchestrator::fire_deadlines);
+            Kithly::DeadlineScheduler* target = scheduler.get();
+            Kithly::set_transition_listener([target](const std::string& tx_id, int status) {
+                target->on_transition(tx_id, status);
+            });
+            scheduler->rebuild_from_database();
+            scheduler->start();
+        }
+        
+        // Loaded before the first job so reroutes never scan Shops; the
+        // listener then keeps it current from kithly_shops notifications
+        std::unique_ptr<Kithly::ShopIndexListener> shop_listener;
+        if (config_.shop_index) {
+            auto index = std::make_shared<Kithly::ShopIndex>();
+            index->load_all();
+            Kithly::install_shop_index(index);
+            shop_listener = std::make_unique<Kithly::ShopIndexListener>(index, pool_);
+            shop_listener->start();
+        }
+        
+        // Accepts and re-run fan-outs use the shop index and task pool
+        std::unique_ptr<Kithly::RerouteOfferWorker> reroute_offers;
+        if (config_.reroute_offers) {
+            reroute_offers = std::make_unique<Kithly::RerouteOfferWorker>(
+                config_.redis_uri, Kithly::RerouteOfferWorker::Options{});
+            reroute_offers->start();
+        }
+        
+        // Uploads only need the DB pool; a failed bind or unwritable
+        // store disables the endpoint, never the worker
+        std::unique_ptr<Kithly::evidence::EvidenceIngestor> evidence_ingestor;
+        std::unique_ptr<Kithly::evidence::EvidenceServer> evidence_server;
+        if (config_.evidence_port > 0) {
+            Kithly::evidence::EvidenceIngestor::Options ingest_options;
+            ingest_options.root = config_.evidence_dir;
+            ingest_options.base_url = config_.evidence_base_url;
+            evidence_ingestor = std::make_unique<Kithly::evidence::EvidenceIngestor>(ingest_options);
+            
+            Kithly::evidence::EvidenceServer::Options server_options;
+            server_options.port = config_.evidence_port;
+            server_options.handlers = static_cast<std::size_t>(config_.evidence_handlers);
+            server_options.internal_key = config_.internal_key;
+            if (evidence_ingestor->open()) {
+                evidence_server = std::make_unique<Kithly::evidence::EvidenceServer>(*evidence_ingestor, server_options);
+                if (!evidence_server->start()) {
+                    evidence_server.reset();
+                }
+            }
+        }
+        
+        // Completions it drives go through the transition listener, so it
+        // starts once the scheduler has installed one
+        std::unique_ptr<Kithly::ZraSyncWorker> zra_sync;
+        if (config_.zra_sync) {
+            Kithly::VsdcClient::Options vsdc_options;
+            vsdc_options.base_url = config_.vsdc_url;
+            vsdc_options.connect_timeout = std::chrono::seconds(config_.vsdc_timeout_secs);
+            Kithly::ZraSyncWorker::Options sync_options;
+            sync_options.batch_size = config_.zra_batch;
+            sync_options.concurrency = static_cast<std::size_t>(config_.zra_concurrency);
+            zra_sync = std::make_unique<Kithly::ZraSyncWorker>(vsdc_options, sync_options);
+            zra_sync->start();
+        }
+        
+        // In front of every ingestion lookup; installed (and its filter
+        // seeded) before the first job
+        if (config_.idempotency_cache > 0 || config_.redis_reservations || config_.idempotency_filter) {
+            std::shared_ptr<kithly::idempotency::ReservationBackend> reservations;
+            if (config_.redis_reservations) {
+                reservations = std::make_shared<kithly::idempotency::RedisReservationBackend>(
+                    std::make_shared<sw::redis::Redis>(config_.redis_uri));
+            }
+            auto guard = std::make_shared<kithly::idempotency::IdempotencyGuard>(
+                static_cast<std::size_t>(config_.idempotency_cache), std::move(reservations));
+            if (config_.idempotency_filter) {
+                // Unseeded (seed failed) it is never consulted; every key
+                // then goes to the database
+                auto filter = std::make_shared<kithly::idempotency::IdempotencyFilter>();
+                filter->seed_from_database();
+                guard->set_key_filter(std::move(filter));
+            }
+            kithly::idempotency::install_idempotency_guard(std::move(guard));
+        }
+        
+        // One consumer thread per configured slot; all share pool_
+        std::vector<std::thread> consumers;
+        consumers.reserve(config_.threads);
+        for (int id = 0; id < config_.threads; ++id) {
+            consumers.emplace_back(&KithLyWorker::drain_loop, this, id);
+        }
+        
+        for (auto& consumer : consumers) {
+            consumer.join();
+        }
+        if (recovery.joinable()) {
+            recovery.join();
+        }
+        if (auto guard = kithly::idempotency::installed_idempotency_guard()) {
+            kithly::idempotency::install_idempotency_guard(nullptr);
+            const auto stats = guard->stats();
+            KITHLY_LOG_INFO("IDEMPOTENCY", "Guard stopped")
+                .field("cache_hits", stats.cache.hits).field("cache_misses", stats.cache.misses)
+                .field("evictions", stats.cache.evictions)
+                .field("reservation_round_trips", stats.reservations.misses);
+            if (const auto& filter = guard->key_filter()) {
+                const auto filter_stats = filter->stats();
+                KITHLY_LOG_INFO("IDEMPOTENCY", "Filter stopped")
+                    .field("lookups_skipped", filter_stats.definite_misses)
+                    .field("maybe_hits", filter_stats.maybe_hits);
+            }
+        }
+        
+        if (evidence_server) {
+            evidence_server->stop();
+        }
+        if (zra_sync) {
+            zra_sync->stop();
+            const auto stats = zra_sync->stats();
+            KITHLY_LOG_INFO("ZRA", "Sync worker stopped")
+                .field("claimed", stats.claimed).field("succeeded", stats.succeeded)
+                .field("retried", stats.retried).field("failed", stats.failed)
+                .field("completed", stats.completed).field("held", stats.held).field("swept", stats.swept);
+        }
+        if (reroute_offers) {
+            reroute_offers->stop();
+        }
+        if (scheduler) {
+            Kithly::set_transition_listener(nullptr);
+            scheduler->stop();
+        }
+        // Runs whatever is still queued (it needs the DB pool and shop index)
+        Kithly::install_task_pool(nullptr);
+        task_pool.reset();
+        if (shop_listener) {
+            shop_listener->stop();
+            Kithly::install_shop_index(nullptr);
+        }
+        if (gateway_events) {
+            Kithly::install_gateway_events(nullptr);
+            gateway_events->stop();
+            const auto stats = gateway_events->stats();
+            KITHLY_LOG_INFO("GATEWAY", "Event stream stopped")
+                .field("published", stats.published).field("coalesced", stats.coalesced)
+                .field("appended", stats.appended).field("dropped", stats.dropped)
+                .field("outboxed", stats.outboxed).field("replayed", stats.replayed);
+        }
+        if (metrics_server) {
+            metrics_server->stop();
+        }
+        
+        KITHLY_LOG_INFO("KITHLY", "Shutdown complete");
+    }
+
+private:
+    WorkerConfig config_;
+    std::shared_ptr<db::ConnectionPool> pool_;
+
+    /**
+     * Event-driven Drain Loop (one per consumer thread)
+     * Each consumer owns its Redis connection so a blocking pop on one
+     * thread never stalls the others.
+     */
+    // Time a consumer sat in BRPOP/BLMOVE before a job arrived; empty
+    // timeouts are not recorded
+    static Kithly::metrics::LatencyHistogram& pop_wait_latency() {
+        static auto& h = Kithly::metrics::histogram("kithly_queue_pop_wait_seconds", "",
+                                                    "Blocking pop wait until a job arrived");
+        return h;
+    }
+
+    void drain_loop(int worker_id) {
+        const std::string consumer_id = config_.node_id + ":" + std::to_string(worker_id);
+        const std::string processing_key = PROCESSING_PREFIX + consumer_id;
+        const std::string heartbeat_key = HEARTBEAT_PREFIX + consumer_id;
+        
         // Initialize Redis Client
-        auto redis = sw::redis::Redis("tcp://127.0.0.1:6379");
+        auto redis = sw::redis::Redis(config_.redis_uri);
+        
+        // Anything left in our processing list was in flight when the
+        // previous incarnation (or connection) died: re-drive it first.
+        bool needs_recovery = config_.reliable;
+        auto last_heartbeat = std::chrono::steady_clock::time_point{};
 
-        // Event-driven Drain Loop
         while (!g_shutdown) {
             try {
-                // Blocking pop with a 0 timeout (wait forever)
-                // Note: We use brpop which blocks the thread until an item arrives
-                auto result = redis.brpop("kithly:ingestion:gifts", 0);
+                if (needs_recovery) {
+                    redrive(redis, processing_key);
+                    needs_recovery = false;
+                }
+                
+                if (config_.reliable) {
+                    auto now = std::chrono::steady_clock::now();
+                    if (now - last_heartbeat >= config_.pop_timeout) {
+                        redis.set(heartbeat_key, "1", heartbeat_ttl());
+                        last_heartbeat = now;
+                    }
+                }
                 
-                if (result) {
-                    // result is a std::optional<std::pair<std::string, std::string>>
-                    // result->first is the queue name, result->second is the JSON payload
-                    auto& payload = result->second;
+                // Blocking pop with a bounded timeout so shutdown is observed
+                const auto pop_start = Kithly::metrics::Clock::now();
+                auto first = pop_first(redis, processing_key);
+                if (!first) {
+                    continue;
+                }
+                pop_wait_latency().record_since(pop_start);
+                
+                if (config_.batch_size > 1) {
+                    auto batch = drain_batch(redis, std::move(*first), processing_key);
                     
-                    std::cout << "\n📦 C++ Worker Pulled Job from Queue" << std::endl;
-                    std::cout << "Raw Payload: " << payload << std::endl;
+                    KITHLY_LOG_DEBUG("KITHLY", "Pulled jobs from queue")
+                        .field("worker", worker_id).field("jobs", batch.size());
                     
                     try {
-                        Kithly::Orchestrator::process_gift_job(payload, redis);
+                        Kithly::Orchestrator::process_gift_batch(batch, redis);
+                    } catch (const sw::redis::Error&) {
+                        throw;  // Publish failed: leave the batch un-acked
+                    } catch (const Kithly::Orchestrator::TransientJobError&) {
+                        throw;  // Database unavailable: leave the batch un-acked
                     } catch (const std::exception& e) {
-                        std::cerr << "[KITHLY ERROR] Failed to process payload: " << e.what() << std::endl;
+                        KITHLY_LOG_ERROR("KITHLY", "Failed to process batch")
+                            .field("worker", worker_id).field("error", e.what());
                     }
+                    
+                    ack(redis, processing_key, batch);
+                    continue;
+                }
+                
+                auto& payload = *first;
+                
+                KITHLY_LOG_DEBUG("KITHLY", "Pulled job from queue").field("worker", worker_id);
+                // Full payloads are sampled: one line per job would dominate the log
+                if (Kithly::log::sample_payload()) {
+                    KITHLY_LOG_INFO("KITHLY", "Sampled payload")
+                        .field("worker", worker_id).field("payload", payload);
+                }
+                
+                try {
+                    Kithly::Orchestrator::process_gift_job(payload, redis);
+                } catch (const sw::redis::Error&) {
+                    throw;  // Publish failed: leave the job un-acked
+                } catch (const Kithly::Orchestrator::TransientJobError&) {
+                    throw;  // Database unavailable: leave the job un-acked
+                } catch (const std::exception& e) {
+                    KITHLY_LOG_ERROR("KITHLY", "Failed to process payload")
+                        .field("worker", worker_id).field("error", e.what());
+                }
+                
+                if (config_.reliable) {
+                    ack(redis, processing_key, {payload});
                 }
 
             } catch (const sw::redis::TimeoutError& e) {
-                // Ignore timeout and continue if we had a non-zero timeout
+                // Pop timed out with an empty queue - loop and re-check shutdown
                 continue;
             } catch (const sw::redis::Error& e) {
                 // Handle Redis disconnections/errors gracefully
-                std::cerr << "[KITHLY ERROR] Redis exception: " << e.what() << std::endl;
-                std::cerr << "Attempting to reconnect in 3 seconds..." << std::endl;
+                KITHLY_LOG_ERROR("KITHLY", "Redis exception - reconnecting in 3 seconds")
+                    .field("worker", worker_id).field("error", e.what());
                 std::this_thread::sleep_for(std::chrono::seconds(3));
                 
                 // (Re)Initialize Redis Client on disconnect
                 try {
-                    redis = sw::redis::Redis("tcp://127.0.0.1:6379");
+                    redis = sw::redis::Redis(config_.redis_uri);
                 } catch (const std::exception& reconnect_e) {
-                    std::cerr << "[KITHLY ERROR] Reconnect failed: " << reconnect_e.what() << std::endl;
+                    KITHLY_LOG_ERROR("KITHLY", "Reconnect failed")
+                        .field("worker", worker_id).field("error", reconnect_e.what());
                 }
+                needs_recovery = config_.reliable;
             } catch (const std::exception& e) {
                 // Catch standard exceptions to prevent full crash
-                std::cerr << "[KITHLY FATAL] Worker exception: " << e.what() << std::endl;
+                KITHLY_LOG_ERROR("KITHLY", "Worker exception")
+                    .field("worker", worker_id).field("error", e.what());
                 std::this_thread::sleep_for(std::chrono::seconds(1));
+                needs_recovery = config_.reliable;
+            }
+        }
+        
+        // Clean exit: hand back anything still un-acked and retire the
+        // heartbeat, so no sweep has to wait out its TTL for this id
+        if (config_.reliable) {
+            try {
+                redrive(redis, processing_key);
+                redis.del(heartbeat_key);
+            } catch (const std::exception& e) {
+                KITHLY_LOG_WARN("KITHLY", "Heartbeat not retired; list recovered after TTL")
+                    .field("worker", worker_id).field("error", e.what());
             }
         }
         
-        std::cout << "[KITHLY] Shutdown complete." << std::endl;
+        KITHLY_LOG_INFO("KITHLY", "Worker stopped").field("worker", worker_id);
     }
 
-private:
-    std::shared_ptr<db::ConnectionPool> pool_;
-    std::shared_ptr<db::GiftRepository> gift_repo_;
-    std::shared_ptr<db::ShopRepository> shop_repo_;
-    std::shared_ptr<db::EvidenceRepository> evidence_repo_;
+    /**
+     * Pop the first payload of a round, blocking up to pop_timeout.
+     * Reliable mode moves it atomically into the processing list instead
+     * of removing it, so a crash before ack cannot lose the job.
+     */
+    std::optional<std::string> pop_first(sw::redis::Redis& redis, const std::string& processing_key) {
+        if (config_.reliable) {
+            return redis.command<sw::redis::OptionalString>(
+                "BLMOVE", INGESTION_QUEUE, processing_key, "RIGHT", "LEFT",
+                std::to_string(config_.pop_timeout.count()));
+        }
+        
+        auto result = redis.brpop(INGESTION_QUEUE, config_.pop_timeout);
+        if (!result) {
+            return std::nullopt;
+        }
+        // result->first is the queue name, result->second is the JSON payload
+        return std::move(result->second);
+    }
+
+    /**
+     * Top up a batch after the blocking pop returned its first payload.
+     * The remaining batch_size - 1 pops go out in one pipeline, so a deep
+     * queue costs two round-trips per batch instead of one per job.
+     */
+    std::vector<std::string> drain_batch(
+        sw::redis::Redis& redis, 
+        std::string first, 
+        const std::string& processing_key
+    ) {
+        std::vector<std::string> batch;
+        batch.reserve(config_.batch_size);
+        batch.push_back(std::move(first));
+        
+        // Borrow the client's connection rather than opening a new one
+        auto pipe = redis.pipeline(false);
+        for (int i = 1; i < config_.batch_size; ++i) {
+            if (config_.reliable) {
+                pipe.command("LMOVE", INGESTION_QUEUE, processing_key, "RIGHT", "LEFT");
+            } else {
+                pipe.rpop(INGESTION_QUEUE);
+            }
+        }
+        auto replies = pipe.exec();
+        
+        for (std::size_t i = 0; i < replies.size(); ++i) {
+            // Keep scanning past a nil: a producer may LPUSH between two
+            // pipelined RPOPs, and a popped payload must never be dropped.
+            auto payload = replies.get<sw::redis::OptionalString>(i);
+            if (payload) {
+                batch.push_back(std::move(*payload));
+            }
+        }
+        
+        return batch;
+    }
+
+    /**
+     * Acknowledge committed jobs by removing them from the processing list
+     */
+    void ack(sw::redis::Redis& redis, const std::string& processing_key, const std::vector<std::string>& batch) {
+        if (!config_.reliable) {
+            return;
+        }
+        
+        auto pipe = redis.pipeline(false);
+        for (const auto& payload : batch) {
+            pipe.lrem(processing_key, 1, payload);
+        }
+        pipe.exec();
+    }
+
+    /**
+     * Move every entry of a processing list back onto the ingestion queue.
+     * Entries are moved newest-first onto the pop end, so the oldest job
+     * is the next one consumed. Re-driven jobs go back through the
+     * idempotency check, so a job that had already committed is skipped.
+     */
+    long long redrive(sw::redis::Redis& redis, const std::string& processing_key) {
+        long long moved = 0;
+        while (redis.command<sw::redis::OptionalString>(
+                   "LMOVE", processing_key, INGESTION_QUEUE, "LEFT", "RIGHT")) {
+            ++moved;
+        }
+        
+        if (moved > 0) {
+            KITHLY_LOG_INFO("KITHLY", "Re-driven in-flight jobs")
+                .field("jobs", moved).field("processing_key", processing_key);
+        }
+        return moved;
+    }
+
+    /**
+     * Run recover_stale_consumers() at startup and every heartbeat_ttl()
+     * until shutdown, on its own Redis connection
+     */
+    void recovery_loop() {
+        std::optional<sw::redis::Redis> redis;
+        const auto interval = heartbeat_ttl();
+        auto next_sweep = std::chrono::steady_clock::now();
+        
+        while (!g_shutdown) {
+            if (std::chrono::steady_clock::now() >= next_sweep) {
+                try {
+                    if (!redis) {
+                        redis.emplace(config_.redis_uri);
+                    }
+                    recover_stale_consumers(*redis);
+                } catch (const std::exception& e) {
+                    KITHLY_LOG_ERROR("KITHLY", "Recovery sweep failed").field("error", e.what());
+                    redis.reset();
+                }
+                next_sweep = std::chrono::steady_clock::now() + interval;
+            }
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+    }
+
+    /**
+     * Recovery sweep: re-drive processing lists whose consumer heartbeat
+     * has expired (crashed nodes, ids retired by a resize, or a restarted
+     * process's previous id). Lists of live consumers are left alone.
+     */
+    void recover_stale_consumers(sw::redis::Redis& redis) {
+        const std::string prefix = PROCESSING_PREFIX;
+        std::vector<std::string> keys;
+        long long cursor = 0;
+        do {
+            cursor = redis.scan(cursor, prefix + "*", 100, std::back_inserter(keys));
+        } while (cursor != 0);
+        
+        long long recovered = 0;
+        for (const auto& key : keys) {
+            const std::string consumer_id = key.substr(prefix.size());
+            if (redis.exists(HEARTBEAT_PREFIX + consumer_id) == 0) {
+                recovered += redrive(redis, key);
+            }
+        }
+        
+        // Quiet when there was nothing to do: this runs every heartbeat TTL
+        if (recovered > 0) {
+            KITHLY_LOG_INFO("KITHLY", "Recovery sweep")
+                .field("processing_lists", keys.size()).field("jobs", recovered);
+        } else {
+            KITHLY_LOG_DEBUG("KITHLY", "Recovery sweep")
+                .field("processing_lists", keys.size()).field("jobs", recovered);
+        }
+    }
+
+    std::chrono::milliseconds heartbeat_ttl() const {
+        // Survive a few missed beats during a slow batch
+        return std::chrono::duration_cast<std::chrono::milliseconds>(config_.pop_timeout) * 5
+               + std::chrono::seconds(30);
+    }
 };
 
 } // namespace kithly
@@ -125,21 +658,75 @@ int main(int argc, char* argv[]) {
     std::signal(SIGTERM, kithly::signal_handler);
     
     // Parse configuration (from env or args)
-    kithly::db::DbConfig db_config;
-    db_config.host = std::getenv("KITHLY_DB_HOST") ? std::getenv("KITHLY_DB_HOST") : "localhost";
-    db_config.port = std::getenv("KITHLY_DB_PORT") ? std::stoi(std::getenv("KITHLY_DB_PORT")) : 5432;
-    db_config.database = std::getenv("KITHLY_DB_NAME") ? std::getenv("KITHLY_DB_NAME") : "kithly";
-    db_config.user = std::getenv("KITHLY_DB_USER") ? std::getenv("KITHLY_DB_USER") : "kithly_app";
-    db_config.password = std::getenv("KITHLY_DB_PASSWORD") ? std::getenv("KITHLY_DB_PASSWORD") : "";
-    db_config.pool_size = std::getenv("KITHLY_DB_POOL_SIZE") ? std::stoi(std::getenv("KITHLY_DB_POOL_SIZE")) : 10;
+    // KITHLY_DB_HOST / _PORT / _NAME / _USER / _PASSWORD / _POOL_SIZE / _MAX_WAITERS /
+    // _ACQUIRE_TIMEOUT_MS / _CONNECT_TIMEOUT_SECS
+    auto db_config = kithly::db::DbConfig::from_env();
+    
+    kithly::WorkerConfig worker_config;
+    worker_config.redis_uri = std::getenv("KITHLY_REDIS_URL") ? std::getenv("KITHLY_REDIS_URL") : "tcp://127.0.0.1:6379";
+    worker_config.threads = std::getenv("KITHLY_WORKER_THREADS")
+        ? std::max(1, std::stoi(std::getenv("KITHLY_WORKER_THREADS")))
+        : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    worker_config.pop_timeout = std::chrono::seconds(
+        std::getenv("KITHLY_POP_TIMEOUT_SECS") ? std::max(1, std::stoi(std::getenv("KITHLY_POP_TIMEOUT_SECS"))) : 1);
+    worker_config.batch_size = std::getenv("KITHLY_BATCH_SIZE")
+        ? std::max(1, std::stoi(std::getenv("KITHLY_BATCH_SIZE"))) : 1;
+    worker_config.reliable = std::getenv("KITHLY_RELIABLE_QUEUE") 
+        && std::string(std::getenv("KITHLY_RELIABLE_QUEUE")) == "1";
+    worker_config.node_id = std::getenv("KITHLY_NODE_ID") && *std::getenv("KITHLY_NODE_ID")
+        ? std::getenv("KITHLY_NODE_ID") : kithly::default_node_id();
+    worker_config.run_scheduler = !std::getenv("KITHLY_DEADLINE_SCHEDULER")
+        || std::string(std::getenv("KITHLY_DEADLINE_SCHEDULER")) != "0";
+    worker_config.shop_index = !std::getenv("KITHLY_SHOP_INDEX")
+        || std::string(std::getenv("KITHLY_SHOP_INDEX")) != "0";
+    worker_config.task_threads = std::getenv("KITHLY_TASK_THREADS")
+        ? std::max(0, std::stoi(std::getenv("KITHLY_TASK_THREADS"))) : 0;
+    worker_config.metrics_port = std::getenv("KITHLY_METRICS_PORT")
+        ? std::max(0, std::stoi(std::getenv("KITHLY_METRICS_PORT"))) : 9464;
+    worker_config.gateway_events = !std::getenv("KITHLY_GATEWAY_EVENTS")
+        || std::string(std::getenv("KITHLY_GATEWAY_EVENTS")) != "0";
+    worker_config.evidence_port = std::getenv("KITHLY_EVIDENCE_PORT")
+        ? std::max(0, std::stoi(std::getenv("KITHLY_EVIDENCE_PORT"))) : 0;
+    if (std::getenv("KITHLY_EVIDENCE_DIR")) {
+        worker_config.evidence_dir = std::getenv("KITHLY_EVIDENCE_DIR");
+    }
+    worker_config.evidence_base_url = std::getenv("KITHLY_EVIDENCE_BASE_URL") ? std::getenv("KITHLY_EVIDENCE_BASE_URL") : "";
+    worker_config.evidence_handlers = std::getenv("KITHLY_EVIDENCE_HANDLERS")
+        ? std::max(1, std::stoi(std::getenv("KITHLY_EVIDENCE_HANDLERS"))) : 8;
+    worker_config.internal_key = std::getenv("KITHLY_INTERNAL_KEY") ? std::getenv("KITHLY_INTERNAL_KEY") : "";
+    worker_config.idempotency_cache = std::getenv("KITHLY_IDEMPOTENCY_CACHE")
+        ? std::max(0, std::stoi(std::getenv("KITHLY_IDEMPOTENCY_CACHE"))) : 100000;
+    worker_config.idempotency_filter = !std::getenv("KITHLY_IDEMPOTENCY_FILTER")
+        || std::string(std::getenv("KITHLY_IDEMPOTENCY_FILTER")) != "0";
+    worker_config.redis_reservations = std::getenv("KITHLY_RESERVATIONS")
+        && std::string(std::getenv("KITHLY_RESERVATIONS")) == "redis";
+    worker_config.reroute_offers = !std::getenv("KITHLY_REROUTE_OFFERS")
+        || std::string(std::getenv("KITHLY_REROUTE_OFFERS")) != "0";
+    worker_config.zra_sync = !std::getenv("KITHLY_ZRA_SYNC")
+        || std::string(std::getenv("KITHLY_ZRA_SYNC")) != "0";
+    if (std::getenv("ZRA_VSDC_URL")) {
+        worker_config.vsdc_url = std::getenv("ZRA_VSDC_URL");
+    }
+    worker_config.vsdc_timeout_secs = std::getenv("ZRA_TIMEOUT")
+        ? std::max(1, std::stoi(std::getenv("ZRA_TIMEOUT"))) : 10;
+    worker_config.zra_batch = std::getenv("KITHLY_ZRA_BATCH")
+        ? std::max(1, std::stoi(std::getenv("KITHLY_ZRA_BATCH"))) : 64;
+    worker_config.zra_concurrency = std::getenv("KITHLY_ZRA_CONCURRENCY")
+        ? std::max(1, std::stoi(std::getenv("KITHLY_ZRA_CONCURRENCY"))) : 8;
+    
+    // Hot-path logging goes through the ring from here on; stop() drains
+    // it before exit
+    Kithly::log::start();
     
     try {
-        kithly::KithLyWorker worker(db_config);
+        kithly::KithLyWorker worker(db_config, worker_config);
         worker.run();
     } catch (const std::exception& e) {
-        std::cerr << "[FATAL] " << e.what() << std::endl;
+        KITHLY_LOG_ERROR("FATAL", "Worker aborted").field("error", e.what());
+        Kithly::log::stop();
         return 1;
     }
     
+    Kithly::log::stop();
     return 0;
 }
@@ -0,0 +1,225 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * metrics/metrics.cpp - Per-Thread HDR Latency Histograms
+ * =============================================================================
+ */
+
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace Kithly {
+namespace metrics {
+
+namespace {
+
+std::atomic<std::size_t> next_histogram_id{0};
+
+// Relaxed increment for a counter only the calling thread writes
+inline void bump(std::atomic<uint64_t>& counter, uint64_t by) {
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+
+} // namespace
+
+// =============================================================================
+// HISTOGRAM
+// =============================================================================
+
+LatencyHistogram::Shard::Shard() {
+    for (auto& count : counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    total.store(0, std::memory_order_relaxed);
+    sum_ns.store(0, std::memory_order_relaxed);
+    max_ns.store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram::LatencyHistogram(std::string name, std::string labels)
+    : name_(std::move(name)), labels_(std::move(labels)), id_(next_histogram_id.fetch_add(1)) {}
+
+std::size_t LatencyHistogram::index_of(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    // Bucket 0 holds 0..127 at unit resolution; bucket b >= 1 holds
+    // [64 << b, 128 << b) in 64 steps of 1 << b
+    const int bucket = (63 - __builtin_clzll(value | ((uint64_t{1} << SUB_BUCKET_BITS) - 1))) - HALF_BITS;
+    const uint64_t sub = value >> bucket;
+    return (static_cast<std::size_t>(bucket + 1) << HALF_BITS) + sub - (uint64_t{1} << HALF_BITS);
+}
+
+uint64_t LatencyHistogram::highest_equivalent(std::size_t index) {
+    constexpr std::size_t half = std::size_t{1} << HALF_BITS;
+    if (index < 2 * half) {
+        return index;
+    }
+    const int bucket = static_cast<int>(index >> HALF_BITS) - 1;
+    const uint64_t sub = (index & (half - 1)) + half;
+    return ((sub + 1) << bucket) - 1;
+}
+
+LatencyHistogram::Shard& LatencyHistogram::local_shard() {
+    // Histograms are never destroyed, so cached shard pointers stay valid
+    thread_local std::vector<Shard*> table;
+    if (id_ >= table.size()) {
+        table.resize(id_ + 1, nullptr);
+    }
+    if (!table[id_]) {
+        Shard* shard = new Shard();
+        shard->next = shards_.load(std::memory_order_relaxed);
+        while (!shards_.compare_exchange_weak(shard->next, shard,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+        }
+        table[id_] = shard;
+    }
+    return *table[id_];
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    const uint64_t value = latency.count() > 0 ? static_cast<uint64_t>(latency.count()) : 0;
+    Shard& shard = local_shard();
+    bump(shard.counts[index_of(value)], 1);
+    bump(shard.total, 1);
+    bump(shard.sum_ns, value);
+    if (value > shard.max_ns.load(std::memory_order_relaxed)) {
+        shard.max_ns.store(value, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot snap;
+    snap.counts.assign(COUNTS, 0);
+    for (Shard* shard = shards_.load(std::memory_order_acquire); shard; shard = shard->next) {
+        for (std::size_t i = 0; i < COUNTS; ++i) {
+            snap.counts[i] += shard->counts[i].load(std::memory_order_relaxed);
+        }
+        snap.sum_ns += shard->sum_ns.load(std::memory_order_relaxed);
+        snap.max_ns = std::max(snap.max_ns, shard->max_ns.load(std::memory_order_relaxed));
+    }
+    // Total from the merged counters, so quantiles are self-consistent
+    for (uint64_t count : snap.counts) {
+        snap.total += count;
+    }
+    return snap;
+}
+
+uint64_t LatencyHistogram::Snapshot::quantile(double q) const {
+    if (total == 0) {
+        return 0;
+    }
+    const uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total))));
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(highest_equivalent(i), max_ns);
+        }
+    }
+    return max_ns;
+}
+
+// =============================================================================
+// REGISTRY
+// =============================================================================
+
+namespace {
+
+struct Family {
+    std::string help;
+    std::vector<std::unique_ptr<LatencyHistogram>> series;
+};
+
+std::mutex registry_mutex;
+
+std::map<std::string, Family>& registry() {
+    static auto* families = new std::map<std::string, Family>();  // Never destroyed
+    return *families;
+}
+
+} // namespace
+
+LatencyHistogram& histogram(const std::string& name, const std::string& labels, const char* help) {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    Family& family = registry()[name];
+    if (family.help.empty() && help && *help) {
+        family.help = help;
+    }
+    for (const auto& series : family.series) {
+        if (series->labels() == labels) {
+            return *series;
+        }
+    }
+    family.series.push_back(std::make_unique<LatencyHistogram>(name, labels));
+    return *family.series.back();
+}
+
+LatencyHistogram& statement_latency(const char* statement) {
+    thread_local std::unordered_map<const char*, LatencyHistogram*> cache;
+    auto it = cache.find(statement);
+    if (it != cache.end()) {
+        return *it->second;
+    }
+    LatencyHistogram& h = histogram(
+        "kithly_db_statement_seconds", std::string("statement=\"") + statement + "\"",
+        "Prepared statement latency, send to result");
+    cache.emplace(statement, &h);
+    return h;
+}
+
+std::string render_prometheus() {
+    static constexpr std::pair<double, const char*> QUANTILES[] = {
+        {0.5, "0.5"}, {0.9, "0.9"}, {0.99, "0.99"}, {0.999, "0.999"}
+    };
+
+    // Snapshot under the lock (series are only ever appended), format after
+    struct Rendered {
+        std::string name;
+        std::string help;
+        std::vector<std::pair<std::string, LatencyHistogram::Snapshot>> series;
+    };
+    std::vector<Rendered> rendered;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        for (const auto& [name, family] : registry()) {
+            Rendered r{name, family.help, {}};
+            for (const auto& series : family.series) {
+                r.series.emplace_back(series->labels(), series->snapshot());
+            }
+            rendered.push_back(std::move(r));
+        }
+    }
+
+    std::string out;
+    char value[64];
+    auto seconds = [&value](uint64_t ns) {
+        std::snprintf(value, sizeof(value), "%.9g", static_cast<double>(ns) / 1e9);
+        return value;
+    };
+
+    for (const auto& family : rendered) {
+        if (!family.help.empty()) {
+            out += "# HELP " + family.name + " " + family.help + "\n";
+        }
+        out += "# TYPE " + family.name + " summary\n";
+        for (const auto& [labels, snap] : family.series) {
+            const std::string prefix = labels.empty() ? "{" : "{" + labels + ",";
+            for (const auto& [q, text] : QUANTILES) {
+                out += family.name + prefix + "quantile=\"" + text + "\"} " + seconds(snap.quantile(q)) + "\n";
+            }
+            const std::string braces = labels.empty() ? "" : "{" + labels + "}";
+            out += family.name + "_sum" + braces + " " + seconds(snap.sum_ns) + "\n";
+            out += family.name + "_count" + braces + " " + std::to_string(snap.total) + "\n";
+        }
+    }
+    return out;
+}
+
+} // namespace metrics
+} // namespace Kithly
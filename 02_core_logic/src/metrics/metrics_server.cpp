@@ -0,0 +1,127 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * metrics/metrics_server.cpp - Embedded HTTP /metrics Endpoint
+ * =============================================================================
+ */
+
+#include "metrics.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace Kithly {
+namespace metrics {
+
+MetricsServer::MetricsServer(int port) : port_(port) {}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "[METRICS] socket failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(static_cast<uint16_t>(port_));
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 16) != 0) {
+        std::cerr << "[METRICS] Cannot listen on port " << port_ << ": "
+                  << std::strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread(&MetricsServer::run, this);
+    std::cout << "[METRICS] Serving /metrics on port " << port_ << std::endl;
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(listen_fd_);
+    listen_fd_ = -1;
+}
+
+void MetricsServer::run() {
+    while (running_) {
+        // Bounded poll so stop() is observed without closing under accept()
+        pollfd pfd{listen_fd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, 500);
+        if (ready <= 0) {
+            continue;
+        }
+
+        int client = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            continue;
+        }
+        serve(client);
+        close(client);
+    }
+}
+
+void MetricsServer::serve(int client_fd) {
+    // A slow or idle client must not stall the next scrape for long
+    timeval timeout{2, 0};
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    // Only the request line matters; read up to the end of the headers
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        ssize_t n = recv(client_fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<std::size_t>(n));
+    }
+
+    const std::string_view line(request.data(), std::min(request.find("\r\n"), request.size()));
+    const bool is_metrics = line.rfind("GET /metrics ", 0) == 0 || line.rfind("GET /metrics?", 0) == 0;
+
+    std::string body = is_metrics ? render_prometheus() : "Not Found\n";
+    std::string response = is_metrics ? "HTTP/1.1 200 OK\r\n" : "HTTP/1.1 404 Not Found\r\n";
+    response += is_metrics ? "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           : "Content-Type: text/plain\r\n";
+    response += "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+
+    std::size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(client_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+}
+
+} // namespace metrics
+} // namespace Kithly
@@ -0,0 +1,280 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * orchestrator/deadline_scheduler.cpp - Timing Wheel Escalation Scheduler
+ * =============================================================================
+ */
+
+#include "deadline_scheduler.h"
+#include "constants.h"
+#include "status_table.h"
+#include "db_connector.h"
+#include <libpq-fe.h>
+#include <cstdlib>
+#include <iostream>
+
+namespace Kithly {
+
+namespace {
+
+uint64_t to_tick(Clock::time_point t) {
+    auto secs = std::chrono::duration_cast<std::chrono::seconds>(t.time_since_epoch()).count();
+    return secs > 0 ? static_cast<uint64_t>(secs) : 0;
+}
+
+/**
+ * The protocol's clocks: which status escalates to what, and when
+ */
+bool next_deadline(
+    int status,
+    Clock::time_point changed_at,
+    const std::optional<Clock::time_point>& explicit_deadline,
+    int& to_status,
+    Clock::time_point& due
+) {
+    switch (status) {
+        case Status::FULFILLING:
+            to_status = status::checked<Status::FULFILLING, FORCE_CALL_PENDING>;
+            due = changed_at + std::chrono::minutes(FORCE_CALL_THRESHOLD_MINS);
+            return true;
+        case FORCE_CALL_PENDING:
+            to_status = status::checked<FORCE_CALL_PENDING, REROUTING>;
+            due = changed_at + std::chrono::minutes(REROUTE_THRESHOLD_MINS);
+            return true;
+        case Status::FUNDS_LOCKED:
+            to_status = status::checked<Status::FUNDS_LOCKED, EXPIRED>;
+            due = explicit_deadline.value_or(changed_at + std::chrono::hours(ESCROW_TIMEOUT_HOURS));
+            return true;
+        case AWAITING_SHOP_ACCEPTANCE:
+            // Silence past the acceptance window counts as a decline,
+            // which hands the order to the 910 → 106 reroute path
+            to_status = status::checked<AWAITING_SHOP_ACCEPTANCE, DECLINED>;
+            due = explicit_deadline.value_or(changed_at + std::chrono::hours(SHOP_ACCEPTANCE_HOURS));
+            return true;
+        default:
+            return false;
+    }
+}
+
+Clock::time_point from_epoch_seconds(const char* value) {
+    return Clock::time_point(std::chrono::seconds(std::atoll(value)));
+}
+
+} // namespace
+
+// =============================================================================
+// TIMING WHEEL
+// =============================================================================
+
+void TimerWheel::schedule(Deadline deadline) {
+    uint64_t due = deadline.due_tick < current_ ? current_ : deadline.due_tick;
+    uint64_t delta = due - current_;
+
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (SLOTS << (SLOT_BITS * level))) {
+        ++level;
+    }
+
+    // Beyond the top level's range: park in its farthest slot; it is
+    // re-inserted on cascade until it is in range
+    uint64_t slot_tick = due;
+    if (delta >= (SLOTS << (SLOT_BITS * (LEVELS - 1)))) {
+        slot_tick = current_ + ((SLOTS - 1) << (SLOT_BITS * (LEVELS - 1)));
+    }
+
+    auto index = (slot_tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+    slots_[level][index].push_back(std::move(deadline));
+    ++size_;
+}
+
+void TimerWheel::cascade(int level) {
+    auto index = (current_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+    auto entries = std::move(slots_[level][index]);
+    slots_[level][index].clear();
+
+    size_ -= entries.size();
+    for (auto& entry : entries) {
+        schedule(std::move(entry));
+    }
+}
+
+void TimerWheel::advance(uint64_t now_tick, std::vector<Deadline>& fired) {
+    while (current_ <= now_tick) {
+        // On each level-0 wrap, pull the next coarse slot down a level
+        for (int level = 1; level < LEVELS; ++level) {
+            uint64_t mask = (uint64_t{1} << (SLOT_BITS * level)) - 1;
+            if ((current_ & mask) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+
+        auto entries = std::move(slots_[0][current_ & (SLOTS - 1)]);
+        slots_[0][current_ & (SLOTS - 1)].clear();
+        size_ -= entries.size();
+
+        ++current_;
+
+        for (auto& entry : entries) {
+            if (entry.due_tick < current_) {
+                fired.push_back(std::move(entry));
+            } else {
+                // A parked out-of-range entry that lapped the wheel
+                schedule(std::move(entry));
+            }
+        }
+    }
+}
+
+// =============================================================================
+// SCHEDULER
+// =============================================================================
+
+DeadlineScheduler::DeadlineScheduler(FireHandler handler)
+    : handler_(std::move(handler)), wheel_(to_tick(Clock::now())) {}
+
+DeadlineScheduler::~DeadlineScheduler() {
+    stop();
+}
+
+void DeadlineScheduler::on_transition(
+    const std::string& tx_id,
+    int new_status,
+    Clock::time_point changed_at,
+    std::optional<Clock::time_point> explicit_deadline
+) {
+    int to_status = 0;
+    Clock::time_point due;
+    bool has_clock = next_deadline(new_status, changed_at, explicit_deadline, to_status, due);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_clock) {
+        // Status without a clock: any pending deadline is now void
+        generations_.erase(tx_id);
+        return;
+    }
+
+    uint64_t generation = next_generation_++;
+    generations_[tx_id] = generation;
+    wheel_.schedule(Deadline{tx_id, new_status, to_status, to_tick(due), generation});
+}
+
+int DeadlineScheduler::rebuild_from_database() {
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        std::cerr << "[SCHEDULER] No database connection - rebuild skipped" << std::endl;
+        return -1;
+    }
+    PGconn* conn = lease.get();
+
+    // updated_at is bumped by trg_global_gifts_updated on every write,
+    // so it is when the current status was entered
+    const char* query = R"(
+        SELECT tx_id,
+               status_code,
+               EXTRACT(EPOCH FROM updated_at)::int8,
+               EXTRACT(EPOCH FROM CASE status_code
+                   WHEN 110 THEN acceptance_deadline
+                   WHEN 200 THEN expiry_timestamp
+               END)::int8
+        FROM Global_Gifts
+        WHERE status_code IN (110, 200, 300, 305)
+    )";
+
+    // Single-row mode streams the result: memory stays flat however
+    // many clocks are open
+    if (!PQsendQuery(conn, query) || !PQsetSingleRowMode(conn)) {
+        std::cerr << "[SCHEDULER] Rebuild query failed: " << PQerrorMessage(conn) << std::endl;
+        lease.invalidate();
+        return -1;
+    }
+
+    int scheduled = 0;
+    bool failed = false;
+    while (PGresult* res = PQgetResult(conn)) {
+        ExecStatusType status = PQresultStatus(res);
+        if (status == PGRES_SINGLE_TUPLE) {
+            std::optional<Clock::time_point> explicit_deadline;
+            if (!PQgetisnull(res, 0, 3)) {
+                explicit_deadline = from_epoch_seconds(PQgetvalue(res, 0, 3));
+            }
+            on_transition(PQgetvalue(res, 0, 0),
+                          std::atoi(PQgetvalue(res, 0, 1)),
+                          from_epoch_seconds(PQgetvalue(res, 0, 2)),
+                          explicit_deadline);
+            ++scheduled;
+        } else if (status != PGRES_TUPLES_OK) {
+            std::cerr << "[SCHEDULER] Rebuild failed: " << PQerrorMessage(conn) << std::endl;
+            failed = true;
+        }
+        PQclear(res);
+    }
+
+    if (failed) {
+        return -1;
+    }
+
+    std::cout << "[SCHEDULER] Rebuilt " << scheduled << " deadlines from Global_Gifts" << std::endl;
+    return scheduled;
+}
+
+void DeadlineScheduler::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    driver_ = std::thread(&DeadlineScheduler::run, this);
+}
+
+void DeadlineScheduler::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    wake_.notify_all();
+    if (driver_.joinable()) {
+        driver_.join();
+    }
+}
+
+std::size_t DeadlineScheduler::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generations_.size();
+}
+
+void DeadlineScheduler::run() {
+    std::vector<Deadline> fired;
+
+    while (running_) {
+        fired.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            // Tick on whole-second boundaries
+            auto next = Clock::time_point(std::chrono::seconds(wheel_.current_tick()));
+            wake_.wait_until(lock, next, [this] { return !running_; });
+            if (!running_) {
+                break;
+            }
+
+            std::vector<Deadline> due;
+            wheel_.advance(to_tick(Clock::now()), due);
+
+            // Drop deadlines superseded by a later transition
+            for (auto& deadline : due) {
+                auto it = generations_.find(deadline.tx_id);
+                if (it != generations_.end() && it->second == deadline.generation) {
+                    generations_.erase(it);
+                    fired.push_back(std::move(deadline));
+                }
+            }
+        }
+
+        if (!fired.empty() && handler_) {
+            try {
+                handler_(fired);
+            } catch (const std::exception& e) {
+                std::cerr << "[SCHEDULER] Fire handler failed: " << e.what() << std::endl;
+            }
+        }
+    }
+}
+
+} // namespace Kithly
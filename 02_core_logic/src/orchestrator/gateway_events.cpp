@@ -0,0 +1,479 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * orchestrator/gateway_events.cpp - Write-behind Gateway Event Stream
+ * =============================================================================
+ */
+
+#include "../../include/gateway_events.h"
+#include "../../include/db_connector.h"
+#include "../../include/statements.h"
+#include "../../include/log.h"
+#include "../../include/metrics.h"
+
+#include <libpq-fe.h>
+#include <sw/redis++/redis++.h>
+#include <algorithm>
+#include <cstdlib>
+#include <optional>
+#include <iterator>
+#include <unordered_set>
+#include <utility>
+
+namespace Kithly {
+
+const char* event_type_name(GatewayEventType type) {
+    switch (type) {
+        case GatewayEventType::FORCE_CALL:              return "force_call";
+        case GatewayEventType::REROUTE:                 return "reroute";
+        case GatewayEventType::NOTIFY_SHOP:             return "notify_shop";
+        case GatewayEventType::REFUND:                  return "refund";
+        case GatewayEventType::TRIGGER_ZRA:             return "trigger_zra";
+        case GatewayEventType::TRIGGER_DISBURSEMENT:    return "trigger_disbursement";
+        case GatewayEventType::REROUTE_OFFER:           return "reroute_offer";
+        case GatewayEventType::REROUTE_OFFER_WITHDRAWN: return "reroute_offer_withdrawn";
+    }
+    return "unknown";
+}
+
+bool is_durable_event(GatewayEventType type) {
+    return type == GatewayEventType::REFUND || type == GatewayEventType::TRIGGER_DISBURSEMENT;
+}
+
+namespace {
+
+constexpr std::chrono::milliseconds MIN_BACKOFF{50};
+constexpr std::chrono::milliseconds MAX_BACKOFF{2000};
+
+metrics::LatencyHistogram& flush_latency() {
+    static metrics::LatencyHistogram& h = metrics::histogram(
+        "kithly_gateway_events_flush_seconds", "",
+        "Pipelined XADD round trip per gateway event batch");
+    return h;
+}
+
+/**
+ * Keep only the latest copy of each (type, tx_id, shop_id), in order
+ *
+ * @return number of events removed
+ */
+std::size_t coalesce(std::vector<GatewayEvent>& events) {
+    if (events.size() < 2) {
+        return 0;
+    }
+    std::unordered_set<std::string> seen;
+    seen.reserve(events.size());
+    std::vector<char> keep(events.size(), 0);
+    for (std::size_t i = events.size(); i-- > 0;) {
+        const auto& e = events[i];
+        std::string key;
+        key.reserve(e.tx_id.size() + e.shop_id.size() + 4);
+        key.push_back(static_cast<char>('0' + static_cast<int>(e.type)));
+        key.append(e.tx_id).push_back('|');
+        key.append(e.shop_id);
+        // Each outbox row is deleted only once sent, so rows never merge;
+        // a row claimed again while still buffered does
+        if (e.outbox_id != 0) {
+            key.push_back('#');
+            key.append(std::to_string(e.outbox_id));
+        }
+        keep[i] = seen.insert(std::move(key)).second ? 1 : 0;
+    }
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        if (keep[i]) {
+            if (out != i) {
+                events[out] = std::move(events[i]);
+            }
+            ++out;
+        }
+    }
+    const std::size_t removed = events.size() - out;
+    events.resize(out);
+    return removed;
+}
+
+using Fields = std::vector<std::pair<std::string, std::string>>;
+
+void to_fields(const GatewayEvent& e, Fields& fields) {
+    fields.clear();
+    fields.emplace_back("type", event_type_name(e.type));
+    fields.emplace_back("tx_id", e.tx_id);
+    if (e.status != 0) {
+        fields.emplace_back("status", std::to_string(e.status));
+    }
+    if (!e.shop_id.empty()) {
+        fields.emplace_back("shop_id", e.shop_id);
+    }
+    if (!e.payment_ref.empty()) {
+        fields.emplace_back("payment_ref", e.payment_ref);
+    }
+    fields.emplace_back("at_ms", std::to_string(e.at_ms));
+}
+
+// =============================================================================
+// OUTBOX (018_gateway_event_outbox.sql)
+// =============================================================================
+
+std::optional<GatewayEventType> event_type_from_name(std::string_view name) {
+    for (auto type : {GatewayEventType::REFUND, GatewayEventType::TRIGGER_DISBURSEMENT}) {
+        if (name == event_type_name(type)) {
+            return type;
+        }
+    }
+    return std::nullopt;
+}
+
+/**
+ * @return the row's event_id, 0 if it was not written
+ */
+int64_t insert_outbox_event(const GatewayEvent& e, std::chrono::seconds lease) {
+    auto db = acquire_db_connection();
+    if (!db) {
+        KITHLY_LOG_ERROR("GATEWAY", "No database connection - event not outboxed")
+            .field("type", event_type_name(e.type)).field("tx_id", e.tx_id);
+        return 0;
+    }
+    const std::string status = std::to_string(e.status);
+    const std::string at_ms = std::to_string(e.at_ms);
+    const std::string lease_secs = std::to_string(lease.count());
+    const char* paramValues[7] = {
+        event_type_name(e.type), e.tx_id.c_str(), status.c_str(), e.shop_id.c_str(),
+        e.payment_ref.c_str(), at_ms.c_str(), lease_secs.c_str()
+    };
+    PGresult* res = sql::exec_prepared(db.get(), sql::INSERT_OUTBOX_EVENT, 7, paramValues, nullptr, nullptr, 0);
+    int64_t event_id = 0;
+    if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1) {
+        event_id = std::strtoll(PQgetvalue(res, 0, 0), nullptr, 10);
+    } else {
+        KITHLY_LOG_ERROR("GATEWAY", "Outbox insert failed")
+            .field("type", event_type_name(e.type)).field("tx_id", e.tx_id)
+            .field("error", PQerrorMessage(db.get()));
+    }
+    PQclear(res);
+    return event_id;
+}
+
+/**
+ * Sent rows; a failure only means they are re-sent after their lease
+ */
+void delete_outbox_events(const std::vector<int64_t>& event_ids) {
+    if (event_ids.empty()) {
+        return;
+    }
+    std::string ids = "{";
+    for (std::size_t i = 0; i < event_ids.size(); ++i) {
+        ids += (i ? "," : "") + std::to_string(event_ids[i]);
+    }
+    ids += "}";
+
+    auto db = acquire_db_connection();
+    if (!db) {
+        KITHLY_LOG_WARN("GATEWAY", "No database connection - sent outbox rows kept")
+            .field("rows", event_ids.size());
+        return;
+    }
+    const char* paramValues[1] = { ids.c_str() };
+    PGresult* res = sql::exec_prepared(db.get(), sql::DELETE_OUTBOX_EVENTS, 1, paramValues, nullptr, nullptr, 0);
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        KITHLY_LOG_WARN("GATEWAY", "Outbox delete failed - rows will be re-sent")
+            .field("rows", event_ids.size()).field("error", PQerrorMessage(db.get()));
+    }
+    PQclear(res);
+}
+
+/**
+ * Rows whose lease lapsed, re-leased to this node
+ */
+std::vector<GatewayEvent> claim_outbox_events(std::size_t limit, std::chrono::seconds lease) {
+    std::vector<GatewayEvent> events;
+    auto db = acquire_db_connection();
+    if (!db) {
+        return events;
+    }
+    sql::Int4Param batch(static_cast<int32_t>(limit));
+    sql::Int4Param lease_secs(static_cast<int32_t>(lease.count()));
+    const char* paramValues[2] = { batch.bytes, lease_secs.bytes };
+    const int paramLengths[2] = { sizeof(batch.bytes), sizeof(lease_secs.bytes) };
+    const int paramFormats[2] = { sql::BINARY_FORMAT, sql::BINARY_FORMAT };
+
+    PGresult* res = sql::exec_prepared(
+        db.get(), sql::CLAIM_OUTBOX_EVENTS, 2, paramValues, paramLengths, paramFormats, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("GATEWAY", "Outbox claim failed").field("error", PQerrorMessage(db.get()));
+        PQclear(res);
+        return events;
+    }
+    int rows = PQntuples(res);
+    events.reserve(rows);
+    for (int r = 0; r < rows; ++r) {
+        auto type = event_type_from_name(PQgetvalue(res, r, 1));
+        if (!type) {
+            KITHLY_LOG_ERROR("GATEWAY", "Unknown outbox event type")
+                .field("event_id", PQgetvalue(res, r, 0)).field("type", PQgetvalue(res, r, 1));
+            continue;
+        }
+        GatewayEvent e{*type, PQgetvalue(res, r, 2), std::atoi(PQgetvalue(res, r, 3)),
+                       PQgetvalue(res, r, 4), PQgetvalue(res, r, 5),
+                       std::strtoll(PQgetvalue(res, r, 6), nullptr, 10),
+                       std::strtoll(PQgetvalue(res, r, 0), nullptr, 10)};
+        events.push_back(std::move(e));
+    }
+    PQclear(res);
+    return events;
+}
+
+} // namespace
+
+// =============================================================================
+// GATEWAY EVENT STREAM
+// =============================================================================
+
+GatewayEventStream::GatewayEventStream(std::string redis_uri)
+    : GatewayEventStream(std::move(redis_uri), Options{}) {}
+
+GatewayEventStream::GatewayEventStream(std::string redis_uri, Options options)
+    : redis_uri_(std::move(redis_uri)), options_(std::move(options)) {
+    options_.max_batch = std::max<std::size_t>(1, options_.max_batch);
+}
+
+GatewayEventStream::~GatewayEventStream() {
+    stop();
+}
+
+bool GatewayEventStream::publish(GatewayEvent event) {
+    if (event.at_ms == 0) {
+        event.at_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    if (options_.durable_outbox && is_durable_event(event.type) && event.outbox_id == 0) {
+        event.outbox_id = insert_outbox_event(event, options_.outbox_lease);
+    }
+    if (event.outbox_id != 0) {
+        outboxed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (buffer_.size() + retained_ >= options_.max_buffered) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            // Sent by a later replay once its lease lapses
+            return event.outbox_id != 0;
+        }
+        buffer_.push_back(std::move(event));
+        // The flusher sleeps out flush_interval unless a batch is full
+        wake = buffer_.size() == 1 || buffer_.size() == options_.max_batch;
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+    if (wake) {
+        wake_.notify_one();
+    }
+    return true;
+}
+
+void GatewayEventStream::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (flusher_.joinable()) {
+        return;
+    }
+    stopping_ = false;
+    flusher_ = std::thread(&GatewayEventStream::run, this);
+}
+
+void GatewayEventStream::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (flusher_.joinable()) {
+        flusher_.join();
+    }
+}
+
+GatewayEventStream::Stats GatewayEventStream::stats() const {
+    Stats s;
+    s.published = published_.load(std::memory_order_relaxed);
+    s.coalesced = coalesced_.load(std::memory_order_relaxed);
+    s.appended = appended_.load(std::memory_order_relaxed);
+    s.dropped = dropped_.load(std::memory_order_relaxed);
+    s.outboxed = outboxed_.load(std::memory_order_relaxed);
+    s.replayed = replayed_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void GatewayEventStream::run() {
+    std::unique_ptr<sw::redis::Redis> redis;
+    std::vector<GatewayEvent> batch;   // Oldest first; survives failed flushes
+    Fields fields;
+    auto backoff = MIN_BACKOFF;
+    auto next_replay = std::chrono::steady_clock::now();   // Leftovers from before a restart
+
+    while (true) {
+        if (options_.durable_outbox && std::chrono::steady_clock::now() >= next_replay) {
+            auto orphans = claim_outbox_events(options_.max_batch, options_.outbox_lease);
+            next_replay = std::chrono::steady_clock::now() + options_.outbox_replay_interval;
+            if (!orphans.empty()) {
+                KITHLY_LOG_WARN("GATEWAY", "Re-sending outbox events").field("events", orphans.size());
+                replayed_.fetch_add(orphans.size(), std::memory_order_relaxed);
+                batch.insert(batch.begin(), std::make_move_iterator(orphans.begin()),
+                             std::make_move_iterator(orphans.end()));
+            }
+        }
+
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (batch.empty()) {
+                const auto ready = [&] { return stopping_ || !buffer_.empty(); };
+                if (options_.durable_outbox) {
+                    wake_.wait_until(lock, next_replay, ready);
+                } else {
+                    wake_.wait(lock, ready);
+                }
+                if (buffer_.empty()) {
+                    if (stopping_) {
+                        return;  // Stopping with nothing left to send
+                    }
+                    continue;    // Replay tick
+                }
+                // Give the batch flush_interval to fill
+                wake_.wait_for(lock, options_.flush_interval, [&] {
+                    return stopping_ || buffer_.size() >= options_.max_batch;
+                });
+            }
+            batch.insert(batch.end(), std::make_move_iterator(buffer_.begin()),
+                         std::make_move_iterator(buffer_.end()));
+            buffer_.clear();
+            retained_ = batch.size();
+            stopping = stopping_;
+        }
+
+        coalesced_.fetch_add(coalesce(batch), std::memory_order_relaxed);
+
+        std::size_t sent = 0;
+        std::vector<int64_t> outboxed;
+        try {
+            if (!redis) {
+                redis = std::make_unique<sw::redis::Redis>(redis_uri_);
+            }
+            while (sent < batch.size()) {
+                const std::size_t end = std::min(batch.size(), sent + options_.max_batch);
+                metrics::ScopedTimer timer(flush_latency());
+                auto pipe = redis->pipeline(false);
+                for (std::size_t i = sent; i < end; ++i) {
+                    to_fields(batch[i], fields);
+                    if (options_.max_length > 0) {
+                        pipe.xadd(options_.stream, "*", fields.begin(), fields.end(), options_.max_length, true);
+                    } else {
+                        pipe.xadd(options_.stream, "*", fields.begin(), fields.end());
+                    }
+                }
+                pipe.exec();
+                appended_.fetch_add(end - sent, std::memory_order_relaxed);
+                for (std::size_t i = sent; i < end; ++i) {
+                    if (batch[i].outbox_id != 0) {
+                        outboxed.push_back(batch[i].outbox_id);
+                    }
+                }
+                sent = end;
+            }
+            backoff = MIN_BACKOFF;
+        } catch (const sw::redis::Error& e) {
+            KITHLY_LOG_ERROR("GATEWAY", "Event stream flush failed - retrying")
+                .field("error", e.what()).field("pending", batch.size() - sent)
+                .field("backoff_ms", static_cast<int64_t>(backoff.count()));
+            redis.reset();
+        }
+        delete_outbox_events(outboxed);
+        batch.erase(batch.begin(), batch.begin() + static_cast<std::ptrdiff_t>(sent));
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        retained_ = batch.size();
+        if (batch.empty()) {
+            continue;
+        }
+        if (stopping) {
+            // Outbox rows among them are re-sent by a node that next claims them
+            std::size_t kept = 0;
+            for (const auto* events : {&batch, &buffer_}) {
+                kept += static_cast<std::size_t>(std::count_if(events->begin(), events->end(),
+                    [](const GatewayEvent& e) { return e.outbox_id != 0; }));
+            }
+            KITHLY_LOG_ERROR("GATEWAY", "Event stream stopped with unsent events")
+                .field("lost", batch.size() + buffer_.size() - kept).field("in_outbox", kept);
+            buffer_.clear();
+            retained_ = 0;
+            return;
+        }
+        // Keep the batch and retry; a stop() cuts the wait short for one
+        // last attempt
+        wake_.wait_for(lock, backoff, [&] { return stopping_; });
+        backoff = std::min(backoff * 2, MAX_BACKOFF);
+    }
+}
+
+// =============================================================================
+// NODE-WIDE STREAM
+// =============================================================================
+
+static std::shared_ptr<GatewayEventStream> installed;
+static std::mutex installed_mutex;
+
+void install_gateway_events(std::shared_ptr<GatewayEventStream> stream) {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    installed = std::move(stream);
+}
+
+std::shared_ptr<GatewayEventStream> installed_gateway_events() {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    return installed;
+}
+
+static void publish_event(const std::shared_ptr<GatewayEventStream>& stream, GatewayEvent event) {
+    const GatewayEventType type = event.type;
+    const std::string tx_id = event.tx_id;
+    const int status = event.status;
+    const std::string shop_id = event.shop_id;
+    bool queued = false;
+    if (stream) {
+        queued = stream->publish(std::move(event));
+    }
+    if (stream && !queued) {
+        KITHLY_LOG_ERROR("GATEWAY", "Event buffer full - event dropped")
+            .field("type", event_type_name(type)).field("tx_id", tx_id);
+        return;
+    }
+    if (!log::enabled(log::Level::INFO)) {
+        return;
+    }
+    log::Record line(log::Level::INFO, "GATEWAY", event_type_name(type));
+    line.field("tx_id", tx_id);
+    if (status != 0) {
+        line.field("status", status);
+    }
+    if (!shop_id.empty()) {
+        line.field("shop_id", shop_id);
+    }
+}
+
+void publish_gateway_event(GatewayEventType type, const std::string& tx_id, int status,
+                           const std::string& shop_id, const std::string& payment_ref) {
+    publish_event(installed_gateway_events(), {type, tx_id, status, shop_id, payment_ref, 0});
+}
+
+std::vector<OutboxedTransition> transition_with_event(GatewayEventType type,
+                                                      const std::vector<StatusTransition>& transitions) {
+    const auto stream = installed_gateway_events();
+    const auto lease = stream ? stream->options().outbox_lease : GatewayEventStream::Options{}.outbox_lease;
+    auto outcomes = bulk_transition_with_outbox(transitions, event_type_name(type), lease);
+    for (std::size_t i = 0; i < transitions.size(); ++i) {
+        if (outcomes[i].applied) {
+            publish_event(stream, {type, transitions[i].tx_id, transitions[i].to_status, "",
+                                   outcomes[i].payment_ref, 0, outcomes[i].outbox_id});
+        }
+    }
+    return outcomes;
+}
+
+} // namespace Kithly
@@ -0,0 +1,102 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE ORCHESTRATOR
+ * orchestrator/handshake_token.cpp - Per-Thread CSPRNG Handshake Tokens
+ * =============================================================================
+ */
+
+#include "handshake_token.h"
+#include "orchestrator.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+#include <sys/random.h>
+
+namespace Kithly {
+namespace Orchestrator {
+
+namespace {
+
+// Excludes confusing characters: O, 0, I, 1. Exactly 32 symbols.
+constexpr char ALPHABET[] = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789";
+static_assert(sizeof(ALPHABET) - 1 == 32, "5-bit sampling needs a 32-symbol alphabet");
+
+constexpr std::size_t BYTES_PER_TOKEN = 5;   // 8 symbols x 5 bits
+constexpr std::size_t POOL_TOKENS = 64;
+
+/**
+ * Read exactly n bytes from the kernel CSPRNG
+ */
+void fill_random(unsigned char* out, std::size_t n) {
+    while (n > 0) {
+        // getrandom never returns short for <= 256 bytes once the pool is
+        // initialised, but larger reads and signals can interrupt it
+        ssize_t got = getrandom(out, n, 0);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "getrandom");
+        }
+        out += got;
+        n -= static_cast<std::size_t>(got);
+    }
+}
+
+void encode_token(const unsigned char* bytes, HandshakeToken& out) {
+    uint64_t bits = 0;
+    for (std::size_t i = 0; i < BYTES_PER_TOKEN; ++i) {
+        bits = (bits << 8) | bytes[i];
+    }
+    for (int i = 0; i < 4; ++i) {
+        out[i] = ALPHABET[(bits >> (35 - 5 * i)) & 31];
+    }
+    out[4] = '-';
+    for (int i = 0; i < 4; ++i) {
+        out[5 + i] = ALPHABET[(bits >> (15 - 5 * i)) & 31];
+    }
+}
+
+struct TokenPool {
+    HandshakeToken tokens[POOL_TOKENS];
+    std::size_t next = POOL_TOKENS;   // Empty until first use
+};
+
+} // namespace
+
+void generate_handshake_tokens(HandshakeToken* out, std::size_t count) {
+    // Random bytes for up to one pool's worth of tokens per syscall
+    unsigned char bytes[POOL_TOKENS * BYTES_PER_TOKEN];
+    while (count > 0) {
+        const std::size_t n = count < POOL_TOKENS ? count : POOL_TOKENS;
+        fill_random(bytes, n * BYTES_PER_TOKEN);
+        for (std::size_t i = 0; i < n; ++i) {
+            encode_token(bytes + i * BYTES_PER_TOKEN, out[i]);
+        }
+        // Issued tokens must not be recoverable from stack residue
+        std::memset(bytes, 0, n * BYTES_PER_TOKEN);
+        out += n;
+        count -= n;
+    }
+}
+
+void generate_handshake_token(HandshakeToken& out) {
+    thread_local TokenPool pool;
+    if (pool.next == POOL_TOKENS) {
+        generate_handshake_tokens(pool.tokens, POOL_TOKENS);
+        pool.next = 0;
+    }
+    HandshakeToken& token = pool.tokens[pool.next++];
+    std::memcpy(out, token, HANDSHAKE_TOKEN_LEN);
+    std::memset(token, 0, HANDSHAKE_TOKEN_LEN);
+}
+
+std::string generate_handshake_token() {
+    HandshakeToken token;
+    generate_handshake_token(token);
+    return std::string(token, HANDSHAKE_TOKEN_LEN);
+}
+
+} // namespace Orchestrator
+} // namespace Kithly
@@ -16,101 +16,360 @@
 
 #include "orchestrator.h"
 #include "constants.h"
+#include "status_table.h"
 #include "structs.h"
 #include "db_connector.h"
+#include "statements.h"
+#include "payload_parser.h"
+#include "job_arena.h"
+#include "handshake_token.h"
+#include "idempotency_guard.h"
+#include "gateway_events.h"
+#include "reroute_fanout.h"
+#include "task_pool.h"
+#include "metrics.h"
+#include "log.h"
 #include <chrono>
+#include <cstdlib>
 #include <string>
-#include <iostream>
-#include <random>
-#include <nlohmann/json.hpp>
+#include <vector>
+#include <optional>
 #include <sw/redis++/redis++.h>
 
 namespace Kithly {
 namespace Orchestrator {
 
-std::string generate_handshake_token() {
-    // Exclude confusing characters: O, 0, I, 1
-    const std::string charset = "ABCDEFGHJKLMNPQRSTUVWXYZ23456789";
-    
-    // Provide a cryptographically secure seed
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, charset.size() - 1);
-    
-    std::string token;
-    token.reserve(9); // 8 chars + 1 hyphen
-    
-    for (int i = 0; i < 4; ++i) {
-        token += charset[dist(gen)];
+// One parser per worker thread: its scratch buffer is reused across jobs
+static GiftPayloadParser& worker_parser() {
+    thread_local GiftPayloadParser parser;
+    return parser;
+}
+
+// Hot-path latency histograms (registered once, see metrics.h)
+static metrics::LatencyHistogram& parse_latency() {
+    static auto& h = metrics::histogram("kithly_payload_parse_seconds", "",
+                                        "Gift payload parse and validation");
+    return h;
+}
+
+static metrics::LatencyHistogram& idempotency_latency(const char* path) {
+    static auto& db = metrics::histogram("kithly_idempotency_check_seconds", "path=\"db\"",
+                                         "Idempotency check latency by resolving path");
+    static auto& pipelined = metrics::histogram("kithly_idempotency_check_seconds", "path=\"db_pipeline\"");
+    return std::string_view(path) == "db" ? db : pipelined;
+}
+
+using kithly::idempotency::KeyState;
+
+/**
+ * Idempotency state of one key: through the installed guard, or a direct
+ * prepared lookup when none is installed (tools, benchmarks)
+ */
+static KeyState check_idempotency(std::string_view key) {
+    if (auto guard = kithly::idempotency::installed_idempotency_guard()) {
+        return guard->check(key);
+    }
+    const auto start = metrics::Clock::now();
+    auto exists = gift_exists(key);
+    idempotency_latency("db").record_since(start);
+    return !exists ? KeyState::UNKNOWN : *exists ? KeyState::DUPLICATE : KeyState::NEW;
+}
+
+static std::vector<KeyState> check_idempotency(const std::vector<std::string_view>& keys) {
+    if (auto guard = kithly::idempotency::installed_idempotency_guard()) {
+        return guard->check_all(keys);
     }
-    token += "-";
-    for (int i = 0; i < 4; ++i) {
-        token += charset[dist(gen)];
+    // Recorded once per batch: the round trip every lookup in it shared
+    const auto start = metrics::Clock::now();
+    auto exists = gifts_exist(keys);
+    idempotency_latency("db_pipeline").record_since(start);
+    std::vector<KeyState> states;
+    states.reserve(exists.size());
+    for (const auto& e : exists) {
+        states.push_back(!e ? KeyState::UNKNOWN : *e ? KeyState::DUPLICATE : KeyState::NEW);
     }
-    
-    return token;
+    return states;
 }
 
-void process_gift_job(const std::string& raw_json, sw::redis::Redis& redis) {
+using kithly::idempotency::ReservationGuard;
+
+/**
+ * Claim a NEW key before its INSERT (see IdempotencyGuard::reserve).
+ * On NEW, `claim` holds the key until commit() or scope exit.
+ */
+static KeyState reserve_idempotency(std::string_view key, ReservationGuard& claim) {
+    auto guard = kithly::idempotency::installed_idempotency_guard();
+    if (!guard) {
+        return KeyState::NEW;
+    }
+    uint64_t token = 0;
+    const KeyState state = guard->reserve(key, token);
+    if (state == KeyState::NEW) {
+        claim = ReservationGuard(std::move(guard), key, token);
+    }
+    return state;
+}
+
+static metrics::LatencyHistogram& publish_latency() {
+    static auto& h = metrics::histogram("kithly_event_publish_seconds", "",
+                                        "Escrow-locked event LPUSH round trip");
+    return h;
+}
+
+bool execute_gift_job(std::string_view raw_json, std::pmr::string& event) {
+    GiftPayloadParser& parser = worker_parser();
+    
     try {
-        // 1. Parse JSON
-        auto parsed_json = nlohmann::json::parse(raw_json);
-        auto payload = parsed_json.get<Kithly::GiftPayload>();
+        // 1. Parse + validate in one pass; fields view into raw_json
+        GiftPayloadView payload;
+        const auto parse_start = metrics::Clock::now();
+        const bool parsed = parser.parse(raw_json, payload);
+        parse_latency().record_since(parse_start);
+        if (!parsed) {
+            KITHLY_LOG_ERROR("ORCHESTRATOR", "JSON parse error")
+                .field("error", parser.error()).field("payload", raw_json);
+            return false;
+        }
         
-        std::cout << "[ORCHESTRATOR] Parsed tx_id: " << payload.tx_id << std::endl;
+        KITHLY_LOG_DEBUG("ORCHESTRATOR", "Parsed gift").field("tx_id", payload.tx_id);
         
-        // 2. Instantiate/Use DBConnector
-        // (Assuming existing connection or placeholder)
+        // 2. Idempotency Check (guard cache, then a prepared lookup)
+        const KeyState seen = check_idempotency(payload.idempotency_key);
+        if (seen == KeyState::UNKNOWN) {
+            throw TransientJobError("idempotency lookup failed for tx_id " + std::string(payload.tx_id));
+        }
         
-        // 3. Idempotency Check
-        // TODO: Replace with actual Postgres SELECT query
-        bool is_duplicate = false; 
+        // 3. Act
+        if (seen == KeyState::DUPLICATE) {
+            KITHLY_LOG_INFO("IDEMPOTENCY", "Duplicate ignored").field("tx_id", payload.tx_id);
+            return false;
+        }
         
-        // 4. Act
-        if (is_duplicate) {
-            std::cout << "Duplicate ignored. KithLy saved from double-charging." << std::endl;
-        } else {
-            std::string hs_token = generate_handshake_token();
-            
-            // TODO: Replace with actual Postgres INSERT query into Global_Gifts
-            // Parameters: 
-            //   status = 'ESCROW_LOCKED'
-            //   handshake_jwt = hs_token
-            //   ... other fields from payload
-            
-            std::cout << "✅ Bare-Metal Database committed." << std::endl;
-            std::cout << "🔒 Escrow Locked. Handshake Token: " << hs_token << std::endl;
+        // Released on any exit that does not commit the key
+        ReservationGuard claim;
+        switch (reserve_idempotency(payload.idempotency_key, claim)) {
+            case KeyState::NEW:
+                break;
+            case KeyState::DUPLICATE:
+                KITHLY_LOG_INFO("IDEMPOTENCY", "Duplicate ignored").field("tx_id", payload.tx_id);
+                return false;
+            case KeyState::UNKNOWN:
+                throw TransientJobError("idempotency key held elsewhere for tx_id " + std::string(payload.tx_id));
+        }
+        
+        HandshakeToken hs_buffer;
+        try {
+            generate_handshake_token(hs_buffer);
+        } catch (const std::system_error& e) {
+            throw TransientJobError(std::string("handshake token generation failed: ") + e.what());
+        }
+        const std::string_view hs_token(hs_buffer, HANDSHAKE_TOKEN_LEN);
+        
+        // 4. INSERT into Global_Gifts as ESCROW_LOCKED (200)
+        switch (insert_gift(payload, hs_token)) {
+            case GiftWrite::INSERTED:
+                claim.commit();
+                break;
+            case GiftWrite::DUPLICATE:
+                // A peer worker committed the same key between lookup and insert
+                claim.commit();
+                KITHLY_LOG_INFO("IDEMPOTENCY", "Duplicate ignored").field("tx_id", payload.tx_id);
+                return false;
+            case GiftWrite::INVALID:
+                KITHLY_LOG_ERROR("ORCHESTRATOR", "Rejected payload").field("tx_id", payload.tx_id);
+                return false;
+            case GiftWrite::FAILED:
+                throw TransientJobError("gift insert failed for tx_id " + std::string(payload.tx_id));
+        }
+        
+        KITHLY_LOG_INFO("ORCHESTRATOR", "Escrow locked")
+            .field("tx_id", payload.tx_id).field("status", static_cast<int>(Status::FUNDS_LOCKED));
 
-            // 5. Publish escrow-locked event to Redis Event Bus
-            //    The Python Gateway will BRPOP this queue and send the SMS.
-            nlohmann::json event;
-            event["tx_ref"]         = parsed_json.value("tx_ref", payload.tx_id);
-            event["receiver_phone"] = payload.receiver_phone;
-            event["handshake_code"] = hs_token;
+        // 5. Build escrow-locked event for the Redis Event Bus
+        //    The Python Gateway will BRPOP this queue and send the SMS.
+        //    Encoded straight into the caller's (arena-backed) string.
+        append_escrow_locked_event(event, payload.effective_tx_ref(), payload.receiver_phone, hs_token);
 
-            redis.lpush("kithly:events:escrow_locked", event.dump());
-            std::cout << "📡 Event published → kithly:events:escrow_locked" << std::endl;
-        }
+        return true;
 
-    } catch (const nlohmann::json::parse_error& e) {
-        std::cerr << "[ORCHESTRATOR FATAL] JSON parse error: " << e.what() << "\nPayload: " << raw_json << std::endl;
-    } catch (const nlohmann::json::type_error& e) {
-        std::cerr << "[ORCHESTRATOR FATAL] JSON type error: " << e.what() << "\nThis indicates a schema mismatch." << std::endl;
+    } catch (const TransientJobError&) {
+        throw;
     } catch (const std::exception& e) {
-        std::cerr << "[ORCHESTRATOR FATAL] Unhandled exception: " << e.what() << std::endl;
+        KITHLY_LOG_ERROR("ORCHESTRATOR", "Unhandled exception").field("error", e.what());
     }
+    return false;
 }
 
-} // namespace Orchestrator
+std::optional<std::string> execute_gift_job(const std::string& raw_json) {
+    ArenaScope scope(worker_arena());
+    std::pmr::string event(scope.resource());
+    if (!execute_gift_job(raw_json, event)) {
+        return std::nullopt;
+    }
+    return std::string(event);
+}
+
+void process_gift_job(const std::string& raw_json, sw::redis::Redis& redis) {
+    ArenaScope scope(worker_arena());
+    std::pmr::string event(scope.resource());
+    if (!execute_gift_job(raw_json, event)) {
+        return;
+    }
+    
+    {
+        metrics::ScopedTimer timer(publish_latency());
+        redis.lpush(ESCROW_LOCKED_QUEUE, sw::redis::StringView(event.data(), event.size()));
+    }
+    KITHLY_LOG_DEBUG("ORCHESTRATOR", "Event published").field("queue", ESCROW_LOCKED_QUEUE);
+}
+
+std::size_t process_gift_batch(const std::vector<std::string>& raw_jsons, sw::redis::Redis& redis) {
+    // Events, tokens and escaped payload fields live in the worker's arena
+    // and are dropped together when the batch ends
+    ArenaScope scope(worker_arena());
+    GiftPayloadParser& parser = worker_parser();
+    
+    // 1. Parse every job up front. Detached views only need raw_jsons.
+    std::vector<GiftPayloadView> payloads;
+    payloads.reserve(raw_jsons.size());
+    for (const auto& raw_json : raw_jsons) {
+        GiftPayloadView payload;
+        const auto parse_start = metrics::Clock::now();
+        const bool parsed = parser.parse(raw_json, payload);
+        parse_latency().record_since(parse_start);
+        if (!parsed) {
+            KITHLY_LOG_ERROR("ORCHESTRATOR", "JSON parse error")
+                .field("error", parser.error()).field("payload", raw_json);
+            continue;
+        }
+        parser.detach(payload, scope.resource());
+        KITHLY_LOG_DEBUG("ORCHESTRATOR", "Parsed gift").field("tx_id", payload.tx_id);
+        payloads.push_back(payload);
+    }
+    
+    if (payloads.empty()) {
+        return 0;
+    }
+    
+    // 2. Every idempotency lookup the guard cache cannot answer, in one
+    //    pipelined round trip
+    std::vector<std::string_view> keys;
+    keys.reserve(payloads.size());
+    for (const auto& payload : payloads) {
+        keys.push_back(payload.idempotency_key);
+    }
+    const std::vector<KeyState> seen = check_idempotency(keys);
+    
+    // A failed lookup stops the batch there, as the sequential loop did:
+    // the retry re-runs that job and everything after it in FIFO order
+    std::size_t runnable = payloads.size();
+    for (std::size_t i = 0; i < seen.size(); ++i) {
+        if (seen[i] == KeyState::UNKNOWN) {
+            runnable = i;
+            break;
+        }
+    }
+    
+    // A key held by another request (or an unreachable reservation
+    // backend) is left for the retry, like a failed lookup
+    bool failed = runnable < payloads.size();
+    std::vector<GiftPayloadView> fresh;
+    std::vector<ReservationGuard> claims;
+    fresh.reserve(runnable);
+    claims.reserve(runnable);
+    for (std::size_t i = 0; i < runnable; ++i) {
+        if (seen[i] == KeyState::DUPLICATE) {
+            KITHLY_LOG_INFO("IDEMPOTENCY", "Duplicate ignored").field("tx_id", payloads[i].tx_id);
+            continue;
+        }
+        ReservationGuard claim;
+        switch (reserve_idempotency(payloads[i].idempotency_key, claim)) {
+            case KeyState::NEW:
+                fresh.push_back(payloads[i]);
+                claims.push_back(std::move(claim));
+                break;
+            case KeyState::DUPLICATE:
+                KITHLY_LOG_INFO("IDEMPOTENCY", "Duplicate ignored").field("tx_id", payloads[i].tx_id);
+                break;
+            case KeyState::UNKNOWN:
+                failed = true;
+                break;
+        }
+    }
+    
+    // 3. Tokens in one draw, then every INSERT in one pipelined round trip.
+    //    Rows commit independently; a batch duplicate loses on ON CONFLICT.
+    std::vector<GiftWrite> writes;
+    std::vector<std::string_view> token_views;
+    if (!fresh.empty()) {
+        auto* tokens = static_cast<HandshakeToken*>(
+            scope.resource()->allocate(sizeof(HandshakeToken) * fresh.size(), alignof(HandshakeToken)));
+        try {
+            generate_handshake_tokens(tokens, fresh.size());
+        } catch (const std::system_error& e) {
+            throw TransientJobError(std::string("handshake token generation failed: ") + e.what());
+        }
+        token_views.reserve(fresh.size());
+        for (std::size_t k = 0; k < fresh.size(); ++k) {
+            token_views.emplace_back(tokens[k], HANDSHAKE_TOKEN_LEN);
+        }
+        writes = insert_gifts(fresh, token_views);
+    }
+    
+    // 4. Events for every committed gift, including those after a failed
+    //    row: a retry sees them as duplicates and would never send the SMS
+    std::pmr::vector<std::pmr::string> events(scope.resource());
+    events.reserve(fresh.size());
+    for (std::size_t k = 0; k < fresh.size(); ++k) {
+        switch (writes[k]) {
+            case GiftWrite::INSERTED:
+                claims[k].commit();
+                KITHLY_LOG_INFO("ORCHESTRATOR", "Escrow locked")
+                    .field("tx_id", fresh[k].tx_id).field("status", static_cast<int>(Status::FUNDS_LOCKED));
+                events.emplace_back();
+                append_escrow_locked_event(events.back(), fresh[k].effective_tx_ref(),
+                                           fresh[k].receiver_phone, token_views[k]);
+                break;
+            case GiftWrite::DUPLICATE:
+                // A peer worker (or an earlier job in this batch) committed the key
+                claims[k].commit();
+                KITHLY_LOG_INFO("IDEMPOTENCY", "Duplicate ignored").field("tx_id", fresh[k].tx_id);
+                break;
+            case GiftWrite::INVALID:
+                KITHLY_LOG_ERROR("ORCHESTRATOR", "Rejected payload").field("tx_id", fresh[k].tx_id);
+                break;
+            case GiftWrite::FAILED:
+                failed = true;
+                break;
+        }
+    }
+    
+    // One LPUSH with N values: a single round-trip, and FIFO order is kept
+    // for the gateway's BRPOP because values are pushed left-to-right.
+    if (!events.empty()) {
+        std::pmr::vector<sw::redis::StringView> values(scope.resource());
+        values.reserve(events.size());
+        for (const auto& event : events) {
+            values.emplace_back(event.data(), event.size());
+        }
+        {
+            metrics::ScopedTimer timer(publish_latency());
+            redis.lpush(ESCROW_LOCKED_QUEUE, values.begin(), values.end());
+        }
+        KITHLY_LOG_DEBUG("ORCHESTRATOR", "Events published")
+            .field("queue", ESCROW_LOCKED_QUEUE).field("count", events.size());
+    }
+    
+    if (failed) {
+        throw TransientJobError("database unavailable for part of a " +
+                                std::to_string(raw_jsons.size()) + "-job batch");
+    }
+    return events.size();
+}
 
-// Extended status codes for escalation
-constexpr int FORCE_CALL_PENDING = 305;
-constexpr int REROUTING = 315;
-constexpr int HELD_FOR_REVIEW = 800;
+} // namespace Orchestrator
 
-// Escalation thresholds
-constexpr int FORCE_CALL_THRESHOLD_MINS = 5;
-constexpr int REROUTE_THRESHOLD_MINS = 10;
+// Extended status codes and escalation thresholds: see constants.h
 
 /**
  * Transaction with timing info for escalation checks
@@ -142,18 +401,16 @@ int check_for_escalation(const Transaction& tx) {
     
     // Status 300 (FULFILLING) → 305 (FORCE_CALL_PENDING) after 5 mins
     if (tx.status_code == Status::FULFILLING && elapsed_mins > FORCE_CALL_THRESHOLD_MINS) {
-        std::cout << "[ESCALATION] tx_id=" << tx.tx_id 
-                  << " | 300→305 | Triggering force call after " 
-                  << elapsed_mins << " mins" << std::endl;
-        return FORCE_CALL_PENDING;
+        KITHLY_LOG_INFO("ESCALATION", "Triggering force call")
+            .field("tx_id", tx.tx_id).field("from", 300).field("to", 305).field("elapsed_mins", elapsed_mins);
+        return status::checked<Status::FULFILLING, FORCE_CALL_PENDING>;
     }
     
     // Status 305 → 315 (REROUTING) after 10 mins
     if (tx.status_code == FORCE_CALL_PENDING && elapsed_mins > REROUTE_THRESHOLD_MINS) {
-        std::cout << "[ESCALATION] tx_id=" << tx.tx_id 
-                  << " | 305→315 | Initiating reroute after " 
-                  << elapsed_mins << " mins" << std::endl;
-        return REROUTING;
+        KITHLY_LOG_INFO("ESCALATION", "Initiating reroute")
+            .field("tx_id", tx.tx_id).field("from", 305).field("to", 315).field("elapsed_mins", elapsed_mins);
+        return status::checked<FORCE_CALL_PENDING, REROUTING>;
     }
     
     return 0; // No escalation needed
@@ -169,16 +426,14 @@ bool process_escalation(Transaction& tx) {
         return false; // No escalation
     }
     
-    // Update in database
-    if (update_status(tx.tx_id, new_status)) {
+    // Compare-and-set, as process_escalations
+    if (bulk_transition_status({{tx.tx_id, tx.status_code, new_status}}).front()) {
         tx.status_code = new_status;
         tx.status_changed_at = std::chrono::system_clock::now();
         
-        // Trigger gateway hook for force call
+        // Trigger gateway hook for force call (Twilio, via the event stream)
         if (new_status == FORCE_CALL_PENDING) {
-            // TODO: Call internal_worker to trigger Twilio
-            std::cout << "[GATEWAY] POST /internal/force-call tx_id=" 
-                      << tx.tx_id << std::endl;
+            publish_gateway_event(GatewayEventType::FORCE_CALL, tx.tx_id, FORCE_CALL_PENDING);
         }
         
         return true;
@@ -187,19 +442,63 @@ bool process_escalation(Transaction& tx) {
     return false;
 }
 
+/**
+ * Process escalations for a whole sweep batch in one round-trip
+ * Returns: number of transactions escalated
+ */
+int process_escalations(std::vector<Transaction>& txs) {
+    std::vector<StatusTransition> transitions;
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < txs.size(); ++i) {
+        int new_status = check_for_escalation(txs[i]);
+        if (new_status != 0) {
+            transitions.push_back({txs[i].tx_id, txs[i].status_code, new_status});
+            indices.push_back(i);
+        }
+    }
+    
+    if (transitions.empty()) {
+        return 0;
+    }
+    
+    // Compare-and-set on the status the sweep read: a gift that moved on
+    // since (handed off, or escalated by the timing wheel) is left alone
+    auto outcomes = bulk_transition_status(transitions);
+    auto now = std::chrono::system_clock::now();
+    int escalated = 0;
+    
+    for (std::size_t k = 0; k < transitions.size(); ++k) {
+        if (!outcomes[k]) {
+            continue;
+        }
+        
+        Transaction& tx = txs[indices[k]];
+        tx.status_code = transitions[k].to_status;
+        tx.status_changed_at = now;
+        ++escalated;
+        
+        // Trigger gateway hook for force call (Twilio, via the event stream)
+        if (tx.status_code == FORCE_CALL_PENDING) {
+            publish_gateway_event(GatewayEventType::FORCE_CALL, tx.tx_id, FORCE_CALL_PENDING);
+        }
+    }
+    
+    return escalated;
+}
+
 /**
  * Handle Stripe webhook: 100 → 200 (FUNDS_LOCKED)
  * Only trust server-to-server webhook, not client-side success
  */
 bool on_stripe_webhook_payment_confirmed(const std::string& tx_id, const std::string& payment_intent_id) {
-    std::cout << "[STRIPE WEBHOOK] Payment confirmed for tx_id=" << tx_id 
-              << " intent=" << payment_intent_id << std::endl;
-    
-    // Verify current status is 100
-    // TODO: Query database for current status
+    KITHLY_LOG_INFO("STRIPE WEBHOOK", "Payment confirmed")
+        .field("tx_id", tx_id).field("intent", payment_intent_id);
     
-    if (update_status(tx_id, Status::FUNDS_LOCKED)) {
-        std::cout << "[STATUS] " << tx_id << " | 100 → 200 (FUNDS_LOCKED)" << std::endl;
+    // Compare-and-set: only a gift still at 100 locks its funds (a
+    // replayed webhook finds it already at 200)
+    if (bulk_transition_status({{tx_id, Status::INITIATED,
+                                 status::checked<Status::INITIATED, Status::FUNDS_LOCKED>}}).front()) {
+        KITHLY_LOG_INFO("STATUS", "FUNDS_LOCKED").field("tx_id", tx_id).field("from", 100).field("to", 200);
         return true;
     }
     
@@ -211,15 +510,14 @@ bool on_stripe_webhook_payment_confirmed(const std::string& tx_id, const std::st
  * Only after shop's mobile money account is validated
  */
 bool on_flutterwave_webhook_account_verified(const std::string& tx_id, const std::string& shop_id) {
-    std::cout << "[FLUTTERWAVE WEBHOOK] Account verified for shop=" << shop_id 
-              << " tx_id=" << tx_id << std::endl;
+    KITHLY_LOG_INFO("FLUTTERWAVE WEBHOOK", "Account verified")
+        .field("tx_id", tx_id).field("shop_id", shop_id);
     
-    // Verify current status is 200 (FUNDS_LOCKED)
-    // Only proceed if funds are locked
-    
-    if (update_status(tx_id, Status::SETTLED)) {
-        std::cout << "[STATUS] " << tx_id << " | 200 → 250 (SETTLED)" << std::endl;
-        std::cout << "[GATEWAY] POST /internal/notify-shop shop_id=" << shop_id << std::endl;
+    // Compare-and-set: only proceed while funds are locked (200)
+    if (bulk_transition_status({{tx_id, Status::FUNDS_LOCKED,
+                                 status::checked<Status::FUNDS_LOCKED, Status::SETTLED>}}).front()) {
+        KITHLY_LOG_INFO("STATUS", "SETTLED").field("tx_id", tx_id).field("from", 200).field("to", 250);
+        publish_gateway_event(GatewayEventType::NOTIFY_SHOP, tx_id, Status::SETTLED, shop_id);
         return true;
     }
     
@@ -227,7 +525,7 @@ bool on_flutterwave_webhook_account_verified(const std::string& tx_id, const std
 }
 
 /**
- * ZRA Fiscalization Interlock: Controls 340 → 400 transition
+ * ZRA Fiscalization Interlock: Controls 350 → 400 transition
  * Returns true only if ZRA VSDC returns resultCd 000 or 001
  */
 bool can_complete_delivery(const std::string& tx_id, const std::string& zra_result_code) {
@@ -235,44 +533,54 @@ bool can_complete_delivery(const std::string& tx_id, const std::string& zra_resu
     // without successful ZRA fiscalization
     
     if (zra_result_code == "000" || zra_result_code == "001") {
-        std::cout << "[ZRA OK] tx_id=" << tx_id << " resultCd=" << zra_result_code 
-                  << " | Interlock RELEASED" << std::endl;
+        KITHLY_LOG_INFO("ZRA", "Interlock released")
+            .field("tx_id", tx_id).field("result_cd", zra_result_code);
         return true;
     }
     
-    std::cout << "[ZRA FAIL] tx_id=" << tx_id << " resultCd=" << zra_result_code 
-              << " | Interlock HELD" << std::endl;
+    KITHLY_LOG_WARN("ZRA", "Interlock held")
+        .field("tx_id", tx_id).field("result_cd", zra_result_code);
     return false;
 }
 
 /**
- * Mark delivery complete: 340 → 400 (COMPLETED)
- * Requires ZRA verification (hard interlock)
+ * Mark deliveries complete: 350 → 400 (COMPLETED)
+ * Requires ZRA verification (hard interlock); failures are held for review
  */
-bool complete_delivery(const std::string& tx_id, const std::string& zra_result_code) {
-    if (!can_complete_delivery(tx_id, zra_result_code)) {
-        // Hold for review if ZRA failed
-        update_status(tx_id, HELD_FOR_REVIEW);
-        std::cout << "[STATUS] " << tx_id << " | → 800 (HELD_FOR_REVIEW) - ZRA interlock failed" << std::endl;
-        return false;
+std::vector<bool> complete_deliveries(const std::vector<ZraResult>& results) {
+    std::vector<StatusTransition> transitions;
+    transitions.reserve(results.size());
+    for (const auto& [tx_id, zra_result_code] : results) {
+        transitions.push_back({tx_id, KEY_VERIFIED,
+            can_complete_delivery(tx_id, zra_result_code)
+                ? status::checked<KEY_VERIFIED, Status::COMPLETED>
+                : status::checked<KEY_VERIFIED, HELD_FOR_REVIEW>});
     }
     
-    if (update_status(tx_id, Status::COMPLETED)) {
-        std::cout << "[STATUS] " << tx_id << " | → 400 (COMPLETED)" << std::endl;
-        return true;
+    auto applied = bulk_transition_status(transitions);
+    std::vector<bool> completed(results.size(), false);
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        if (!applied[i]) {
+            continue;
+        }
+        if (transitions[i].to_status == Status::COMPLETED) {
+            completed[i] = true;
+            KITHLY_LOG_INFO("STATUS", "COMPLETED").field("tx_id", results[i].first).field("to", 400);
+        } else {
+            KITHLY_LOG_WARN("STATUS", "HELD_FOR_REVIEW - ZRA interlock failed").field("tx_id", results[i].first).field("to", 800);
+        }
     }
-    
-    return false;
+    return completed;
+}
+
+bool complete_delivery(const std::string& tx_id, const std::string& zra_result_code) {
+    return complete_deliveries({{tx_id, zra_result_code}}).front();
 }
 
 // =============================================================================
 // 48-HOUR ESCROW WATCHDOG (Phase III-V)
 // =============================================================================
 
-constexpr int KEY_VERIFIED = 350;
-constexpr int EXPIRED = 900;
-constexpr int ESCROW_TIMEOUT_HOURS = 48;
-
 /**
  * Extended Transaction with escrow data
  */
@@ -306,26 +614,64 @@ bool process_expired_escrow(EscrowTransaction& tx) {
         return false;
     }
     
-    std::cout << "[ESCROW EXPIRED] tx_id=" << tx.tx_id 
-              << " | 48-hour deadline passed" << std::endl;
+    KITHLY_LOG_INFO("ESCROW EXPIRED", "48-hour deadline passed").field("tx_id", tx.tx_id);
     
-    // Move to EXPIRED status
-    if (update_status(tx.tx_id, EXPIRED)) {
+    // Move to EXPIRED status, only if still FUNDS_LOCKED; the refund
+    // (Stripe Refund API via the Gateway) is outboxed in the same statement
+    auto outcome = transition_with_event(GatewayEventType::REFUND,
+        {{tx.tx_id, Status::FUNDS_LOCKED, status::checked<Status::FUNDS_LOCKED, EXPIRED>}}).front();
+    if (outcome.applied) {
         tx.status_code = EXPIRED;
-        
-        // Trigger Stripe refund
-        std::cout << "[STRIPE REFUND] Initiating refund for tx_id=" << tx.tx_id 
-                  << " payment_ref=" << tx.stripe_payment_ref << std::endl;
-        
-        // TODO: Call Stripe Refund API via Gateway
-        // POST /internal/refund { tx_id, stripe_payment_ref }
-        
+        KITHLY_LOG_INFO("STRIPE REFUND", "Initiating refund")
+            .field("tx_id", tx.tx_id).field("payment_ref", outcome.payment_ref);
         return true;
     }
     
     return false;
 }
 
+/**
+ * Process a batch of expired escrows: 200 → 900 in one round-trip
+ * Returns: number of transactions expired
+ */
+int process_expired_escrows(std::vector<EscrowTransaction>& txs) {
+    std::vector<StatusTransition> transitions;
+    std::vector<std::size_t> indices;
+    for (std::size_t i = 0; i < txs.size(); ++i) {
+        if (is_escrow_expired(txs[i])) {
+            transitions.push_back({txs[i].tx_id, Status::FUNDS_LOCKED,
+                                   status::checked<Status::FUNDS_LOCKED, EXPIRED>});
+            indices.push_back(i);
+        }
+    }
+    
+    if (transitions.empty()) {
+        return 0;
+    }
+    
+    // Only gifts still FUNDS_LOCKED expire: one picked up or settled
+    // after the scan page was read must not be refunded. Each refund
+    // commits with its transition (Stripe Refund API via the Gateway).
+    auto outcomes = transition_with_event(GatewayEventType::REFUND, transitions);
+    int expired = 0;
+    
+    for (std::size_t k = 0; k < transitions.size(); ++k) {
+        if (!outcomes[k].applied) {
+            continue;
+        }
+        
+        EscrowTransaction& tx = txs[indices[k]];
+        tx.status_code = EXPIRED;
+        ++expired;
+        
+        KITHLY_LOG_INFO("STRIPE REFUND", "Initiating refund")
+            .field("tx_id", tx.tx_id).field("payment_ref", outcomes[k].payment_ref);
+    }
+    
+    KITHLY_LOG_INFO("ESCROW EXPIRED", "48-hour deadline passed").field("expired", expired);
+    return expired;
+}
+
 /**
  * Verify collection token and transition to KEY_VERIFIED
  * Called when shop scans QR or enters 10-digit code
@@ -336,20 +682,23 @@ bool verify_collection_token(
     const std::string& expected_token
 ) {
     if (provided_token != expected_token) {
-        std::cout << "[TOKEN INVALID] tx_id=" << tx_id 
-                  << " | Provided token does not match" << std::endl;
+        KITHLY_LOG_WARN("TOKEN INVALID", "Provided token does not match").field("tx_id", tx_id);
         return false;
     }
     
-    // Move to KEY_VERIFIED
-    if (update_status(tx_id, KEY_VERIFIED)) {
-        std::cout << "[STATUS] " << tx_id << " | → 350 (KEY_VERIFIED)" << std::endl;
+    // Move to KEY_VERIFIED from whichever collectable state the gift is
+    // in (a force call may be outstanding); the Flutterwave disbursement
+    // is outboxed in the same statement
+    for (int from : {static_cast<int>(Status::FULFILLING), FORCE_CALL_PENDING}) {
+        const int to = from == FORCE_CALL_PENDING ? status::checked<FORCE_CALL_PENDING, KEY_VERIFIED>
+                                                  : status::checked<Status::FULFILLING, KEY_VERIFIED>;
+        if (!transition_with_event(GatewayEventType::TRIGGER_DISBURSEMENT, {{tx_id, from, to}}).front().applied) {
+            continue;
+        }
+        KITHLY_LOG_INFO("STATUS", "KEY_VERIFIED").field("tx_id", tx_id).field("from", from).field("to", 350);
         
         // Trigger ZRA fiscalization
-        std::cout << "[GATEWAY] POST /verification/trigger-zra tx_id=" << tx_id << std::endl;
-        
-        // Trigger Flutterwave disbursement
-        std::cout << "[GATEWAY] POST /verification/trigger-disbursement tx_id=" << tx_id << std::endl;
+        publish_gateway_event(GatewayEventType::TRIGGER_ZRA, tx_id, KEY_VERIFIED);
         
         return true;
     }
@@ -359,20 +708,163 @@ bool verify_collection_token(
 
 /**
  * Run escrow watchdog (called by scheduled worker)
- * Scans all LOCKED transactions for expiry
+ * Streams expired LOCKED transactions in keyset pages of page_size rows,
+ * so memory stays constant however large Global_Gifts grows.
  */
-void run_escrow_watchdog() {
-    std::cout << "[ESCROW WATCHDOG] Starting scan..." << std::endl;
+void run_escrow_watchdog(int page_size = 500) {
+    KITHLY_LOG_INFO("ESCROW WATCHDOG", "Starting scan");
     
-    // TODO: Query database for LOCKED transactions
-    // SELECT tx_id, expiry_timestamp, stripe_payment_ref 
-    // FROM Global_Gifts 
-    // WHERE status_code = 200
+    // Keyset cursor: position after the last (expiry_timestamp, tx_id) seen
+    std::string cursor_expiry = "-infinity";
+    std::string cursor_tx_id = "00000000-0000-0000-0000-000000000000";
+    sql::Int4Param limit(page_size);
     
-    // For each expired transaction, call process_expired_escrow()
+    std::vector<EscrowTransaction> page;
+    page.reserve(page_size);
+    int scanned = 0;
+    int expired = 0;
     
-    std::cout << "[ESCROW WATCHDOG] Scan complete" << std::endl;
+    while (true) {
+        page.clear();
+        {
+            // Hold the lease for the SELECT only: the bulk update below
+            // checks out its own connection.
+            auto lease = acquire_db_connection();
+            if (!lease) {
+                KITHLY_LOG_ERROR("ESCROW WATCHDOG", "No database connection - scan aborted");
+                return;
+            }
+            
+            const char* paramValues[3] = { cursor_expiry.c_str(), cursor_tx_id.c_str(), limit.bytes };
+            const int paramLengths[3] = { 0, 0, sizeof(limit.bytes) };
+            const int paramFormats[3] = { sql::TEXT_FORMAT, sql::TEXT_FORMAT, sql::BINARY_FORMAT };
+            
+            PGresult* res = sql::exec_prepared(
+                lease.get(), sql::SCAN_EXPIRED_ESCROW, 3, paramValues, paramLengths, paramFormats, 0);
+            
+            if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+                KITHLY_LOG_ERROR("ESCROW WATCHDOG", "Scan failed").field("error", PQerrorMessage(lease.get()));
+                PQclear(res);
+                return;
+            }
+            
+            int rows = PQntuples(res);
+            for (int r = 0; r < rows; ++r) {
+                EscrowTransaction tx;
+                tx.tx_id = PQgetvalue(res, r, 0);
+                tx.status_code = Status::FUNDS_LOCKED;
+                tx.expiry_timestamp = std::chrono::system_clock::time_point(
+                    std::chrono::milliseconds(std::atoll(PQgetvalue(res, r, 2))));
+                tx.collection_token = PQgetvalue(res, r, 3);
+                tx.stripe_payment_ref = PQgetvalue(res, r, 4);
+                tx.is_settled = PQgetvalue(res, r, 5)[0] == 't';
+                page.push_back(std::move(tx));
+            }
+            
+            if (rows > 0) {
+                cursor_expiry = PQgetvalue(res, rows - 1, 1);
+                cursor_tx_id = PQgetvalue(res, rows - 1, 0);
+            }
+            PQclear(res);
+        }
+        
+        if (page.empty()) {
+            break;
+        }
+        
+        scanned += static_cast<int>(page.size());
+        expired += process_expired_escrows(page);
+        
+        if (static_cast<int>(page.size()) < page_size) {
+            break;  // Last (short) page
+        }
+    }
+    
+    KITHLY_LOG_INFO("ESCROW WATCHDOG", "Scan complete").field("scanned", scanned).field("expired", expired);
 }
 
-} // namespace Kithly
+// =============================================================================
+// DEADLINE SCHEDULER FIRE HANDLER
+// =============================================================================
 
+namespace Orchestrator {
+
+void fire_deadlines(std::vector<Deadline>& deadlines) {
+    // Expiries carry a refund, which commits with the transition; the
+    // rest go through the plain compare-and-set
+    std::vector<StatusTransition> transitions, expiries;
+    std::vector<std::size_t> plain, refunded;
+    transitions.reserve(deadlines.size());
+    for (std::size_t i = 0; i < deadlines.size(); ++i) {
+        const Deadline& d = deadlines[i];
+        if (d.to_status == EXPIRED) {
+            expiries.push_back({d.tx_id, d.from_status, d.to_status});
+            refunded.push_back(i);
+        } else {
+            transitions.push_back({d.tx_id, d.from_status, d.to_status});
+            plain.push_back(i);
+        }
+    }
+    
+    // Compare-and-set: a gift that moved on since the deadline was armed
+    // (e.g. handed off at 300) simply does not match
+    std::vector<bool> outcomes(deadlines.size(), false);
+    std::vector<std::string> payment_refs(deadlines.size());
+    if (!transitions.empty()) {
+        auto applied = bulk_transition_status(transitions);
+        for (std::size_t k = 0; k < plain.size(); ++k) {
+            outcomes[plain[k]] = applied[k];
+        }
+    }
+    if (!expiries.empty()) {
+        auto applied = transition_with_event(GatewayEventType::REFUND, expiries);
+        for (std::size_t k = 0; k < refunded.size(); ++k) {
+            outcomes[refunded[k]] = applied[k].applied;
+            payment_refs[refunded[k]] = std::move(applied[k].payment_ref);
+        }
+    }
+    int fired = 0;
+    
+    for (std::size_t i = 0; i < deadlines.size(); ++i) {
+        if (!outcomes[i]) {
+            continue;
+        }
+        ++fired;
+        
+        const Deadline& d = deadlines[i];
+        switch (d.to_status) {
+            case FORCE_CALL_PENDING:
+                KITHLY_LOG_INFO("ESCALATION", "FORCE_CALL_PENDING").field("tx_id", d.tx_id).field("from", 300).field("to", 305);
+                publish_gateway_event(GatewayEventType::FORCE_CALL, d.tx_id, FORCE_CALL_PENDING);
+                break;
+            case REROUTING:
+                KITHLY_LOG_INFO("ESCALATION", "REROUTING").field("tx_id", d.tx_id).field("from", 305).field("to", 315);
+                publish_gateway_event(GatewayEventType::REROUTE, d.tx_id, REROUTING);
+                break;
+            case EXPIRED:
+                KITHLY_LOG_INFO("ESCROW EXPIRED", "48-hour deadline passed").field("tx_id", d.tx_id).field("from", 200).field("to", 900);
+                KITHLY_LOG_INFO("STRIPE REFUND", "Initiating refund")
+                    .field("tx_id", d.tx_id).field("payment_ref", payment_refs[i]);
+                break;
+            case DECLINED:
+                KITHLY_LOG_INFO("BAKER'S PROTOCOL", "Acceptance window lapsed")
+                    .field("tx_id", d.tx_id).field("from", 110).field("to", 910);
+                // Offer the gift to the next-best shops in parallel; off the
+                // scheduler thread when the node has a task pool
+                if (auto pool = installed_task_pool()) {
+                    pool->submit([tx_id = d.tx_id] { fan_out_reroute(tx_id); });
+                } else {
+                    fan_out_reroute(d.tx_id);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    
+    KITHLY_LOG_INFO("SCHEDULER", "Fired deadlines").field("fired", fired).field("due", deadlines.size());
+}
+
+} // namespace Orchestrator
+
+} // namespace Kithly
@@ -0,0 +1,529 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * orchestrator/payload_parser.cpp - Single-Pass Ingestion Payload Parser
+ * =============================================================================
+ */
+
+#include "payload_parser.h"
+#include <charconv>
+#include <climits>
+#include <cstring>
+
+namespace Kithly {
+
+namespace {
+
+// Deeper unknown values are rejected rather than recursed into
+constexpr int MAX_SKIP_DEPTH = 32;
+
+enum class Field {
+    UNKNOWN,
+    TX_ID, IDEMPOTENCY_KEY, RECEIVER_PHONE, SHOP_ID, PRODUCT_ID, QUANTITY,
+    TX_REF, SENDER_ID, RECEIVER_NAME, UNIT_PRICE, MESSAGE, IS_SURPRISE
+};
+
+// Bit per required field, in Field order
+constexpr unsigned REQUIRED_MASK = (1u << 6) - 1;
+constexpr const char* REQUIRED_NAMES[6] = {
+    "tx_id", "idempotency_key", "receiver_phone", "shop_id", "product_id", "quantity"
+};
+
+Field field_of(std::string_view key) {
+    switch (key.size()) {
+        case 5:
+            return key == "tx_id" ? Field::TX_ID : Field::UNKNOWN;
+        case 6:
+            return key == "tx_ref" ? Field::TX_REF : Field::UNKNOWN;
+        case 7:
+            if (key == "shop_id") return Field::SHOP_ID;
+            if (key == "message") return Field::MESSAGE;
+            return Field::UNKNOWN;
+        case 8:
+            return key == "quantity" ? Field::QUANTITY : Field::UNKNOWN;
+        case 9:
+            return key == "sender_id" ? Field::SENDER_ID : Field::UNKNOWN;
+        case 10:
+            if (key == "product_id") return Field::PRODUCT_ID;
+            if (key == "unit_price") return Field::UNIT_PRICE;
+            return Field::UNKNOWN;
+        case 11:
+            return key == "is_surprise" ? Field::IS_SURPRISE : Field::UNKNOWN;
+        case 13:
+            return key == "receiver_name" ? Field::RECEIVER_NAME : Field::UNKNOWN;
+        case 14:
+            return key == "receiver_phone" ? Field::RECEIVER_PHONE : Field::UNKNOWN;
+        case 15:
+            return key == "idempotency_key" ? Field::IDEMPOTENCY_KEY : Field::UNKNOWN;
+        default:
+            return Field::UNKNOWN;
+    }
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+} // namespace
+
+// =============================================================================
+// LEXING
+// =============================================================================
+
+bool GiftPayloadParser::fail(const char* what) {
+    error_ = what;
+    error_ += " at offset ";
+    error_ += std::to_string(p_ - begin_);
+    return false;
+}
+
+bool GiftPayloadParser::type_error(std::string_view key, const char* expected) {
+    error_ = "field '";
+    error_.append(key.data(), key.size());
+    error_ += "' must be ";
+    error_ += expected;
+    return false;
+}
+
+void GiftPayloadParser::skip_ws() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\n' || *p_ == '\r' || *p_ == '\t')) {
+        ++p_;
+    }
+}
+
+bool GiftPayloadParser::expect(char c) {
+    skip_ws();
+    if (p_ >= end_ || *p_ != c) {
+        char msg[] = "expected ' '";
+        msg[10] = c;
+        return fail(msg);
+    }
+    ++p_;
+    return true;
+}
+
+bool GiftPayloadParser::skip_utf8() {
+    const unsigned char c = static_cast<unsigned char>(*p_);
+    int n;
+    uint32_t cp;
+    if (c >= 0xC2 && c <= 0xDF) {
+        n = 1;
+        cp = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        n = 2;
+        cp = c & 0x0F;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        n = 3;
+        cp = c & 0x07;
+    } else {
+        return false;
+    }
+    if (end_ - p_ <= n) {
+        return false;
+    }
+    for (int i = 1; i <= n; ++i) {
+        const unsigned char b = static_cast<unsigned char>(p_[i]);
+        if ((b & 0xC0) != 0x80) {
+            return false;
+        }
+        cp = (cp << 6) | (b & 0x3F);
+    }
+    // Overlong forms, UTF-16 surrogates and beyond U+10FFFF are invalid
+    if (n == 2 && (cp < 0x800 || (cp >= 0xD800 && cp <= 0xDFFF))) {
+        return false;
+    }
+    if (n == 3 && (cp < 0x10000 || cp > 0x10FFFF)) {
+        return false;
+    }
+    p_ += n + 1;
+    return true;
+}
+
+bool GiftPayloadParser::parse_hex4(uint32_t& out) {
+    if (end_ - p_ < 4) {
+        return fail("truncated \\u escape");
+    }
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = *p_++;
+        out <<= 4;
+        if (c >= '0' && c <= '9') out |= static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') out |= static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') out |= static_cast<uint32_t>(c - 'A' + 10);
+        else return fail("invalid \\u escape");
+    }
+    return true;
+}
+
+bool GiftPayloadParser::parse_string(std::string_view& out) {
+    // p_ is on the opening quote
+    ++p_;
+    const char* start = p_;
+
+    // Fast path: no escapes, view straight into the input
+    while (p_ < end_) {
+        const unsigned char c = static_cast<unsigned char>(*p_);
+        if (c == '"') {
+            out = std::string_view(start, static_cast<std::size_t>(p_ - start));
+            ++p_;
+            return true;
+        }
+        if (c == '\\') {
+            break;
+        }
+        if (c < 0x20) {
+            return fail("control character in string");
+        }
+        if (c < 0x80) {
+            ++p_;
+        } else if (!skip_utf8()) {
+            return fail("invalid UTF-8 in string");
+        }
+    }
+    if (p_ >= end_) {
+        return fail("unterminated string");
+    }
+
+    // Slow path: decode into scratch_. Output never exceeds input, so
+    // the reservation made in parse() is never outgrown.
+    const std::size_t decoded = scratch_.size();
+    scratch_.append(start, static_cast<std::size_t>(p_ - start));
+    while (p_ < end_) {
+        const unsigned char c = static_cast<unsigned char>(*p_);
+        if (c == '"') {
+            out = std::string_view(scratch_.data() + decoded, scratch_.size() - decoded);
+            ++p_;
+            return true;
+        }
+        if (c < 0x20) {
+            return fail("control character in string");
+        }
+        if (c >= 0x80) {
+            const char* q = p_;
+            if (!skip_utf8()) {
+                return fail("invalid UTF-8 in string");
+            }
+            scratch_.append(q, static_cast<std::size_t>(p_ - q));
+            continue;
+        }
+        ++p_;
+        if (c != '\\') {
+            scratch_ += static_cast<char>(c);
+            continue;
+        }
+        if (p_ >= end_) {
+            break;
+        }
+        switch (*p_++) {
+            case '"':  scratch_ += '"'; break;
+            case '\\': scratch_ += '\\'; break;
+            case '/':  scratch_ += '/'; break;
+            case 'b':  scratch_ += '\b'; break;
+            case 'f':  scratch_ += '\f'; break;
+            case 'n':  scratch_ += '\n'; break;
+            case 'r':  scratch_ += '\r'; break;
+            case 't':  scratch_ += '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!parse_hex4(cp)) {
+                    return false;
+                }
+                if (cp >= 0xDC00 && cp <= 0xDFFF) {
+                    return fail("unpaired low surrogate");
+                }
+                if (cp >= 0xD800 && cp <= 0xDBFF) {
+                    uint32_t low;
+                    if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+                        return fail("unpaired high surrogate");
+                    }
+                    p_ += 2;
+                    if (!parse_hex4(low)) {
+                        return false;
+                    }
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        return fail("unpaired high surrogate");
+                    }
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(scratch_, cp);
+                break;
+            }
+            default:
+                return fail("invalid escape");
+        }
+    }
+    return fail("unterminated string");
+}
+
+bool GiftPayloadParser::parse_number(double& out) {
+    // JSON grammar: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+    const char* start = p_;
+    auto digits = [this] {
+        const char* d = p_;
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            ++p_;
+        }
+        return p_ > d;
+    };
+
+    if (p_ < end_ && *p_ == '-') {
+        ++p_;
+    }
+    if (p_ < end_ && *p_ == '0') {
+        ++p_;
+    } else if (!digits()) {
+        return fail("invalid number");
+    }
+    if (p_ < end_ && *p_ == '.') {
+        ++p_;
+        if (!digits()) {
+            return fail("invalid number");
+        }
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+        ++p_;
+        if (p_ < end_ && (*p_ == '+' || *p_ == '-')) {
+            ++p_;
+        }
+        if (!digits()) {
+            return fail("invalid number");
+        }
+    }
+
+    auto result = std::from_chars(start, p_, out);
+    if (result.ec != std::errc() || result.ptr != p_) {
+        return fail("number out of range");
+    }
+    return true;
+}
+
+bool GiftPayloadParser::parse_literal(std::string_view word) {
+    if (static_cast<std::size_t>(end_ - p_) < word.size() ||
+        std::memcmp(p_, word.data(), word.size()) != 0) {
+        return fail("invalid literal");
+    }
+    p_ += word.size();
+    return true;
+}
+
+bool GiftPayloadParser::skip_value(int depth) {
+    if (depth > MAX_SKIP_DEPTH) {
+        return fail("nesting too deep");
+    }
+    skip_ws();
+    if (p_ >= end_) {
+        return fail("unexpected end of input");
+    }
+
+    std::string_view ignored;
+    double number;
+    switch (*p_) {
+        case '"':
+            return parse_string(ignored);
+        case 't':
+            return parse_literal("true");
+        case 'f':
+            return parse_literal("false");
+        case 'n':
+            return parse_literal("null");
+        case '{':
+        case '[': {
+            const bool object = *p_ == '{';
+            const char close = object ? '}' : ']';
+            ++p_;
+            skip_ws();
+            if (p_ < end_ && *p_ == close) {
+                ++p_;
+                return true;
+            }
+            while (true) {
+                if (object) {
+                    skip_ws();
+                    if (p_ >= end_ || *p_ != '"') {
+                        return fail("expected object key");
+                    }
+                    if (!parse_string(ignored) || !expect(':')) {
+                        return false;
+                    }
+                }
+                if (!skip_value(depth + 1)) {
+                    return false;
+                }
+                skip_ws();
+                if (p_ < end_ && *p_ == ',') {
+                    ++p_;
+                    continue;
+                }
+                return expect(close);
+            }
+        }
+        default:
+            return parse_number(number);
+    }
+}
+
+// =============================================================================
+// SCHEMA
+// =============================================================================
+
+bool GiftPayloadParser::parse(std::string_view json, GiftPayloadView& out) {
+    scratch_.clear();
+    if (scratch_.capacity() < json.size()) {
+        scratch_.reserve(json.size());
+    }
+    error_.clear();
+    out = GiftPayloadView{};
+    begin_ = p_ = json.data();
+    end_ = json.data() + json.size();
+
+    if (!expect('{')) {
+        return false;
+    }
+
+    unsigned seen = 0;
+    skip_ws();
+    if (p_ < end_ && *p_ == '}') {
+        ++p_;
+    } else {
+        while (true) {
+            skip_ws();
+            if (p_ >= end_ || *p_ != '"') {
+                return fail("expected object key");
+            }
+            std::string_view key;
+            if (!parse_string(key) || !expect(':')) {
+                return false;
+            }
+            skip_ws();
+            if (p_ >= end_) {
+                return fail("unexpected end of input");
+            }
+
+            const Field field = field_of(key);
+            const bool is_null = *p_ == 'n';
+            const bool required = field != Field::UNKNOWN &&
+                                  static_cast<int>(field) <= static_cast<int>(Field::QUANTITY);
+
+            if (field == Field::UNKNOWN) {
+                if (!skip_value(0)) {
+                    return false;
+                }
+            } else if (is_null) {
+                // Optional: null is treated like an absent key
+                if (required) {
+                    return type_error(key, "non-null");
+                }
+                if (!parse_literal("null")) {
+                    return false;
+                }
+            } else if (field == Field::QUANTITY || field == Field::UNIT_PRICE) {
+                if (*p_ != '-' && (*p_ < '0' || *p_ > '9')) {
+                    return type_error(key, "a number");
+                }
+                double number;
+                if (!parse_number(number)) {
+                    return false;
+                }
+                if (field == Field::UNIT_PRICE) {
+                    out.unit_price = number;
+                } else if (number < INT_MIN || number > INT_MAX) {
+                    return type_error(key, "a 32-bit integer");
+                } else {
+                    out.quantity = static_cast<int>(number);
+                }
+            } else if (field == Field::IS_SURPRISE) {
+                if (*p_ == 't') {
+                    if (!parse_literal("true")) return false;
+                    out.is_surprise = true;
+                } else if (*p_ == 'f') {
+                    if (!parse_literal("false")) return false;
+                    out.is_surprise = false;
+                } else {
+                    return type_error(key, "a boolean");
+                }
+            } else {
+                if (*p_ != '"') {
+                    return type_error(key, "a string");
+                }
+                std::string_view value;
+                if (!parse_string(value)) {
+                    return false;
+                }
+                switch (field) {
+                    case Field::TX_ID:           out.tx_id = value; break;
+                    case Field::IDEMPOTENCY_KEY: out.idempotency_key = value; break;
+                    case Field::RECEIVER_PHONE:  out.receiver_phone = value; break;
+                    case Field::SHOP_ID:         out.shop_id = value; break;
+                    case Field::PRODUCT_ID:      out.product_id = value; break;
+                    case Field::TX_REF:          out.tx_ref = value; break;
+                    case Field::SENDER_ID:       out.sender_id = value; break;
+                    case Field::RECEIVER_NAME:   out.receiver_name = value; break;
+                    case Field::MESSAGE:         out.message = value; break;
+                    default: break;
+                }
+            }
+
+            if (required) {
+                seen |= 1u << (static_cast<int>(field) - static_cast<int>(Field::TX_ID));
+            }
+
+            skip_ws();
+            if (p_ < end_ && *p_ == ',') {
+                ++p_;
+                continue;
+            }
+            if (!expect('}')) {
+                return false;
+            }
+            break;
+        }
+    }
+
+    skip_ws();
+    if (p_ != end_) {
+        return fail("trailing characters");
+    }
+
+    if (seen != REQUIRED_MASK) {
+        for (int i = 0; i < 6; ++i) {
+            if (!(seen & (1u << i))) {
+                error_ = "missing required field '";
+                error_ += REQUIRED_NAMES[i];
+                error_ += "'";
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void GiftPayloadParser::detach(GiftPayloadView& view, std::pmr::memory_resource* resource) const {
+    const char* lo = scratch_.data();
+    const char* hi = scratch_.data() + scratch_.size();
+    for (std::string_view* field : {&view.tx_id, &view.idempotency_key, &view.receiver_phone,
+                                    &view.shop_id, &view.product_id, &view.tx_ref,
+                                    &view.sender_id, &view.receiver_name, &view.message}) {
+        if (field->empty() || field->data() < lo || field->data() >= hi) {
+            continue;  // Views into the raw job stay valid
+        }
+        char* copy = static_cast<char*>(resource->allocate(field->size(), 1));
+        std::memcpy(copy, field->data(), field->size());
+        *field = std::string_view(copy, field->size());
+    }
+}
+
+} // namespace Kithly
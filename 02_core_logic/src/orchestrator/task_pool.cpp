@@ -0,0 +1,238 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * task_pool.cpp - Work-Stealing Task Pool
+ * =============================================================================
+ */
+
+#include "task_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+namespace Kithly {
+
+namespace {
+
+// Pool and deque the current thread belongs to (pool threads only)
+thread_local TaskPool* current_pool = nullptr;
+thread_local std::size_t current_index = 0;
+
+} // namespace
+
+TaskPool::TaskPool(std::size_t threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    queues_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    threads_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&TaskPool::worker_loop, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_.store(true);
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+TaskPool* TaskPool::current() {
+    return current_pool;
+}
+
+std::size_t TaskPool::own_queue() const {
+    return current_pool == this ? current_index : queues_.size();
+}
+
+void TaskPool::submit(Task task) {
+    std::size_t target = own_queue();
+    if (target == queues_.size()) {
+        target = next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+        queues_[target]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+
+    // Taking the sleep lock orders this against a worker that has just
+    // seen queued_ == 0 and is about to wait
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    wake_.notify_one();
+}
+
+bool TaskPool::take(std::size_t home, Task& out) {
+    const std::size_t n = queues_.size();
+
+    // Own deque first, newest task (its data is still in cache)
+    if (home < n) {
+        Queue& own = *queues_[home];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Steal the oldest task from a sibling
+    const std::size_t start = home < n ? home + 1 : next_queue_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < n; ++i) {
+        const std::size_t victim = (start + i) % n;
+        if (victim == home) {
+            continue;
+        }
+        Queue& queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (!queue.tasks.empty()) {
+            out = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            queued_.fetch_sub(1);
+            if (home < n) {
+                stolen_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void TaskPool::execute(Task& task) {
+    try {
+        task();
+    } catch (const std::exception& e) {
+        std::cerr << "[TASK POOL] Task failed: " << e.what() << std::endl;
+    } catch (...) {
+        std::cerr << "[TASK POOL] Task failed with a non-standard exception" << std::endl;
+    }
+    executed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TaskPool::run_one() {
+    Task task;
+    if (!take(own_queue(), task)) {
+        return false;
+    }
+    execute(task);
+    return true;
+}
+
+void TaskPool::worker_loop(std::size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    while (true) {
+        Task task;
+        if (take(index, task)) {
+            execute(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stopping_.load() || queued_.load() > 0; });
+        if (stopping_.load() && queued_.load() == 0) {
+            return;  // Drained
+        }
+    }
+}
+
+TaskPool::Stats TaskPool::stats() const {
+    return Stats{executed_.load(std::memory_order_relaxed), stolen_.load(std::memory_order_relaxed)};
+}
+
+// =============================================================================
+// TASK GROUP
+// =============================================================================
+
+TaskGroup::TaskGroup(TaskPool* pool) : pool_(pool) {}
+
+TaskGroup::~TaskGroup() {
+    try {
+        wait();
+    } catch (...) {
+        // Exceptions are only reported through an explicit wait()
+    }
+}
+
+void TaskGroup::run(TaskPool::Task task) {
+    if (!pool_) {
+        try {
+            task();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_) error_ = std::current_exception();
+        }
+        return;
+    }
+
+    pending_.fetch_add(1);
+    pool_->submit([this, task = std::move(task)] {
+        std::exception_ptr error;
+        try {
+            task();
+        } catch (...) {
+            error = std::current_exception();
+        }
+        finish(error);
+    });
+}
+
+void TaskGroup::finish(std::exception_ptr error) {
+    // Decrement and notify under the lock: once wait() sees zero and takes
+    // the lock, this task no longer touches the group
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error && !error_) {
+        error_ = error;
+    }
+    if (pending_.fetch_sub(1) == 1) {
+        done_.notify_all();
+    }
+}
+
+void TaskGroup::wait() {
+    while (pending_.load() > 0) {
+        // Help instead of blocking: this may well be our own task
+        if (pool_ && pool_->run_one()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Short timeout: a running task may queue more work to help with
+        done_.wait_for(lock, std::chrono::milliseconds(1), [this] { return pending_.load() == 0; });
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+// =============================================================================
+// NODE-WIDE POOL
+// =============================================================================
+
+static std::shared_ptr<TaskPool> installed;
+static std::mutex installed_mutex;
+
+void install_task_pool(std::shared_ptr<TaskPool> pool) {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    installed = std::move(pool);
+}
+
+std::shared_ptr<TaskPool> installed_task_pool() {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    return installed;
+}
+
+} // namespace Kithly
@@ -0,0 +1,220 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * routing/geo.cpp - Shared Distance Kernels (SoA, SIMD)
+ * =============================================================================
+ */
+
+#include "geo.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// AVX2 is compiled in directly under -mavx2 (or -march=native); any
+// other x86-64 GCC/Clang build carries it as a target("avx2,fma") kernel
+// chosen at runtime, so a portable binary still gets it on hosts that
+// have it
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define KITHLY_GEO_AVX2 1
+#define KITHLY_GEO_AVX2_TARGET
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define KITHLY_GEO_AVX2 1
+#define KITHLY_GEO_AVX2_DISPATCH 1
+#define KITHLY_GEO_AVX2_TARGET __attribute__((target("avx2,fma")))
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace Kithly {
+namespace geo {
+
+namespace {
+
+constexpr double DEG_TO_RAD = 3.14159265358979323846 / 180.0;
+
+#if defined(KITHLY_GEO_AVX2)
+
+bool avx2_available() {
+#if defined(KITHLY_GEO_AVX2_DISPATCH)
+    static const bool available = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return available;
+#else
+    return true;
+#endif
+}
+
+/**
+ * chord² for the leading multiple-of-4 points
+ *
+ * @return how many were written
+ */
+KITHLY_GEO_AVX2_TARGET
+std::size_t chord2_avx2(const UnitVector& origin, const double* xs, const double* ys,
+                        const double* zs, std::size_t n, double* out) {
+    const __m256d ox = _mm256_set1_pd(origin.x);
+    const __m256d oy = _mm256_set1_pd(origin.y);
+    const __m256d oz = _mm256_set1_pd(origin.z);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(xs + i), ox);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(ys + i), oy);
+        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(zs + i), oz);
+#if defined(__FMA__) || defined(KITHLY_GEO_AVX2_DISPATCH)
+        __m256d c2 = _mm256_fmadd_pd(dx, dx, _mm256_fmadd_pd(dy, dy, _mm256_mul_pd(dz, dz)));
+#else
+        __m256d c2 = _mm256_add_pd(_mm256_mul_pd(dx, dx),
+                                   _mm256_add_pd(_mm256_mul_pd(dy, dy), _mm256_mul_pd(dz, dz)));
+#endif
+        _mm256_storeu_pd(out + i, c2);
+    }
+    return i;
+}
+
+#endif
+
+} // namespace
+
+UnitVector to_unit(double lat_deg, double lon_deg) {
+    double lat = lat_deg * DEG_TO_RAD;
+    double lon = lon_deg * DEG_TO_RAD;
+    double cos_lat = std::cos(lat);
+    return { cos_lat * std::cos(lon), cos_lat * std::sin(lon), std::sin(lat) };
+}
+
+double chord2_to_km(double chord2) {
+    double half = std::sqrt(chord2) / 2.0;
+    return 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, half));
+}
+
+double km_to_chord2(double km) {
+    double angle = km / (2.0 * EARTH_RADIUS_KM);
+    if (angle >= 3.14159265358979323846 / 2.0) {
+        return 4.0;  // Antipodal: every point qualifies
+    }
+    double chord = 2.0 * std::sin(angle);
+    return chord * chord;
+}
+
+double distance_km(double lat1, double lon1, double lat2, double lon2) {
+    return chord2_to_km(chord2(to_unit(lat1, lon1), to_unit(lat2, lon2)));
+}
+
+// =============================================================================
+// POINT SET
+// =============================================================================
+
+void PointSet::reserve(std::size_t n) {
+    x_.reserve(n);
+    y_.reserve(n);
+    z_.reserve(n);
+}
+
+void PointSet::clear() {
+    x_.clear();
+    y_.clear();
+    z_.clear();
+}
+
+std::size_t PointSet::add(double lat_deg, double lon_deg) {
+    UnitVector u = to_unit(lat_deg, lon_deg);
+    x_.push_back(u.x);
+    y_.push_back(u.y);
+    z_.push_back(u.z);
+    return x_.size() - 1;
+}
+
+void PointSet::set(std::size_t i, const UnitVector& u) {
+    if (i >= x_.size()) {
+        x_.resize(i + 1);
+        y_.resize(i + 1);
+        z_.resize(i + 1);
+    }
+    x_[i] = u.x;
+    y_[i] = u.y;
+    z_[i] = u.z;
+}
+
+void PointSet::chord2_batch(const UnitVector& origin, double* out) const {
+    const std::size_t n = x_.size();
+    const double* xs = x_.data();
+    const double* ys = y_.data();
+    const double* zs = z_.data();
+    std::size_t i = 0;
+
+#if defined(KITHLY_GEO_AVX2)
+    if (avx2_available()) {
+        i = chord2_avx2(origin, xs, ys, zs, n, out);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    const float64x2_t ox = vdupq_n_f64(origin.x);
+    const float64x2_t oy = vdupq_n_f64(origin.y);
+    const float64x2_t oz = vdupq_n_f64(origin.z);
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t dx = vsubq_f64(vld1q_f64(xs + i), ox);
+        float64x2_t dy = vsubq_f64(vld1q_f64(ys + i), oy);
+        float64x2_t dz = vsubq_f64(vld1q_f64(zs + i), oz);
+        float64x2_t c2 = vmulq_f64(dz, dz);
+        c2 = vfmaq_f64(c2, dy, dy);
+        c2 = vfmaq_f64(c2, dx, dx);
+        vst1q_f64(out + i, c2);
+    }
+#endif
+
+    for (; i < n; ++i) {
+        out[i] = chord2(origin, {xs[i], ys[i], zs[i]});
+    }
+}
+
+void PointSet::distances_km(const UnitVector& origin, double* out) const {
+    chord2_batch(origin, out);
+    for (std::size_t i = 0; i < x_.size(); ++i) {
+        out[i] = chord2_to_km(out[i]);
+    }
+}
+
+std::vector<std::size_t> PointSet::within(const UnitVector& origin, double radius_km) const {
+    std::vector<double> c2(x_.size());
+    chord2_batch(origin, c2.data());
+
+    const double limit = km_to_chord2(radius_km);
+    std::vector<std::size_t> hits;
+    for (std::size_t i = 0; i < c2.size(); ++i) {
+        if (c2[i] <= limit) {
+            hits.push_back(i);
+        }
+    }
+    return hits;
+}
+
+std::size_t PointSet::nearest(const UnitVector& origin, const std::vector<bool>* skip) const {
+    std::vector<double> c2(x_.size());
+    chord2_batch(origin, c2.data());
+
+    std::size_t best = x_.size();
+    double best_c2 = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < c2.size(); ++i) {
+        if (skip && (*skip)[i]) {
+            continue;
+        }
+        if (c2[i] < best_c2) {
+            best_c2 = c2[i];
+            best = i;
+        }
+    }
+    return best;
+}
+
+const char* simd_backend() {
+#if defined(KITHLY_GEO_AVX2)
+    return avx2_available() ? "avx2" : "scalar";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace geo
+} // namespace Kithly
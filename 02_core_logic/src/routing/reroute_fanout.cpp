@@ -0,0 +1,231 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * reroute_fanout.cpp - Parallel Reroute Offers, First Accept Wins
+ * =============================================================================
+ */
+
+#include "reroute_fanout.h"
+#include "gateway_events.h"
+#include "operating_hours.h"
+#include "shop_index.h"
+#include "status_table.h"
+#include "task_pool.h"
+#include "metrics.h"
+#include "log.h"
+
+#include <nlohmann/json.hpp>
+#include <sw/redis++/redis++.h>
+#include <algorithm>
+
+namespace Kithly {
+
+std::vector<RerouteOffer> fan_out_reroute(const std::string& tx_id,
+                                          const RerouteFanoutOptions& options) {
+    std::vector<RerouteOffer> offers;
+
+    // Every scheduler node may fire the same deadline; one fans out
+    if (!lease_reroute_fanout(tx_id, options.offer_ttl, options.max_rounds)) {
+        KITHLY_LOG_DEBUG("ROUTING", "Fan-out not leased - skipped").field("tx_id", tx_id);
+        return offers;
+    }
+
+    auto origin_shop = find_reroute_origin(tx_id);
+    if (!origin_shop || origin_shop->empty()) {
+        KITHLY_LOG_WARN("ROUTING", "No reroute origin").field("tx_id", tx_id);
+        return offers;
+    }
+
+    auto index = installed_shop_index();
+    auto origin = index ? index->find(*origin_shop) : std::nullopt;
+    if (!origin) {
+        KITHLY_LOG_WARN("ROUTING", "Shop not in the index - no fan-out")
+            .field("tx_id", tx_id).field("shop_id", *origin_shop);
+        return offers;
+    }
+
+    // Alternatives within radius_km of the shop that declined, in its
+    // category, open now
+    static auto& search_latency = metrics::histogram("kithly_reroute_search_seconds", "source=\"fanout\"");
+    const auto search_start = metrics::Clock::now();
+    auto hits = index->within(origin->latitude, origin->longitude, options.radius_km,
+                              origin->shop_id, origin->category, current_week_slot());
+    search_latency.record_since(search_start);
+    if (hits.empty()) {
+        KITHLY_LOG_WARN("ROUTING", "No alternative shops found")
+            .field("tx_id", tx_id).field("radius_km", options.radius_km);
+        return offers;
+    }
+
+    // Ranked like the engine's reroute: performance_score, then distance
+    // (within() returns closest first, so stable_sort keeps that order
+    // among equal scores)
+    std::stable_sort(hits.begin(), hits.end(), [](const ShopHit& a, const ShopHit& b) {
+        return a.performance_score > b.performance_score;
+    });
+    if (hits.size() > options.candidates) {
+        hits.resize(options.candidates);
+    }
+
+    offers.reserve(hits.size());
+    for (const auto& hit : hits) {
+        offers.push_back({hit.shop_id, hit.name, hit.distance_km, false});
+    }
+
+    // Each offer is independent: its own connection, its own commit.
+    // On a pool thread (the usual case, see fire_deadlines) fan out on
+    // that pool without taking a reference to it.
+    std::shared_ptr<TaskPool> installed;
+    TaskPool* pool = TaskPool::current();
+    if (!pool) {
+        installed = installed_task_pool();
+        pool = installed.get();
+    }
+    TaskGroup group(pool);
+    for (auto& offer : offers) {
+        group.run([&tx_id, &offer, &options] {
+            offer.offered = offer_reroute(tx_id, offer.shop_id, offer.distance_km, options.offer_ttl);
+            if (offer.offered) {
+                publish_gateway_event(GatewayEventType::REROUTE_OFFER, tx_id, DECLINED, offer.shop_id);
+            }
+        });
+    }
+    group.wait();
+
+    std::size_t offered = 0;
+    for (const auto& offer : offers) {
+        offered += offer.offered ? 1 : 0;
+    }
+    KITHLY_LOG_INFO("ROUTING", "Reroute fan-out")
+        .field("tx_id", tx_id).field("offered", offered).field("candidates", offers.size());
+    return offers;
+}
+
+RerouteClaim accept_reroute_offer(const std::string& tx_id, const std::string& shop_id) {
+    std::vector<std::string> released;
+    const RerouteClaim claim = claim_reroute(tx_id, shop_id, released);
+    if (claim == RerouteClaim::LOST) {
+        KITHLY_LOG_INFO("ROUTING", "Reroute offer no longer open")
+            .field("tx_id", tx_id).field("shop_id", shop_id);
+    }
+    if (claim != RerouteClaim::WON) {
+        return claim;
+    }
+
+    KITHLY_LOG_INFO("STATUS", "ALT_FOUND").field("tx_id", tx_id).field("to", ALT_FOUND).field("shop_id", shop_id);
+    for (const auto& sibling : released) {
+        publish_gateway_event(GatewayEventType::REROUTE_OFFER_WITHDRAWN, tx_id, ALT_FOUND, sibling);
+    }
+    return RerouteClaim::WON;
+}
+
+std::size_t sweep_reroute_offers(const RerouteFanoutOptions& options, int limit) {
+    std::size_t swept = 0;
+
+    if (auto released = release_lapsed_reroute_offers(limit)) {
+        for (const auto& [tx_id, shop_id] : *released) {
+            publish_gateway_event(GatewayEventType::REROUTE_OFFER_WITHDRAWN, tx_id, DECLINED, shop_id);
+        }
+        swept += released->size();
+        if (!released->empty()) {
+            KITHLY_LOG_INFO("ROUTING", "Lapsed reroute offers released").field("offers", released->size());
+        }
+    }
+
+    // The lease keeps a new round from racing a live fan-out on another
+    // node; the refund is a compare-and-set on 910
+    std::vector<StatusTransition> exhausted;
+    for (const auto& [tx_id, rounds] : find_idle_reroutes(limit)) {
+        if (rounds < options.max_rounds) {
+            fan_out_reroute(tx_id, options);
+            ++swept;
+        } else {
+            exhausted.push_back({tx_id, DECLINED, status::checked<DECLINED, EXPIRED>});
+        }
+    }
+    if (!exhausted.empty()) {
+        auto refunded = transition_with_event(GatewayEventType::REFUND, exhausted);
+        for (std::size_t i = 0; i < exhausted.size(); ++i) {
+            if (refunded[i].applied) {
+                KITHLY_LOG_INFO("STRIPE REFUND", "No alternative shop accepted - initiating refund")
+                    .field("tx_id", exhausted[i].tx_id).field("rounds", options.max_rounds)
+                    .field("payment_ref", refunded[i].payment_ref);
+                ++swept;
+            }
+        }
+    }
+    return swept;
+}
+
+// =============================================================================
+// ACCEPT QUEUE + SWEEP
+// =============================================================================
+
+RerouteOfferWorker::RerouteOfferWorker(std::string redis_uri, Options options)
+    : redis_uri_(std::move(redis_uri)), options_(std::move(options)) {}
+
+RerouteOfferWorker::~RerouteOfferWorker() {
+    stop();
+}
+
+void RerouteOfferWorker::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&RerouteOfferWorker::run, this);
+}
+
+void RerouteOfferWorker::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void RerouteOfferWorker::run() {
+    std::optional<sw::redis::Redis> redis;
+    auto next_sweep = std::chrono::steady_clock::now();
+
+    while (running_.load()) {
+        if (std::chrono::steady_clock::now() >= next_sweep) {
+            sweep_reroute_offers(options_.fanout);
+            next_sweep = std::chrono::steady_clock::now() + options_.sweep_interval;
+        }
+
+        try {
+            if (!redis) {
+                redis.emplace(redis_uri_);
+            }
+            auto popped = redis->brpop(REROUTE_ACCEPT_QUEUE, options_.pop_timeout);
+            if (!popped) {
+                continue;
+            }
+
+            auto command = nlohmann::json::parse(popped->second, nullptr, false);
+            if (command.is_discarded() || !command.contains("tx_id") || !command.contains("shop_id") ||
+                !command["tx_id"].is_string() || !command["shop_id"].is_string()) {
+                KITHLY_LOG_ERROR("ROUTING", "Malformed reroute accept dropped").field("payload", popped->second);
+                continue;
+            }
+            const std::string tx_id = command["tx_id"];
+            const std::string shop_id = command["shop_id"];
+
+            if (accept_reroute_offer(tx_id, shop_id) == RerouteClaim::FAILED) {
+                // Database unavailable: hand the accept back for the next pop
+                redis->rpush(REROUTE_ACCEPT_QUEUE, popped->second);
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                continue;
+            }
+        } catch (const sw::redis::TimeoutError&) {
+            continue;
+        } catch (const sw::redis::Error& e) {
+            KITHLY_LOG_ERROR("ROUTING", "Redis exception - reconnecting in 3 seconds").field("error", e.what());
+            redis.reset();
+            std::this_thread::sleep_for(std::chrono::seconds(3));
+        }
+    }
+}
+
+} // namespace Kithly
@@ -0,0 +1,290 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * routing/route_optimizer.cpp - 2-opt / Or-opt Pickup Route Optimisation
+ * =============================================================================
+ */
+
+#include "route_optimizer.h"
+#include "geo.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace Kithly {
+
+namespace {
+
+// Moves must beat this to count, so float noise cannot cycle
+constexpr double EPSILON_KM = 1e-9;
+
+using SteadyClock = std::chrono::steady_clock;
+
+/**
+ * Dense (n+1)² matrix; node 0 is the rider, node i the (i-1)th stop
+ */
+class DistanceMatrix {
+public:
+    DistanceMatrix(double rider_lat, double rider_lon, const std::vector<RouteStop>& stops)
+        : n_(stops.size() + 1), d_(n_ * n_) {
+        geo::PointSet points;
+        points.reserve(n_);
+        points.add(rider_lat, rider_lon);
+        for (const auto& stop : stops) {
+            points.add(stop.latitude, stop.longitude);
+        }
+        for (std::size_t i = 0; i < n_; ++i) {
+            points.distances_km(points.at(i), &d_[i * n_]);
+        }
+    }
+
+    double operator()(std::size_t a, std::size_t b) const { return d_[a * n_ + b]; }
+
+private:
+    std::size_t n_;
+    std::vector<double> d_;
+};
+
+} // namespace
+
+RouteOptimizer::RouteOptimizer() : RouteOptimizer(Options{}) {}
+
+RouteOptimizer::RouteOptimizer(Options options) : options_(options) {}
+
+std::size_t RouteOptimizer::cache_size() const {
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return cache_.size();
+}
+
+std::string RouteOptimizer::cache_key(double rider_lat, double rider_lon,
+                                      const std::vector<RouteStop>& stops) const {
+    // Rider rounded to 0.001° (~100 m): a re-request from slightly further
+    // along the street reuses the plan. Stops are exact and ordered, since
+    // the plan refers to them by index.
+    std::string key;
+    key.reserve(32 + stops.size() * 48);
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "%.3f,%.3f", rider_lat, rider_lon);
+    key += buf;
+    for (const auto& stop : stops) {
+        std::snprintf(buf, sizeof(buf), "|%.6f,%.6f,%g,%g", stop.latitude, stop.longitude,
+                      stop.opens_min.value_or(-1.0), stop.closes_min.value_or(-1.0));
+        key += buf;
+    }
+    return key;
+}
+
+RoutePlan RouteOptimizer::optimize(double rider_lat, double rider_lon,
+                                   const std::vector<RouteStop>& stops) {
+    if (stops.empty()) {
+        return {};
+    }
+
+    const std::string key = cache_key(rider_lat, rider_lon, stops);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = cache_.find(key);
+        if (it != cache_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            RoutePlan plan = it->second->second;
+            plan.from_cache = true;
+            return plan;
+        }
+    }
+
+    // Solve outside the lock; a concurrent duplicate solve is harmless
+    RoutePlan plan = solve(rider_lat, rider_lon, stops);
+
+    if (options_.cache_capacity > 0) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        if (cache_.find(key) == cache_.end()) {
+            lru_.emplace_front(key, plan);
+            cache_[key] = lru_.begin();
+            if (cache_.size() > options_.cache_capacity) {
+                cache_.erase(lru_.back().first);
+                lru_.pop_back();
+            }
+        }
+    }
+    return plan;
+}
+
+RoutePlan RouteOptimizer::solve(double rider_lat, double rider_lon,
+                                const std::vector<RouteStop>& stops) const {
+    const auto deadline = SteadyClock::now() + options_.time_budget;
+    const DistanceMatrix d(rider_lat, rider_lon, stops);
+    const std::size_t m = stops.size();
+
+    const bool has_windows = std::any_of(stops.begin(), stops.end(), [](const RouteStop& s) {
+        return s.opens_min || s.closes_min;
+    });
+
+    // Path of node ids (1..m); the rider (node 0) is the fixed start
+    std::vector<std::size_t> path;
+    path.reserve(m);
+    {
+        std::vector<bool> visited(m + 1, false);
+        std::size_t current = 0;
+        for (std::size_t step = 0; step < m; ++step) {
+            std::size_t best = 0;
+            double best_d = std::numeric_limits<double>::infinity();
+            for (std::size_t node = 1; node <= m; ++node) {
+                if (!visited[node] && d(current, node) < best_d) {
+                    best_d = d(current, node);
+                    best = node;
+                }
+            }
+            visited[best] = true;
+            path.push_back(best);
+            current = best;
+        }
+    }
+
+    // Full evaluation: distance plus lateness (only needed with windows)
+    auto evaluate = [&](const std::vector<std::size_t>& p, double* late_out) {
+        double km = 0.0;
+        double minutes = 0.0;
+        double late = 0.0;
+        std::size_t prev = 0;
+        for (std::size_t node : p) {
+            km += d(prev, node);
+            minutes += d(prev, node) / options_.speed_kmh * 60.0;
+            const RouteStop& stop = stops[node - 1];
+            if (stop.opens_min && minutes < *stop.opens_min) {
+                minutes = *stop.opens_min;  // Wait for the shop to open
+            }
+            if (stop.closes_min && minutes > *stop.closes_min) {
+                late += minutes - *stop.closes_min;
+            }
+            minutes += options_.service_minutes;
+            prev = node;
+        }
+        if (late_out) {
+            *late_out = late;
+        }
+        return km + late * options_.late_penalty_km;
+    };
+
+    double cost = evaluate(path, nullptr);
+    std::vector<std::size_t> candidate;
+    auto out_of_time = [&] { return SteadyClock::now() >= deadline; };
+
+    // Node before position i in the path (the rider for i == 0)
+    auto before = [&](std::size_t i) { return i == 0 ? std::size_t{0} : path[i - 1]; };
+
+    bool improved = true;
+    while (improved && !out_of_time()) {
+        improved = false;
+
+        // --- 2-opt: reverse path[i..j] ---
+        for (std::size_t i = 0; i + 1 < m && !out_of_time(); ++i) {
+            for (std::size_t j = i + 1; j < m; ++j) {
+                if (has_windows) {
+                    candidate = path;
+                    std::reverse(candidate.begin() + i, candidate.begin() + j + 1);
+                    double c = evaluate(candidate, nullptr);
+                    if (c < cost - EPSILON_KM) {
+                        path.swap(candidate);
+                        cost = c;
+                        improved = true;
+                    }
+                    continue;
+                }
+
+                // Symmetric metric: only the two boundary edges change
+                std::size_t a = before(i);
+                double delta = d(a, path[j]) - d(a, path[i]);
+                if (j + 1 < m) {
+                    delta += d(path[i], path[j + 1]) - d(path[j], path[j + 1]);
+                }
+                if (delta < -EPSILON_KM) {
+                    std::reverse(path.begin() + i, path.begin() + j + 1);
+                    cost += delta;
+                    improved = true;
+                }
+            }
+        }
+
+        // --- Or-opt: relocate a segment of 1-3 stops ---
+        for (std::size_t len = 1; len <= 3 && len < m && !out_of_time(); ++len) {
+            for (std::size_t i = 0; i + len <= m; ++i) {
+                const std::size_t first = path[i];
+                const std::size_t last = path[i + len - 1];
+                const std::size_t prev = before(i);
+                const bool has_next = i + len < m;
+
+                double removal_gain = d(prev, first);
+                if (has_next) {
+                    removal_gain += d(last, path[i + len]) - d(prev, path[i + len]);
+                }
+
+                // Path with the segment removed, indexed without copying
+                const std::size_t rest = m - len;
+                auto rest_at = [&](std::size_t q) { return q < i ? path[q] : path[q + len]; };
+
+                std::size_t best_q = rest + 1;
+                double best_delta = -EPSILON_KM;
+                double best_cost = cost - EPSILON_KM;
+
+                for (std::size_t q = 0; q <= rest; ++q) {
+                    if (q == i) {
+                        continue;  // Original position
+                    }
+
+                    if (has_windows) {
+                        candidate.clear();
+                        for (std::size_t r = 0; r < q; ++r) candidate.push_back(rest_at(r));
+                        for (std::size_t r = i; r < i + len; ++r) candidate.push_back(path[r]);
+                        for (std::size_t r = q; r < rest; ++r) candidate.push_back(rest_at(r));
+                        double c = evaluate(candidate, nullptr);
+                        if (c < best_cost) {
+                            best_cost = c;
+                            best_q = q;
+                        }
+                        continue;
+                    }
+
+                    std::size_t u = q == 0 ? std::size_t{0} : rest_at(q - 1);
+                    double insertion = d(u, first);
+                    if (q < rest) {
+                        insertion += d(last, rest_at(q)) - d(u, rest_at(q));
+                    }
+                    double delta = insertion - removal_gain;
+                    if (delta < best_delta) {
+                        best_delta = delta;
+                        best_q = q;
+                    }
+                }
+
+                if (best_q > rest) {
+                    continue;
+                }
+
+                std::vector<std::size_t> moved;
+                moved.reserve(m);
+                for (std::size_t r = 0; r < best_q; ++r) moved.push_back(rest_at(r));
+                for (std::size_t r = i; r < i + len; ++r) moved.push_back(path[r]);
+                for (std::size_t r = best_q; r < rest; ++r) moved.push_back(rest_at(r));
+                path.swap(moved);
+                cost = has_windows ? best_cost : cost + best_delta;
+                improved = true;
+            }
+        }
+    }
+
+    RoutePlan plan;
+    plan.order.reserve(m);
+    for (std::size_t node : path) {
+        plan.order.push_back(node - 1);
+    }
+    evaluate(path, &plan.late_minutes);
+    std::size_t prev = 0;
+    for (std::size_t node : path) {
+        plan.distance_km += d(prev, node);
+        prev = node;
+    }
+    return plan;
+}
+
+} // namespace Kithly
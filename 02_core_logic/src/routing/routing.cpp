@@ -1,57 +1,45 @@
 /**
  * =============================================================================
  * KithLy Global Protocol - THE REROUTER
- * routing.cpp - Haversine Formula for nearest shop lookup
+ * routing.cpp - Nearest shop lookup
  * =============================================================================
  */
 
+#include "routing.h"
+#include "geo.h"
+#include "shop_index.h"
 #include "structs.h"
 #include "db_connector.h"
-#include <cmath>
+#include "metrics.h"
+#include "log.h"
 #include <vector>
-#include <algorithm>
 #include <libpq-fe.h>
-#include <iostream>
 
 namespace Kithly {
 
-// Earth radius in kilometers
-constexpr double EARTH_RADIUS_KM = 6371.0;
-constexpr double PI = 3.14159265358979323846;
-
 /**
- * Convert degrees to radians
- */
-inline double to_radians(double degrees) {
-    return degrees * PI / 180.0;
-}
-
-/**
- * Haversine Formula - Calculate distance between two points on Earth
- * Returns distance in kilometers
+ * Great-circle distance in kilometers (shared chord kernel, see geo.h)
  */
 double haversine_distance(double lat1, double lon1, double lat2, double lon2) {
-    double dlat = to_radians(lat2 - lat1);
-    double dlon = to_radians(lon2 - lon1);
-    
-    double a = std::sin(dlat / 2) * std::sin(dlat / 2) +
-               std::cos(to_radians(lat1)) * std::cos(to_radians(lat2)) *
-               std::sin(dlon / 2) * std::sin(dlon / 2);
-    
-    double c = 2 * std::atan2(std::sqrt(a), std::sqrt(1 - a));
-    
-    return EARTH_RADIUS_KM * c;
+    return geo::distance_km(lat1, lon1, lat2, lon2);
 }
 
 /**
- * Shop with distance for sorting
+ * Shop candidate (coordinates live in a parallel geo::PointSet)
  */
-struct ShopDistance {
+struct ShopCandidate {
     std::string shop_id;
     std::string name;
-    double distance_km;
 };
 
+// Nearest-shop search latency by source (index ring walk, Shops scan)
+static metrics::LatencyHistogram& search_latency(bool from_index) {
+    static auto& index = metrics::histogram("kithly_reroute_search_seconds", "source=\"index\"",
+                                            "Alternative shop search latency by source");
+    static auto& db = metrics::histogram("kithly_reroute_search_seconds", "source=\"db\"");
+    return from_index ? index : db;
+}
+
 /**
  * Find the nearest alternative shop excluding the failed shop
  * Uses Haversine formula for accurate geospatial distance
@@ -62,11 +50,30 @@ std::string find_nearest_shop(
     double origin_lon,
     PGconn* conn
 ) {
-    // Query all active shops except the failed one
+    // Resident index: a ring walk over a few grid cells, skipping shops
+    // that are closed right now
+    if (auto index = installed_shop_index(); index && index->size() > 0) {
+        const auto start = metrics::Clock::now();
+        auto hits = index->nearest(origin_lat, origin_lon, 1, failed_shop_id, "", current_week_slot());
+        search_latency(true).record_since(start);
+        if (hits.empty()) {
+            KITHLY_LOG_WARN("ROUTING", "No alternative shops found").field("failed_shop_id", failed_shop_id);
+            return "";
+        }
+        
+        KITHLY_LOG_INFO("ROUTING", "Rerouting")
+            .field("shop_id", hits[0].shop_id).field("name", hits[0].name).field("distance_km", hits[0].distance_km);
+        return hits[0].shop_id;
+    }
+    
+    // Fallback: query all active shops except the failed one
+    metrics::ScopedTimer timer(search_latency(false));
     const char* query = R"(
         SELECT shop_id, name, latitude, longitude 
         FROM Shops 
         WHERE shop_id != $1 AND is_active = true
+          AND latitude IS NOT NULL AND longitude IS NOT NULL
+          AND shop_open_for_reroute(shop_id)
     )";
     
     const char* params[1] = { failed_shop_id.c_str() };
@@ -74,42 +81,38 @@ std::string find_nearest_shop(
     PGresult* res = PQexecParams(conn, query, 1, nullptr, params, nullptr, nullptr, 0);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "[ROUTING] Query failed: " << PQerrorMessage(conn) << std::endl;
+        KITHLY_LOG_ERROR("ROUTING", "Query failed").field("error", PQerrorMessage(conn));
         PQclear(res);
         return "";
     }
     
-    std::vector<ShopDistance> shops;
+    std::vector<ShopCandidate> shops;
+    geo::PointSet points;
     int rows = PQntuples(res);
+    shops.reserve(rows);
+    points.reserve(rows);
     
     for (int i = 0; i < rows; ++i) {
-        ShopDistance sd;
-        sd.shop_id = PQgetvalue(res, i, 0);
-        sd.name = PQgetvalue(res, i, 1);
-        double lat = std::stod(PQgetvalue(res, i, 2));
-        double lon = std::stod(PQgetvalue(res, i, 3));
-        
-        sd.distance_km = haversine_distance(origin_lat, origin_lon, lat, lon);
-        shops.push_back(sd);
+        shops.push_back({PQgetvalue(res, i, 0), PQgetvalue(res, i, 1)});
+        points.add(std::stod(PQgetvalue(res, i, 2)), std::stod(PQgetvalue(res, i, 3)));
     }
     
     PQclear(res);
     
     if (shops.empty()) {
-        std::cerr << "[ROUTING] No alternative shops found" << std::endl;
+        KITHLY_LOG_WARN("ROUTING", "No alternative shops found").field("failed_shop_id", failed_shop_id);
         return "";
     }
     
-    // Sort by distance and return nearest
-    std::sort(shops.begin(), shops.end(), 
-        [](const ShopDistance& a, const ShopDistance& b) {
-            return a.distance_km < b.distance_km;
-        });
+    // Only the nearest is needed: one batched chord pass, no sort
+    auto origin = geo::to_unit(origin_lat, origin_lon);
+    std::size_t nearest = points.nearest(origin);
+    double distance_km = geo::chord2_to_km(geo::chord2(origin, points.at(nearest)));
     
-    std::cout << "[ROUTING] Rerouting to: " << shops[0].name 
-              << " (" << shops[0].distance_km << " km away)" << std::endl;
+    KITHLY_LOG_INFO("ROUTING", "Rerouting")
+        .field("shop_id", shops[nearest].shop_id).field("name", shops[nearest].name).field("distance_km", distance_km);
     
-    return shops[0].shop_id;
+    return shops[nearest].shop_id;
 }
 
 } // namespace Kithly
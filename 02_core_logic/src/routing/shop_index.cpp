@@ -0,0 +1,532 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * routing/shop_index.cpp - Grid Spatial Index & LISTEN/NOTIFY Refresher
+ * =============================================================================
+ */
+
+#include "shop_index.h"
+#include "geo.h"
+#include "db_connector.h"
+#include <poll.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <unordered_set>
+
+namespace Kithly {
+
+namespace {
+
+// Great-circle kilometers per degree of arc
+constexpr double KM_PER_DEGREE = 6371.0 * 3.14159265358979323846 / 180.0;
+
+constexpr const char* SHOP_CHANNEL = "kithly_shops";
+
+constexpr const char* SHOP_COLUMNS = R"(
+    SELECT shop_id, name, COALESCE(category, ''),
+           latitude::float8, longitude::float8,
+           COALESCE(performance_score, 0)::float8
+    FROM Shops
+    WHERE is_active = true
+      AND latitude IS NOT NULL
+      AND longitude IS NOT NULL
+)";
+
+constexpr const char* HOURS_COLUMNS = R"(
+    SELECT shop_id,
+           day_of_week,
+           (EXTRACT(EPOCH FROM open_time) / 60)::int,
+           (EXTRACT(EPOCH FROM close_time) / 60)::int
+    FROM Operating_Hours
+)";
+
+/**
+ * Fold Operating_Hours rows into per-shop bitmaps
+ */
+void add_hours(PGresult* res, std::unordered_map<std::string, WeeklyHours>& out) {
+    int rows = PQntuples(res);
+    for (int i = 0; i < rows; ++i) {
+        out[PQgetvalue(res, i, 0)].add(std::atoi(PQgetvalue(res, i, 1)),
+                                       std::atoi(PQgetvalue(res, i, 2)),
+                                       std::atoi(PQgetvalue(res, i, 3)));
+    }
+}
+
+IndexedShop shop_from_row(PGresult* res, int row) {
+    IndexedShop shop;
+    shop.shop_id = PQgetvalue(res, row, 0);
+    shop.name = PQgetvalue(res, row, 1);
+    shop.category = PQgetvalue(res, row, 2);
+    shop.latitude = std::atof(PQgetvalue(res, row, 3));
+    shop.longitude = std::atof(PQgetvalue(res, row, 4));
+    shop.performance_score = std::atof(PQgetvalue(res, row, 5));
+    return shop;
+}
+
+std::mutex installed_mutex;
+std::shared_ptr<ShopIndex> installed;
+
+} // namespace
+
+// =============================================================================
+// INDEX
+// =============================================================================
+
+ShopIndex::ShopIndex(double cell_degrees) : cell_degrees_(cell_degrees) {}
+
+int32_t ShopIndex::row_of(double lat) const {
+    return static_cast<int32_t>(std::floor(lat / cell_degrees_));
+}
+
+int32_t ShopIndex::col_of(double lon) const {
+    return static_cast<int32_t>(std::floor(lon / cell_degrees_));
+}
+
+uint64_t ShopIndex::cell_key(int32_t row, int32_t col) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(row)) << 32) | static_cast<uint32_t>(col);
+}
+
+int ShopIndex::load_all() {
+    std::vector<IndexedShop> loaded;
+    {
+        auto lease = acquire_db_connection();
+        if (!lease) {
+            std::cerr << "[SHOP INDEX] No database connection - load skipped" << std::endl;
+            return -1;
+        }
+
+        PGresult* res = PQexec(lease.get(), SHOP_COLUMNS);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            std::cerr << "[SHOP INDEX] Load failed: " << PQerrorMessage(lease.get()) << std::endl;
+            PQclear(res);
+            return -1;
+        }
+
+        int rows = PQntuples(res);
+        loaded.reserve(rows);
+        for (int i = 0; i < rows; ++i) {
+            loaded.push_back(shop_from_row(res, i));
+        }
+        PQclear(res);
+
+        res = PQexec(lease.get(), HOURS_COLUMNS);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            std::cerr << "[SHOP INDEX] Operating hours load failed: " << PQerrorMessage(lease.get()) << std::endl;
+            PQclear(res);
+            return -1;
+        }
+        std::unordered_map<std::string, WeeklyHours> hours;
+        add_hours(res, hours);
+        PQclear(res);
+
+        for (auto& shop : loaded) {
+            auto it = hours.find(shop.shop_id);
+            if (it != hours.end()) {
+                shop.hours = it->second;
+            }
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    shops_.clear();
+    points_.clear();
+    free_slots_.clear();
+    slot_by_id_.clear();
+    partitions_.clear();
+    shops_.reserve(loaded.size());
+    points_.reserve(loaded.size());
+    for (const auto& shop : loaded) {
+        insert_locked(shop);
+    }
+
+    std::cout << "[SHOP INDEX] Loaded " << loaded.size() << " active shops" << std::endl;
+    return static_cast<int>(loaded.size());
+}
+
+bool ShopIndex::refresh_shop(const std::string& shop_id) {
+    auto lease = acquire_db_connection();
+    if (!lease) {
+        return false;
+    }
+
+    const std::string query = std::string(SHOP_COLUMNS) + " AND shop_id = $1::uuid";
+    const char* params[1] = { shop_id.c_str() };
+
+    PGresult* res = PQexecParams(lease.get(), query.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        std::cerr << "[SHOP INDEX] Refresh of " << shop_id << " failed: "
+                  << PQerrorMessage(lease.get()) << std::endl;
+        PQclear(res);
+        return false;
+    }
+
+    if (PQntuples(res) == 0) {
+        PQclear(res);
+        remove(shop_id);  // Deleted, deactivated or lost its coordinates
+        return true;
+    }
+    IndexedShop shop = shop_from_row(res, 0);
+    PQclear(res);
+
+    const std::string hours_query = std::string(HOURS_COLUMNS) + " WHERE shop_id = $1::uuid";
+    res = PQexecParams(lease.get(), hours_query.c_str(), 1, nullptr, params, nullptr, nullptr, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        std::cerr << "[SHOP INDEX] Hours refresh of " << shop_id << " failed: "
+                  << PQerrorMessage(lease.get()) << std::endl;
+        PQclear(res);
+        return false;
+    }
+    std::unordered_map<std::string, WeeklyHours> hours;
+    add_hours(res, hours);
+    PQclear(res);
+    if (!hours.empty()) {
+        shop.hours = hours.begin()->second;
+    }
+
+    upsert(shop);
+    return true;
+}
+
+void ShopIndex::upsert(const IndexedShop& shop) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    erase_locked(shop.shop_id);
+    insert_locked(shop);
+}
+
+void ShopIndex::remove(const std::string& shop_id) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    erase_locked(shop_id);
+}
+
+std::size_t ShopIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return slot_by_id_.size();
+}
+
+void ShopIndex::insert_locked(const IndexedShop& shop) {
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        shops_[slot] = shop;
+    } else {
+        slot = static_cast<uint32_t>(shops_.size());
+        shops_.push_back(shop);
+    }
+    slot_by_id_[shop.shop_id] = slot;
+    points_.set(slot, geo::to_unit(shop.latitude, shop.longitude));
+
+    int32_t row = row_of(shop.latitude);
+    int32_t col = col_of(shop.longitude);
+
+    auto add = [&](Grid& grid) {
+        grid.cells[cell_key(row, col)].push_back(slot);
+        if (grid.max_row < grid.min_row) {
+            grid.min_row = grid.max_row = row;
+            grid.min_col = grid.max_col = col;
+        } else {
+            grid.min_row = std::min(grid.min_row, row);
+            grid.max_row = std::max(grid.max_row, row);
+            grid.min_col = std::min(grid.min_col, col);
+            grid.max_col = std::max(grid.max_col, col);
+        }
+    };
+
+    add(partitions_[""]);
+    if (!shop.category.empty()) {
+        add(partitions_[shop.category]);
+    }
+}
+
+void ShopIndex::erase_locked(const std::string& shop_id) {
+    auto it = slot_by_id_.find(shop_id);
+    if (it == slot_by_id_.end()) {
+        return;
+    }
+    uint32_t slot = it->second;
+    const IndexedShop& shop = shops_[slot];
+    uint64_t key = cell_key(row_of(shop.latitude), col_of(shop.longitude));
+
+    // Extents only grow; a stale bound just means a few empty rings
+    auto drop = [&](const std::string& partition) {
+        auto grid = partitions_.find(partition);
+        if (grid == partitions_.end()) {
+            return;
+        }
+        auto cell = grid->second.cells.find(key);
+        if (cell == grid->second.cells.end()) {
+            return;
+        }
+        auto& slots = cell->second;
+        auto pos = std::find(slots.begin(), slots.end(), slot);
+        if (pos != slots.end()) {
+            *pos = slots.back();
+            slots.pop_back();
+        }
+        if (slots.empty()) {
+            grid->second.cells.erase(cell);
+        }
+    };
+
+    drop("");
+    if (!shop.category.empty()) {
+        drop(shop.category);
+    }
+
+    shops_[slot] = IndexedShop{};
+    free_slots_.push_back(slot);
+    slot_by_id_.erase(it);
+}
+
+std::vector<ShopHit> ShopIndex::nearest(double lat, double lon, std::size_t k,
+                                        const std::string& exclude_shop_id,
+                                        const std::string& category,
+                                        int open_slot) const {
+    return search(lat, lon, k, std::numeric_limits<double>::infinity(),
+                  exclude_shop_id, category, open_slot);
+}
+
+std::vector<ShopHit> ShopIndex::within(double lat, double lon, double radius_km,
+                                       const std::string& exclude_shop_id,
+                                       const std::string& category,
+                                       int open_slot) const {
+    return search(lat, lon, std::numeric_limits<std::size_t>::max(), radius_km,
+                  exclude_shop_id, category, open_slot);
+}
+
+bool ShopIndex::is_open(const std::string& shop_id, int slot) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = slot_by_id_.find(shop_id);
+    if (it == slot_by_id_.end()) {
+        return true;
+    }
+    const auto& hours = shops_[it->second].hours;
+    return !hours || hours->open_at(slot);
+}
+
+std::optional<IndexedShop> ShopIndex::find(const std::string& shop_id) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = slot_by_id_.find(shop_id);
+    if (it == slot_by_id_.end()) {
+        return std::nullopt;
+    }
+    return shops_[it->second];
+}
+
+/**
+ * Ring walk over grid cells.
+ * After finishing ring r, every unvisited cell is at least r whole cells
+ * from the origin, which bounds how close any remaining shop can be.
+ * No antimeridian wrap: service areas are city-scale.
+ */
+std::vector<ShopHit> ShopIndex::search(double lat, double lon, std::size_t k, double radius_km,
+                                       const std::string& exclude_shop_id,
+                                       const std::string& category,
+                                       int open_slot) const {
+    std::vector<ShopHit> hits;
+    if (k == 0) {
+        return hits;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+
+    auto partition = partitions_.find(category);
+    if (partition == partitions_.end() || partition->second.cells.empty()) {
+        return hits;
+    }
+    const Grid& grid = partition->second;
+
+    const int32_t origin_row = row_of(lat);
+    const int32_t origin_col = col_of(lon);
+    const int32_t max_ring = std::max({
+        std::abs(origin_row - grid.min_row), std::abs(origin_row - grid.max_row),
+        std::abs(origin_col - grid.min_col), std::abs(origin_col - grid.max_col)
+    });
+
+    // Ranked on chord² (monotonic in distance); km only for the results
+    const geo::UnitVector origin = geo::to_unit(lat, lon);
+    const double radius_c2 = std::isinf(radius_km) ? 4.0 : geo::km_to_chord2(radius_km);
+
+    // Max-heap on chord² holding the best k so far
+    using Entry = std::pair<double, uint32_t>;
+    std::priority_queue<Entry> best;
+
+    auto visit = [&](int32_t row, int32_t col) {
+        if (row < grid.min_row || row > grid.max_row || col < grid.min_col || col > grid.max_col) {
+            return;
+        }
+        auto cell = grid.cells.find(cell_key(row, col));
+        if (cell == grid.cells.end()) {
+            return;
+        }
+        for (uint32_t slot : cell->second) {
+            const IndexedShop& shop = shops_[slot];
+            if (shop.shop_id == exclude_shop_id) {
+                continue;
+            }
+            if (shop.hours && !shop.hours->open_at(open_slot)) {
+                continue;  // Closed in the requested slot
+            }
+            double d = geo::chord2(origin, points_.at(slot));
+            if (d > radius_c2) {
+                continue;
+            }
+            if (best.size() < k) {
+                best.emplace(d, slot);
+            } else if (d < best.top().first) {
+                best.pop();
+                best.emplace(d, slot);
+            }
+        }
+    };
+
+    for (int32_t ring = 0; ring <= max_ring; ++ring) {
+        if (ring == 0) {
+            visit(origin_row, origin_col);
+        } else {
+            for (int32_t col = origin_col - ring; col <= origin_col + ring; ++col) {
+                visit(origin_row - ring, col);
+                visit(origin_row + ring, col);
+            }
+            for (int32_t row = origin_row - ring + 1; row <= origin_row + ring - 1; ++row) {
+                visit(row, origin_col - ring);
+                visit(row, origin_col + ring);
+            }
+        }
+
+        // Cells narrow towards the poles: use the highest latitude the
+        // next ring can reach for a conservative column width
+        double reach_lat = std::min(89.9, std::abs(lat) + (ring + 1) * cell_degrees_);
+        double cell_km = cell_degrees_ * KM_PER_DEGREE *
+                         std::cos(reach_lat * 3.14159265358979323846 / 180.0);
+        double next_ring_min_km = ring * cell_km;
+
+        if (next_ring_min_km > radius_km) {
+            break;
+        }
+        if (best.size() == k && best.top().first <= geo::km_to_chord2(next_ring_min_km)) {
+            break;
+        }
+    }
+
+    hits.resize(best.size());
+    for (std::size_t i = hits.size(); i-- > 0; ) {
+        const IndexedShop& shop = shops_[best.top().second];
+        hits[i] = ShopHit{shop.shop_id, shop.name, geo::chord2_to_km(best.top().first),
+                          shop.performance_score};
+        best.pop();
+    }
+    return hits;
+}
+
+void install_shop_index(std::shared_ptr<ShopIndex> index) {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    installed = std::move(index);
+}
+
+std::shared_ptr<ShopIndex> installed_shop_index() {
+    std::lock_guard<std::mutex> lock(installed_mutex);
+    return installed;
+}
+
+// =============================================================================
+// LISTEN/NOTIFY REFRESHER
+// =============================================================================
+
+ShopIndexListener::ShopIndexListener(std::shared_ptr<ShopIndex> index,
+                                     std::shared_ptr<kithly::db::ConnectionPool> pool)
+    : index_(std::move(index)), pool_(std::move(pool)) {}
+
+ShopIndexListener::~ShopIndexListener() {
+    stop();
+}
+
+void ShopIndexListener::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    thread_ = std::thread(&ShopIndexListener::run, this);
+}
+
+void ShopIndexListener::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void ShopIndexListener::run() {
+    using namespace std::chrono_literals;
+
+    while (running_) {
+        PGconn* conn = pool_->open_dedicated();
+        if (conn) {
+            PGresult* res = PQexec(conn, "LISTEN kithly_shops");
+            bool listening = PQresultStatus(res) == PGRES_COMMAND_OK;
+            PQclear(res);
+
+            if (!listening) {
+                std::cerr << "[SHOP INDEX] LISTEN failed: " << PQerrorMessage(conn) << std::endl;
+                PQfinish(conn);
+                conn = nullptr;
+            }
+        }
+
+        if (!conn) {
+            for (int i = 0; i < 50 && running_; ++i) {
+                std::this_thread::sleep_for(100ms);
+            }
+            continue;
+        }
+
+        // Already LISTENing, so nothing committed after this snapshot
+        // can be missed
+        index_->load_all();
+        std::cout << "[SHOP INDEX] Listening on " << SHOP_CHANNEL << std::endl;
+
+        while (running_) {
+            pollfd pfd{PQsocket(conn), POLLIN, 0};
+            int ready = ::poll(&pfd, 1, 1000);  // Bounded so stop() is honoured
+            if (ready <= 0) {
+                continue;  // Timeout or EINTR
+            }
+
+            if (!PQconsumeInput(conn)) {
+                std::cerr << "[SHOP INDEX] Listener connection lost: " << PQerrorMessage(conn) << std::endl;
+                break;
+            }
+
+            // Coalesce a burst of edits to the same shop into one re-read
+            std::unordered_set<std::string> changed;
+            bool full_reload = false;
+            while (PGnotify* notify = PQnotifies(conn)) {
+                if (notify->extra && notify->extra[0] != '\0') {
+                    changed.insert(notify->extra);
+                } else {
+                    full_reload = true;
+                }
+                PQfreemem(notify);
+            }
+
+            if (full_reload) {
+                index_->load_all();
+                continue;
+            }
+            for (const auto& shop_id : changed) {
+                index_->refresh_shop(shop_id);
+            }
+        }
+
+        PQfinish(conn);
+    }
+}
+
+} // namespace Kithly
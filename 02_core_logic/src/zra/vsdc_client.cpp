@@ -0,0 +1,374 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * zra/vsdc_client.cpp - Keep-alive HTTP/1.1 POST to the ZRA VSDC
+ * =============================================================================
+ */
+
+#include "vsdc_client.h"
+#include "metrics.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+namespace Kithly {
+
+namespace {
+
+constexpr std::size_t MAX_HEADER_BYTES = 64 * 1024;
+
+metrics::LatencyHistogram& request_latency() {
+    static metrics::LatencyHistogram& h = metrics::histogram(
+        "kithly_vsdc_request_seconds", "", "ZRA VSDC POST round trip, including connect");
+    return h;
+}
+
+timeval to_timeval(std::chrono::milliseconds ms) {
+    timeval tv{};
+    tv.tv_sec = static_cast<time_t>(ms.count() / 1000);
+    tv.tv_usec = static_cast<suseconds_t>((ms.count() % 1000) * 1000);
+    return tv;
+}
+
+bool send_all(int fd, const std::string& data) {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+/**
+ * Append whatever the socket has (blocking up to SO_RCVTIMEO)
+ */
+bool fill(int fd, std::string& buffer, std::string& error) {
+    char chunk[16384];
+    while (true) {
+        ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n > 0) {
+            buffer.append(chunk, static_cast<std::size_t>(n));
+            return true;
+        }
+        if (n == 0) {
+            error = "connection closed";
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            error = "read timeout";
+        } else {
+            error = std::strerror(errno);
+        }
+        return false;
+    }
+}
+
+std::string lower(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return out;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+    return s;
+}
+
+/**
+ * Decode a chunked body; `raw` grows from the socket as needed
+ */
+bool read_chunked(int fd, std::string& raw, std::string& body, std::size_t limit, std::string& error) {
+    std::size_t pos = 0;
+    while (true) {
+        std::size_t eol;
+        while ((eol = raw.find("\r\n", pos)) == std::string::npos) {
+            if (!fill(fd, raw, error)) return false;
+        }
+        std::string size_line(trim(std::string_view(raw).substr(pos, eol - pos)));
+        char* end = nullptr;
+        const unsigned long size = std::strtoul(size_line.c_str(), &end, 16);
+        if (end == size_line.c_str()) {
+            error = "malformed chunk size";
+            return false;
+        }
+        pos = eol + 2;
+
+        if (size == 0) {
+            // Trailers (normally none) end with an empty line
+            while (true) {
+                while ((eol = raw.find("\r\n", pos)) == std::string::npos) {
+                    if (!fill(fd, raw, error)) return false;
+                }
+                if (eol == pos) return true;
+                pos = eol + 2;
+            }
+        }
+        if (body.size() + size > limit) {
+            error = "response too large";
+            return false;
+        }
+        while (raw.size() < pos + size + 2) {
+            if (!fill(fd, raw, error)) return false;
+        }
+        body.append(raw, pos, size);
+        pos += size + 2;
+    }
+}
+
+/**
+ * Read one response. keep_alive says whether the connection can carry
+ * the next request; nothing_received marks a connection that was dead
+ * before the server said anything.
+ */
+bool read_response(int fd, std::size_t limit, VsdcResponse& out, bool& keep_alive, bool& nothing_received) {
+    std::string raw;
+    std::size_t head_end;
+    while ((head_end = raw.find("\r\n\r\n")) == std::string::npos) {
+        if (raw.size() > MAX_HEADER_BYTES) {
+            out.error = "response headers too large";
+            return false;
+        }
+        if (!fill(fd, raw, out.error)) {
+            nothing_received = raw.empty();
+            return false;
+        }
+    }
+
+    std::string_view head(raw.data(), head_end);
+    std::size_t eol = head.find("\r\n");
+    std::string_view status_line = head.substr(0, eol);
+    if (status_line.rfind("HTTP/1.", 0) != 0 || status_line.size() < 12) {
+        out.error = "malformed status line";
+        return false;
+    }
+    const bool http10 = status_line[7] == '0';
+    out.http_status = std::atoi(std::string(status_line.substr(9, 3)).c_str());
+
+    long long content_length = -1;
+    bool chunked = false;
+    keep_alive = !http10;
+    while (eol != std::string_view::npos) {
+        head.remove_prefix(eol + 2);
+        eol = head.find("\r\n");
+        std::string_view field = head.substr(0, eol);
+        std::size_t colon = field.find(':');
+        if (colon == std::string_view::npos) continue;
+        const std::string name = lower(field.substr(0, colon));
+        const std::string value = lower(trim(field.substr(colon + 1)));
+        if (name == "content-length") {
+            content_length = std::atoll(value.c_str());
+        } else if (name == "transfer-encoding") {
+            chunked = value.find("chunked") != std::string::npos;
+        } else if (name == "connection") {
+            if (value.find("close") != std::string::npos) keep_alive = false;
+            if (value.find("keep-alive") != std::string::npos) keep_alive = true;
+        }
+    }
+
+    std::string rest = raw.substr(head_end + 4);
+    if (chunked) {
+        return read_chunked(fd, rest, out.body, limit, out.error);
+    }
+    if (content_length >= 0) {
+        if (static_cast<std::size_t>(content_length) > limit) {
+            out.error = "response too large";
+            return false;
+        }
+        while (rest.size() < static_cast<std::size_t>(content_length)) {
+            if (!fill(fd, rest, out.error)) return false;
+        }
+        rest.resize(static_cast<std::size_t>(content_length));
+        out.body = std::move(rest);
+        return true;
+    }
+
+    // Delimited by close
+    keep_alive = false;
+    std::string ignored;
+    while (rest.size() <= limit && fill(fd, rest, ignored)) {}
+    if (rest.size() > limit) {
+        out.error = "response too large";
+        return false;
+    }
+    out.body = std::move(rest);
+    return true;
+}
+
+} // namespace
+
+VsdcClient::VsdcClient(Options options) : options_(std::move(options)) {
+    constexpr std::string_view SCHEME = "http://";
+    std::string_view url = options_.base_url;
+    if (url.rfind(SCHEME, 0) != 0) {
+        std::cerr << "[ZRA] Unsupported VSDC URL (http:// only): " << options_.base_url << std::endl;
+        return;
+    }
+    url.remove_prefix(SCHEME.size());
+    const std::size_t slash = url.find('/');
+    std::string_view authority = url.substr(0, slash);
+    std::string_view path = slash == std::string_view::npos ? std::string_view() : url.substr(slash);
+    while (!path.empty() && path.back() == '/') path.remove_suffix(1);
+
+    std::size_t colon = authority.rfind(':');
+    if (!authority.empty() && authority.front() == '[') {
+        // [v6]:port
+        const std::size_t close = authority.find(']');
+        host_ = std::string(authority.substr(1, close == std::string_view::npos ? close : close - 1));
+        colon = (close != std::string_view::npos && close + 1 < authority.size()) ? close + 1 : std::string_view::npos;
+    } else {
+        host_ = std::string(authority.substr(0, colon));
+    }
+    port_ = colon == std::string_view::npos ? "80" : std::string(authority.substr(colon + 1));
+    path_ = std::string(path);
+    valid_ = !host_.empty() && !port_.empty();
+}
+
+VsdcClient::~VsdcClient() {
+    for (int fd : idle_) {
+        close(fd);
+    }
+}
+
+int VsdcClient::connect_new(std::string& error) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    int rc = getaddrinfo(host_.c_str(), port_.c_str(), &hints, &addresses);
+    if (rc != 0) {
+        error = std::string("resolve failed: ") + gai_strerror(rc);
+        return -1;
+    }
+
+    int fd = -1;
+    error = "connect failed";
+    for (addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, a->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        // Non-blocking connect bounded by connect_timeout
+        if (connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            int so_error = errno;
+            if (errno == EINPROGRESS) {
+                pollfd pfd{fd, POLLOUT, 0};
+                so_error = ETIMEDOUT;
+                if (poll(&pfd, 1, static_cast<int>(options_.connect_timeout.count())) == 1) {
+                    socklen_t len = sizeof(so_error);
+                    getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+                }
+            }
+            if (so_error != 0) {
+                error = std::string("connect failed: ") + std::strerror(so_error);
+                close(fd);
+                fd = -1;
+                continue;
+            }
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        return -1;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    const timeval timeout = to_timeval(options_.read_timeout);
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+int VsdcClient::acquire(bool& reused, std::string& error) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            int fd = idle_.back();
+            idle_.pop_back();
+            reused = true;
+            return fd;
+        }
+    }
+    reused = false;
+    return connect_new(error);
+}
+
+void VsdcClient::release(int fd, bool keep_alive) {
+    if (keep_alive) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < options_.max_idle) {
+            idle_.push_back(fd);
+            return;
+        }
+    }
+    close(fd);
+}
+
+VsdcResponse VsdcClient::post(const std::string& endpoint, const std::string& json_body) {
+    VsdcResponse out;
+    if (!valid_) {
+        out.error = "invalid VSDC URL";
+        return out;
+    }
+    metrics::ScopedTimer timer(request_latency());
+
+    std::string request = "POST " + path_ + endpoint + " HTTP/1.1\r\n";
+    request += "Host: " + host_ + ":" + port_ + "\r\n";
+    request += "Content-Type: application/json\r\n";
+    request += "Accept: application/json\r\n";
+    request += "Content-Length: " + std::to_string(json_body.size()) + "\r\n";
+    request += "Connection: keep-alive\r\n\r\n";
+    request += json_body;
+
+    // A pooled connection the VSDC closed while idle fails before any
+    // response byte; that one case is retried on a fresh connection.
+    // (saveSales is keyed by cisInvcNo, so a replay is not a new sale.)
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        out = VsdcResponse{};
+        bool reused = false;
+        int fd = acquire(reused, out.error);
+        if (fd < 0) {
+            return out;
+        }
+
+        bool keep_alive = false;
+        bool nothing_received = false;
+        if (!send_all(fd, request)) {
+            out.error = "send failed";
+            nothing_received = true;
+        } else if (read_response(fd, options_.max_response_bytes, out, keep_alive, nothing_received)) {
+            release(fd, keep_alive);
+            return out;
+        }
+        close(fd);
+        out.http_status = 0;
+        if (!(reused && nothing_received)) {
+            break;
+        }
+    }
+    return out;
+}
+
+} // namespace Kithly
@@ -0,0 +1,418 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * zra/zra_sync.cpp - Batched ZRA_Sync_Queue Drainer
+ * =============================================================================
+ */
+
+#include "zra_sync.h"
+#include "db_connector.h"
+#include "orchestrator.h"
+#include "statements.h"
+#include "metrics.h"
+#include "log.h"
+
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Kithly {
+
+namespace {
+
+metrics::LatencyHistogram& batch_latency() {
+    static metrics::LatencyHistogram& h = metrics::histogram(
+        "kithly_zra_sync_batch_seconds", "", "ZRA_Sync_Queue claim, VSDC submissions and finish for one batch");
+    return h;
+}
+
+struct SyncJob {
+    std::string sync_id;
+    std::string tx_id;
+    std::string endpoint;
+    std::string payload_json;
+    int attempt = 0;          // Including this one
+    int max_attempts = 5;
+};
+
+struct SyncOutcome {
+    std::string status;       // SUCCESS, FAILED or PENDING
+    std::string result_code;  // VSDC resultCd, empty if none came back
+    std::string error;
+    int retry_secs = 0;
+    nlohmann::json response;  // null unless the VSDC answered with JSON
+    bool unreachable = false;
+};
+
+double unit_random() {
+    thread_local std::mt19937_64 rng{std::random_device{}()};
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+}
+
+std::vector<SyncJob> claim_batch(int limit, std::chrono::seconds lease) {
+    std::vector<SyncJob> jobs;
+    auto db = acquire_db_connection();
+    if (!db) {
+        KITHLY_LOG_ERROR("ZRA", "No database connection");
+        return jobs;
+    }
+
+    sql::Int4Param batch(limit);
+    sql::Int4Param lease_secs(static_cast<int32_t>(lease.count()));
+    const char* paramValues[2] = { batch.bytes, lease_secs.bytes };
+    const int paramLengths[2] = { sizeof(batch.bytes), sizeof(lease_secs.bytes) };
+    const int paramFormats[2] = { sql::BINARY_FORMAT, sql::BINARY_FORMAT };
+
+    PGresult* res = sql::exec_prepared(
+        db.get(), sql::CLAIM_ZRA_SYNC, 2, paramValues, paramLengths, paramFormats, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("ZRA", "Sync claim failed").field("error", PQerrorMessage(db.get()));
+        PQclear(res);
+        return jobs;
+    }
+
+    int rows = PQntuples(res);
+    jobs.reserve(rows);
+    for (int r = 0; r < rows; ++r) {
+        SyncJob job;
+        job.sync_id = PQgetvalue(res, r, 0);
+        job.tx_id = PQgetvalue(res, r, 1);
+        job.endpoint = PQgetvalue(res, r, 2);
+        job.payload_json = PQgetvalue(res, r, 3);
+        job.attempt = std::atoi(PQgetvalue(res, r, 4));
+        job.max_attempts = std::atoi(PQgetvalue(res, r, 5));
+        jobs.push_back(std::move(job));
+    }
+    PQclear(res);
+    return jobs;
+}
+
+/**
+ * PENDING with backoff, or FAILED once the attempts are used up
+ */
+SyncOutcome transient(const SyncJob& job, std::string error, const ZraSyncWorker::Options& options) {
+    SyncOutcome out;
+    out.error = std::move(error);
+    if (job.attempt >= job.max_attempts) {
+        out.status = "FAILED";
+        out.error += " (attempts exhausted)";
+        return out;
+    }
+    out.status = "PENDING";
+    out.retry_secs = static_cast<int>(ZraSyncWorker::retry_delay(
+        job.attempt, options.base_retry, options.max_retry, unit_random()).count());
+    return out;
+}
+
+SyncOutcome submit(VsdcClient& client, const SyncJob& job, const ZraSyncWorker::Options& options) {
+    const VsdcResponse response = client.post(job.endpoint, job.payload_json);
+
+    if (!response.transport_ok()) {
+        SyncOutcome out = transient(job, response.error, options);
+        out.unreachable = true;
+        return out;
+    }
+    const int code = response.http_status;
+    if (code >= 500 || code == 429 || code == 408) {
+        return transient(job, "HTTP " + std::to_string(code), options);
+    }
+    if (code < 200 || code >= 300) {
+        // The payload itself was refused; retrying cannot help
+        SyncOutcome out;
+        out.status = "FAILED";
+        out.error = "HTTP " + std::to_string(code);
+        return out;
+    }
+
+    nlohmann::json body = nlohmann::json::parse(response.body, nullptr, false);
+    if (body.is_discarded() || !body.is_object() || !body.contains("resultCd")) {
+        return transient(job, "Malformed VSDC response", options);
+    }
+
+    SyncOutcome out;
+    const auto& result_cd = body["resultCd"];
+    out.result_code = result_cd.is_string() ? result_cd.get<std::string>() : result_cd.dump();
+    out.result_code.resize(std::min<std::size_t>(out.result_code.size(), 10));   // VARCHAR(10)
+    out.response = std::move(body);
+    if (out.result_code == "000" || out.result_code == "001") {
+        out.status = "SUCCESS";
+    } else {
+        out.status = "FAILED";
+        out.error = "resultCd " + out.result_code;
+        if (out.response.contains("resultMsg") && out.response["resultMsg"].is_string()) {
+            out.error += ": " + out.response["resultMsg"].get<std::string>();
+        }
+    }
+    return out;
+}
+
+struct FinishedRow {
+    std::string tx_id;
+    std::string endpoint;
+    std::string status;
+    std::string result_code;
+    bool proof_recorded = false;
+};
+
+std::vector<FinishedRow> finish_batch(const std::vector<SyncJob>& jobs, const std::vector<SyncOutcome>& outcomes) {
+    nlohmann::json rows = nlohmann::json::array();
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        const SyncOutcome& o = outcomes[i];
+        rows.push_back({
+            {"sync_id", jobs[i].sync_id},
+            {"status", o.status},
+            {"result_code", o.result_code.empty() ? nlohmann::json() : nlohmann::json(o.result_code)},
+            {"last_error", o.error.empty() ? nlohmann::json() : nlohmann::json(o.error)},
+            {"retry_secs", o.retry_secs},
+            {"response", o.response},
+        });
+    }
+    const std::string param = rows.dump();
+
+    std::vector<FinishedRow> finished;
+    auto db = acquire_db_connection();
+    if (!db) {
+        KITHLY_LOG_ERROR("ZRA", "No database connection; batch retried after its lease");
+        return finished;
+    }
+    const char* paramValues[1] = { param.c_str() };
+    PGresult* res = sql::exec_prepared(db.get(), sql::FINISH_ZRA_SYNC, 1, paramValues, nullptr, nullptr, 0);
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        KITHLY_LOG_ERROR("ZRA", "Sync finish failed; batch retried after its lease")
+            .field("error", PQerrorMessage(db.get()));
+        PQclear(res);
+        return finished;
+    }
+
+    int n = PQntuples(res);
+    finished.reserve(n);
+    for (int r = 0; r < n; ++r) {
+        FinishedRow row;
+        row.tx_id = PQgetvalue(res, r, 1);
+        row.endpoint = PQgetvalue(res, r, 2);
+        row.status = PQgetvalue(res, r, 3);
+        row.result_code = PQgetisnull(res, r, 4) ? "" : PQgetvalue(res, r, 4);
+        row.proof_recorded = PQgetvalue(res, r, 5)[0] == 't';
+        finished.push_back(std::move(row));
+    }
+    PQclear(res);
+    return finished;
+}
+
+} // namespace
+
+std::chrono::seconds ZraSyncWorker::retry_delay(int attempt, std::chrono::seconds base,
+                                                std::chrono::seconds cap, double unit_random) {
+    const double exponent = std::min(std::max(attempt - 1, 0), 30);
+    const double delay = std::min(static_cast<double>(cap.count()),
+                                  static_cast<double>(base.count()) * std::ldexp(1.0, static_cast<int>(exponent)));
+    return std::chrono::seconds(static_cast<long long>(delay / 2 + unit_random * delay / 2));
+}
+
+ZraSyncWorker::ZraSyncWorker(VsdcClient::Options vsdc, Options options)
+    : client_(std::move(vsdc)), options_(std::move(options)) {
+    options_.batch_size = std::max(1, options_.batch_size);
+    options_.concurrency = std::max<std::size_t>(1, options_.concurrency);
+
+    // The lease must outlive the slowest possible batch, or a second node
+    // could claim rows this one is still submitting
+    const auto per_request = std::chrono::duration_cast<std::chrono::seconds>(
+        client_.options().connect_timeout + client_.options().read_timeout) * 2;
+    const auto rounds = static_cast<int>((static_cast<std::size_t>(options_.batch_size) + options_.concurrency - 1)
+                                         / options_.concurrency);
+    lease_ = std::max(options_.lease, per_request * rounds + std::chrono::seconds(30));
+}
+
+ZraSyncWorker::~ZraSyncWorker() {
+    stop();
+}
+
+void ZraSyncWorker::start() {
+    if (thread_.joinable() || !client_.valid()) {
+        return;
+    }
+    stopping_ = false;
+    thread_ = std::thread(&ZraSyncWorker::loop, this);
+    KITHLY_LOG_INFO("ZRA", "Sync worker started")
+        .field("vsdc", client_.options().base_url).field("batch_size", options_.batch_size)
+        .field("concurrency", options_.concurrency).field("lease_secs", static_cast<int64_t>(lease_.count()));
+}
+
+void ZraSyncWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+ZraSyncWorker::Stats ZraSyncWorker::stats() const {
+    Stats s;
+    s.claimed = claimed_.load();
+    s.succeeded = succeeded_.load();
+    s.retried = retried_.load();
+    s.failed = failed_.load();
+    s.completed = completed_.load();
+    s.held = held_.load();
+    s.swept = swept_.load();
+    return s;
+}
+
+std::size_t ZraSyncWorker::run_once() {
+    last_batch_unreachable_ = false;
+    const auto start = metrics::Clock::now();
+
+    std::vector<SyncJob> jobs = claim_batch(options_.batch_size, lease_);
+    if (jobs.empty()) {
+        return 0;
+    }
+    claimed_ += jobs.size();
+
+    // Bounded fan-out: each sender takes the next unsent row
+    std::vector<SyncOutcome> outcomes(jobs.size());
+    std::atomic<std::size_t> next{0};
+    auto sender = [&] {
+        for (std::size_t i; (i = next.fetch_add(1)) < jobs.size();) {
+            outcomes[i] = submit(client_, jobs[i], options_);
+        }
+    };
+    std::vector<std::thread> senders;
+    const std::size_t parallel = std::min(options_.concurrency, jobs.size());
+    senders.reserve(parallel - 1);
+    for (std::size_t k = 1; k < parallel; ++k) {
+        senders.emplace_back(sender);
+    }
+    sender();
+    for (auto& t : senders) {
+        t.join();
+    }
+
+    last_batch_unreachable_ = std::all_of(outcomes.begin(), outcomes.end(),
+                                          [](const SyncOutcome& o) { return o.unreachable; });
+
+    // Interlock (trg_check_proof): only a row whose resultCd reached a
+    // proof may complete; everything else that ended goes to review
+    std::vector<ZraResult> results;
+    for (const FinishedRow& row : finish_batch(jobs, outcomes)) {
+        if (row.status == "SUCCESS") {
+            ++succeeded_;
+        } else if (row.status == "PENDING") {
+            ++retried_;
+            continue;
+        } else {
+            ++failed_;
+        }
+        if (row.endpoint != ZRA_SAVE_SALES_ENDPOINT) {
+            continue;
+        }
+        if (row.status == "SUCCESS" && !row.proof_recorded) {
+            KITHLY_LOG_WARN("ZRA", "Fiscalised gift has no delivery proof").field("tx_id", row.tx_id);
+            results.emplace_back(row.tx_id, "");
+            continue;
+        }
+        results.emplace_back(row.tx_id, row.result_code);
+    }
+
+    if (!results.empty()) {
+        const auto completed = complete_deliveries(results);
+        const auto n = static_cast<uint64_t>(std::count(completed.begin(), completed.end(), true));
+        completed_ += n;
+        held_ += results.size() - n;
+    }
+
+    batch_latency().record_since(start);
+    KITHLY_LOG_INFO("ZRA", "Sync batch")
+        .field("claimed", jobs.size()).field("resolved", results.size())
+        .field("unreachable", last_batch_unreachable_);
+    return jobs.size();
+}
+
+std::size_t ZraSyncWorker::sweep_stranded() {
+    std::vector<ZraResult> results;
+    {
+        auto db = acquire_db_connection();
+        if (!db) {
+            KITHLY_LOG_ERROR("ZRA", "No database connection");
+            return 0;
+        }
+
+        sql::Int4Param grace_secs(static_cast<int32_t>(lease_.count()));
+        sql::Int4Param limit(options_.batch_size);
+        const char* paramValues[3] = { ZRA_SAVE_SALES_ENDPOINT, grace_secs.bytes, limit.bytes };
+        const int paramLengths[3] = { 0, sizeof(grace_secs.bytes), sizeof(limit.bytes) };
+        const int paramFormats[3] = { 0, sql::BINARY_FORMAT, sql::BINARY_FORMAT };
+
+        PGresult* res = sql::exec_prepared(
+            db.get(), sql::SCAN_STRANDED_ZRA_SYNC, 3, paramValues, paramLengths, paramFormats, 0);
+        if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+            KITHLY_LOG_ERROR("ZRA", "Stranded sync scan failed").field("error", PQerrorMessage(db.get()));
+            PQclear(res);
+            return 0;
+        }
+        int rows = PQntuples(res);
+        results.reserve(rows);
+        for (int r = 0; r < rows; ++r) {
+            // Same interlock as run_once: only a SUCCESS whose resultCd
+            // reached a proof may complete
+            const bool success = std::strcmp(PQgetvalue(res, r, 1), "SUCCESS") == 0;
+            results.emplace_back(PQgetvalue(res, r, 0), success ? PQgetvalue(res, r, 2) : "");
+        }
+        PQclear(res);
+    }   // Lease returned before complete_deliveries takes its own
+    if (results.empty()) {
+        return 0;
+    }
+
+    const auto completed = complete_deliveries(results);
+    const auto n = static_cast<uint64_t>(std::count(completed.begin(), completed.end(), true));
+    completed_ += n;
+    held_ += results.size() - n;
+    swept_ += results.size();
+    KITHLY_LOG_WARN("ZRA", "Completed stranded gifts")
+        .field("gifts", results.size()).field("completed", n);
+    return results.size();
+}
+
+void ZraSyncWorker::loop() {
+    std::chrono::milliseconds outage_pause{0};
+    auto next_sweep = std::chrono::steady_clock::now();
+
+    while (true) {
+        if (std::chrono::steady_clock::now() >= next_sweep) {
+            sweep_stranded();
+            next_sweep = std::chrono::steady_clock::now() + options_.sweep_interval;
+        }
+        const std::size_t claimed = run_once();
+
+        std::chrono::milliseconds wait = options_.idle_poll;
+        if (claimed > 0 && last_batch_unreachable_) {
+            outage_pause = std::min<std::chrono::milliseconds>(
+                std::max<std::chrono::milliseconds>(outage_pause * 2, std::chrono::seconds(1)),
+                options_.max_outage_pause);
+            wait = outage_pause;
+            KITHLY_LOG_WARN("ZRA", "VSDC unreachable, pausing sync")
+                .field("pause_ms", static_cast<int64_t>(outage_pause.count()));
+        } else {
+            outage_pause = std::chrono::milliseconds(0);
+            if (claimed == static_cast<std::size_t>(options_.batch_size)) {
+                wait = std::chrono::milliseconds(0);   // Backlog: keep draining
+            }
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (wake_.wait_for(lock, wait, [this] { return stopping_; })) {
+            return;
+        }
+    }
+}
+
+} // namespace Kithly
@@ -0,0 +1,189 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * tests/test_idempotency_cache.cpp - CLOCK Cache & Reservation Reaping
+ * =============================================================================
+ */
+
+#include "idempotency_cache.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace kithly {
+namespace idempotency {
+namespace {
+
+using namespace std::chrono_literals;
+
+// =============================================================================
+// SHARDED CLOCK CACHE
+// =============================================================================
+
+TEST(ShardedClockCache, HitsMissesAndOverwrites) {
+    ShardedClockCache<std::string, int> cache(8, 1h, 1);
+    EXPECT_FALSE(cache.get("a").has_value());
+
+    cache.put("a", 1);
+    cache.put("a", 2);
+    EXPECT_EQ(cache.get("a"), 2);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.evictions, 0u);
+    EXPECT_EQ(stats.size, 1u);
+
+    cache.erase("a");
+    EXPECT_FALSE(cache.get("a").has_value());
+}
+
+TEST(ShardedClockCache, CapacityIsAHardBound) {
+    ShardedClockCache<int, int> cache(4, 1h, 1);
+    for (int i = 0; i < 10; ++i) {
+        cache.put(i, i);
+    }
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.size, 4u);
+    EXPECT_EQ(stats.evictions, 6u);
+}
+
+TEST(ShardedClockCache, ReferencedEntriesGetASecondChance) {
+    ShardedClockCache<std::string, int> cache(3, 1h, 1);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    cache.put("c", 3);
+    ASSERT_TRUE(cache.get("a").has_value());   // a earns its second chance
+
+    cache.put("d", 4);   // Hand passes a, evicts b
+    EXPECT_FALSE(cache.get("b").has_value());
+    EXPECT_TRUE(cache.get("a").has_value());
+
+    cache.put("e", 5);   // Next unreferenced in the sweep is c
+    EXPECT_FALSE(cache.get("c").has_value());
+    EXPECT_TRUE(cache.get("a").has_value());
+    EXPECT_TRUE(cache.get("d").has_value());
+    EXPECT_TRUE(cache.get("e").has_value());
+}
+
+TEST(ShardedClockCache, ExpiredEntriesAreAbsentAndEvictedFirst) {
+    ShardedClockCache<std::string, int> cache(2, 200ms, 1);
+    cache.put("old", 1);
+    ASSERT_TRUE(cache.get("old").has_value());   // Referenced, but expiring
+
+    std::this_thread::sleep_for(300ms);
+    cache.put("fresh", 2);
+    cache.put("newer", 3);   // Full: the expired slot goes despite its bit
+
+    EXPECT_TRUE(cache.get("fresh").has_value());
+    EXPECT_TRUE(cache.get("newer").has_value());
+    EXPECT_FALSE(cache.get("old").has_value());
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.expirations, 1u);
+    EXPECT_EQ(stats.evictions, 0u);
+    EXPECT_EQ(stats.size, 2u);
+}
+
+TEST(ShardedClockCache, ShardsRoundUpAndStayBoundedUnderContention) {
+    // 10 shards round up to 16, 4 slots each
+    ShardedClockCache<int, int> cache(64, 1h, 10);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&cache, t] {
+            for (int i = 0; i < 5000; ++i) {
+                int key = t * 5000 + i;
+                cache.put(key, key);
+                auto hit = cache.get(key - 3);
+                if (hit) {
+                    EXPECT_EQ(*hit, key - 3);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto stats = cache.stats();
+    EXPECT_LE(stats.size, 64u);
+    EXPECT_EQ(stats.size + stats.evictions + stats.expirations, 8u * 5000u);
+}
+
+// =============================================================================
+// RESERVATION TABLE
+// =============================================================================
+
+TEST(ReservationTable, OneHolderUntilReleased) {
+    ReservationTable<std::string> table(1h, 4, 1h);
+    EXPECT_TRUE(table.try_reserve("k", 7));
+    EXPECT_FALSE(table.try_reserve("k", 8));
+    EXPECT_TRUE(table.holds("k", 7));
+    EXPECT_FALSE(table.holds("k", 8));
+
+    EXPECT_FALSE(table.release("k", 8));   // Not the owner
+    EXPECT_TRUE(table.release("k", 7));
+    EXPECT_FALSE(table.release("k", 7));
+
+    EXPECT_TRUE(table.try_reserve("k", 8));
+    EXPECT_TRUE(table.release("k"));       // owner 0: unconditional
+
+    auto stats = table.stats();
+    EXPECT_EQ(stats.misses, 1u);           // One contended reserve
+    EXPECT_EQ(stats.size, 0u);
+}
+
+TEST(ReservationTable, ReapDropsOnlyExpiredReservations) {
+    ReservationTable<int> table(200ms, 4, 1h);   // Reaper effectively idle
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(table.try_reserve(i));
+    }
+    std::this_thread::sleep_for(300ms);
+    for (int i = 100; i < 110; ++i) {
+        ASSERT_TRUE(table.try_reserve(i));
+    }
+
+    table.reap();
+    auto stats = table.stats();
+    EXPECT_EQ(stats.expirations, 100u);
+    EXPECT_EQ(stats.size, 10u);
+}
+
+TEST(ReservationTable, TakeoverIsNotReapedByTheStaleQueueEntry) {
+    ReservationTable<std::string> table(200ms, 1, 1h);
+    ASSERT_TRUE(table.try_reserve("k", 1));
+    std::this_thread::sleep_for(300ms);
+
+    // Expired but unreaped: a new owner takes it over
+    ASSERT_TRUE(table.try_reserve("k", 2));
+    EXPECT_FALSE(table.holds("k", 1));
+
+    // The first reservation's queue entry is due now; it must not
+    // expire the live one
+    table.reap();
+    EXPECT_TRUE(table.holds("k", 2));
+    EXPECT_EQ(table.stats().expirations, 0u);
+}
+
+TEST(ReservationTable, ReaperThreadExpiresInTheBackground) {
+    ReservationTable<int> table(20ms, 4, 10ms);
+    for (int i = 0; i < 20; ++i) {
+        ASSERT_TRUE(table.try_reserve(i));
+    }
+
+    auto deadline = SteadyClock::now() + 2s;
+    while (table.stats().size != 0 && SteadyClock::now() < deadline) {
+        std::this_thread::sleep_for(5ms);
+    }
+    EXPECT_EQ(table.stats().size, 0u);
+    EXPECT_EQ(table.stats().expirations, 20u);
+}
+
+} // namespace
+} // namespace idempotency
+} // namespace kithly
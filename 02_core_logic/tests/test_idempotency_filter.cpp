@@ -0,0 +1,105 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - LAYER 2: THE BRAIN (C++23)
+ * tests/test_idempotency_filter.cpp - Rotating Blocked Bloom Filter
+ * =============================================================================
+ */
+
+#include "idempotency_filter.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <string>
+
+namespace kithly {
+namespace idempotency {
+namespace {
+
+using namespace std::chrono_literals;
+using SystemClock = std::chrono::system_clock;
+
+IdempotencyFilter::Options small_filter() {
+    IdempotencyFilter::Options options;
+    options.window = std::chrono::hours(24);
+    options.slices = 4;                 // 6h slices, ring of 5
+    options.expected_keys = 20000;
+    options.false_positive_rate = 0.01;
+    return options;
+}
+
+TEST(IdempotencyFilter, NotReadyUntilSeeded) {
+    IdempotencyFilter filter(small_filter());
+    EXPECT_FALSE(filter.ready());
+    EXPECT_GT(filter.stats().bytes, 0u);
+}
+
+TEST(IdempotencyFilter, NoFalseNegativesAcrossTheWindow) {
+    IdempotencyFilter filter(small_filter());
+    const auto now = SystemClock::now();
+
+    // Spread over every slice of the window, oldest just inside it
+    for (int i = 0; i < 20000; ++i) {
+        auto age = std::chrono::minutes((i * 7) % (24 * 60 - 1));
+        filter.insert("key-" + std::to_string(i), now - age);
+    }
+    for (int i = 0; i < 20000; ++i) {
+        EXPECT_TRUE(filter.may_contain("key-" + std::to_string(i))) << i;
+    }
+    EXPECT_EQ(filter.stats().maybe_hits, 20000u);
+}
+
+TEST(IdempotencyFilter, FalsePositiveRateMeetsTheTarget) {
+    IdempotencyFilter filter(small_filter());
+    const auto now = SystemClock::now();
+    for (int i = 0; i < 20000; ++i) {
+        filter.insert("key-" + std::to_string(i), now - std::chrono::minutes(i % (24 * 60 - 1)));
+    }
+
+    int false_positives = 0;
+    constexpr int PROBES = 200000;
+    for (int i = 0; i < PROBES; ++i) {
+        if (filter.may_contain("absent-" + std::to_string(i))) {
+            ++false_positives;
+        }
+    }
+    EXPECT_LE(static_cast<double>(false_positives) / PROBES, 0.01);
+
+    auto stats = filter.stats();
+    EXPECT_EQ(stats.definite_misses + stats.maybe_hits, static_cast<uint64_t>(PROBES));
+}
+
+TEST(IdempotencyFilter, KeysOlderThanTheRingAreIgnored) {
+    IdempotencyFilter filter(small_filter());
+    const auto now = SystemClock::now();
+
+    // Past window + one slice: outside every filter in the ring
+    filter.insert("stale", now - 31h);
+    EXPECT_FALSE(filter.may_contain("stale"));
+
+    // A full window back still lands in the oldest live slice
+    filter.insert("edge", now - 24h + 1min);
+    EXPECT_TRUE(filter.may_contain("edge"));
+}
+
+TEST(IdempotencyFilter, FutureTimestampsCountAsNow) {
+    IdempotencyFilter filter(small_filter());
+    filter.insert("skewed", SystemClock::now() + 2h);
+    EXPECT_TRUE(filter.may_contain("skewed"));
+}
+
+TEST(IdempotencyFilter, UnseenKeysAreDefiniteMisses) {
+    IdempotencyFilter filter(small_filter());
+    filter.insert("present");
+
+    EXPECT_FALSE(filter.may_contain("never-inserted"));
+    EXPECT_TRUE(filter.may_contain("present"));
+
+    auto stats = filter.stats();
+    EXPECT_EQ(stats.definite_misses, 1u);
+    EXPECT_EQ(stats.maybe_hits, 1u);
+}
+
+} // namespace
+} // namespace idempotency
+} // namespace kithly
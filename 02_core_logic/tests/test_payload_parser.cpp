@@ -0,0 +1,118 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * tests/test_payload_parser.cpp - Single-Pass Parser vs. from_json
+ * =============================================================================
+ */
+
+#include "payload_parser.h"
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <string>
+
+namespace Kithly {
+namespace {
+
+const std::string VALID = R"({
+    "tx_id": "5f0c1a2e-9d3b-4c7a-8e21-3b6f0d9a4c11",
+    "idempotency_key": "idem-001",
+    "receiver_phone": "+260971234567",
+    "shop_id": "b7e4d2c0-1f3a-4e5b-9c8d-7a6b5c4d3e2f",
+    "product_id": "SKU-42",
+    "quantity": 3,
+    "tx_ref": "KLY-ABCD-1234",
+    "unit_price": 125.5,
+    "message": "Happy birthday",
+    "is_surprise": true,
+    "ignored": {"nested": [1, 2, {"deep": null}]}
+})";
+
+TEST(GiftPayloadParser, ParsesEveryField) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    ASSERT_TRUE(parser.parse(VALID, view)) << parser.error();
+
+    EXPECT_EQ(view.tx_id, "5f0c1a2e-9d3b-4c7a-8e21-3b6f0d9a4c11");
+    EXPECT_EQ(view.idempotency_key, "idem-001");
+    EXPECT_EQ(view.receiver_phone, "+260971234567");
+    EXPECT_EQ(view.shop_id, "b7e4d2c0-1f3a-4e5b-9c8d-7a6b5c4d3e2f");
+    EXPECT_EQ(view.product_id, "SKU-42");
+    EXPECT_EQ(view.quantity, 3);
+    EXPECT_EQ(view.tx_ref, "KLY-ABCD-1234");
+    EXPECT_DOUBLE_EQ(view.unit_price, 125.5);
+    EXPECT_EQ(view.message, "Happy birthday");
+    EXPECT_TRUE(view.is_surprise);
+}
+
+TEST(GiftPayloadParser, MatchesFromJson) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    ASSERT_TRUE(parser.parse(VALID, view)) << parser.error();
+
+    const GiftPayload reference = nlohmann::json::parse(VALID).get<GiftPayload>();
+    EXPECT_EQ(view.tx_id, reference.tx_id);
+    EXPECT_EQ(view.receiver_phone, reference.receiver_phone);
+    EXPECT_EQ(view.quantity, reference.quantity);
+    EXPECT_EQ(view.message, reference.message);
+    EXPECT_EQ(view.is_surprise, reference.is_surprise);
+}
+
+TEST(GiftPayloadParser, DecodesEscapes) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    const std::string json = R"({"tx_id":"t","idempotency_key":"k","receiver_phone":"p",
+        "shop_id":"s","product_id":"x","quantity":1,
+        "message":"line\nbreak \"quoted\" é 🎁"})";
+    ASSERT_TRUE(parser.parse(json, view)) << parser.error();
+    EXPECT_EQ(view.message, "line\nbreak \"quoted\" \xc3\xa9 \xf0\x9f\x8e\x81");
+}
+
+TEST(GiftPayloadParser, OptionalNullsAndRepeatedKeys) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    const std::string json = R"({"tx_id":"first","tx_id":"last","idempotency_key":"k",
+        "receiver_phone":"p","shop_id":"s","product_id":"x","quantity":1,
+        "message":null,"unit_price":null})";
+    ASSERT_TRUE(parser.parse(json, view)) << parser.error();
+    EXPECT_EQ(view.tx_id, "last");
+    EXPECT_TRUE(view.message.empty());
+    EXPECT_DOUBLE_EQ(view.unit_price, 0.0);
+    EXPECT_EQ(view.effective_tx_ref(), "last");
+}
+
+TEST(GiftPayloadParser, RejectsSchemaMismatch) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    // Missing required product_id
+    EXPECT_FALSE(parser.parse(R"({"tx_id":"t","idempotency_key":"k","receiver_phone":"p",
+        "shop_id":"s","quantity":1})", view));
+    // Required field null
+    EXPECT_FALSE(parser.parse(R"({"tx_id":null,"idempotency_key":"k","receiver_phone":"p",
+        "shop_id":"s","product_id":"x","quantity":1})", view));
+    // Wrong type
+    EXPECT_FALSE(parser.parse(R"({"tx_id":"t","idempotency_key":"k","receiver_phone":"p",
+        "shop_id":"s","product_id":"x","quantity":"1"})", view));
+    EXPECT_FALSE(parser.error().empty());
+}
+
+TEST(GiftPayloadParser, RejectsMalformedJson) {
+    GiftPayloadParser parser;
+    GiftPayloadView view;
+    EXPECT_FALSE(parser.parse("", view));
+    EXPECT_FALSE(parser.parse(R"({"tx_id":"t",})", view));
+    EXPECT_FALSE(parser.parse(VALID + "garbage", view));
+    EXPECT_FALSE(parser.parse("{\"tx_id\":\"\xff\"}", view));   // Invalid UTF-8
+}
+
+TEST(EscrowLockedEvent, MatchesNlohmannDump) {
+    std::string out;
+    append_escrow_locked_event(out, "KLY-\"1\"", "+260\n97", "ABC123");
+    const nlohmann::json reference = {
+        {"tx_ref", "KLY-\"1\""}, {"receiver_phone", "+260\n97"}, {"handshake_code", "ABC123"}};
+    EXPECT_EQ(out, reference.dump());
+}
+
+} // namespace
+} // namespace Kithly
@@ -0,0 +1,197 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * tests/test_route_optimizer.cpp - 2-opt / Or-opt Pickup Routes
+ * =============================================================================
+ */
+
+#include "route_optimizer.h"
+#include "geo.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace Kithly {
+namespace {
+
+constexpr double LUSAKA_LAT = -15.4167;
+constexpr double LUSAKA_LON = 28.2833;
+constexpr double KM_PER_DEGREE = 111.195;
+
+// Tolerance for comparing against geo::distance_km (same kernel family)
+constexpr double TOLERANCE_KM = 1e-6;
+
+RouteStop north_km(double km) {
+    return {LUSAKA_LAT + km / KM_PER_DEGREE, LUSAKA_LON, std::nullopt, std::nullopt};
+}
+
+std::vector<RouteStop> random_stops(std::size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> offset(-0.1, 0.1);
+    std::vector<RouteStop> stops;
+    for (std::size_t i = 0; i < n; ++i) {
+        stops.push_back({LUSAKA_LAT + offset(rng), LUSAKA_LON + offset(rng),
+                         std::nullopt, std::nullopt});
+    }
+    return stops;
+}
+
+/**
+ * Open-path length from the rider through stops in the given order
+ */
+double path_km(const std::vector<RouteStop>& stops, const std::vector<std::size_t>& order) {
+    double km = 0.0;
+    double lat = LUSAKA_LAT, lon = LUSAKA_LON;
+    for (std::size_t i : order) {
+        km += geo::distance_km(lat, lon, stops[i].latitude, stops[i].longitude);
+        lat = stops[i].latitude;
+        lon = stops[i].longitude;
+    }
+    return km;
+}
+
+bool is_permutation_of_stops(const std::vector<std::size_t>& order, std::size_t n) {
+    std::vector<std::size_t> sorted = order;
+    std::sort(sorted.begin(), sorted.end());
+    std::vector<std::size_t> expected(n);
+    std::iota(expected.begin(), expected.end(), 0);
+    return sorted == expected;
+}
+
+RouteOptimizer::Options generous() {
+    RouteOptimizer::Options options;
+    options.time_budget = std::chrono::seconds(1);
+    options.cache_capacity = 0;
+    return options;
+}
+
+TEST(RouteOptimizer, EmptyBatchIsAnEmptyPlan) {
+    RouteOptimizer optimizer;
+    auto plan = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, {});
+    EXPECT_TRUE(plan.order.empty());
+    EXPECT_EQ(plan.distance_km, 0.0);
+}
+
+TEST(RouteOptimizer, TwoOptFixesTheGreedyDoubleBack) {
+    // Greedy goes +1 km, back to -1.5 km, then out to +3 km (8 km);
+    // sweeping south first is 6 km
+    std::vector<RouteStop> stops = {north_km(1.0), north_km(-1.5), north_km(3.0)};
+    RouteOptimizer optimizer(generous());
+    auto plan = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, stops);
+
+    EXPECT_EQ(plan.order, (std::vector<std::size_t>{1, 0, 2}));
+    EXPECT_NEAR(plan.distance_km, 6.0, 1e-3);
+}
+
+TEST(RouteOptimizer, ResultIsTwoOptAndOrOptLocallyOptimal) {
+    for (unsigned seed : {1u, 2u, 3u, 4u, 5u}) {
+        auto stops = random_stops(25, seed);
+        RouteOptimizer optimizer(generous());
+        auto plan = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, stops);
+
+        ASSERT_TRUE(is_permutation_of_stops(plan.order, stops.size())) << "seed " << seed;
+        const double km = path_km(stops, plan.order);
+        EXPECT_NEAR(plan.distance_km, km, TOLERANCE_KM);
+        EXPECT_EQ(plan.late_minutes, 0.0);
+
+        const std::size_t m = plan.order.size();
+        for (std::size_t i = 0; i + 1 < m; ++i) {
+            for (std::size_t j = i + 1; j < m; ++j) {
+                auto reversed = plan.order;
+                std::reverse(reversed.begin() + i, reversed.begin() + j + 1);
+                EXPECT_GE(path_km(stops, reversed), km - TOLERANCE_KM)
+                    << "2-opt " << i << ".." << j << " improves, seed " << seed;
+            }
+        }
+        for (std::size_t len = 1; len <= 3; ++len) {
+            for (std::size_t i = 0; i + len <= m; ++i) {
+                std::vector<std::size_t> segment(plan.order.begin() + i,
+                                                 plan.order.begin() + i + len);
+                std::vector<std::size_t> rest = plan.order;
+                rest.erase(rest.begin() + i, rest.begin() + i + len);
+                for (std::size_t q = 0; q <= rest.size(); ++q) {
+                    auto moved = rest;
+                    moved.insert(moved.begin() + q, segment.begin(), segment.end());
+                    EXPECT_GE(path_km(stops, moved), km - TOLERANCE_KM)
+                        << "Or-opt len " << len << " from " << i << " to " << q
+                        << " improves, seed " << seed;
+                }
+            }
+        }
+    }
+}
+
+TEST(RouteOptimizer, ZeroBudgetStillReturnsTheGreedyTour) {
+    auto stops = random_stops(40, 9);
+    RouteOptimizer::Options options;
+    options.time_budget = std::chrono::microseconds(0);
+    RouteOptimizer optimizer(options);
+    auto plan = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, stops);
+
+    ASSERT_TRUE(is_permutation_of_stops(plan.order, stops.size()));
+    EXPECT_NEAR(plan.distance_km, path_km(stops, plan.order), TOLERANCE_KM);
+
+    // First hop is the nearest stop to the rider
+    double nearest = path_km(stops, {plan.order[0]});
+    for (std::size_t i = 0; i < stops.size(); ++i) {
+        EXPECT_LE(nearest, path_km(stops, {i}) + TOLERANCE_KM);
+    }
+}
+
+TEST(RouteOptimizer, WindowsOutweighDistance) {
+    // A is 1 km north with no window; B is 5 km south and closes at
+    // 15 min. Greedy (A then B) reaches B at ~21.8 min; B first is on time.
+    std::vector<RouteStop> stops = {north_km(1.0), north_km(-5.0)};
+    stops[1].closes_min = 15.0;
+
+    RouteOptimizer optimizer(generous());
+    auto plan = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, stops);
+
+    EXPECT_EQ(plan.order, (std::vector<std::size_t>{1, 0}));
+    EXPECT_EQ(plan.late_minutes, 0.0);
+}
+
+TEST(RouteOptimizer, UnavoidableLatenessIsReported) {
+    std::vector<RouteStop> stops = {north_km(10.0)};
+    stops[0].closes_min = 10.0;  // 24 min away at 25 km/h
+
+    RouteOptimizer optimizer(generous());
+    auto plan = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, stops);
+
+    ASSERT_EQ(plan.order.size(), 1u);
+    EXPECT_NEAR(plan.late_minutes, 24.0 - 10.0, 0.01);
+}
+
+TEST(RouteOptimizer, CachesPerRiderBatchWithLruEviction) {
+    RouteOptimizer::Options options;
+    options.cache_capacity = 2;
+    RouteOptimizer optimizer(options);
+
+    auto a = random_stops(6, 11);
+    auto b = random_stops(6, 12);
+    auto c = random_stops(6, 13);
+
+    auto first = optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, a);
+    EXPECT_FALSE(first.from_cache);
+
+    // Rider ~30 m further along: same 0.001° bucket
+    auto again = optimizer.optimize(LUSAKA_LAT + 0.0002, LUSAKA_LON, a);
+    EXPECT_TRUE(again.from_cache);
+    EXPECT_EQ(again.order, first.order);
+
+    optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, b);
+    optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, a);   // a is now most recent
+    optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, c);   // evicts b
+    EXPECT_EQ(optimizer.cache_size(), 2u);
+
+    EXPECT_TRUE(optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, a).from_cache);
+    EXPECT_FALSE(optimizer.optimize(LUSAKA_LAT, LUSAKA_LON, b).from_cache);
+}
+
+} // namespace
+} // namespace Kithly
@@ -0,0 +1,63 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * tests/test_sha256.cpp - Incremental SHA-256 Known Answers
+ * =============================================================================
+ */
+
+#include "sha256.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace Kithly {
+namespace {
+
+// FIPS 180-4 / NIST CAVP vectors
+TEST(Sha256, KnownAnswers) {
+    EXPECT_EQ(sha256_hex(""),
+              "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    EXPECT_EQ(sha256_hex("abc"),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    EXPECT_EQ(sha256_hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"),
+              "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    EXPECT_EQ(sha256_hex(std::string(1000000, 'a')),
+              "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+}
+
+TEST(Sha256, ChunkingDoesNotChangeTheDigest) {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data.push_back(static_cast<char>(i * 31 + 7));
+    }
+    const std::string expected = sha256_hex(data);
+
+    // Chunk sizes straddling the 64-byte block and the 56-byte pad point
+    for (std::size_t chunk : {1u, 3u, 55u, 56u, 63u, 64u, 65u, 127u, 999u}) {
+        Sha256 hasher;
+        for (std::size_t off = 0; off < data.size(); off += chunk) {
+            hasher.update(std::string_view(data).substr(off, chunk));
+        }
+        EXPECT_EQ(hasher.bytes_hashed(), data.size());
+        EXPECT_EQ(hasher.hex_digest(), expected) << "chunk " << chunk;
+    }
+}
+
+TEST(Sha256, ResetStartsOver) {
+    Sha256 hasher;
+    hasher.update("discarded");
+    hasher.hex_digest();
+    hasher.reset();
+    hasher.update("abc");
+    EXPECT_EQ(hasher.hex_digest(),
+              "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+TEST(Sha256, ReportsABackend) {
+    const std::string backend = sha256_backend();
+    EXPECT_TRUE(backend == "sha-ni" || backend == "armv8-sha2" || backend == "portable") << backend;
+}
+
+} // namespace
+} // namespace Kithly
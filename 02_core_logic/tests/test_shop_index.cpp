@@ -0,0 +1,201 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE REROUTER
+ * tests/test_shop_index.cpp - Grid Spatial Index Ring Search
+ * =============================================================================
+ */
+
+#include "shop_index.h"
+#include "geo.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Kithly {
+namespace {
+
+constexpr double LUSAKA_LAT = -15.4167;
+constexpr double LUSAKA_LON = 28.2833;
+
+IndexedShop shop(const std::string& id, double lat, double lon,
+                 const std::string& category = "bakery") {
+    IndexedShop s;
+    s.shop_id = id;
+    s.name = "Shop " + id;
+    s.category = category;
+    s.latitude = lat;
+    s.longitude = lon;
+    return s;
+}
+
+/**
+ * Brute-force reference: every shop passing the filters within
+ * radius_km, closest first, cut to k
+ */
+std::vector<std::string> scan(const std::vector<IndexedShop>& shops, double lat, double lon,
+                              std::size_t k, double radius_km,
+                              const std::string& exclude = "",
+                              const std::string& category = "") {
+    std::vector<std::pair<double, std::string>> all;
+    for (const auto& s : shops) {
+        if (s.shop_id == exclude || (!category.empty() && s.category != category)) {
+            continue;
+        }
+        double d = geo::distance_km(lat, lon, s.latitude, s.longitude);
+        if (d <= radius_km) {
+            all.emplace_back(d, s.shop_id);
+        }
+    }
+    std::sort(all.begin(), all.end());
+    if (all.size() > k) {
+        all.resize(k);
+    }
+    std::vector<std::string> ids;
+    for (const auto& entry : all) {
+        ids.push_back(entry.second);
+    }
+    return ids;
+}
+
+std::vector<std::string> ids_of(const std::vector<ShopHit>& hits) {
+    std::vector<std::string> ids;
+    for (const auto& hit : hits) {
+        ids.push_back(hit.shop_id);
+    }
+    return ids;
+}
+
+/**
+ * A dense city cluster plus a few far-flung shops, so the occupied grid
+ * extent (and with it the ring bound) is much larger than the cluster
+ */
+class ShopIndexTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<double> offset(-0.15, 0.15);
+        const char* categories[] = {"bakery", "florist", "pharmacy"};
+        for (int i = 0; i < 600; ++i) {
+            shops.push_back(shop("s" + std::to_string(i),
+                                 LUSAKA_LAT + offset(rng), LUSAKA_LON + offset(rng),
+                                 categories[i % 3]));
+        }
+        shops.push_back(shop("ndola", -12.9587, 28.6366));
+        shops.push_back(shop("livingstone", -17.8419, 25.8544, "florist"));
+        shops.push_back(shop("chipata", -13.6333, 32.6500, "pharmacy"));
+
+        for (const auto& s : shops) {
+            index.upsert(s);
+        }
+    }
+
+    std::vector<IndexedShop> shops;
+    ShopIndex index;
+};
+
+TEST_F(ShopIndexTest, NearestMatchesABruteForceScan) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> offset(-0.2, 0.2);
+    for (int q = 0; q < 200; ++q) {
+        double lat = LUSAKA_LAT + offset(rng);
+        double lon = LUSAKA_LON + offset(rng);
+        for (std::size_t k : {1u, 3u, 10u, 50u}) {
+            auto hits = index.nearest(lat, lon, k);
+            EXPECT_EQ(ids_of(hits), scan(shops, lat, lon, k, 1e9)) << "q=" << q << " k=" << k;
+            for (const auto& hit : hits) {
+                const auto& s = *std::find_if(shops.begin(), shops.end(),
+                    [&](const IndexedShop& x) { return x.shop_id == hit.shop_id; });
+                EXPECT_NEAR(hit.distance_km,
+                            geo::distance_km(lat, lon, s.latitude, s.longitude), 1e-6);
+            }
+        }
+    }
+}
+
+TEST_F(ShopIndexTest, WithinStopsAtTheRadius) {
+    for (double radius : {0.5, 2.0, 5.0, 12.0}) {
+        auto hits = index.within(LUSAKA_LAT, LUSAKA_LON, radius);
+        EXPECT_EQ(ids_of(hits), scan(shops, LUSAKA_LAT, LUSAKA_LON, shops.size(), radius))
+            << "radius " << radius;
+        for (const auto& hit : hits) {
+            EXPECT_LE(hit.distance_km, radius);
+        }
+    }
+}
+
+TEST_F(ShopIndexTest, OriginOutsideTheOccupiedExtentStillTerminates) {
+    // Hundreds of rings from the nearest occupied cell: the walk is
+    // bounded by the grid extent, not by k
+    auto hits = index.nearest(-1.2921, 36.8219, 2);  // Nairobi
+    EXPECT_EQ(ids_of(hits), scan(shops, -1.2921, 36.8219, 2, 1e9));
+
+    EXPECT_TRUE(index.within(-1.2921, 36.8219, 50.0).empty());
+}
+
+TEST_F(ShopIndexTest, KBeyondTheIndexReturnsEveryShop) {
+    auto hits = index.nearest(LUSAKA_LAT, LUSAKA_LON, shops.size() + 10);
+    EXPECT_EQ(hits.size(), shops.size());
+    EXPECT_TRUE(std::is_sorted(hits.begin(), hits.end(),
+        [](const ShopHit& a, const ShopHit& b) { return a.distance_km < b.distance_km; }));
+}
+
+TEST_F(ShopIndexTest, ExcludeAndCategoryFilterBeforeRanking) {
+    auto nearest = index.nearest(LUSAKA_LAT, LUSAKA_LON, 1);
+    ASSERT_EQ(nearest.size(), 1u);
+
+    auto excluded = index.nearest(LUSAKA_LAT, LUSAKA_LON, 5, nearest[0].shop_id, "florist");
+    EXPECT_EQ(ids_of(excluded),
+              scan(shops, LUSAKA_LAT, LUSAKA_LON, 5, 1e9, nearest[0].shop_id, "florist"));
+
+    EXPECT_TRUE(index.nearest(LUSAKA_LAT, LUSAKA_LON, 5, "", "no-such-category").empty());
+    EXPECT_TRUE(index.nearest(LUSAKA_LAT, LUSAKA_LON, 0).empty());
+}
+
+TEST_F(ShopIndexTest, ClosedShopsAreSkippedOnlyWhenASlotIsGiven) {
+    auto nearest = index.nearest(LUSAKA_LAT, LUSAKA_LON, 1);
+    ASSERT_EQ(nearest.size(), 1u);
+
+    // Open Monday 08:00-17:00 only
+    IndexedShop closed = *index.find(nearest[0].shop_id);
+    WeeklyHours hours;
+    hours.add(1, 8 * 60, 17 * 60);
+    closed.hours = hours;
+    index.upsert(closed);
+
+    const int sunday_noon = 12 * 60 / SLOT_MINUTES;
+    const int monday_noon = SLOTS_PER_DAY + sunday_noon;
+
+    EXPECT_EQ(index.nearest(LUSAKA_LAT, LUSAKA_LON, 1)[0].shop_id, closed.shop_id);
+    EXPECT_EQ(index.nearest(LUSAKA_LAT, LUSAKA_LON, 1, "", "", monday_noon)[0].shop_id,
+              closed.shop_id);
+    EXPECT_NE(index.nearest(LUSAKA_LAT, LUSAKA_LON, 1, "", "", sunday_noon)[0].shop_id,
+              closed.shop_id);
+    EXPECT_FALSE(index.is_open(closed.shop_id, sunday_noon));
+}
+
+TEST_F(ShopIndexTest, UpsertMovesAndRemoveDrops) {
+    auto nearest = index.nearest(LUSAKA_LAT, LUSAKA_LON, 1);
+    ASSERT_EQ(nearest.size(), 1u);
+    const std::string moved_id = nearest[0].shop_id;
+
+    IndexedShop moved = *index.find(moved_id);
+    moved.latitude = -12.9587;
+    moved.longitude = 28.6366;
+    index.upsert(moved);
+    EXPECT_EQ(index.size(), shops.size());
+    EXPECT_NE(index.nearest(LUSAKA_LAT, LUSAKA_LON, 1)[0].shop_id, moved_id);
+
+    index.remove(moved_id);
+    EXPECT_EQ(index.size(), shops.size() - 1);
+    EXPECT_FALSE(index.find(moved_id).has_value());
+    for (const auto& hit : index.within(-12.9587, 28.6366, 1.0)) {
+        EXPECT_NE(hit.shop_id, moved_id);
+    }
+}
+
+} // namespace
+} // namespace Kithly
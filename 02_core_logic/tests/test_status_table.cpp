@@ -0,0 +1,67 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE FIRST BRICK
+ * tests/test_status_table.cpp - Status Names & Transition Table
+ * =============================================================================
+ */
+
+#include "status_table.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace Kithly {
+namespace {
+
+TEST(StatusTable, NamesEveryKnownCode) {
+    for (const auto& entry : status::TABLE) {
+        EXPECT_EQ(std::string(status::name(entry.code)), entry.name);
+        EXPECT_EQ(status::is_known(entry.code), entry.code != 0);
+    }
+}
+
+TEST(StatusTable, UnknownCodesFallToTheSink) {
+    for (int code : {-1, 0, 1, 199, 201, 1023, 5000}) {
+        EXPECT_FALSE(status::is_known(code)) << code;
+        EXPECT_STREQ(status::name(code), "UNKNOWN") << code;
+    }
+}
+
+TEST(StatusTable, EveryEdgeIsLegal) {
+    for (const auto& edge : status::EDGES) {
+        EXPECT_TRUE(status::can_transition(edge.from, edge.to))
+            << status::name(edge.from) << " -> " << status::name(edge.to);
+    }
+}
+
+TEST(StatusTable, OnlyEdgesAreLegal) {
+    int legal = 0;
+    for (const auto& from : status::TABLE) {
+        for (const auto& to : status::TABLE) {
+            legal += status::can_transition(from.code, to.code) ? 1 : 0;
+        }
+    }
+    EXPECT_EQ(legal, static_cast<int>(std::size(status::EDGES)));
+}
+
+TEST(StatusTable, GuardsTheInterlocks) {
+    // ZRA interlock: completion only from KEY_VERIFIED or manual review
+    EXPECT_TRUE(status::can_transition(KEY_VERIFIED, Status::COMPLETED));
+    EXPECT_FALSE(status::can_transition(Status::FULFILLING, Status::COMPLETED));
+    // Escrow: a settled gift can no longer expire into a refund
+    EXPECT_TRUE(status::can_transition(Status::FUNDS_LOCKED, EXPIRED));
+    EXPECT_FALSE(status::can_transition(Status::SETTLED, EXPIRED));
+    // No way back
+    EXPECT_FALSE(status::can_transition(Status::COMPLETED, KEY_VERIFIED));
+    EXPECT_FALSE(status::can_transition(Status::FUNDS_LOCKED, Status::FUNDS_LOCKED));
+}
+
+TEST(StatusTable, CheckedYieldsTheTarget) {
+    static_assert(status::checked<Status::FUNDS_LOCKED, Status::SETTLED> == Status::SETTLED);
+    static_assert(status::checked<DECLINED, ALT_FOUND> == ALT_FOUND);
+    SUCCEED();
+}
+
+} // namespace
+} // namespace Kithly
@@ -0,0 +1,156 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * tests/test_task_pool.cpp - Work-Stealing Pool & Nested TaskGroups
+ * =============================================================================
+ */
+
+#include "task_pool.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+namespace Kithly {
+namespace {
+
+TEST(TaskGroup, WaitsForEveryTask) {
+    TaskPool pool(4);
+    std::atomic<int> done{0};
+
+    TaskGroup group(&pool);
+    for (int i = 0; i < 1000; ++i) {
+        group.run([&] { done.fetch_add(1); });
+    }
+    group.wait();
+
+    EXPECT_EQ(done.load(), 1000);
+    EXPECT_GE(pool.stats().executed, 1000u);
+}
+
+TEST(TaskGroup, NestedWaitsOnASingleThreadDoNotDeadlock) {
+    // Every level blocks in wait() on the only pool thread (or the test
+    // thread); progress relies on wait() running queued tasks itself
+    TaskPool pool(1);
+    std::atomic<int> leaves{0};
+
+    std::function<void(int)> fan_out = [&](int depth) {
+        if (depth == 0) {
+            leaves.fetch_add(1);
+            return;
+        }
+        TaskGroup group(TaskPool::current() ? TaskPool::current() : &pool);
+        for (int i = 0; i < 4; ++i) {
+            group.run([&, depth] { fan_out(depth - 1); });
+        }
+        group.wait();
+    };
+
+    fan_out(4);
+    EXPECT_EQ(leaves.load(), 4 * 4 * 4 * 4);
+}
+
+TEST(TaskGroup, NestedWaitsAcrossThreadsComplete) {
+    TaskPool pool(3);
+    std::atomic<int> inner_done{0};
+
+    TaskGroup outer(&pool);
+    for (int i = 0; i < 16; ++i) {
+        // wait() may run this on the test thread, so take the pool by
+        // reference rather than from TaskPool::current()
+        outer.run([&] {
+            TaskGroup inner(&pool);
+            for (int j = 0; j < 16; ++j) {
+                inner.run([&] {
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                    inner_done.fetch_add(1);
+                });
+            }
+            inner.wait();
+        });
+    }
+    outer.wait();
+
+    EXPECT_EQ(inner_done.load(), 16 * 16);
+}
+
+TEST(TaskGroup, WaitRethrowsTheFirstErrorOnce) {
+    TaskPool pool(2);
+    std::atomic<int> ran{0};
+
+    TaskGroup group(&pool);
+    for (int i = 0; i < 10; ++i) {
+        group.run([&, i] {
+            ran.fetch_add(1);
+            if (i % 3 == 0) {
+                throw std::runtime_error("task failed");
+            }
+        });
+    }
+    EXPECT_THROW(group.wait(), std::runtime_error);
+    EXPECT_EQ(ran.load(), 10);   // Errors do not cancel siblings
+
+    // Reported once; the group is reusable
+    group.run([&] { ran.fetch_add(1); });
+    EXPECT_NO_THROW(group.wait());
+    EXPECT_EQ(ran.load(), 11);
+}
+
+TEST(TaskGroup, NullPoolRunsInline) {
+    const auto caller = std::this_thread::get_id();
+    TaskGroup group(nullptr);
+
+    std::thread::id ran_on;
+    group.run([&] { ran_on = std::this_thread::get_id(); });
+    EXPECT_EQ(ran_on, caller);
+
+    group.run([] { throw std::logic_error("inline failure"); });
+    EXPECT_THROW(group.wait(), std::logic_error);
+}
+
+TEST(TaskGroup, DestructorWaitsAndSwallowsErrors) {
+    TaskPool pool(2);
+    std::atomic<int> done{0};
+    {
+        TaskGroup group(&pool);
+        for (int i = 0; i < 50; ++i) {
+            group.run([&] {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                done.fetch_add(1);
+            });
+        }
+        group.run([] { throw std::runtime_error("ignored"); });
+    }
+    EXPECT_EQ(done.load(), 50);
+}
+
+TEST(TaskPool, CurrentNamesTheOwningPool) {
+    TaskPool pool(2);
+    EXPECT_EQ(TaskPool::current(), nullptr);
+    EXPECT_EQ(pool.threads(), 2u);
+    EXPECT_FALSE(pool.run_one());
+
+    // Plain submit (no helping wait): runs on a pool thread
+    std::promise<TaskPool*> seen;
+    pool.submit([&] { seen.set_value(TaskPool::current()); });
+    EXPECT_EQ(seen.get_future().get(), &pool);
+}
+
+TEST(TaskPool, DestructorDrainsQueuedTasks) {
+    std::atomic<int> done{0};
+    {
+        TaskPool pool(1);
+        for (int i = 0; i < 200; ++i) {
+            pool.submit([&] { done.fetch_add(1); });
+        }
+    }
+    EXPECT_EQ(done.load(), 200);
+}
+
+} // namespace
+} // namespace Kithly
@@ -0,0 +1,118 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - THE HEART
+ * tests/test_timer_wheel.cpp - Hierarchical Timing Wheel
+ * =============================================================================
+ */
+
+#include "deadline_scheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Kithly {
+namespace {
+
+constexpr uint64_t START = 1'700'000'000;
+
+// One level's span: 64, 4096, 262144 and 16777216 ticks
+constexpr uint64_t span(int level) {
+    return TimerWheel::SLOTS << (TimerWheel::SLOT_BITS * level);
+}
+
+Deadline at(uint64_t due_tick, const std::string& tx_id = "tx") {
+    return {tx_id, 300, 305, due_tick, 1};
+}
+
+/**
+ * Advance to due - 1 (nothing may fire), then to due (exactly the one)
+ */
+void expect_fires_exactly_at(TimerWheel& wheel, uint64_t due) {
+    std::vector<Deadline> fired;
+    wheel.advance(due - 1, fired);
+    EXPECT_TRUE(fired.empty()) << "fired early for due " << due;
+
+    wheel.advance(due, fired);
+    ASSERT_EQ(fired.size(), 1u) << "due " << due;
+    EXPECT_EQ(fired[0].due_tick, due);
+}
+
+TEST(TimerWheel, FiresOnTheDueTickWithinLevelZero) {
+    TimerWheel wheel(START);
+    wheel.schedule(at(START + 5));
+    EXPECT_EQ(wheel.size(), 1u);
+
+    expect_fires_exactly_at(wheel, START + 5);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, OverdueFiresOnTheNextTick) {
+    TimerWheel wheel(START);
+    wheel.schedule(at(START - 3600));
+
+    std::vector<Deadline> fired;
+    wheel.advance(START, fired);
+    ASSERT_EQ(fired.size(), 1u);
+    EXPECT_EQ(fired[0].due_tick, START - 3600);
+}
+
+TEST(TimerWheel, CascadesDownFromEveryLevel) {
+    // Each lands on a coarse level and must cascade to level 0 in time,
+    // including the last tick of a level's range and a slot that shares
+    // its index with the current one
+    for (uint64_t delta : {span(0) - 1, span(0), span(0) + 7, span(1) - 1, span(1),
+                           span(1) + 4095, span(2) - 1, span(2) + 12345, span(3) - 1}) {
+        TimerWheel wheel(START + 61);
+        wheel.schedule(at(START + 61 + delta));
+        expect_fires_exactly_at(wheel, START + 61 + delta);
+        EXPECT_EQ(wheel.size(), 0u) << "delta " << delta;
+    }
+}
+
+TEST(TimerWheel, BatchesFireInDueOrderAcrossLevels) {
+    TimerWheel wheel(START);
+    std::vector<uint64_t> dues = {START + 3, START + 100, START + 5000, START + 300000};
+    for (auto it = dues.rbegin(); it != dues.rend(); ++it) {
+        wheel.schedule(at(*it, std::to_string(*it)));
+    }
+
+    std::vector<Deadline> fired;
+    for (uint64_t due : dues) {
+        wheel.advance(due, fired);
+        ASSERT_FALSE(fired.empty());
+        EXPECT_EQ(fired.back().due_tick, due);
+    }
+    EXPECT_EQ(fired.size(), dues.size());
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, BeyondTheTopLevelParksAndStillFiresOnTime) {
+    // Past ~194 days: parked in the top level's farthest slot and
+    // re-inserted each lap until in range
+    TimerWheel wheel(START);
+    const uint64_t due = START + span(3) + span(2) + 17;
+    wheel.schedule(at(due));
+
+    expect_fires_exactly_at(wheel, due);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheel, SizeCountsParkedAndCascadingEntries) {
+    TimerWheel wheel(START);
+    wheel.schedule(at(START + 1));
+    wheel.schedule(at(START + span(1) + 1));
+    wheel.schedule(at(START + span(3) * 2));
+    EXPECT_EQ(wheel.size(), 3u);
+
+    std::vector<Deadline> fired;
+    wheel.advance(START + span(1), fired);
+    EXPECT_EQ(fired.size(), 1u);
+    EXPECT_EQ(wheel.size(), 2u);
+    EXPECT_EQ(wheel.current_tick(), START + span(1) + 1);
+}
+
+} // namespace
+} // namespace Kithly
@@ -0,0 +1,48 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - EVIDENCE VAULT
+ * tests/test_zra_retry.cpp - ZRA Sync Backoff
+ * =============================================================================
+ */
+
+#include "zra_sync.h"
+
+#include <gtest/gtest.h>
+
+namespace Kithly {
+namespace {
+
+using std::chrono::seconds;
+
+constexpr seconds BASE{60};
+constexpr seconds CAP{86400};
+
+TEST(ZraRetryDelay, JitterSpansTheUpperHalf) {
+    // attempt 1: full delay = base
+    EXPECT_EQ(ZraSyncWorker::retry_delay(1, BASE, CAP, 0.0), seconds(30));
+    EXPECT_EQ(ZraSyncWorker::retry_delay(1, BASE, CAP, 0.999), seconds(59));
+}
+
+TEST(ZraRetryDelay, DoublesPerAttempt) {
+    EXPECT_EQ(ZraSyncWorker::retry_delay(2, BASE, CAP, 0.0), seconds(60));
+    EXPECT_EQ(ZraSyncWorker::retry_delay(3, BASE, CAP, 0.0), seconds(120));
+    EXPECT_EQ(ZraSyncWorker::retry_delay(5, BASE, CAP, 0.0), seconds(480));
+}
+
+TEST(ZraRetryDelay, CappedAndNeverNegative) {
+    EXPECT_EQ(ZraSyncWorker::retry_delay(20, BASE, CAP, 0.0), seconds(43200));
+    EXPECT_EQ(ZraSyncWorker::retry_delay(1000, BASE, CAP, 0.999), seconds(86356));
+    // attempt <= 0 behaves as the first attempt
+    EXPECT_EQ(ZraSyncWorker::retry_delay(0, BASE, CAP, 0.0), seconds(30));
+    EXPECT_EQ(ZraSyncWorker::retry_delay(-3, BASE, CAP, 0.0), seconds(30));
+}
+
+TEST(ZraRetryDelay, MonotonicInAttempt) {
+    for (int attempt = 1; attempt < 40; ++attempt) {
+        EXPECT_LE(ZraSyncWorker::retry_delay(attempt, BASE, CAP, 0.5),
+                  ZraSyncWorker::retry_delay(attempt + 1, BASE, CAP, 0.5)) << attempt;
+    }
+}
+
+} // namespace
+} // namespace Kithly
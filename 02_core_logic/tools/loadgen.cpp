@@ -0,0 +1,277 @@
+/**
+ * =============================================================================
+ * KithLy Global Protocol - TOOLS
+ * tools/loadgen.cpp - Ingestion Load Generator
+ * =============================================================================
+ *
+ * Floods kithly:ingestion:gifts with synthetic gift jobs and measures
+ * end-to-end latency: from the moment a job was due to be sent until its
+ * escrow_locked event appears on kithly:events:escrow_locked. Under --rate
+ * latency counts from the scheduled send time, so a stalled producer
+ * cannot hide queueing (no coordinated omission).
+ *
+ * The generator pops the escrow_locked queue itself, so point it at a
+ * staging stack without a running Gateway. Events from other runs are
+ * pushed back untouched.
+ *
+ * Every job uses a fresh tx_id and idempotency key; shop and product must
+ * exist in the target database (Global_Gifts foreign keys).
+ *
+ *   kithly_loadgen --count 50000 --rate 2000 \
+ *       --shop-id 3c1d8e2a-5b4f-4a9e-8c7d-6e5f4a3b2c1d --product-id SKU-CAKE-001
+ */
+
+#include "metrics.h"
+#include "orchestrator.h"
+#include <sw/redis++/redis++.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Kithly::Orchestrator::ESCROW_LOCKED_QUEUE;
+using Kithly::Orchestrator::INGESTION_QUEUE;
+
+struct Options {
+    std::string redis_uri = "tcp://127.0.0.1:6379";
+    std::size_t count = 10000;
+    double rate = 0.0;                  // Jobs per second (0 = unthrottled)
+    std::size_t batch = 100;            // LPUSH values per pipelined round trip
+    std::string shop_id;
+    std::string product_id;
+    std::chrono::seconds timeout{30};   // Wait for stragglers after the last send
+    bool wait = true;
+};
+
+void usage() {
+    std::cerr << "Usage: kithly_loadgen --shop-id UUID --product-id SKU [options]\n"
+                 "  --redis URI        Redis (default $KITHLY_REDIS_URL or tcp://127.0.0.1:6379)\n"
+                 "  --count N          Jobs to send (default 10000)\n"
+                 "  --rate R           Jobs per second, 0 = as fast as possible (default 0)\n"
+                 "  --batch B          Jobs per pipelined LPUSH batch (default 100)\n"
+                 "  --timeout S        Seconds to wait for events after the last send (default 30)\n"
+                 "  --no-wait          Only send; do not collect escrow_locked events\n";
+}
+
+bool parse_options(int argc, char* argv[], Options& options) {
+    if (const char* uri = std::getenv("KITHLY_REDIS_URL")) {
+        options.redis_uri = uri;
+    }
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg(argv[i]);
+        auto value = [&]() -> const char* { return i + 1 < argc ? argv[++i] : nullptr; };
+        const char* v = nullptr;
+        if (arg == "--no-wait") {
+            options.wait = false;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || !(v = value())) {
+            return false;
+        }
+        if (arg == "--redis") options.redis_uri = v;
+        else if (arg == "--count") options.count = std::strtoull(v, nullptr, 10);
+        else if (arg == "--rate") options.rate = std::strtod(v, nullptr);
+        else if (arg == "--batch") options.batch = std::max<std::size_t>(1, std::strtoull(v, nullptr, 10));
+        else if (arg == "--timeout") options.timeout = std::chrono::seconds(std::strtoll(v, nullptr, 10));
+        else if (arg == "--shop-id") options.shop_id = v;
+        else if (arg == "--product-id") options.product_id = v;
+        else return false;
+    }
+    return options.count > 0 && !options.shop_id.empty() && !options.product_id.empty();
+}
+
+std::string uuid_v4(std::mt19937_64& rng) {
+    const uint64_t hi = (rng() & 0xFFFFFFFFFFFF0FFFull) | 0x0000000000004000ull;
+    const uint64_t lo = (rng() & 0x3FFFFFFFFFFFFFFFull) | 0x8000000000000000ull;
+    char out[37];
+    std::snprintf(out, sizeof(out), "%08x-%04x-%04x-%04x-%012llx",
+                  static_cast<unsigned>(hi >> 32), static_cast<unsigned>((hi >> 16) & 0xFFFF),
+                  static_cast<unsigned>(hi & 0xFFFF), static_cast<unsigned>(lo >> 48),
+                  static_cast<unsigned long long>(lo & 0xFFFFFFFFFFFFull));
+    return out;
+}
+
+std::string make_payload(std::mt19937_64& rng, const Options& options,
+                         const std::string& tx_ref) {
+    const std::string tx_id = uuid_v4(rng);
+    nlohmann::json job = {
+        {"tx_id", tx_id},
+        {"idempotency_key", "loadgen-" + tx_id},
+        {"receiver_phone", "+26097" + std::to_string(1000000 + rng() % 9000000)},
+        {"shop_id", options.shop_id},
+        {"product_id", options.product_id},
+        {"quantity", 1 + static_cast<int>(rng() % 3)},
+        {"tx_ref", tx_ref},
+        {"sender_id", "loadgen"},
+        {"receiver_name", "Load Test"},
+        {"unit_price", 150.0},
+        {"message", "Synthetic load"},
+        {"is_surprise", false}
+    };
+    return job.dump();
+}
+
+struct Report {
+    std::size_t received = 0;
+    std::size_t foreign = 0;
+    Clock::time_point last_event{};
+};
+
+/**
+ * Drain escrow_locked events until every job is accounted for, or the
+ * producer has finished and `timeout` passes without a new event
+ */
+Report collect(const Options& options, const std::string& run_prefix,
+               const std::vector<std::atomic<int64_t>>& due_ns, Clock::time_point epoch,
+               const std::atomic<bool>& sending, Kithly::metrics::LatencyHistogram& e2e) {
+    sw::redis::Redis redis(options.redis_uri);
+    Report report;
+    std::vector<char> seen(options.count, 0);
+    auto idle_since = Clock::now();
+
+    while (report.received < options.count) {
+        auto popped = redis.brpop(ESCROW_LOCKED_QUEUE, std::chrono::seconds(1));
+        const auto now = Clock::now();
+        if (!popped) {
+            // The timeout only starts once the producer is done
+            if (sending.load()) {
+                idle_since = now;
+            } else if (now - idle_since > options.timeout) {
+                break;
+            }
+            continue;
+        }
+
+        std::string tx_ref;
+        try {
+            tx_ref = nlohmann::json::parse(popped->second).value("tx_ref", "");
+        } catch (const std::exception&) {
+        }
+        if (tx_ref.rfind(run_prefix, 0) != 0) {
+            redis.lpush(ESCROW_LOCKED_QUEUE, popped->second);
+            ++report.foreign;
+            continue;
+        }
+
+        const std::size_t seq = std::strtoull(tx_ref.c_str() + run_prefix.size(), nullptr, 10);
+        if (seq >= options.count || seen[seq]) {
+            continue;
+        }
+        seen[seq] = 1;
+        ++report.received;
+        report.last_event = now;
+        idle_since = now;
+        const auto due = epoch + std::chrono::nanoseconds(due_ns[seq].load(std::memory_order_relaxed));
+        e2e.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - due));
+    }
+    return report;
+}
+
+double ms(uint64_t ns) {
+    return static_cast<double>(ns) / 1e6;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    std::mt19937_64 rng(std::random_device{}());
+    char run_id[24];
+    std::snprintf(run_id, sizeof(run_id), "LG-%08llx-", static_cast<unsigned long long>(rng() & 0xFFFFFFFF));
+    const std::string run_prefix = run_id;
+
+    std::cout << "[LOADGEN] " << options.count << " jobs → " << INGESTION_QUEUE
+              << " at " << (options.rate > 0 ? std::to_string(static_cast<long>(options.rate)) + "/s" : "max rate")
+              << " (run " << run_prefix.substr(0, run_prefix.size() - 1) << ")" << std::endl;
+
+    // Payloads are built up front so generation never throttles the send loop
+    std::vector<std::string> payloads;
+    payloads.reserve(options.count);
+    for (std::size_t i = 0; i < options.count; ++i) {
+        payloads.push_back(make_payload(rng, options, run_prefix + std::to_string(i)));
+    }
+
+    std::vector<std::atomic<int64_t>> due_ns(options.count);
+    Kithly::metrics::LatencyHistogram e2e("kithly_loadgen_e2e_seconds", "");
+    std::atomic<bool> sending{true};
+    const auto epoch = Clock::now();
+
+    Report report;
+    std::thread collector;
+    if (options.wait) {
+        collector = std::thread([&] {
+            try {
+                report = collect(options, run_prefix, due_ns, epoch, sending, e2e);
+            } catch (const std::exception& e) {
+                std::cerr << "[LOADGEN] Collector failed: " << e.what() << std::endl;
+            }
+        });
+    }
+
+    try {
+        sw::redis::Redis redis(options.redis_uri);
+        auto pipe = redis.pipeline(false);
+        std::size_t queued = 0;
+        for (std::size_t i = 0; i < options.count; ++i) {
+            auto due = Clock::now();
+            if (options.rate > 0) {
+                due = epoch + std::chrono::nanoseconds(static_cast<int64_t>(1e9 * static_cast<double>(i) / options.rate));
+                std::this_thread::sleep_until(due);
+            }
+            due_ns[i].store(std::chrono::duration_cast<std::chrono::nanoseconds>(due - epoch).count(),
+                            std::memory_order_relaxed);
+            pipe.lpush(INGESTION_QUEUE, payloads[i]);
+            // A throttled run flushes every job, so none waits for its batch
+            if (++queued == options.batch || options.rate > 0 || i + 1 == options.count) {
+                pipe.exec();
+                queued = 0;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[LOADGEN] Send failed: " << e.what() << std::endl;
+        sending = false;
+        if (collector.joinable()) collector.join();
+        return 1;
+    }
+    const auto sent_at = Clock::now();
+    sending = false;
+
+    const double send_secs = std::chrono::duration<double>(sent_at - epoch).count();
+    std::printf("[LOADGEN] Sent %zu jobs in %.3f s (%.0f jobs/s)\n",
+                options.count, send_secs, static_cast<double>(options.count) / send_secs);
+
+    if (!collector.joinable()) {
+        return 0;
+    }
+    collector.join();
+
+    const auto snap = e2e.snapshot();
+    const double e2e_secs = report.received > 0
+        ? std::chrono::duration<double>(report.last_event - epoch).count() : 0.0;
+    std::printf("[LOADGEN] Received %zu/%zu events (%zu missing, %zu foreign re-queued)\n",
+                report.received, options.count, options.count - report.received, report.foreign);
+    if (report.received > 0) {
+        std::printf("[LOADGEN] End-to-end throughput: %.0f jobs/s over %.3f s\n",
+                    static_cast<double>(report.received) / e2e_secs, e2e_secs);
+        std::printf("[LOADGEN] Latency ms: p50 %.3f  p90 %.3f  p99 %.3f  p99.9 %.3f  max %.3f  mean %.3f\n",
+                    ms(snap.quantile(0.5)), ms(snap.quantile(0.9)), ms(snap.quantile(0.99)),
+                    ms(snap.quantile(0.999)), ms(snap.max_ns),
+                    ms(snap.sum_ns / std::max<uint64_t>(1, snap.total)));
+    }
+    return report.received == options.count ? 0 : 1;
+}
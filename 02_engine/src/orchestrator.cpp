@@ -9,8 +9,9 @@
  * - PostGIS proximity search within 5km
  * - Shadow Lock inventory management
  * - Baker's Protocol state (Status 110)
+ * - Read-through Shop / Product metadata cache (LISTEN/NOTIFY invalidated)
  * 
- * Build: g++ -O3 -std=c++17 orchestrator.cpp -lpqxx -lpq -o orchestrator
+ * Build: g++ -O3 -std=c++17 orchestrator.cpp -lpqxx -lpq -pthread -o orchestrator
  * =============================================================================
  */
 
@@ -19,25 +20,42 @@
 #include <vector>
 #include <chrono>
 #include <optional>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <pqxx/pqxx>
 
+// Shared status codes and compile-time transition table
+#include "../../02_core_logic/include/status_table.h"
+
 namespace kithly {
 
 // =============================================================================
 // STATUS CODES
 // =============================================================================
 
+// Engine names for the protocol codes in 02_core_logic/include/constants.h
 enum class OrderStatus {
-    PENDING = 100,
-    AWAITING_SHOP_ACCEPTANCE = 110,  // Baker's Protocol
-    ALT_FOUND = 106,                  // Re-route found
-    CONFIRMED = 200,
-    READY_FOR_COLLECTION = 300,
-    COMPLETED = 400,
-    DECLINED = 910,
-    CANCELLED = 900
+    PENDING = Kithly::Status::INITIATED,
+    AWAITING_SHOP_ACCEPTANCE = Kithly::AWAITING_SHOP_ACCEPTANCE,  // Baker's Protocol
+    ALT_FOUND = Kithly::ALT_FOUND,                                // Re-route found
+    CONFIRMED = Kithly::Status::FUNDS_LOCKED,
+    READY_FOR_COLLECTION = Kithly::Status::FULFILLING,
+    COMPLETED = Kithly::Status::COMPLETED,
+    DECLINED = Kithly::DECLINED,
+    CANCELLED = Kithly::EXPIRED
 };
 
+/**
+ * Target code of a transition the engine writes; fails the build unless
+ * From → To is in the protocol's table (status_table.h)
+ */
+template <OrderStatus From, OrderStatus To>
+inline constexpr int transition_to = Kithly::status::checked<static_cast<int>(From), static_cast<int>(To)>;
+
 // =============================================================================
 // DATA STRUCTURES
 // =============================================================================
@@ -52,6 +70,11 @@ struct Shop {
     double performance_score;
 };
 
+struct Product {
+    std::string sku_id;
+    bool is_made_to_order;
+};
+
 struct Order {
     std::string tx_id;
     std::string shop_id;
@@ -77,73 +100,420 @@ struct RerouteResult {
 // DATABASE CONNECTION
 // =============================================================================
 
+// Prepared statement names (prepared once per connection)
+constexpr const char* STMT_REROUTE = "reroute";
+constexpr const char* STMT_PRODUCT_META = "product_meta";
+constexpr const char* STMT_SHOP_META = "shop_meta";
+constexpr const char* STMT_ALL_PRODUCTS = "all_products";
+constexpr const char* STMT_ALL_SHOPS = "all_shops";
+
+/**
+ * Catalog lookups used by CatalogCache, on the engine connection (misses)
+ * and on the cache's listener connection (invalidations).
+ * Shops names the column `category` (002_proximity_graph.sql).
+ */
+void prepare_catalog_statements(pqxx::connection& conn) {
+    conn.prepare(STMT_PRODUCT_META, R"(
+        SELECT sku_id, COALESCE(is_made_to_order, false)
+        FROM Products WHERE sku_id = $1::text
+    )");
+    conn.prepare(STMT_SHOP_META, R"(
+        SELECT shop_id::text, name, latitude::float8, longitude::float8,
+               category AS category_id, tier, performance_score::float8
+        FROM Shops WHERE shop_id = $1::uuid
+    )");
+    conn.prepare(STMT_ALL_PRODUCTS, R"(
+        SELECT sku_id, COALESCE(is_made_to_order, false)
+        FROM Products
+    )");
+    conn.prepare(STMT_ALL_SHOPS, R"(
+        SELECT shop_id::text, name, latitude::float8, longitude::float8,
+               category AS category_id, tier, performance_score::float8
+        FROM Shops
+    )");
+}
+
 class Database {
 private:
     std::unique_ptr<pqxx::connection> conn_;
     
+    /**
+     * Prepare hot statements once so each reroute skips parse/plan.
+     * Parameters are typed in the SQL so the plan is fixed up front.
+     */
+    void prepare_statements() {
+        // The whole reroute as one statement: search, Inventory_Locks upsert
+        // (016_inventory_locks.sql) and Global_Gifts update share one
+        // snapshot and one commit.
+        // The gift row is locked first, and only while it is still in
+        // $9 (DECLINED): a replayed or late reroute of the same gift waits,
+        // then finds nothing to do. Shops are not locked, so unrelated
+        // reroutes in one area can all get the best shop; the hold on its
+        // stock is the gift's own Inventory_Locks row.
+        conn_->prepare(STMT_REROUTE, R"(
+            WITH gift AS (
+                SELECT tx_id
+                FROM Global_Gifts
+                WHERE tx_id = $7::uuid AND status_code = $9::int4
+                FOR UPDATE
+            ),
+            candidate AS (
+                SELECT 
+                    s.shop_id,
+                    s.name,
+                    ST_Distance(
+                        s.location::geography,
+                        ST_SetSRID(ST_MakePoint($1::float8, $2::float8), 4326)::geography
+                    ) / 1000.0 - $6::float8 as distance_diff_km
+                FROM Shops s
+                CROSS JOIN gift
+                WHERE s.category = $3::text
+                  AND s.shop_id != $4::uuid
+                  AND s.admin_approval_status = 'approved'
+                  AND s.is_verified = true
+                  AND shop_open_for_reroute(s.shop_id)  -- 010_operating_hours_notify.sql
+                  AND ST_DWithin(
+                      s.location::geography,
+                      ST_SetSRID(ST_MakePoint($1::float8, $2::float8), 4326)::geography,
+                      $5::float8  -- 5km in meters
+                  )
+                ORDER BY s.performance_score DESC, distance_diff_km ASC
+                LIMIT 1
+            ),
+            shadow_lock AS (
+                INSERT INTO Inventory_Locks (shop_id, tx_id, locked_at, expires_at)
+                SELECT c.shop_id, $7::uuid, NOW(), NOW() + INTERVAL '15 minutes'
+                FROM candidate c
+                ON CONFLICT (shop_id, tx_id) DO UPDATE
+                SET locked_at = NOW(), expires_at = NOW() + INTERVAL '15 minutes'
+            ),
+            rerouted AS (
+                UPDATE Global_Gifts g
+                SET status_code = $8::int4,
+                    alternative_shop_id = c.shop_id,
+                    re_route_distance_diff = (CASE WHEN c.distance_diff_km >= 0 THEN '+' ELSE '' END)
+                        || to_char(c.distance_diff_km, 'FM999999990.000000') || 'km',
+                    rerouted_at = NOW()
+                FROM candidate c
+                WHERE g.tx_id = $7::uuid
+                  AND g.status_code = $9::int4
+                RETURNING g.tx_id
+            )
+            SELECT c.shop_id, c.name, c.distance_diff_km,
+                   (SELECT COUNT(*) FROM rerouted) AS rerouted
+            FROM candidate c
+        )");
+        
+        prepare_catalog_statements(*conn_);
+    }
+    
 public:
-    Database(const std::string& connection_string) {
+    Database(const std::string& connection_string)
+        : connection_string_(connection_string) {
         conn_ = std::make_unique<pqxx::connection>(connection_string);
+        prepare_statements();
     }
     
     pqxx::connection& connection() { return *conn_; }
+    const std::string& connection_string() const { return connection_string_; }
+    
+private:
+    std::string connection_string_;
 };
 
 // =============================================================================
-// RE-ROUTING ENGINE
+// CATALOG CACHE (Shop / Product metadata)
 // =============================================================================
-// Target: < 50ms execution time
+// Catalog rows change rarely but are read on every job. Readers take the
+// current immutable snapshot (one atomic shared_ptr load, no lock) and
+// look it up; writers copy the snapshot, change it and swap it in (RCU).
+//
+// Invalidation: 009_shop_index_notify.sql (kithly_shops) and
+// 013_catalog_cache_notify.sql (kithly_products) send the changed key.
+// A listener thread on its own connection re-reads that row and publishes
+// a new snapshot. NOTIFY is not durable, so every (re)connect of the
+// listener reloads the whole catalog.
 
-class ReroutingEngine {
+/**
+ * One immutable version of the catalog. nullopt caches "no such row" so
+ * an unknown SKU is not re-queried on every job.
+ */
+struct CatalogSnapshot {
+    uint64_t version = 0;
+    std::unordered_map<std::string, std::optional<Product>> products;
+    std::unordered_map<std::string, std::optional<Shop>> shops;
+};
+
+namespace catalog_rows {
+
+inline Product product(const pqxx::row& row) {
+    return Product{row[0].as<std::string>(), row[1].as<bool>()};
+}
+
+inline Shop shop(const pqxx::row& row) {
+    return Shop{
+        row[0].as<std::string>(), row[1].as<std::string>(""),
+        row[2].as<double>(0.0), row[3].as<double>(0.0),
+        row[4].as<std::string>(""), row[5].as<std::string>("sandbox"),
+        row[6].as<double>(0.0)
+    };
+}
+
+} // namespace catalog_rows
+
+class CatalogCache {
 private:
     Database& db_;
-    static constexpr double SEARCH_RADIUS_KM = 5.0;
+    std::shared_ptr<const CatalogSnapshot> current_;
+    std::mutex write_mutex_;                   // Serialises snapshot swaps
+    std::atomic<uint64_t> invalidations_{0};   // Bumped on every NOTIFY
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    
+    std::atomic<bool> stopping_{false};
+    std::thread listener_;
+    
+    /**
+     * Copy the current snapshot, apply edit, publish as the next version
+     * Caller holds write_mutex_.
+     */
+    void publish(const std::function<void(CatalogSnapshot&)>& edit) {
+        auto next = std::make_shared<CatalogSnapshot>(*std::atomic_load(&current_));
+        edit(*next);
+        ++next->version;
+        std::atomic_store(&current_, std::shared_ptr<const CatalogSnapshot>(std::move(next)));
+    }
+    
+    /**
+     * Miss on the engine connection. The row is only cached if no
+     * invalidation arrived while it was being read; otherwise a stale
+     * row could overwrite the listener's fresher one.
+     */
+    template <typename T, typename Read, typename Slot>
+    std::optional<T> read_through(const char* statement, const std::string& key, Read read, Slot slot) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t epoch = invalidations_.load();
+        
+        std::optional<T> value;
+        try {
+            pqxx::work txn(db_.connection());
+            auto rows = txn.exec_prepared(statement, key);
+            txn.commit();
+            if (!rows.empty()) {
+                value = read(rows[0]);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[CATALOG] Lookup failed for " << key << ": " << e.what() << std::endl;
+            return std::nullopt;  // Not cached: the next call retries
+        }
+        
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        if (invalidations_.load() == epoch) {
+            publish([&](CatalogSnapshot& s) { slot(s)[key] = value; });
+        }
+        return value;
+    }
+    
+    template <typename Map>
+    static const typename Map::mapped_type* find(const Map& map, const std::string& key) {
+        auto it = map.find(key);
+        return it == map.end() ? nullptr : &it->second;
+    }
+    
+    // -------------------------------------------------------------------------
+    // Listener (own connection, own thread)
+    // -------------------------------------------------------------------------
+    
+    class Receiver : public pqxx::notification_receiver {
+    public:
+        Receiver(pqxx::connection& conn, const std::string& channel, std::vector<std::string>& out)
+            : pqxx::notification_receiver(conn, channel), out_(out) {}
+        
+        // Queries are not allowed from inside the callback; just queue
+        void operator()(const std::string& payload, int) override { out_.push_back(payload); }
+        
+    private:
+        std::vector<std::string>& out_;
+    };
+    
+    void reload_all(pqxx::connection& conn) {
+        invalidations_.fetch_add(1);
+        auto next = std::make_shared<CatalogSnapshot>();
+        {
+            pqxx::work txn(conn);
+            for (const auto& row : txn.exec_prepared(STMT_ALL_PRODUCTS)) {
+                auto product = catalog_rows::product(row);
+                std::string key = product.sku_id;
+                next->products.emplace(std::move(key), std::move(product));
+            }
+            for (const auto& row : txn.exec_prepared(STMT_ALL_SHOPS)) {
+                auto shop = catalog_rows::shop(row);
+                std::string key = shop.shop_id;
+                next->shops.emplace(std::move(key), std::move(shop));
+            }
+            txn.commit();
+        }
+        
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        next->version = std::atomic_load(&current_)->version + 1;
+        std::cout << "[CATALOG] Loaded " << next->products.size() << " products, "
+                  << next->shops.size() << " shops (v" << next->version << ")" << std::endl;
+        std::atomic_store(&current_, std::shared_ptr<const CatalogSnapshot>(std::move(next)));
+    }
+    
+    template <typename T, typename Read, typename Slot>
+    void refresh(pqxx::connection& conn, const char* statement, const std::string& key, Read read, Slot slot) {
+        std::optional<T> value;
+        {
+            pqxx::work txn(conn);
+            auto rows = txn.exec_prepared(statement, key);
+            txn.commit();
+            if (!rows.empty()) {
+                value = read(rows[0]);
+            }
+        }
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        publish([&](CatalogSnapshot& s) { slot(s)[key] = std::move(value); });
+    }
+    
+    void run_listener() {
+        while (!stopping_) {
+            try {
+                pqxx::connection conn(db_.connection_string());
+                prepare_catalog_statements(conn);
+                
+                std::vector<std::string> products, shops;
+                Receiver product_receiver(conn, "kithly_products", products);
+                Receiver shop_receiver(conn, "kithly_shops", shops);
+                
+                // Anything committed while we were not listening was missed
+                reload_all(conn);
+                
+                while (!stopping_) {
+                    conn.await_notification(1, 0);
+                    if (products.empty() && shops.empty()) {
+                        continue;
+                    }
+                    // Readers already past the lookup keep their snapshot;
+                    // in-flight misses must not cache what they read
+                    invalidations_.fetch_add(1);
+                    
+                    // An empty payload requests a full reload
+                    bool full = false;
+                    for (const auto& key : products) full |= key.empty();
+                    for (const auto& key : shops) full |= key.empty();
+                    if (full) {
+                        reload_all(conn);
+                    } else {
+                        for (const auto& sku : products) {
+                            refresh<Product>(conn, STMT_PRODUCT_META, sku, catalog_rows::product,
+                                             [](CatalogSnapshot& s) -> auto& { return s.products; });
+                        }
+                        for (const auto& shop_id : shops) {
+                            refresh<Shop>(conn, STMT_SHOP_META, shop_id, catalog_rows::shop,
+                                          [](CatalogSnapshot& s) -> auto& { return s.shops; });
+                        }
+                    }
+                    products.clear();
+                    shops.clear();
+                }
+            } catch (const std::exception& e) {
+                // Misses still read through on the engine connection
+                std::cerr << "[CATALOG] Listener error: " << e.what() 
+                          << " - reconnecting in 3 seconds" << std::endl;
+                for (int i = 0; i < 30 && !stopping_; ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                }
+            }
+        }
+    }
+    
+public:
+    CatalogCache(Database& db)
+        : db_(db), current_(std::make_shared<const CatalogSnapshot>()) {}
+    
+    ~CatalogCache() { stop(); }
+    
+    CatalogCache(const CatalogCache&) = delete;
+    CatalogCache& operator=(const CatalogCache&) = delete;
+    
+    /**
+     * Start the LISTEN thread; it loads the full catalog once connected
+     */
+    void start() {
+        if (!listener_.joinable()) {
+            stopping_ = false;
+            listener_ = std::thread(&CatalogCache::run_listener, this);
+        }
+    }
+    
+    void stop() {
+        stopping_ = true;
+        if (listener_.joinable()) {
+            listener_.join();
+        }
+    }
+    
+    /**
+     * Current version; hold it to read several entries consistently
+     */
+    std::shared_ptr<const CatalogSnapshot> snapshot() const {
+        return std::atomic_load(&current_);
+    }
     
     /**
-     * PostGIS query to find alternative shops within 5km
-     * Requirement: Complete in < 50ms
+     * Product metadata by SKU (read-through)
+     * @return nullopt if the SKU does not exist (or the lookup failed)
      */
-    std::string build_proximity_query(
-        double lat, 
-        double lon, 
-        const std::string& category_id,
-        const std::string& exclude_shop_id
-    ) {
-        // PostGIS ST_DWithin is optimized for spatial index
-        return R"(
-            SELECT 
-                s.shop_id,
-                s.name,
-                s.latitude,
-                s.longitude,
-                s.performance_score,
-                ST_Distance(
-                    s.location::geography,
-                    ST_SetSRID(ST_MakePoint($1, $2), 4326)::geography
-                ) / 1000.0 as distance_km
-            FROM Shops s
-            WHERE s.category_id = $3
-              AND s.shop_id != $4
-              AND s.admin_approval_status = 'approved'
-              AND s.is_verified = true
-              AND ST_DWithin(
-                  s.location::geography,
-                  ST_SetSRID(ST_MakePoint($1, $2), 4326)::geography,
-                  $5  -- 5km in meters
-              )
-            ORDER BY s.performance_score DESC, distance_km ASC
-            LIMIT 1
-        )";
+    std::optional<Product> product(const std::string& sku_id) {
+        auto snap = snapshot();
+        if (auto* cached = find(snap->products, sku_id)) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return *cached;
+        }
+        return read_through<Product>(STMT_PRODUCT_META, sku_id, catalog_rows::product,
+                                     [](CatalogSnapshot& s) -> auto& { return s.products; });
+    }
+    
+    /**
+     * Shop metadata (tier, performance_score, category, coords) by shop_id
+     */
+    std::optional<Shop> shop(const std::string& shop_id) {
+        auto snap = snapshot();
+        if (auto* cached = find(snap->shops, shop_id)) {
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return *cached;
+        }
+        return read_through<Shop>(STMT_SHOP_META, shop_id, catalog_rows::shop,
+                                  [](CatalogSnapshot& s) -> auto& { return s.shops; });
     }
     
+    uint64_t version() const { return snapshot()->version; }
+    uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+};
+
+// =============================================================================
+// RE-ROUTING ENGINE
+// =============================================================================
+// Target: < 50ms execution time
+
+class ReroutingEngine {
+private:
+    Database& db_;
+    static constexpr double SEARCH_RADIUS_KM = 5.0;
+    
 public:
     ReroutingEngine(Database& db) : db_(db) {}
     
     /**
-     * Search for alternative shop within 5km
+     * Find an alternative shop within 5km, shadow lock its inventory and
+     * move the order to ALT_FOUND (106) - one prepared statement, one commit
      * Called when: Status == 910 (Declined) AND auto_reroute == true
+     * 
+     * @return found == true only if the reroute committed
      */
-    RerouteResult find_alternative(const Order& order, double original_distance_km) {
+    RerouteResult reroute(const Order& order, double original_distance_km) {
         auto start = std::chrono::high_resolution_clock::now();
         
         RerouteResult result{false, "", "", 0.0, std::chrono::microseconds(0)};
@@ -151,112 +521,54 @@ public:
         try {
             pqxx::work txn(db_.connection());
             
-            // Execute PostGIS proximity search
-            auto rows = txn.exec_params(
-                build_proximity_query(
-                    order.recipient_lat,
-                    order.recipient_lon,
-                    order.category_id,
-                    order.shop_id
-                ),
+            auto rows = txn.exec_prepared(STMT_REROUTE,
                 order.recipient_lon,  // $1 - Note: PostGIS uses lon,lat
                 order.recipient_lat,  // $2
                 order.category_id,    // $3
                 order.shop_id,        // $4 - exclude declined shop
-                SEARCH_RADIUS_KM * 1000  // $5 - meters
+                SEARCH_RADIUS_KM * 1000,  // $5 - meters
+                original_distance_km, // $6
+                order.tx_id,          // $7
+                transition_to<OrderStatus::DECLINED, OrderStatus::ALT_FOUND>,  // $8
+                static_cast<int>(OrderStatus::DECLINED)                        // $9 - expected state
             );
             
-            if (!rows.empty()) {
+            if (rows.empty()) {
+                txn.commit();  // Nothing written
+            } else if (rows[0]["rerouted"].as<long>() == 0) {
+                // Lock without a moved order row: abort rather than leave it dangling
+                std::cerr << "[REROUTE] Order " << order.tx_id
+                          << " missing or no longer DECLINED - rolled back" << std::endl;
+                txn.abort();
+            } else {
                 auto row = rows[0];
-                result.found = true;
                 result.alternative_shop_id = row["shop_id"].as<std::string>();
                 result.shop_name = row["name"].as<std::string>();
+                result.distance_diff_km = row["distance_diff_km"].as<double>();
                 
-                double new_distance = row["distance_km"].as<double>();
-                result.distance_diff_km = new_distance - original_distance_km;
+                txn.commit();
+                result.found = true;
+                
+                std::cout << "[SHADOW_LOCK] Locked inventory for shop " 
+                          << result.alternative_shop_id << " (tx: " << order.tx_id << ")" << std::endl;
+                std::cout << "[REROUTE] Order " << order.tx_id 
+                          << " → Status 106 (ALT_FOUND)" << std::endl;
             }
             
-            txn.commit();
-            
         } catch (const std::exception& e) {
             std::cerr << "[REROUTE] Error: " << e.what() << std::endl;
+            result = RerouteResult{false, "", "", 0.0, std::chrono::microseconds(0)};
         }
         
         auto end = std::chrono::high_resolution_clock::now();
         result.search_time = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
         
         // Log performance
-        std::cout << "[REROUTE] Search completed in " 
+        std::cout << "[REROUTE] Reroute completed in " 
                   << result.search_time.count() << "µs" << std::endl;
         
         return result;
     }
-    
-    /**
-     * Execute shadow lock on alternative shop's inventory
-     * Prevents race conditions during re-route confirmation
-     */
-    bool shadow_lock_inventory(const std::string& alternative_shop_id, const std::string& tx_id) {
-        try {
-            pqxx::work txn(db_.connection());
-            
-            // Create temporary reservation
-            txn.exec_params(R"(
-                INSERT INTO Inventory_Locks (shop_id, tx_id, locked_at, expires_at)
-                VALUES ($1, $2, NOW(), NOW() + INTERVAL '15 minutes')
-                ON CONFLICT (shop_id, tx_id) DO UPDATE
-                SET locked_at = NOW(), expires_at = NOW() + INTERVAL '15 minutes'
-            )", alternative_shop_id, tx_id);
-            
-            txn.commit();
-            
-            std::cout << "[SHADOW_LOCK] Locked inventory for shop " 
-                      << alternative_shop_id << " (tx: " << tx_id << ")" << std::endl;
-            
-            return true;
-            
-        } catch (const std::exception& e) {
-            std::cerr << "[SHADOW_LOCK] Error: " << e.what() << std::endl;
-            return false;
-        }
-    }
-    
-    /**
-     * Update order status and set alternative shop
-     */
-    bool update_order_reroute(const std::string& tx_id, const RerouteResult& result) {
-        try {
-            pqxx::work txn(db_.connection());
-            
-            std::string distance_diff = (result.distance_diff_km >= 0 ? "+" : "") 
-                                       + std::to_string(result.distance_diff_km) + "km";
-            
-            txn.exec_params(R"(
-                UPDATE Global_Gifts
-                SET status_code = $1,
-                    alternative_shop_id = $2,
-                    re_route_distance_diff = $3,
-                    rerouted_at = NOW()
-                WHERE tx_id = $4
-            )", 
-                static_cast<int>(OrderStatus::ALT_FOUND),
-                result.alternative_shop_id,
-                distance_diff,
-                tx_id
-            );
-            
-            txn.commit();
-            
-            std::cout << "[REROUTE] Order " << tx_id 
-                      << " → Status 106 (ALT_FOUND)" << std::endl;
-            
-            return true;
-            
-        } catch (const std::exception& e) {
-            std::cerr << "[REROUTE] Update error: " << e.what() << std::endl;
-            return false;
-        }
-    }
 };
 
 // =============================================================================
@@ -267,32 +579,19 @@ public:
 class BakersProtocol {
 private:
     Database& db_;
+    CatalogCache& catalog_;
     
 public:
-    BakersProtocol(Database& db) : db_(db) {}
+    BakersProtocol(Database& db, CatalogCache& catalog) : db_(db), catalog_(catalog) {}
     
     /**
      * Check if order requires shop acceptance
      * Returns true if the product is made-to-order
+     * (from the catalog cache; the database is only read on a miss)
      */
     bool requires_acceptance(const std::string& product_id) {
-        try {
-            pqxx::work txn(db_.connection());
-            
-            auto rows = txn.exec_params(R"(
-                SELECT is_made_to_order FROM Products WHERE sku_id = $1
-            )", product_id);
-            
-            if (!rows.empty()) {
-                return rows[0]["is_made_to_order"].as<bool>();
-            }
-            
-            return false;
-            
-        } catch (const std::exception& e) {
-            std::cerr << "[BAKER] Error checking product: " << e.what() << std::endl;
-            return false;
-        }
+        auto product = catalog_.product(product_id);
+        return product && product->is_made_to_order;
     }
     
     /**
@@ -303,15 +602,22 @@ public:
         try {
             pqxx::work txn(db_.connection());
             
-            txn.exec_params(R"(
+            // Compare-and-set on $3: only a PENDING order starts the window
+            auto res = txn.exec_params(R"(
                 UPDATE Global_Gifts
                 SET status_code = $1,
                     acceptance_deadline = NOW() + INTERVAL '2 hours'
-                WHERE tx_id = $2
-            )", static_cast<int>(OrderStatus::AWAITING_SHOP_ACCEPTANCE), tx_id);
+                WHERE tx_id = $2 AND status_code = $3
+            )", transition_to<OrderStatus::PENDING, OrderStatus::AWAITING_SHOP_ACCEPTANCE>, tx_id,
+                static_cast<int>(OrderStatus::PENDING));
             
             txn.commit();
             
+            if (res.affected_rows() == 0) {
+                std::cerr << "[BAKER] Order " << tx_id << " not PENDING - unchanged" << std::endl;
+                return false;
+            }
+            
             std::cout << "[BAKER] Order " << tx_id 
                       << " → Status 110 (AWAITING_SHOP_ACCEPTANCE)" << std::endl;
             
@@ -331,16 +637,24 @@ public:
         try {
             pqxx::work txn(db_.connection());
             
-            // Move to CONFIRMED status
-            txn.exec_params(R"(
+            // Move to CONFIRMED status, only while still awaiting this shop
+            // (a lapsed window has already moved it to DECLINED)
+            auto res = txn.exec_params(R"(
                 UPDATE Global_Gifts
                 SET status_code = $1,
                     shop_accepted_at = NOW()
-                WHERE tx_id = $2 AND shop_id = $3
-            )", static_cast<int>(OrderStatus::CONFIRMED), tx_id, shop_id);
+                WHERE tx_id = $2 AND shop_id = $3 AND status_code = $4
+            )", transition_to<OrderStatus::AWAITING_SHOP_ACCEPTANCE, OrderStatus::CONFIRMED>, tx_id, shop_id,
+                static_cast<int>(OrderStatus::AWAITING_SHOP_ACCEPTANCE));
             
             txn.commit();
             
+            if (res.affected_rows() == 0) {
+                std::cerr << "[BAKER] Order " << tx_id
+                          << " no longer awaiting shop " << shop_id << " - accept ignored" << std::endl;
+                return false;
+            }
+            
             std::cout << "[BAKER] Order " << tx_id 
                       << " ACCEPTED by shop " << shop_id << std::endl;
             
@@ -363,16 +677,23 @@ public:
         try {
             pqxx::work txn(db_.connection());
             
-            txn.exec_params(R"(
+            auto res = txn.exec_params(R"(
                 UPDATE Global_Gifts
                 SET status_code = $1,
                     decline_reason = $2,
                     declined_at = NOW()
-                WHERE tx_id = $3 AND shop_id = $4
-            )", static_cast<int>(OrderStatus::DECLINED), reason, tx_id, shop_id);
+                WHERE tx_id = $3 AND shop_id = $4 AND status_code = $5
+            )", transition_to<OrderStatus::AWAITING_SHOP_ACCEPTANCE, OrderStatus::DECLINED>, reason, tx_id, shop_id,
+                static_cast<int>(OrderStatus::AWAITING_SHOP_ACCEPTANCE));
             
             txn.commit();
             
+            if (res.affected_rows() == 0) {
+                std::cerr << "[BAKER] Order " << tx_id
+                          << " no longer awaiting shop " << shop_id << " - decline ignored" << std::endl;
+                return false;
+            }
+            
             std::cout << "[BAKER] Order " << tx_id 
                       << " DECLINED by shop " << shop_id 
                       << " (reason: " << reason << ")" << std::endl;
@@ -393,15 +714,19 @@ public:
 class Orchestrator {
 private:
     Database db_;
+    CatalogCache catalog_;
     ReroutingEngine rerouter_;
     BakersProtocol baker_;
     
 public:
     Orchestrator(const std::string& db_connection)
         : db_(db_connection)
+        , catalog_(db_)
         , rerouter_(db_)
-        , baker_(db_)
-    {}
+        , baker_(db_, catalog_)
+    {
+        catalog_.start();
+    }
     
     /**
      * Process order state changes
@@ -420,22 +745,17 @@ public:
             // Calculate original distance (would come from order data)
             double original_distance = 2.5; // TODO: Get from order
             
-            auto result = rerouter_.find_alternative(order, original_distance);
+            // Search + shadow lock + ALT_FOUND (106) in one transaction
+            auto result = rerouter_.reroute(order, original_distance);
             
             if (result.found) {
-                // Shadow lock the alternative shop's inventory
-                if (rerouter_.shadow_lock_inventory(result.alternative_shop_id, order.tx_id)) {
-                    // Update order to ALT_FOUND (106)
-                    rerouter_.update_order_reroute(order.tx_id, result);
-                    
-                    std::cout << "[ORCHESTRATOR] Re-route SUCCESS: " 
-                              << result.shop_name 
-                              << " (diff: " << result.distance_diff_km << "km)"
-                              << " in " << result.search_time.count() << "µs" << std::endl;
-                    
-                    // TODO: Trigger push notification via gateway
-                    // gateway::push::send_reroute_notification(order.tx_id);
-                }
+                std::cout << "[ORCHESTRATOR] Re-route SUCCESS: " 
+                          << result.shop_name 
+                          << " (diff: " << result.distance_diff_km << "km)"
+                          << " in " << result.search_time.count() << "µs" << std::endl;
+                
+                // TODO: Trigger push notification via gateway
+                // gateway::push::send_reroute_notification(order.tx_id);
             } else {
                 std::cout << "[ORCHESTRATOR] No alternative found within 5km" << std::endl;
                 // TODO: Trigger refund flow
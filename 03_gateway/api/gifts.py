@@ -13,6 +13,9 @@ from enum import IntEnum
 import uuid
 import hashlib
 import json
+import os
+
+import httpx
 
 import redis.asyncio as aioredis
 from sqlalchemy import select
@@ -66,6 +69,12 @@ STATUS_NAMES = {
 # AI confidence threshold
 CONFIDENCE_THRESHOLD = 0.85
 
+# Core evidence endpoint (PUT /evidence/<tx_id>/<proof_type>, see
+# 02_core_logic/src/evidence). Unset = hash locally, nothing is stored.
+EVIDENCE_URL = os.getenv("KITHLY_EVIDENCE_URL", "").rstrip("/")
+INTERNAL_API_KEY = os.getenv("KITHLY_INTERNAL_KEY", "")
+EVIDENCE_CHUNK_BYTES = 64 * 1024
+
 
 # === Pydantic Models ===
 
@@ -117,6 +126,7 @@ class ProofUploadResponse(BaseModel):
     new_status: int
     new_status_name: str
     message: str
+    receipt_hash: Optional[str] = None
 
 
 class StatusUpdate(BaseModel):
@@ -212,12 +222,13 @@ async def upload_delivery_proof(
     - If confidence >= 0.85 → Status 400 (DELIVERED)
     - If confidence < 0.85 → Status 800 (HELD_FOR_REVIEW)
     """
-    # Read image bytes
+    # Store and hash the evidence chunk by chunk (never the whole photo)
+    receipt_hash = await _store_evidence(tx_id, photo, current_user.user_id)
+
+    # The AI Auditor sends the image inline, so it alone needs the bytes
+    await photo.seek(0)
     image_bytes = await photo.read()
-    
-    # Generate SHA-256 hash for evidence vault
-    receipt_hash = hashlib.sha256(image_bytes).hexdigest()
-    
+
     # Call AI Auditor (Gemini Vision)
     vision_service = get_vision_service()
     audit_result: AuditResult = await vision_service.analyze_delivery_proof(
@@ -236,8 +247,7 @@ async def upload_delivery_proof(
         message = f"Held for manual review (AI confidence: {audit_result.confidence:.2f} < {CONFIDENCE_THRESHOLD})"
     
     # TODO: Update status in C++ Core via internal API
-    # TODO: Store evidence in Delivery_Proofs table with receipt_hash
-    
+
     return ProofUploadResponse(
         tx_id=tx_id,
         proof_accepted=proof_accepted,
@@ -246,10 +256,68 @@ async def upload_delivery_proof(
         zra_ref=audit_result.zra_ref,
         new_status=new_status,
         new_status_name=STATUS_NAMES[new_status],
-        message=message
+        message=message,
+        receipt_hash=receipt_hash,
     )
 
 
+async def _store_evidence(tx_id: str, photo: UploadFile, uploaded_by: str) -> str:
+    """
+    Stream the upload to the core evidence endpoint, which hashes it,
+    stores it content-addressed and records the Delivery_Proofs row.
+    Without KITHLY_EVIDENCE_URL the photo is only hashed locally.
+
+    Returns the SHA-256 receipt hash.
+    """
+    # UploadFile spools to disk; its size is the Content-Length the core
+    # needs (it refuses chunked bodies)
+    photo.file.seek(0, os.SEEK_END)
+    size = photo.file.tell()
+    await photo.seek(0)
+
+    if not EVIDENCE_URL:
+        digest = hashlib.sha256()
+        while chunk := await photo.read(EVIDENCE_CHUNK_BYTES):
+            digest.update(chunk)
+        return digest.hexdigest()
+
+    async def body():
+        while chunk := await photo.read(EVIDENCE_CHUNK_BYTES):
+            yield chunk
+
+    headers = {
+        "Content-Length": str(size),
+        "Content-Type": photo.content_type or "application/octet-stream",
+        "X-Uploaded-By": uploaded_by,
+    }
+    if INTERNAL_API_KEY:
+        headers["X-Internal-Key"] = INTERNAL_API_KEY
+
+    try:
+        async with httpx.AsyncClient(timeout=httpx.Timeout(30.0, connect=5.0)) as client:
+            response = await client.put(
+                f"{EVIDENCE_URL}/evidence/{tx_id}/delivery_photo",
+                content=body(),
+                headers=headers,
+            )
+    except httpx.HTTPError as e:
+        raise HTTPException(
+            status_code=status.HTTP_503_SERVICE_UNAVAILABLE,
+            detail=f"Evidence vault unreachable: {e}"
+        )
+
+    if response.status_code == 404:
+        raise HTTPException(status_code=status.HTTP_404_NOT_FOUND, detail=f"Gift {tx_id} not found")
+    if response.status_code == 413:
+        raise HTTPException(status_code=status.HTTP_413_REQUEST_ENTITY_TOO_LARGE, detail="Photo too large")
+    if response.status_code not in (200, 201):
+        raise HTTPException(
+            status_code=status.HTTP_502_BAD_GATEWAY,
+            detail=f"Evidence vault rejected upload: {response.text}"
+        )
+    return response.json()["receipt_hash"]
+
+
 @router.get("/{tx_id}", response_model=GiftResponse)
 async def get_gift(
     tx_id: str,
@@ -9,8 +9,11 @@ Implements:
 - Pending escrow orders (real DB query)
 - Order management (status 300 ready for collection)
 - Emergency cancellation
+- Reroute offer acceptance (first accept wins, decided by the C++ core)
 """
 
+import json
+import uuid
 from datetime import datetime, timedelta
 from typing import Optional, List
 from fastapi import APIRouter, Depends, HTTPException
@@ -18,11 +21,16 @@ from pydantic import BaseModel
 from sqlalchemy import select
 from sqlalchemy.ext.asyncio import AsyncSession
 
-from services.database import get_db
+import redis.asyncio as aioredis
+
+from services.database import get_db, get_redis
 from services.models import Transaction, EscrowStatus
 
 router = APIRouter(prefix="/shop", tags=["Shop Dashboard"])
 
+# Drained by the core's RerouteOfferWorker (include/reroute_fanout.h)
+REROUTE_ACCEPT_QUEUE = "kithly:commands:reroute_accept"
+
 
 # =============================================================================
 # MODELS
@@ -244,6 +252,32 @@ async def cancel_order(tx_id: str, request: CancelOrderRequest):
     }
 
 
+@router.post("/{shop_id}/reroute-offers/{tx_id}/accept", status_code=202)
+async def accept_reroute_offer(
+    shop_id: str,
+    tx_id: str,
+    r: aioredis.Redis = Depends(get_redis),
+):
+    """
+    Accept a reroute offer. The core decides: the first shop to accept
+    wins the gift (status 106) and every other offer is withdrawn; a
+    late accept is ignored. The outcome arrives as a gateway event.
+    """
+    try:
+        uuid.UUID(shop_id)
+        uuid.UUID(tx_id)
+    except ValueError:
+        raise HTTPException(status_code=400, detail="shop_id and tx_id must be UUIDs")
+
+    await r.lpush(REROUTE_ACCEPT_QUEUE, json.dumps({"tx_id": tx_id, "shop_id": shop_id}))
+
+    return {
+        "tx_id": tx_id,
+        "shop_id": shop_id,
+        "status": "accept_queued",
+    }
+
+
 # =============================================================================
 # REAL-TIME UPDATES (WebSocket ready)
 # =============================================================================
@@ -0,0 +1,236 @@
+"""
+=============================================================================
+KithLy Global Protocol - EVENT CONSUMER (Pipeline 2)
+event_consumer.py - C++ Brain → Gateway Side Effects (Redis Stream)
+=============================================================================
+
+The C++ core no longer calls the Gateway over HTTP on every transition.
+It appends one entry per side effect to the kithly:events:gateway stream
+(pipelined XADD, repeats per tx coalesced), and this consumer performs
+them: Twilio force calls, shop notifications, ZRA fiscalization,
+Flutterwave disbursement, refunds and reroute offers.
+
+Run it as a sidecar next to worker.py:
+    python event_consumer.py
+
+Architecture:
+    ┌──────────┐   XADD   ┌─────────┐ XREADGROUP ┌───────────────────┐
+    │  C++ Core │ ───────▶ │  Redis  │ ─────────▶ │ event_consumer.py │
+    │  (Brain)  │          │ (Stream)│ ◀───────── │  (this file)      │
+    └──────────┘          └─────────┘    XACK    └───────────────────┘
+
+Delivery is at-least-once:
+    • An entry is XACKed only after its handler returns.
+    • Entries left pending by a crashed consumer are XCLAIMed after
+      CLAIM_IDLE_MS and retried.
+    • After MAX_DELIVERIES attempts an entry is moved to the dead-letter
+      stream and acked, so one poison event cannot block the group.
+    • Types without a handler yet (see UNHANDLED_TYPES) go straight to
+      the dead-letter stream, never acked as done.
+Handlers must therefore be idempotent on (type, tx_id).
+
+Scale horizontally by starting more instances with distinct
+KITHLY_CONSUMER_NAME values; the group splits entries between them.
+=============================================================================
+"""
+
+import asyncio
+import os
+import socket
+from typing import Awaitable, Callable, Dict
+
+import redis.asyncio as aioredis
+from redis.exceptions import ResponseError
+
+from services.database import _get_redis_client
+
+
+# ---------------------------------------------------------------------------
+# CONSTANTS
+# ---------------------------------------------------------------------------
+
+STREAM_KEY = "kithly:events:gateway"
+DEAD_LETTER_KEY = "kithly:events:gateway:dead"
+GROUP_NAME = os.getenv("KITHLY_CONSUMER_GROUP", "gateway")
+CONSUMER_NAME = os.getenv("KITHLY_CONSUMER_NAME", f"{socket.gethostname()}-{os.getpid()}")
+
+READ_COUNT = 100          # Entries per XREADGROUP
+BLOCK_MS = 5000           # XREADGROUP block timeout
+CLAIM_IDLE_MS = 60_000    # Pending this long → assume the owner died
+MAX_DELIVERIES = 5        # Attempts before dead-lettering
+
+
+# ---------------------------------------------------------------------------
+# HANDLERS (one per event type, see include/gateway_events.h)
+# ---------------------------------------------------------------------------
+
+Event = Dict[str, str]
+
+
+async def handle_force_call(event: Event) -> None:
+    from api.internal_worker import ForceCallRequest, trigger_force_call
+
+    response = await trigger_force_call(
+        ForceCallRequest(tx_id=event["tx_id"], shop_id=event.get("shop_id", ""))
+    )
+    if not response.success:
+        raise RuntimeError(response.message)
+
+
+async def handle_trigger_zra(event: Event) -> None:
+    from api.verification import _trigger_zra_fiscalization
+
+    if not await _trigger_zra_fiscalization(event["tx_id"], event.get("shop_id", "")):
+        raise RuntimeError("ZRA fiscalization failed")
+
+
+async def handle_trigger_disbursement(event: Event) -> None:
+    from api.verification import _trigger_flutterwave_disbursement
+
+    if not await _trigger_flutterwave_disbursement(event["tx_id"], event.get("shop_id", "")):
+        raise RuntimeError("Flutterwave disbursement failed")
+
+
+HANDLERS: Dict[str, Callable[[Event], Awaitable[None]]] = {
+    "force_call": handle_force_call,
+    "trigger_zra": handle_trigger_zra,
+    "trigger_disbursement": handle_trigger_disbursement,
+}
+
+# Types the core emits that have no Gateway integration yet. They are
+# dead-lettered (reason "no_handler") rather than acked, so a refund is
+# never silently marked done; redrive them from DEAD_LETTER_KEY once a
+# handler exists.
+UNHANDLED_TYPES = {
+    "reroute",
+    "notify_shop",
+    "refund",
+    "reroute_offer",
+    "reroute_offer_withdrawn",
+}
+
+
+# ---------------------------------------------------------------------------
+# THE CONSUMER LOOP
+# ---------------------------------------------------------------------------
+
+async def ensure_group(r: aioredis.Redis) -> None:
+    """Create the consumer group (and the stream) if it does not exist."""
+    try:
+        await r.xgroup_create(STREAM_KEY, GROUP_NAME, id="0", mkstream=True)
+    except ResponseError as e:
+        if "BUSYGROUP" not in str(e):
+            raise
+
+
+async def dispatch(r: aioredis.Redis, entry_id: str, event: Event) -> None:
+    """Run one handler; ack on success, leave pending on failure."""
+    handler = HANDLERS.get(event.get("type", ""))
+    if handler is None:
+        if event.get("type") in UNHANDLED_TYPES:
+            print(f"   ⚠️  No handler for {event['type']} tx_id={event.get('tx_id')} ({entry_id}) → dead letter")
+            await dead_letter(r, entry_id, event, "no_handler")
+        else:
+            print(f"   ❌ Unknown event type {event.get('type')!r} ({entry_id}) → dead letter")
+            await dead_letter(r, entry_id, event, "unknown_type")
+        return
+
+    try:
+        await handler(event)
+    except Exception as e:
+        # Stays in the PEL; reclaim_stale() retries it
+        print(f"   ❌ {event['type']} tx_id={event.get('tx_id')} failed: {type(e).__name__}: {e}")
+        return
+
+    await r.xack(STREAM_KEY, GROUP_NAME, entry_id)
+
+
+async def dead_letter(r: aioredis.Redis, entry_id: str, event: Event, reason: str) -> None:
+    async with r.pipeline(transaction=True) as pipe:
+        pipe.xadd(DEAD_LETTER_KEY, {**event, "source_id": entry_id, "reason": reason})
+        pipe.xack(STREAM_KEY, GROUP_NAME, entry_id)
+        await pipe.execute()
+
+
+async def reclaim_stale(r: aioredis.Redis) -> None:
+    """
+    Take over entries another consumer read but never acked. Entries that
+    have already failed MAX_DELIVERIES times go to the dead-letter stream.
+    """
+    pending = await r.xpending_range(
+        STREAM_KEY, GROUP_NAME, min="-", max="+", count=READ_COUNT, idle=CLAIM_IDLE_MS
+    )
+    if not pending:
+        return
+
+    retry = []
+    for p in pending:
+        if p["times_delivered"] >= MAX_DELIVERIES:
+            claimed = await r.xclaim(STREAM_KEY, GROUP_NAME, CONSUMER_NAME, CLAIM_IDLE_MS, [p["message_id"]])
+            for entry_id, event in claimed:
+                await dead_letter(r, entry_id, event, "max_deliveries")
+        else:
+            retry.append(p["message_id"])
+
+    if retry:
+        claimed = await r.xclaim(STREAM_KEY, GROUP_NAME, CONSUMER_NAME, CLAIM_IDLE_MS, retry)
+        for entry_id, event in claimed:
+            await dispatch(r, entry_id, event)
+
+
+async def consume_events() -> None:
+    print("=" * 65)
+    print("  KithLy Event Consumer — Pipeline 2 (C++ Core → Gateway)")
+    print("=" * 65)
+    print(f"  Stream   : {STREAM_KEY}")
+    print(f"  Group    : {GROUP_NAME}")
+    print(f"  Consumer : {CONSUMER_NAME}")
+    print("=" * 65)
+
+    r = _get_redis_client()
+    await ensure_group(r)
+
+    # Our own entries left pending by a previous run of this consumer
+    backlog_id = "0"
+
+    while True:
+        try:
+            await reclaim_stale(r)
+
+            # ">" = never-delivered entries; "0" = our own pending backlog
+            result = await r.xreadgroup(
+                GROUP_NAME, CONSUMER_NAME, {STREAM_KEY: backlog_id or ">"},
+                count=READ_COUNT, block=BLOCK_MS,
+            )
+            entries = result[0][1] if result else []
+
+            if backlog_id and not entries:
+                backlog_id = None  # Backlog replayed; switch to new entries
+                continue
+
+            for entry_id, event in entries:
+                await dispatch(r, entry_id, event)
+
+            if backlog_id and entries:
+                backlog_id = entries[-1][0]
+
+        except ResponseError as e:
+            if "NOGROUP" in str(e):
+                # Stream was deleted (e.g. FLUSHALL in staging); recreate
+                await ensure_group(r)
+                continue
+            print(f"   ❌ Redis error: {e}")
+            await asyncio.sleep(1)
+
+        except Exception as e:
+            print(f"   ❌ Consumer error: {type(e).__name__}: {e}")
+            # Brief cooldown to avoid CPU spin on repeated failures.
+            await asyncio.sleep(1)
+
+
+# ---------------------------------------------------------------------------
+# ENTRY POINT
+# ---------------------------------------------------------------------------
+
+if __name__ == "__main__":
+    asyncio.run(consume_events())